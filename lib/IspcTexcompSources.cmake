@@ -1,6 +1,7 @@
 set(ispcTexcompSources
 	${ISPC_TEXCOMP_DIR}/ispc_texcomp/ispc_texcomp.cpp
 	${ISPC_TEXCOMP_DIR}/ispc_texcomp/ispc_texcomp.h
+	${ISPC_TEXCOMP_DIR}/ispc_texcomp/ispc_texcomp_astc.cpp
 )
 
 set(ISPC_TEXCOMP_INCLUDE_DIRS ${ISPC_TEXCOMP_DIR}/ispc_texcomp)
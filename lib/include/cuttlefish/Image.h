@@ -42,6 +42,10 @@ struct ColorRGBAd;
  * (such as a PNG) then transformed as desired, such as resizing or flipping the image. Afterward,
  * one or more images will be added to a Texture.
  *
+ * Copies of an image share the same pixel data until one of them is modified, so copying is cheap.
+ * Functions that modify the image, including the non-const scanline(), give the image its own copy
+ * of the pixels first if they are shared.
+ *
  * @remark The coordinate (0, 0) is the upper-left of the image.
  */
 class CUTTLEFISH_EXPORT Image
@@ -159,6 +163,20 @@ public:
 	Image(Format format, unsigned int width, unsigned int height,
 		ColorSpace colorSpace = ColorSpace::Linear);
 
+	/**
+	 * @brief Wraps existing pixel memory without copying it.
+	 * @param format The pixel format.
+	 * @param width The width of the image.
+	 * @param height The height of the image.
+	 * @param data The pixel data, with rows ordered from top to bottom.
+	 * @param stride The number of bytes between the start of each row.
+	 * @param colorSpace The color space of the image.
+	 * @remark The image will be invalid if it failed to initialize.
+	 * @see initialize(Format, unsigned int, unsigned int, void*, std::size_t, ColorSpace)
+	 */
+	Image(Format format, unsigned int width, unsigned int height, void* data, std::size_t stride,
+		ColorSpace colorSpace = ColorSpace::Linear);
+
 	~Image();
 
 	/// @cond
@@ -183,6 +201,7 @@ public:
 	 * @param fileName The name of the file to load.
 	 * @param colorSpace The color space of the image.
 	 * @return False if the image couldn't be loaded.
+	 * @remark The file is memory mapped when possible to decode without an intermediate copy.
 	 */
 	bool load(const char* fileName, ColorSpace colorSpace = ColorSpace::Linear);
 
@@ -191,6 +210,8 @@ public:
 	 * @param stream The stream to load from. This must be opened in binary mode!
 	 * @param colorSpace The color space of the image.
 	 * @return False if the image couldn't be loaded.
+	 * @remark If the stream can't seek, it's read as the decoder requests data, retaining what was
+	 *     read so far in memory.
 	 */
 	bool load(std::istream& stream, ColorSpace colorSpace = ColorSpace::Linear);
 
@@ -258,6 +279,29 @@ public:
 	bool initialize(Format format, unsigned int width, unsigned int height,
 		ColorSpace colorSpace = ColorSpace::Linear);
 
+	/**
+	 * @brief Initializes the image to wrap existing pixel memory without copying it.
+	 *
+	 * This avoids copying pixels that were already decoded or generated elsewhere, such as by a
+	 * renderer. The image doesn't take ownership of the memory, which must remain valid until the
+	 * image is reset or destroyed. Functions that modify the image in place, such as setPixel() or
+	 * changeColorSpace(), write directly to the memory, while copies of the image and new images
+	 * returned by functions such as convert() and resize() have their own storage.
+	 *
+	 * @param format The pixel format.
+	 * @param width The width of the image.
+	 * @param height The height of the image.
+	 * @param data The pixel data, with rows ordered from top to bottom. Each pixel must be
+	 *     laid out as returned by scanline() for the format, and should be aligned to the size of
+	 *     its channels.
+	 * @param stride The number of bytes between the start of each row. This must be at least the
+	 *     size of a row.
+	 * @param colorSpace The color space of the image.
+	 * @return False if the image couldn't be initialized.
+	 */
+	bool initialize(Format format, unsigned int width, unsigned int height, void* data,
+		std::size_t stride, ColorSpace colorSpace = ColorSpace::Linear);
+
 	/**
 	 * @brief Resets the image to an unitialized state.
 	 */
@@ -275,6 +319,12 @@ public:
 	 */
 	ColorSpace colorSpace() const;
 
+	/**
+	 * @brief Returns whether or not the image wraps external memory.
+	 * @return True if the image was initialized with memory owned by the caller.
+	 */
+	bool isExternal() const;
+
 	/**
 	 * @brief Gets the number of bits per pixel in the image.
 	 * @return The bits per pixel.
@@ -345,6 +395,8 @@ public:
 	 * @brief Gets a scanline of the image.
 	 * @param y The Y coordinate of the scanline.
 	 * @return The data for the scanline.
+	 * @remark The returned pointer shouldn't be used to modify the image after it's copied, since
+	 *     the copy will share the same pixels.
 	 */
 	void* scanline(unsigned int y);
 
@@ -459,7 +511,7 @@ public:
 
 private:
 	struct Impl;
-	std::unique_ptr<Impl> m_impl;
+	std::shared_ptr<Impl> m_impl;
 };
 
 /**
@@ -25,6 +25,8 @@
 #include <cuttlefish/Export.h>
 #include <cuttlefish/Image.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
 #include <memory>
 #include <unordered_map>
@@ -38,6 +40,9 @@ namespace cuttlefish
  *
  * A texture is created from one or more images, and are then converted to the final texture format.
  * From that point, it can be saved to a texture file.
+ *
+ * Copies of a texture share the images and converted data until they are modified, so a texture
+ * may be cheaply copied to create multiple variants.
  */
 class CUTTLEFISH_EXPORT Texture
 {
@@ -177,14 +182,63 @@ public:
 
 	/**
 	 * @brief Enum for the compression quality.
+	 *
+	 * Preview was added after the other levels to keep their values, so the values aren't
+	 * ordered by quality and shouldn't be compared directly. Use qualityRank() to order them.
 	 */
 	enum class Quality
 	{
-		Lowest, ///< Lowest quality, but fastest results.
-		Low,    ///< Low quality and moderately fast.
-		Normal, ///< Tradeoff between quality and speed.
-		High,   ///< High quality, but moderately slow.
-		Highest ///< Highest quality, but slow.
+		Lowest,  ///< Lowest quality of the standard levels, but fastest results.
+		Low,     ///< Low quality and moderately fast.
+		Normal,  ///< Tradeoff between quality and speed.
+		High,    ///< High quality, but moderately slow.
+		Highest, ///< Highest quality, but slow.
+		Preview  ///< Real-time encoding for previews with significantly reduced quality.
+	};
+
+	/**
+	 * @brief Enum for the library used to encode block compressed formats.
+	 *
+	 * The relative speed and quality of each encoder depends on the content, so the best choice
+	 * should be measured for typical images, such as with quality metrics. Use
+	 * isEncoderSupported() to check which encoders may be used for a format.
+	 */
+	enum class Encoder
+	{
+		/**
+		 * The default encoder for the format, which gives the best tradeoff for typical images.
+		 */
+		Default,
+
+		/**
+		 * rgbcx for BC1 (opaque), BC2, BC3, and unsigned BC4 and BC5. This is fast with good
+		 * quality, with a large range of speeds across quality levels.
+		 */
+		Rgbcx,
+
+		/**
+		 * libsquish for BC1, BC2, and BC3. The cluster fit used for normal quality and above is
+		 * slower than rgbcx, but may give higher quality for blocks with many colors.
+		 */
+		Squish,
+
+		/**
+		 * Compressonator for BC4, BC5, and BC6H. This supports signed BC4 and BC5 but is slower
+		 * than rgbcx for unsigned formats.
+		 */
+		Compressonator,
+
+		/**
+		 * ISPC texture compressor for BC1 (opaque), BC3, and unsigned BC4, BC5, and BC6H. This is
+		 * the fastest encoder but doesn't change with the quality level for BC1 to BC5. Only
+		 * available when built with ISPC.
+		 */
+		IspcTexcomp,
+
+		/**
+		 * bc7e when built with ISPC, otherwise bc7enc, for BC7.
+		 */
+		Bc7enc
 	};
 
 	/**
@@ -195,7 +249,8 @@ public:
 		Auto, ///< Automatically choose the format based on the extension.
 		DDS,  ///< Direct Draw Surface format.
 		KTX,  ///< Kronos texture format.
-		PVR   ///< PowerVR texture format.
+		PVR,  ///< PowerVR texture format.
+		KTX2  ///< Khronos texture format version 2.
 	};
 
 	/**
@@ -236,6 +291,63 @@ public:
 		bool a; ///< True if the alpha channel is enabled.
 	};
 
+	/**
+	 * @brief Structure containing metrics for the quality of a converted image compared to the
+	 *     original image.
+	 *
+	 * Channels that aren't present in the format or are disabled with the color mask are ignored,
+	 * with an RMSE of 0 and an infinite PSNR. The alpha channel is also ignored when the alpha
+	 * type is None.
+	 */
+	struct QualityMetrics
+	{
+		/**
+		 * @brief The root mean square error for each channel.
+		 */
+		ColorRGBAd rmse;
+
+		/**
+		 * @brief The peak signal to noise ratio in decibels for each channel.
+		 *
+		 * The peak is the span of the value range for normalized types, which is 1 for UNorm and 2
+		 * for SNorm, and the largest value in the original image for other types, with a minimum
+		 * of 1. This is infinite for exact results.
+		 */
+		ColorRGBAd psnr;
+
+		/**
+		 * @brief The root mean square error across all channels.
+		 *
+		 * Channels are weighted by their perceptual importance for sRGB textures.
+		 */
+		double combinedRmse;
+
+		/**
+		 * @brief The peak signal to noise ratio in decibels across all channels.
+		 *
+		 * Channels are weighted by their perceptual importance for sRGB textures.
+		 */
+		double combinedPsnr;
+
+		/**
+		 * @brief The mean structural similarity index across all channels.
+		 *
+		 * This is in the range [-1, 1], where 1 is identical, and is computed with 8x8 pixel
+		 * windows. This is -1 if SSIM wasn't enabled.
+		 */
+		double ssim;
+	};
+
+	/**
+	 * @brief Structure describing properties of the content of the images.
+	 */
+	struct ContentProperties
+	{
+		bool opaqueAlpha; ///< True if all alpha values are at least 1.
+		bool binaryAlpha; ///< True if all alpha values are at most 0 or at least 1.
+		bool grayscale; ///< True if the red, green, and blue values are equal for all pixels.
+	};
+
 	/**
 	 * @brief Structure to index to a specific image within a texture.
 	 */
@@ -393,6 +505,65 @@ public:
 		Image imageStorage;
 	};
 
+	/**
+	 * @brief Interface for reading the source image in bands of rows for convertStreaming().
+	 */
+	class CUTTLEFISH_EXPORT RowSource
+	{
+	public:
+		virtual ~RowSource() = default;
+
+		/**
+		 * @brief Reads the next rows of the source image.
+		 *
+		 * Rows are read in order from the top of the image, and each row is only read once.
+		 *
+		 * @param[out] outImage The image to read the rows into. This must have the same width as
+		 *     the texture and rowCount rows, but may use any format and color space.
+		 * @param rowCount The number of rows to read.
+		 * @return False if the rows couldn't be read.
+		 */
+		virtual bool read(Image& outImage, unsigned int rowCount) = 0;
+	};
+
+	/**
+	 * @brief Row source that reads uncompressed pixels from a raw file.
+	 *
+	 * The file contains tightly packed rows of pixels from top to bottom, which may be preceded by
+	 * a header of a fixed size that's skipped.
+	 */
+	class CUTTLEFISH_EXPORT RawRowSource : public RowSource
+	{
+	public:
+		/**
+		 * @brief Opens the raw file.
+		 * @param fileName The name of the file.
+		 * @param format The pixel format within the file. This must have a whole number of bytes
+		 *     per pixel.
+		 * @param width The width of the image.
+		 * @param colorSpace The color space of the pixels.
+		 * @param offset The offset in bytes to the first row.
+		 */
+		RawRowSource(const char* fileName, Image::Format format, unsigned int width,
+			ColorSpace colorSpace = ColorSpace::Linear, std::uint64_t offset = 0);
+		~RawRowSource();
+
+		RawRowSource(const RawRowSource&) = delete;
+		RawRowSource& operator=(const RawRowSource&) = delete;
+
+		/**
+		 * @brief Returns whether or not the file was opened.
+		 * @return True if the file is open.
+		 */
+		bool isOpen() const;
+
+		bool read(Image& outImage, unsigned int rowCount) override;
+
+	private:
+		struct Impl;
+		std::unique_ptr<Impl> m_impl;
+	};
+
 	/**
 	 * @brief Mapping from an index of a specific mip image to a custom image to replace during mip
 	 * generation.
@@ -409,6 +580,11 @@ public:
 	 */
 	static const unsigned int allCores = (unsigned int)-1;
 
+	/**
+	 * @brief The default memory budget for convertStreaming(), 512 MiB.
+	 */
+	static const std::size_t defaultStreamingMemoryBudget = 512*1024*1024;
+
 	/**
 	 * @brief Returns whether or not a format is valid.
 	 *
@@ -431,6 +607,50 @@ public:
 	 */
 	static bool isFormatValid(Format format, Type type, FileType fileType);
 
+	/**
+	 * @brief Returns whether or not an encoder can be used for a format.
+	 * @remark Encoders that rely on libraries that have been disabled through compile flags will
+	 *     always return false.
+	 * @param format The base format for the texture.
+	 * @param type The type for the texture data.
+	 * @param encoder The encoder to check.
+	 * @return True if the format and type combination is valid and may be encoded with encoder.
+	 *     Encoder::Default is supported for all valid formats.
+	 */
+	static bool isEncoderSupported(Format format, Type type, Encoder encoder);
+
+	/**
+	 * @brief Returns whether or not data for a format can be decoded.
+	 * @remark Formats decoded through external libraries that have been disabled through compile
+	 *     flags will always return false.
+	 * @param format The base format for the texture.
+	 * @param type The type for the texture data.
+	 * @return True if the format and type combination can be decoded.
+	 */
+	static bool isDecodeSupported(Format format, Type type);
+
+	/**
+	 * @brief Decodes the data for a portion of a texture.
+	 *
+	 * This is intended to verify the results of block compressed formats, such as to compare
+	 * against the original image.
+	 *
+	 * @param[out] outImage The image to decode to. This will be RGBAF, with the unused channels set
+	 *     to 0 and alpha set to 1 when the format doesn't have them.
+	 * @param data The encoded data.
+	 * @param dataSize The size of the data in bytes.
+	 * @param format The base format of the data.
+	 * @param type The type of the data.
+	 * @param width The width of the image.
+	 * @param height The height of the image.
+	 * @param colorSpace The color space to set on the decoded image.
+	 * @param threads The number of threads to use during decoding.
+	 * @return False if the format can't be decoded or the data is too small.
+	 */
+	static bool decode(Image& outImage, const void* data, std::size_t dataSize, Format format,
+		Type type, unsigned int width, unsigned int height,
+		ColorSpace colorSpace = ColorSpace::Linear, unsigned int threads = allCores);
+
 	/**
 	 * @brief Returns whether or not a format supports native sRGB.
 	 *
@@ -450,6 +670,43 @@ public:
 	 */
 	static bool hasAlpha(Format format);
 
+	/**
+	 * @brief Gets the rank of a quality level to order them from fastest to slowest.
+	 *
+	 * Preview has the lowest rank, followed by Lowest through Highest.
+	 *
+	 * @param quality The quality level.
+	 * @return The rank of the quality, which may be compared with the rank of other levels.
+	 */
+	static unsigned int qualityRank(Quality quality);
+
+	/**
+	 * @brief Gets a cheaper format that can store the content without loss of information.
+	 *
+	 * Only formats with a smaller size are used. The following downgrades are performed:
+	 * - Opaque alpha: formats with alpha are replaced with the equivalent format without alpha,
+	 *   such as BC2 and BC3 to BC1_RGB, ETC2_R8G8B8A8 to ETC2_R8G8B8, and R8G8B8A8 to R8G8B8.
+	 * - Binary alpha: BC2 and BC3 are replaced with BC1_RGBA and ETC2_R8G8B8A8 is replaced with
+	 *   ETC2_R8G8B8A1. This is only done for standard and pre-multiplied alpha, since the color of
+	 *   transparent pixels is lost.
+	 * - Grayscale with opaque alpha: formats are replaced with a single channel format, such as
+	 *   R8G8B8A8 to R8, BC3 and BC7 to BC4, and ETC2_R8G8B8A8 to EAC_R11. The red channel must be
+	 *   replicated when sampling the texture, such as with a swizzle.
+	 *
+	 * The alpha is treated as opaque when the alpha type is None. The new format may not be
+	 * supported by every file type, which should be checked with isFormatValid() before saving.
+	 *
+	 * @param format The texture format.
+	 * @param type The type of the data within the texture.
+	 * @param alphaType The type of the alpha.
+	 * @param colorSpace The color space of the texture. Formats without native sRGB support won't
+	 *     be used for sRGB textures.
+	 * @param properties The properties of the content.
+	 * @return The cheaper format, or format if it can't be downgraded.
+	 */
+	static Format downgradeFormat(Format format, Type type, Alpha alphaType,
+		ColorSpace colorSpace, const ContentProperties& properties);
+
 	/**
 	 * @brief Gets the maximum number of mipmap levels.
 	 * @param dimension The dimension of the texture.
@@ -664,6 +921,10 @@ public:
 	 * @param depth The depth level.
 	 * @return False if the parameters are invalid, the image is an incorrect size, or the texture
 	 *     is a cube map.
+	 * @remark An image wrapping external memory is used in place when it's already
+	 *     Image::Format::RGBAF and in the texture's color space, so the memory must remain valid
+	 *     while the texture holds the image. Otherwise it's copied, and the memory is never
+	 *     modified by the texture.
 	 */
 	bool setImage(Image&& image, unsigned int mipLevel = 0, unsigned int depth = 0);
 
@@ -689,6 +950,10 @@ public:
 	 * @param depth The depth level.
 	 * @return False if the parameters are invalid, the image is an incorrect size or color space,
 	 *     or the texture isn't a cube map and face isn't PosX.
+	 * @remark An image wrapping external memory is used in place when it's already
+	 *     Image::Format::RGBAF and in the texture's color space, so the memory must remain valid
+	 *     while the texture holds the image. Otherwise it's copied, and the memory is never
+	 *     modified by the texture.
 	 */
 	bool setImage(Image&& image, CubeFace face, unsigned int mipLevel = 0, unsigned int depth = 0);
 
@@ -714,6 +979,30 @@ public:
 	bool generateMipmaps(Image::ResizeFilter filter = Image::ResizeFilter::CatmullRom,
 		unsigned int mipLevels = allMipLevels, const CustomMipImages& customMipImages = {});
 
+	/**
+	 * @brief Sets whether or not mipmap generation is fused with conversion.
+	 *
+	 * When enabled, generateMipmaps() only records the mip levels to generate, and each level is
+	 * generated during convert() from the previous level right after that level is encoded. This
+	 * keeps at most two levels of each image in memory at once rather than the full set of mipmaps
+	 * for every face and array layer. The output is the same whether or not this is enabled.
+	 *
+	 * While mipmaps are pending, getImage() returns empty images for the levels after the first
+	 * one, format downgrades only analyze the first level, and any custom mip images that aren't
+	 * owned by CustomMipImage must remain valid until convert() is called. This has no effect for
+	 * 3D textures and is disabled by default.
+	 *
+	 * @remark This is reset when the texture is initialized.
+	 * @param enabled True to fuse mipmap generation with conversion.
+	 */
+	void setFusedMipmapsEnabled(bool enabled);
+
+	/**
+	 * @brief Gets whether or not mipmap generation is fused with conversion.
+	 * @return True if fused mipmap generation is enabled.
+	 */
+	bool fusedMipmapsEnabled() const;
+
 	/**
 	 * @brief Returns whether or not all images are present for each mip level, depth level, and
 	 *     face.
@@ -721,6 +1010,249 @@ public:
 	 */
 	bool imagesComplete() const;
 
+	/**
+	 * @brief Sets whether or not to cache encoded blocks during conversion.
+	 *
+	 * When enabled, block compressed formats will only encode each unique source block once and
+	 * copy the result for any duplicate blocks. The cache is shared across all faces, mip levels,
+	 * and depth levels of the texture. This is most effective for images with many repeated
+	 * blocks, such as sprite atlases or tiled images, and adds a small overhead otherwise.
+	 *
+	 * This is only used for S3TC, ETC, and ASTC formats, and is disabled by default. The output is
+	 * the same whether or not the cache is enabled.
+	 *
+	 * @remark This is reset when the texture is initialized.
+	 * @param enabled True to enable the block cache.
+	 */
+	void setBlockCacheEnabled(bool enabled);
+
+	/**
+	 * @brief Gets whether or not encoded blocks are cached during conversion.
+	 * @return True if the block cache is enabled.
+	 */
+	bool blockCacheEnabled() const;
+
+	/**
+	 * @brief Gets the number of blocks that were looked up in the block cache for the last
+	 *     conversion.
+	 * @return The number of lookups.
+	 */
+	std::size_t blockCacheLookups() const;
+
+	/**
+	 * @brief Gets the number of blocks that were found in the block cache for the last conversion.
+	 * @return The number of hits.
+	 */
+	std::size_t blockCacheHits() const;
+
+	/**
+	 * @brief Sets whether or not to record a hash of the source for each block during conversion.
+	 *
+	 * The hashes may be saved with saveBlockHashes() and used with setPreviousOutput() for a later
+	 * conversion to only re-encode the blocks that changed. This is only used for block compressed
+	 * formats other than PVRTC, and is disabled by default.
+	 *
+	 * @remark This is reset when the texture is initialized.
+	 * @param enabled True to record the block hashes.
+	 */
+	void setBlockHashesEnabled(bool enabled);
+
+	/**
+	 * @brief Gets whether or not the block hashes are recorded during conversion.
+	 * @return True if the block hashes are recorded.
+	 */
+	bool blockHashesEnabled() const;
+
+	/**
+	 * @brief Saves the block hashes from the last conversion.
+	 *
+	 * This should be saved alongside the output texture so they can be passed to
+	 * setPreviousOutput() for the next conversion.
+	 *
+	 * @param fileName The name of the file to save the hashes to.
+	 * @return False if the texture hasn't been converted with block hashes enabled or the file
+	 *     couldn't be written.
+	 */
+	bool saveBlockHashes(const char* fileName) const;
+
+	/**
+	 * @brief Sets the output from a previous conversion to reuse unchanged blocks from.
+	 *
+	 * Any block whose source is unchanged since the previous conversion will copy the previously
+	 * encoded block rather than encoding it again. This is only used for the next call to
+	 * convert(), and implicitly enables block hashes. The previous output is ignored if the
+	 * parameters for the conversion, such as the dimensions, format, or quality, don't match or the
+	 * output file was modified after the block hashes were saved.
+	 *
+	 * @remark This is reset when the texture is initialized.
+	 * @param fileName The name of the previously saved texture file.
+	 * @param blockHashFileName The name of the block hashes saved with the texture file.
+	 * @param fileType The type of the previously saved texture file.
+	 * @return False if the texture is invalid, the files couldn't be read, or the block hashes are
+	 *     invalid.
+	 */
+	bool setPreviousOutput(const char* fileName, const char* blockHashFileName,
+		FileType fileType = FileType::Auto);
+
+	/**
+	 * @brief Gets the number of blocks reused from the previous output for the last conversion.
+	 * @return The number of reused blocks.
+	 */
+	std::size_t reusedBlockCount() const;
+
+	/**
+	 * @brief Sets whether or not to adaptively choose the quality for each block.
+	 *
+	 * When enabled, each block is first encoded with the fast quality and the error is measured
+	 * against the source. Only blocks where the error is above the threshold are encoded again
+	 * with the quality passed to convert(). Since most blocks in typical images are easy to
+	 * encode, this gives close to the full quality at a fraction of the cost.
+	 *
+	 * This is only used for S3TC, ETC, and ASTC formats, and is disabled by default. It has no
+	 * effect if the fast quality isn't lower than the quality passed to convert().
+	 *
+	 * @remark This is reset when the texture is initialized.
+	 * @param enabled True to enable adaptive quality.
+	 * @param fastQuality The quality to first encode each block with.
+	 * @param errorThreshold The root mean square error, with each channel in the range [0, 1],
+	 *     above which a block is encoded again with the full quality. HDR formats measure the
+	 *     error in log2(1 + value) space. A negative value uses defaultAdaptiveErrorThreshold()
+	 *     for the format.
+	 */
+	void setAdaptiveQuality(bool enabled, Quality fastQuality = Quality::Low,
+		float errorThreshold = -1.0f);
+
+	/**
+	 * @brief Gets whether or not adaptive quality is enabled.
+	 * @return True if adaptive quality is enabled.
+	 */
+	bool adaptiveQualityEnabled() const;
+
+	/**
+	 * @brief Gets the quality to first encode each block with for adaptive quality.
+	 * @return The fast quality.
+	 */
+	Quality adaptiveFastQuality() const;
+
+	/**
+	 * @brief Gets the error threshold for adaptive quality.
+	 * @return The error threshold, or a negative value to use the default for the format.
+	 */
+	float adaptiveErrorThreshold() const;
+
+	/**
+	 * @brief Gets the default error threshold for adaptive quality.
+	 *
+	 * This is roughly the error expected from a typical block at normal quality, so only blocks
+	 * that are harder than average are encoded again.
+	 *
+	 * @param format The texture format.
+	 * @param type The type of the data within the texture.
+	 * @return The default error threshold.
+	 */
+	static float defaultAdaptiveErrorThreshold(Format format, Type type);
+
+	/**
+	 * @brief Gets the number of blocks that were encoded again with the full quality for the last
+	 *     conversion with adaptive quality.
+	 * @return The number of refined blocks.
+	 */
+	std::size_t adaptiveRefinedBlockCount() const;
+
+	/**
+	 * @brief Sets whether or not to compute quality metrics during conversion.
+	 *
+	 * The converted data for each image is decoded after it's converted to compare against the
+	 * original image, so the original images don't need to be kept. This is only supported for
+	 * formats where isDecodeSupported() returns true, and is disabled by default.
+	 *
+	 * @remark This is reset when the texture is initialized.
+	 * @param enabled True to compute quality metrics.
+	 * @param ssim True to also compute the structural similarity index, which is more expensive.
+	 */
+	void setQualityMetricsEnabled(bool enabled, bool ssim = false);
+
+	/**
+	 * @brief Gets whether or not quality metrics are computed during conversion.
+	 * @return True if quality metrics are enabled.
+	 */
+	bool qualityMetricsEnabled() const;
+
+	/**
+	 * @brief Gets whether or not the structural similarity index is computed with the quality
+	 *     metrics.
+	 * @return True if SSIM is enabled.
+	 */
+	bool qualityMetricsSsimEnabled() const;
+
+	/**
+	 * @brief Gets the quality metrics for a portion of a non-cube map texture.
+	 * @param[out] outMetrics The quality metrics.
+	 * @param mipLevel The mipmap level.
+	 * @param depth The depth level.
+	 * @return False if the parameters are invalid, the texture is a cube map, or quality metrics
+	 *     weren't computed for the last conversion.
+	 */
+	bool qualityMetrics(QualityMetrics& outMetrics, unsigned int mipLevel = 0,
+		unsigned int depth = 0) const;
+
+	/**
+	 * @brief Gets the quality metrics for a portion of a cube map texture.
+	 * @param[out] outMetrics The quality metrics.
+	 * @param face The face to get the metrics for.
+	 * @param mipLevel The mipmap level.
+	 * @param depth The depth level.
+	 * @return False if the parameters are invalid, the texture isn't a cube map and face isn't
+	 *     PosX, or quality metrics weren't computed for the last conversion.
+	 */
+	bool qualityMetrics(QualityMetrics& outMetrics, CubeFace face, unsigned int mipLevel = 0,
+		unsigned int depth = 0) const;
+
+	/**
+	 * @brief Analyzes the content of the images.
+	 * @param[out] outProperties The properties of the content across all images.
+	 * @param threads The number of threads to use.
+	 * @return False if the images aren't complete.
+	 */
+	bool analyzeContent(ContentProperties& outProperties, unsigned int threads = allCores) const;
+
+	/**
+	 * @brief Sets whether or not to downgrade the format based on the content of the images.
+	 *
+	 * When enabled, the images are analyzed with analyzeContent() during conversion and the
+	 * format passed to convert() is replaced with downgradeFormat(). The format that was used
+	 * may be queried with format() after conversion. This is disabled by default.
+	 *
+	 * @remark This is reset when the texture is initialized.
+	 * @param enabled True to downgrade the format.
+	 */
+	void setFormatDowngradeEnabled(bool enabled);
+
+	/**
+	 * @brief Gets whether or not the format is downgraded based on the content of the images.
+	 * @return True if format downgrades are enabled.
+	 */
+	bool formatDowngradeEnabled() const;
+
+	/**
+	 * @brief Sets the encoder to use for a format.
+	 *
+	 * Conversion will fail if isEncoderSupported() returns false for the format and type passed to
+	 * convert(). The preview encoders for Quality::Preview are only used with Encoder::Default.
+	 *
+	 * @remark This is reset when the texture is initialized.
+	 * @param format The format to set the encoder for.
+	 * @param encoder The encoder to use.
+	 */
+	void setEncoder(Format format, Encoder encoder);
+
+	/**
+	 * @brief Gets the encoder to use for a format.
+	 * @param format The format to get the encoder for.
+	 * @return The encoder.
+	 */
+	Encoder encoder(Format format) const;
+
 	/**
 	 * @brief Converts the input images into the final texture.
 	 *
@@ -735,12 +1267,109 @@ public:
 	 *     those channels from impacting block compression.
 	 * @param threads The number of threads to use during conversion.
 	 * @return False if the images aren't complete, the format and type combination is invalid, the
-	 *     color space cannot be used with the format, or the size is invalid for the type.
+	 *     encoder for the format isn't supported, the color space cannot be used with the format,
+	 *     or the size is invalid for the type.
 	 */
 	bool convert(Format format, Type type, Quality quality = Quality::Normal,
 		Alpha alphaType = Alpha::Standard, ColorMask colorMask = ColorMask(),
 		unsigned int threads = allCores);
 
+	/**
+	 * @brief Converts the input images into the final texture, selecting the smallest candidate
+	 *     format that meets a quality target.
+	 *
+	 * Candidates are tried from the fewest bits per pixel to the most. Each candidate is evaluated
+	 * by encoding a copy of the first mip level with Quality::Preview and computing its quality
+	 * metrics, and the first candidate where every surface meets the target is converted with the
+	 * requested quality. Since the final conversion uses a quality at least as high as the
+	 * preview, the target is expected to be met for the final texture as well. The candidate with
+	 * the most bits per pixel is used if no other candidate meets the target.
+	 *
+	 * Candidates that aren't valid for the type, don't support the encoder set with setEncoder(),
+	 * can't be used with the color space, or don't support decoding with isDecodeSupported() are
+	 * ignored. The selected format may be queried with format() after conversion.
+	 *
+	 * @param candidates The candidate texture formats.
+	 * @param type The type of the data within the texture.
+	 * @param minPsnr The minimum combined PSNR in decibels. Set to 0 to ignore.
+	 * @param minSsim The minimum structural similarity index. Set to -1 to ignore.
+	 * @param quality The quality of compression for the final conversion.
+	 * @param alphaType The type of the alpha.
+	 * @param colorMask The color mask for the channels that are used. This is also used when
+	 *     computing the quality metrics.
+	 * @param threads The number of threads to use during conversion.
+	 * @return False if the images aren't complete, no candidate is usable, or conversion failed.
+	 */
+	bool convertToQualityTarget(const std::vector<Format>& candidates, Type type, double minPsnr,
+		double minSsim = -1.0, Quality quality = Quality::Normal,
+		Alpha alphaType = Alpha::Standard, ColorMask colorMask = ColorMask(),
+		unsigned int threads = allCores);
+
+	/**
+	 * @brief Converts the input images into the final texture and saves it to a file.
+	 *
+	 * This has the same result as convert() followed by save(), but each surface is written to
+	 * the file on a separate thread as soon as it's converted. This overlaps writing the file with
+	 * converting the remaining surfaces. The converted texture is kept as with convert(), so it
+	 * may be saved again or decoded afterward.
+	 *
+	 * KTX2 files with Zstandard supercompression are saved after the conversion is complete.
+	 *
+	 * @param fileName The name of the file to save to.
+	 * @param fileType The type of the file to save.
+	 * @param format The texture format to use.
+	 * @param type The type of the data within the texture.
+	 * @param quality The quality of compression.
+	 * @param alphaType The type of the alpha.
+	 * @param colorMask The color mask for the channels that are used.
+	 * @param threads The number of threads to use during conversion.
+	 * @return The result of saving. Invalid is returned if the conversion failed as with
+	 *     convert(). If saving failed for any other reason, the texture is still converted.
+	 */
+	SaveResult convertAndSave(const char* fileName, FileType fileType, Format format, Type type,
+		Quality quality = Quality::Normal, Alpha alphaType = Alpha::Standard,
+		ColorMask colorMask = ColorMask(), unsigned int threads = allCores);
+
+	/**
+	 * @brief Converts a texture from a source image that's streamed in and saves it directly to a
+	 *     file.
+	 *
+	 * This is intended for images that are too large to hold in memory. The texture must be
+	 * initialized as a 2D texture without array layers, and the images shouldn't be set. Rows are
+	 * read from the source in bands, with each mip level generated by averaging 2x2 pixels of the
+	 * previous level as the rows stream through. Once a band of rows is complete for a mip level
+	 * it's converted and written to its final location in the file.
+	 *
+	 * Memory use is bounded by memoryBudget, with the band sizes chosen to fit the budget, though
+	 * at least one row of blocks is always kept for each mip level. Larger budgets allow more
+	 * blocks to be encoded in parallel.
+	 *
+	 * The settings for the block cache, adaptive quality, and encoder are used as with convert().
+	 * Quality metrics, incremental conversion, format downgrades, PVRTC formats, and KTX2 files
+	 * aren't supported. Since the texture data isn't kept, converted() remains false afterward.
+	 *
+	 * The file is written to a temporary file that replaces fileName once complete, so an
+	 * existing file is left untouched if conversion fails. The texture is left unchanged if the
+	 * parameters are invalid or the file can't be created.
+	 *
+	 * @param source The source to read the rows from.
+	 * @param fileName The name of the file to save to.
+	 * @param fileType The type of the file to save.
+	 * @param format The texture format to use.
+	 * @param type The type of the data within the texture.
+	 * @param quality The quality of compression.
+	 * @param alphaType The type of the alpha.
+	 * @param colorMask The color mask for the channels that are used.
+	 * @param memoryBudget The approximate maximum number of bytes to use for the image data.
+	 * @param threads The number of threads to use during conversion.
+	 * @return The result of saving. Invalid is returned if the texture or parameters are invalid,
+	 *     or the source couldn't be read.
+	 */
+	SaveResult convertStreaming(RowSource& source, const char* fileName, FileType fileType,
+		Format format, Type type, Quality quality = Quality::Normal,
+		Alpha alphaType = Alpha::Standard, ColorMask colorMask = ColorMask(),
+		std::size_t memoryBudget = defaultStreamingMemoryBudget, unsigned int threads = allCores);
+
 	/**
 	 * @brief Returns whether or not the images have been converted into a texture.
 	 * @return True if converted.
@@ -806,6 +1435,91 @@ public:
 	 */
 	const void* data(CubeFace face, unsigned int mipLevel = 0, unsigned int depth = 0) const;
 
+	/**
+	 * @brief Decodes a portion of a converted non-cube map texture.
+	 * @param[out] outImage The image to decode to.
+	 * @param mipLevel The mipmap level.
+	 * @param depth The depth level.
+	 * @param threads The number of threads to use during decoding.
+	 * @return False if the texture hasn't been converted, the parameters are invalid, or the format
+	 *     can't be decoded.
+	 */
+	bool decode(Image& outImage, unsigned int mipLevel = 0, unsigned int depth = 0,
+		unsigned int threads = allCores) const;
+
+	/**
+	 * @brief Decodes a portion of a converted cube map texture.
+	 * @param[out] outImage The image to decode to.
+	 * @param face The face to decode.
+	 * @param mipLevel The mipmap level.
+	 * @param depth The depth level.
+	 * @param threads The number of threads to use during decoding.
+	 * @return False if the texture hasn't been converted, the parameters are invalid, or the format
+	 *     can't be decoded.
+	 */
+	bool decode(Image& outImage, CubeFace face, unsigned int mipLevel = 0,
+		unsigned int depth = 0, unsigned int threads = allCores) const;
+
+	/**
+	 * @brief Sets the Zstandard compression level to supercompress KTX2 files with.
+	 *
+	 * Each mip level is compressed independently, with the levels compressed in parallel. Saving
+	 * with supercompression returns SaveResult::Unsupported if Cuttlefish was built without
+	 * Zstandard. This has no effect for other file types.
+	 *
+	 * @remark This is reset when the texture is initialized.
+	 * @param level The compression level, or 0 to disable supercompression. Levels above the
+	 *     maximum supported by Zstandard are clamped. This is 0 by default.
+	 */
+	void setKtx2ZstdLevel(unsigned int level);
+
+	/**
+	 * @brief Gets the Zstandard compression level to supercompress KTX2 files with.
+	 * @return The compression level, or 0 if supercompression is disabled.
+	 */
+	unsigned int ktx2ZstdLevel() const;
+
+	/**
+	 * @brief Loads a previously converted texture from a file.
+	 *
+	 * DDS, KTX, and PVR files are supported. The file is memory mapped, and data() references the
+	 * mapped file directly rather than copying it, except for KTX files where the rows of
+	 * uncompressed formats are padded. The mapping is shared with copies of the texture and is
+	 * released once the texture is converted again or destroyed.
+	 *
+	 * Once loaded, converted() returns true and the texture may be queried, decoded, and saved as
+	 * if it was converted. Saving to another file type rewrites the container without re-encoding.
+	 * The images aren't loaded, though they may be set to convert the texture again.
+	 *
+	 * When the file type can't distinguish between formats or types, such as ASTC blocks that are
+	 * used for both UNorm and UFloat, the first matching format and type are used.
+	 *
+	 * @param fileName The name of the file to load.
+	 * @param fileType The type of the file to load.
+	 * @return False if the file couldn't be read, the contents are invalid, or the format isn't
+	 *     supported.
+	 */
+	bool load(const char* fileName, FileType fileType = FileType::Auto);
+
+	/**
+	 * @brief Rewrites a DDS, KTX, or PVR texture file as another file type without re-encoding.
+	 *
+	 * The input is loaded with load() and written with save(). The mip levels, faces, and array
+	 * layers are reordered and the row padding is adjusted for the output file type, with the
+	 * surfaces written directly from the memory mapped input.
+	 *
+	 * @param inputFileName The name of the file to load.
+	 * @param outputFileName The name of the file to save to.
+	 * @param inputFileType The type of the file to load.
+	 * @param outputFileType The type of the file to save.
+	 * @param ktx2ZstdLevel The Zstandard compression level when saving KTX2 files, as with
+	 *     setKtx2ZstdLevel().
+	 * @return The result of saving. Invalid is returned if the input couldn't be loaded.
+	 */
+	static SaveResult transcode(const char* inputFileName, const char* outputFileName,
+		FileType inputFileType = FileType::Auto, FileType outputFileType = FileType::Auto,
+		unsigned int ktx2ZstdLevel = 0);
+
 	/**
 	 * @brief Saves a texture to a file.
 	 * @param fileName The name of the file to save to.
@@ -830,6 +1544,28 @@ public:
      */
     SaveResult save(std::vector<std::uint8_t>& outData, FileType fileType);
 
+	/**
+	 * @brief Saves a texture to a block of memory.
+	 *
+	 * The data is written directly into the memory without any intermediate copies. Use
+	 * savedSize() to get the size required.
+	 *
+	 * @param[out] outData The memory to write the data to.
+	 * @param size The size of outData in bytes.
+	 * @param fileType The type of the file to save.
+	 * @return False if the texture hasn't been converted or the data couldn't be written.
+	 *     WriteError is returned if size is smaller than savedSize().
+	 */
+	SaveResult save(void* outData, std::size_t size, FileType fileType);
+
+	/**
+	 * @brief Gets the number of bytes that will be written when saving the texture.
+	 * @param fileType The type of the file to save.
+	 * @return The size of the saved file, or 0 if the texture hasn't been converted or can't be
+	 *     saved with fileType.
+	 */
+	std::size_t savedSize(FileType fileType) const;
+
 private:
 	struct Impl;
 	std::unique_ptr<Impl> m_impl;
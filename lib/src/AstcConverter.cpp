@@ -17,16 +17,35 @@
 #if CUTTLEFISH_HAS_ASTC
 
 #include "AstcConverter.h"
+#include "BlockCache.h"
+#include "BlockDecoder.h"
+#include "ConstantBlock.h"
+#include "EncoderStateCache.h"
+#include "Shared.h"
 #include <cuttlefish/Color.h>
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
-#include <list>
-#include <mutex>
-#include <thread>
+#include <vector>
 
 #include "astcenc.h"
 
+#if CUTTLEFISH_ISPC
+#include "ispc_texcomp.h"
+#endif
+
+#if CUTTLEFISH_CLANG || CUTTLEFISH_GCC
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#endif
+
+#include <glm/gtc/packing.hpp>
+
+#if CUTTLEFISH_CLANG || CUTTLEFISH_GCC
+#pragma GCC diagnostic pop
+#endif
+
 namespace cuttlefish
 {
 
@@ -36,84 +55,76 @@ namespace
 const unsigned int blockSize = 16;
 const unsigned int maxBlockDim = 12;
 
-class AstcContextManager
+class AstcContext : public EncoderStateCache::State
 {
 public:
-	static const unsigned int cacheSize;
-
-	astcenc_context* createContext(const astcenc_config& config)
+	explicit AstcContext(const astcenc_config& config)
+		: context(nullptr)
 	{
-		std::lock_guard<std::mutex> lock(m_mutex);
-
-		for (auto it = m_cache.begin(); it != m_cache.end(); ++it)
-		{
-			if (std::memcmp(&config, &it->config, sizeof(astcenc_config)) != 0)
-				continue;
-
-			astcenc_context* context = it->context;
-			it->context = nullptr;
-			m_cache.erase(it);
-			return context;
-		}
-
-		astcenc_context* context = nullptr;
 		astcenc_context_alloc(&config, 1, &context);
 		assert(context);
-		return context;
 	}
 
-	void destroyContext(astcenc_context* context, const astcenc_config& config)
+	~AstcContext()
 	{
-		std::lock_guard<std::mutex> lock(m_mutex);
-
-		while (m_cache.size() >= cacheSize)
-			m_cache.pop_back();
-
-		m_cache.emplace_front(context, config);
+		astcenc_context_free(context);
 	}
 
-private:
-	struct ContextInfo
-	{
-		ContextInfo(astcenc_context* _context, const astcenc_config& _config)
-			: context(_context), config(_config)
-		{
-		}
-
-		ContextInfo(const ContextInfo&) = delete;
-		ContextInfo& operator=(const ContextInfo&) = delete;
-
-		~ContextInfo()
-		{
-			astcenc_context_free(context);
-		}
-
-		astcenc_context* context;
-		astcenc_config config;
-	};
-
-	std::list<ContextInfo> m_cache;
-	std::mutex m_mutex;
+	astcenc_context* context;
 };
 
-const unsigned int AstcContextManager::cacheSize = 3*std::thread::hardware_concurrency();
-
-AstcContextManager g_contextManager;
+using AstcContextHandle = EncoderStateCache::Handle<AstcContext>;
 
 } // namespace
 
 struct AstcConverter::AstcData
 {
+	Texture::Format format;
+	Texture::Type type;
+	Texture::Quality quality;
+	Texture::Quality fastQuality;
 	astcenc_swizzle swizzle;
 	astcenc_config config;
+	astcenc_config uniformConfig;
+	astcenc_config fastConfig;
+	Texture::ColorMask uniformMask;
+	bool hdr;
+	bool srgb;
+	bool adaptive;
+	float errorThreshold;
+#if CUTTLEFISH_ISPC
+	std::unique_ptr<astc_enc_settings> ispcSettings;
+#endif
 };
 
 class AstcConverter::AstcThreadData : public Converter::ThreadData
 {
 public:
-	AstcThreadData(unsigned int blockX, unsigned int blockY, const astcenc_config& _config)
-		: config(&_config), context(g_contextManager.createContext(_config))
+	AstcThreadData(unsigned int blockX, unsigned int blockY, const AstcData& _astcData)
+		: astcData(&_astcData)
 	{
+		// All contexts are acquired up front since the thread data is created on the thread
+		// performing the conversion, while the worker threads don't have any cached states.
+		// Contexts with the same config as the main context are shared with it.
+		contextHandle = getContext(astcData->config, astcData->quality);
+		context = contextHandle->context;
+
+		if (std::memcmp(&astcData->uniformConfig, &astcData->config, sizeof(astcenc_config)) == 0)
+			uniformContext = context;
+		else
+		{
+			uniformContextHandle = getContext(astcData->uniformConfig, Texture::Quality::Lowest);
+			uniformContext = uniformContextHandle->context;
+		}
+
+		if (astcData->adaptive)
+		{
+			fastContextHandle = getContext(astcData->fastConfig, astcData->fastQuality);
+			fastContext = fastContextHandle->context;
+		}
+		else
+			fastContext = context;
+
 		dummyImage.dim_x = blockX;
 		dummyImage.dim_y = blockY;
 		dummyImage.dim_z = 1;
@@ -121,21 +132,66 @@ public:
 		dummyImage.data = nullptr;
 	}
 
-	~AstcThreadData()
+	astcenc_image dummyImage;
+	std::vector<ColorRGBAf> rowData;
+	std::vector<std::uint8_t> rowData8;
+	std::vector<void*> rowPointers;
+	std::vector<BlockCache::Key> rowKeys;
+	std::vector<bool> rowPending;
+	const AstcData* astcData;
+	astcenc_context* context;
+	astcenc_context* uniformContext;
+	astcenc_context* fastContext;
+
+private:
+	// Contexts are taken from the encoder state cache since allocating them is expensive compared
+	// to encoding a small image.
+	AstcContextHandle getContext(const astcenc_config& config, Texture::Quality quality) const
 	{
-		g_contextManager.destroyContext(context, *config);
+		return EncoderStateCache::get<AstcContext>(
+			EncoderStateCache::Key(EncoderStateCache::Kind::AstcContext, astcData->format,
+				astcData->type, quality, config),
+			[&config]() {return new AstcContext(config);});
 	}
 
-	astcenc_image dummyImage;
-	const astcenc_config* config;
-	astcenc_context* context;
+	AstcContextHandle contextHandle;
+	AstcContextHandle uniformContextHandle;
+	AstcContextHandle fastContextHandle;
 };
 
+static float getPreset(Texture::Quality quality)
+{
+	switch (quality)
+	{
+		case Texture::Quality::Preview:
+		case Texture::Quality::Lowest:
+			return ASTCENC_PRE_FASTEST;
+		case Texture::Quality::Low:
+			return ASTCENC_PRE_FAST;
+		case Texture::Quality::Normal:
+			return ASTCENC_PRE_MEDIUM;
+		case Texture::Quality::High:
+			return ASTCENC_PRE_THOROUGH;
+		case Texture::Quality::Highest:
+			return ASTCENC_PRE_EXHAUSTIVE;
+		default:
+			assert(false);
+			return ASTCENC_PRE_MEDIUM;
+	}
+}
+
+static void compressBlock(astcenc_context* context, astcenc_image& image,
+	const astcenc_swizzle& swizzle, std::uint8_t* block)
+{
+	astcenc_compress_image(context, &image, &swizzle, block, blockSize, 0);
+	astcenc_compress_reset(context);
+}
+
 AstcConverter::AstcConverter(const Texture& texture, const Image& image, unsigned int blockX,
 	unsigned int blockY, Texture::Quality quality)
 	: Converter(image), m_blockX(blockX), m_blockY(blockY),
 	m_jobsX((image.width() + blockX - 1)/blockX), m_jobsY((image.height() + blockY - 1)/blockY),
-	m_astcData(new AstcData)
+	m_rowBatching(quality == Texture::Quality::Preview), m_astcData(new AstcData)
 {
 	m_astcData->swizzle.r = texture.colorMask().r ? ASTCENC_SWZ_R : ASTCENC_SWZ_0;
 	m_astcData->swizzle.g = texture.colorMask().g ? ASTCENC_SWZ_G : ASTCENC_SWZ_0;
@@ -148,6 +204,16 @@ AstcConverter::AstcConverter(const Texture& texture, const Image& image, unsigne
 	else
 		m_astcData->swizzle.a = ASTCENC_SWZ_0;
 
+	m_astcData->format = texture.format();
+	m_astcData->type = texture.type();
+	m_astcData->quality = quality;
+	m_astcData->fastQuality = quality;
+	m_astcData->uniformMask = texture.colorMask();
+	if (texture.alphaType() == Texture::Alpha::None)
+		m_astcData->uniformMask.a = false;
+	m_astcData->hdr = texture.type() == Texture::Type::UFloat;
+	m_astcData->srgb = image.colorSpace() == ColorSpace::sRGB;
+
 	astcenc_profile profile;
 	if (texture.type() == Texture::Type::UFloat)
 	{
@@ -171,33 +237,48 @@ AstcConverter::AstcConverter(const Texture& texture, const Image& image, unsigne
 	if (image.colorSpace() == ColorSpace::sRGB)
 		flags |= ASTCENC_FLG_USE_PERCEPTUAL;
 
-	float preset;
-	switch (quality)
+	astcenc_config_init(profile, blockX, blockY, 1, getPreset(quality), flags,
+		&m_astcData->config);
+	// Nearly constant blocks don't benefit from a more thorough search.
+	astcenc_config_init(profile, blockX, blockY, 1, ASTCENC_PRE_FASTEST, flags,
+		&m_astcData->uniformConfig);
+
+	m_astcData->adaptive = useAdaptiveQuality(texture, quality);
+	m_astcData->errorThreshold = 0.0f;
+	if (m_astcData->adaptive)
 	{
-		case Texture::Quality::Lowest:
-			preset = ASTCENC_PRE_FASTEST;
-			break;
-		case Texture::Quality::Low:
-			preset = ASTCENC_PRE_FAST;
-			break;
-		case Texture::Quality::Normal:
-			preset = ASTCENC_PRE_MEDIUM;
-			break;
-		case Texture::Quality::High:
-			preset = ASTCENC_PRE_THOROUGH;
-			break;
-		case Texture::Quality::Highest:
-			preset = ASTCENC_PRE_EXHAUSTIVE;
-			break;
-		default:
-			assert(false);
-			return;
+		astcenc_config_init(profile, blockX, blockY, 1, getPreset(texture.adaptiveFastQuality()),
+			flags, &m_astcData->fastConfig);
+		m_astcData->fastQuality = texture.adaptiveFastQuality();
+		m_astcData->errorThreshold = getAdaptiveErrorThreshold(texture);
 	}
-
-	astcenc_config_init(profile, blockX, blockY, 1, preset, flags, &m_astcData->config);
+	else
+		m_astcData->fastConfig = m_astcData->config;
+
+#if CUTTLEFISH_ISPC
+	// ispc_texcomp is much faster than astcenc at low quality levels, but only supports LDR with
+	// blocks up to 8x8.
+	if ((quality == Texture::Quality::Lowest || quality == Texture::Quality::Low) &&
+		!m_astcData->adaptive && texture.type() == Texture::Type::UNorm && blockX <= 8 &&
+		blockY <= 8)
+	{
+		m_astcData->ispcSettings.reset(new astc_enc_settings);
+		if (m_astcData->swizzle.a == ASTCENC_SWZ_A)
+		{
+			GetProfile_astc_alpha_fast(m_astcData->ispcSettings.get(), static_cast<int>(blockX),
+				static_cast<int>(blockY));
+		}
+		else
+		{
+			GetProfile_astc_fast(m_astcData->ispcSettings.get(), static_cast<int>(blockX),
+				static_cast<int>(blockY));
+		}
+		m_rowBatching = true;
+	}
+#endif
 
 	assert(texture.type() == Texture::Type::UNorm || texture.type() == Texture::Type::UFloat);
-	data().resize(m_jobsX*m_jobsY*blockSize);
+	setDataSize(m_jobsX*m_jobsY*blockSize);
 }
 
 AstcConverter::~AstcConverter()
@@ -207,31 +288,312 @@ AstcConverter::~AstcConverter()
 
 void AstcConverter::process(unsigned int x, unsigned int y, ThreadData* threadData)
 {
+	if (m_rowBatching)
+	{
+		assert(x == 0);
+		CUTTLEFISH_UNUSED(x);
+		processRow(y, static_cast<AstcThreadData*>(threadData));
+		return;
+	}
+
 	ColorRGBAf imageData[maxBlockDim*maxBlockDim];
 	void* imageRows[maxBlockDim];
+	loadBlock(imageData, x, y);
+	for (unsigned int j = 0; j < m_blockY; ++j)
+		imageRows[j] = imageData + j*m_blockX;
+
+	unsigned int blockIndex = y*m_jobsX + x;
+	auto block = data() + blockIndex*blockSize;
+	auto astcThreadData = static_cast<AstcThreadData*>(threadData);
+	astcenc_context* context = astcThreadData->context;
+	unsigned int pixelCount = m_blockX*m_blockY;
+
+	// Partial blocks are padded with the edge pixels, so the padded block fully determines the
+	// result.
+	bool useKey = needsBlockKeys();
+	BlockCache::Key key = {};
+	if (useKey)
+	{
+		key = BlockCache::computeKey(imageData, pixelCount*sizeof(ColorRGBAf));
+		if (findBlock(block, blockIndex, key, blockSize))
+			return;
+	}
+
+	bool encoded = false;
+	bool uniform = false;
+	if (getBlockRange(imageData, pixelCount, m_astcData->uniformMask) <=
+		nearConstantBlockThreshold)
+	{
+		encoded = encodeConstantBlock(block, imageData, pixelCount);
+		if (!encoded)
+		{
+			context = astcThreadData->uniformContext;
+			uniform = true;
+		}
+	}
+
+	if (!encoded)
+	{
+		astcThreadData->dummyImage.data = imageRows;
+		if (m_astcData->adaptive && !uniform)
+		{
+			astcenc_context* fastContext = astcThreadData->fastContext;
+			compressBlock(fastContext, astcThreadData->dummyImage, m_astcData->swizzle, block);
+			if (getBlockError(fastContext, block, imageData, pixelCount) >
+				m_astcData->errorThreshold)
+			{
+				compressBlock(context, astcThreadData->dummyImage, m_astcData->swizzle, block);
+				addRefinedBlock();
+			}
+		}
+		else
+			compressBlock(context, astcThreadData->dummyImage, m_astcData->swizzle, block);
+	}
+
+	if (useKey)
+		addBlock(block, key, blockSize);
+}
+
+void AstcConverter::loadBlock(ColorRGBAf* outPixels, unsigned int x, unsigned int y) const
+{
+	// Partial blocks are padded with the edge pixels.
 	for (unsigned int j = 0, index = 0; j < m_blockY; ++j)
 	{
-		imageRows[j] = imageData + index;
 		auto scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(
 			std::min(y*m_blockY + j, image().height() - 1)));
 		for (unsigned int i = 0; i < m_blockX; ++i, ++index)
+			outPixels[index] = scanline[std::min(x*m_blockX + i, image().width() - 1)];
+	}
+}
+
+void AstcConverter::processRow(unsigned int y, AstcThreadData* threadData)
+{
+	// Blocks are handled the same as process() before encoding, so the results don't depend on
+	// whether the blocks are tracked. Spans of the remaining blocks are then encoded together.
+	bool useKey = needsBlockKeys();
+	unsigned int pixelCount = m_blockX*m_blockY;
+	auto blocks = data() + y*m_jobsX*blockSize;
+	threadData->rowKeys.resize(m_jobsX);
+	threadData->rowPending.assign(m_jobsX, false);
+	bool anyPending = false;
+	for (unsigned int x = 0; x < m_jobsX; ++x)
+	{
+		ColorRGBAf imageData[maxBlockDim*maxBlockDim];
+		loadBlock(imageData, x, y);
+		auto block = blocks + x*blockSize;
+		if (useKey)
 		{
-			unsigned int scanlineIdx = std::min(x*m_blockX + i, image().width() - 1);
-			imageData[index] = scanline[scanlineIdx];
+			BlockCache::Key& key = threadData->rowKeys[x];
+			key = BlockCache::computeKey(imageData, pixelCount*sizeof(ColorRGBAf));
+			if (findBlock(block, y*m_jobsX + x, key, blockSize))
+				continue;
 		}
+
+		if (getBlockRange(imageData, pixelCount, m_astcData->uniformMask) <=
+				nearConstantBlockThreshold &&
+			encodeConstantBlock(block, imageData, pixelCount))
+		{
+			if (useKey)
+				addBlock(block, threadData->rowKeys[x], blockSize);
+			continue;
+		}
+
+		threadData->rowPending[x] = true;
+		anyPending = true;
 	}
 
-	auto block = data().data() + (y*m_jobsX + x)*blockSize;
-	auto astcThreadData = static_cast<AstcThreadData*>(threadData);
-	astcThreadData->dummyImage.data = imageRows;
-	astcenc_compress_image(astcThreadData->context, &astcThreadData->dummyImage,
-		&m_astcData->swizzle, block, blockSize, 0);
-	astcenc_compress_reset(astcThreadData->context);
+	if (!anyPending)
+		return;
+
+	for (unsigned int x = 0; x < m_jobsX;)
+	{
+		if (!threadData->rowPending[x])
+		{
+			++x;
+			continue;
+		}
+
+		unsigned int spanEnd = x + 1;
+		while (spanEnd < m_jobsX && threadData->rowPending[spanEnd])
+			++spanEnd;
+		encodeRowSpan(y, x, spanEnd - x, threadData);
+		if (useKey)
+		{
+			for (; x < spanEnd; ++x)
+				addBlock(blocks + x*blockSize, threadData->rowKeys[x], blockSize);
+		}
+		x = spanEnd;
+	}
+}
+
+void AstcConverter::encodeRowSpan(unsigned int y, unsigned int firstBlock, unsigned int blockCount,
+	AstcThreadData* threadData)
+{
+	// Pad the span with the edge pixels to match individual blocks.
+	unsigned int spanStart = firstBlock*m_blockX;
+	unsigned int spanWidth = blockCount*m_blockX;
+	auto blocks = data() + (y*m_jobsX + firstBlock)*blockSize;
+#if CUTTLEFISH_ISPC
+	if (m_astcData->ispcSettings)
+	{
+		// ispc_texcomp doesn't support swizzles, so apply them when converting to 8 bits.
+		const astcenc_swz swizzle[4] = {m_astcData->swizzle.r, m_astcData->swizzle.g,
+			m_astcData->swizzle.b, m_astcData->swizzle.a};
+		threadData->rowData8.resize(spanWidth*m_blockY*4);
+		for (unsigned int j = 0; j < m_blockY; ++j)
+		{
+			std::uint8_t* row = threadData->rowData8.data() + j*spanWidth*4;
+			auto scanline = reinterpret_cast<const float*>(image().scanline(
+				std::min(y*m_blockY + j, image().height() - 1)));
+			for (unsigned int i = 0; i < spanWidth; ++i)
+			{
+				const float* pixel = scanline + std::min(spanStart + i, image().width() - 1)*4;
+				for (unsigned int c = 0; c < 4; ++c)
+				{
+					if (swizzle[c] == ASTCENC_SWZ_0)
+						row[i*4 + c] = 0;
+					else if (swizzle[c] == ASTCENC_SWZ_1)
+						row[i*4 + c] = 0xFF;
+					else
+					{
+						row[i*4 + c] = static_cast<std::uint8_t>(
+							std::round(clamp(pixel[c], 0.0f, 1.0f)*0xFF));
+					}
+				}
+			}
+		}
+
+		rgba_surface surface = {threadData->rowData8.data(), static_cast<std::int32_t>(spanWidth),
+			static_cast<std::int32_t>(m_blockY), static_cast<std::int32_t>(spanWidth*4)};
+		CompressBlocksASTC(&surface, blocks, m_astcData->ispcSettings.get());
+		return;
+	}
+#endif
+
+	threadData->rowData.resize(spanWidth*m_blockY);
+	threadData->rowPointers.resize(m_blockY);
+	for (unsigned int j = 0; j < m_blockY; ++j)
+	{
+		ColorRGBAf* row = threadData->rowData.data() + j*spanWidth;
+		threadData->rowPointers[j] = row;
+		auto scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(
+			std::min(y*m_blockY + j, image().height() - 1)));
+		for (unsigned int i = 0; i < spanWidth; ++i)
+			row[i] = scanline[std::min(spanStart + i, image().width() - 1)];
+	}
+
+	astcenc_image rowImage;
+	rowImage.dim_x = spanWidth;
+	rowImage.dim_y = m_blockY;
+	rowImage.dim_z = 1;
+	rowImage.data_type = ASTCENC_TYPE_F32;
+	rowImage.data = threadData->rowPointers.data();
+
+	astcenc_compress_image(threadData->context, &rowImage, &m_astcData->swizzle, blocks,
+		blockCount*blockSize, 0);
+	astcenc_compress_reset(threadData->context);
 }
 
 std::unique_ptr<Converter::ThreadData> AstcConverter::createThreadData()
 {
-	return std::unique_ptr<ThreadData>(new AstcThreadData(m_blockX, m_blockY, m_astcData->config));
+	return std::unique_ptr<ThreadData>(new AstcThreadData(m_blockX, m_blockY, *m_astcData));
+}
+
+float AstcConverter::getBlockError(astcenc_context* context, const std::uint8_t* block,
+	const ColorRGBAf* pixels, unsigned int pixelCount)
+{
+	ColorRGBAf decodedData[maxBlockDim*maxBlockDim];
+	void* decodedRows[maxBlockDim];
+	for (unsigned int j = 0; j < m_blockY; ++j)
+		decodedRows[j] = decodedData + j*m_blockX;
+
+	astcenc_image decodedImage;
+	decodedImage.dim_x = m_blockX;
+	decodedImage.dim_y = m_blockY;
+	decodedImage.dim_z = 1;
+	decodedImage.data_type = ASTCENC_TYPE_F32;
+	decodedImage.data = decodedRows;
+
+	// The swizzle was applied when encoding, so decode the channels as-is and apply the swizzle
+	// to the original pixels instead.
+	const astcenc_swizzle identitySwizzle = {ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B,
+		ASTCENC_SWZ_A};
+	astcenc_decompress_image(context, block, blockSize, &decodedImage, &identitySwizzle, 0);
+	astcenc_decompress_reset(context);
+
+	ColorRGBAf colors[maxBlockDim*maxBlockDim];
+	const astcenc_swz swizzle[4] = {m_astcData->swizzle.r, m_astcData->swizzle.g,
+		m_astcData->swizzle.b, m_astcData->swizzle.a};
+	for (unsigned int i = 0; i < pixelCount; ++i)
+	{
+		auto pixel = reinterpret_cast<const float*>(pixels + i);
+		auto color = reinterpret_cast<float*>(colors + i);
+		auto decodedColor = reinterpret_cast<float*>(decodedData + i);
+		for (unsigned int c = 0; c < 4; ++c)
+		{
+			if (swizzle[c] == ASTCENC_SWZ_0)
+				color[c] = 0.0f;
+			else if (swizzle[c] == ASTCENC_SWZ_1)
+				color[c] = 1.0f;
+			else if (m_astcData->hdr)
+				color[c] = std::max(pixel[c], 0.0f);
+			else
+				color[c] = clamp(pixel[c], 0.0f, 1.0f);
+
+			// HDR values are measured in log scale so the error is relative to the magnitude.
+			if (m_astcData->hdr)
+			{
+				color[c] = toLogScale(color[c]);
+				decodedColor[c] = toLogScale(decodedColor[c]);
+			}
+		}
+	}
+
+	return cuttlefish::getBlockError(colors, decodedData, pixelCount, m_astcData->uniformMask);
+}
+
+bool AstcConverter::encodeConstantBlock(void* block, const ColorRGBAf* pixels,
+	unsigned int pixelCount)
+{
+	// Apply the swizzle from the color mask and alpha type before quantizing. This matches the
+	// void-extent block astcenc would produce for a constant block.
+	std::uint16_t colors[maxBlockDim*maxBlockDim][4];
+	const astcenc_swz swizzle[4] = {m_astcData->swizzle.r, m_astcData->swizzle.g,
+		m_astcData->swizzle.b, m_astcData->swizzle.a};
+	for (unsigned int i = 0; i < pixelCount; ++i)
+	{
+		auto pixel = reinterpret_cast<const float*>(pixels + i);
+		for (unsigned int c = 0; c < 4; ++c)
+		{
+			float value;
+			if (swizzle[c] == ASTCENC_SWZ_0)
+				value = 0.0f;
+			else if (swizzle[c] == ASTCENC_SWZ_1)
+				value = 1.0f;
+			else
+				value = pixel[c];
+
+			if (m_astcData->hdr)
+				colors[i][c] = glm::packHalf1x16(std::max(value, 0.0f));
+			else if (m_astcData->srgb)
+			{
+				// sRGB decoding only uses the upper 8 bits.
+				auto value8 = static_cast<std::uint16_t>(std::round(clamp(value, 0.0f, 1.0f)*0xFF));
+				colors[i][c] = static_cast<std::uint16_t>(value8*0x101);
+			}
+			else
+			{
+				colors[i][c] =
+					static_cast<std::uint16_t>(std::round(clamp(value, 0.0f, 1.0f)*0xFFFF));
+			}
+		}
+	}
+
+	if (!isBlockConstant(colors[0], pixelCount, 4, 4))
+		return false;
+
+	encodeConstantAstc(block, colors[0], m_astcData->hdr);
+	return true;
 }
 
 } // namespace cuttlefish
@@ -22,6 +22,8 @@
 
 #if CUTTLEFISH_HAS_ASTC
 
+struct astcenc_context;
+
 namespace cuttlefish
 {
 
@@ -32,7 +34,9 @@ public:
 		unsigned int blockY, Texture::Quality quality);
 	~AstcConverter();
 
-	unsigned int jobsX() const override {return m_jobsX;}
+	// Preview quality and ispc_texcomp encode a full row of blocks at a time, reducing the
+	// per-call overhead.
+	unsigned int jobsX() const override {return m_rowBatching ? 1 : m_jobsX;}
 	unsigned int jobsY() const override {return m_jobsY;}
 	void process(unsigned int x, unsigned int y, ThreadData* threadData) override;
 	std::unique_ptr<ThreadData> createThreadData() override;
@@ -41,10 +45,19 @@ private:
 	struct AstcData;
 	class AstcThreadData;
 
+	void loadBlock(ColorRGBAf* outPixels, unsigned int x, unsigned int y) const;
+	void processRow(unsigned int y, AstcThreadData* threadData);
+	void encodeRowSpan(unsigned int y, unsigned int firstBlock, unsigned int blockCount,
+		AstcThreadData* threadData);
+	bool encodeConstantBlock(void* block, const ColorRGBAf* pixels, unsigned int pixelCount);
+	float getBlockError(astcenc_context* context, const std::uint8_t* block,
+		const ColorRGBAf* pixels, unsigned int pixelCount);
+
 	unsigned int m_blockX;
 	unsigned int m_blockY;
 	unsigned int m_jobsX;
 	unsigned int m_jobsY;
+	bool m_rowBatching;
 	AstcData* m_astcData;
 };
 
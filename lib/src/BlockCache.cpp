@@ -0,0 +1,105 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BlockCache.h"
+#include <cassert>
+#include <cstring>
+
+namespace cuttlefish
+{
+
+static std::uint64_t rotateLeft(std::uint64_t value, unsigned int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static std::uint64_t finalizeHash(std::uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+BlockCache::Key BlockCache::computeKey(const void* data, std::size_t size, std::uint64_t seed)
+{
+	// Two independent lanes with different multipliers to form a 128-bit hash.
+	const std::uint64_t prime0 = 0x9E3779B185EBCA87ULL;
+	const std::uint64_t prime1 = 0xC2B2AE3D27D4EB4FULL;
+	std::uint64_t hash0 = seed ^ prime0;
+	std::uint64_t hash1 = rotateLeft(seed, 32) ^ prime1;
+
+	auto bytes = reinterpret_cast<const std::uint8_t*>(data);
+	std::size_t wordCount = size/sizeof(std::uint64_t);
+	for (std::size_t i = 0; i < wordCount; ++i)
+	{
+		std::uint64_t word;
+		std::memcpy(&word, bytes + i*sizeof(std::uint64_t), sizeof(std::uint64_t));
+		hash0 = rotateLeft(hash0 ^ (word*prime1), 31)*prime0;
+		hash1 = rotateLeft(hash1 + (word*prime0), 27)*prime1 + hash0;
+	}
+
+	std::size_t remaining = size - wordCount*sizeof(std::uint64_t);
+	if (remaining > 0)
+	{
+		std::uint64_t word = 0;
+		std::memcpy(&word, bytes + wordCount*sizeof(std::uint64_t), remaining);
+		hash0 = rotateLeft(hash0 ^ (word*prime1), 31)*prime0;
+		hash1 = rotateLeft(hash1 + (word*prime0), 27)*prime1 + hash0;
+	}
+
+	Key key;
+	key.hash[0] = finalizeHash(hash0 ^ size);
+	key.hash[1] = finalizeHash(hash1 + size);
+	return key;
+}
+
+BlockCache::BlockCache()
+	: m_lookups(0), m_hits(0)
+{
+}
+
+bool BlockCache::find(void* outBlock, const Key& key, unsigned int blockSize)
+{
+	assert(blockSize <= maxBlockSize);
+	++m_lookups;
+
+	Shard& shard = getShard(key);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto foundIter = shard.blocks.find(key);
+	if (foundIter == shard.blocks.end())
+		return false;
+
+	std::memcpy(outBlock, foundIter->second.data(), blockSize);
+	++m_hits;
+	return true;
+}
+
+void BlockCache::insert(const Key& key, const void* block, unsigned int blockSize)
+{
+	assert(blockSize <= maxBlockSize);
+	Block cachedBlock = {};
+	std::memcpy(cachedBlock.data(), block, blockSize);
+
+	// If multiple threads encoded the same block, they will have produced the same result.
+	Shard& shard = getShard(key);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	shard.blocks.emplace(key, cachedBlock);
+}
+
+} // namespace cuttlefish
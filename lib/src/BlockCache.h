@@ -0,0 +1,130 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Export.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace cuttlefish
+{
+
+/**
+ * @brief Cache of encoded blocks keyed by the contents of the source pixels.
+ *
+ * This is shared across all images of a texture so duplicate blocks are only encoded once. The
+ * key is a 128-bit hash of the source pixels, which is large enough that collisions aren't a
+ * practical concern. Since the encoders produce the same output for the same input, the results
+ * are deterministic regardless of which thread encodes a block first.
+ *
+ * The cache is split into shards with separate locks to reduce contention between threads.
+ */
+class CUTTLEFISH_EXPORT BlockCache
+{
+public:
+	static const unsigned int maxBlockSize = 16;
+
+	struct Key
+	{
+		std::uint64_t hash[2];
+
+		bool operator==(const Key& other) const
+		{
+			return hash[0] == other.hash[0] && hash[1] == other.hash[1];
+		}
+	};
+
+	/**
+	 * @brief Computes the key for a block.
+	 * @param data The source data for the block.
+	 * @param size The size of the data in bytes.
+	 * @param seed Extra value to distinguish blocks with the same data, such as the dimensions of
+	 *     partial blocks.
+	 * @return The key.
+	 */
+	static Key computeKey(const void* data, std::size_t size, std::uint64_t seed = 0);
+
+	BlockCache();
+
+	BlockCache(const BlockCache&) = delete;
+	BlockCache& operator=(const BlockCache&) = delete;
+
+	/**
+	 * @brief Finds an encoded block.
+	 * @param[out] outBlock The block to copy the encoded data to.
+	 * @param key The key for the block.
+	 * @param blockSize The size of the encoded block.
+	 * @return True if the block was found.
+	 */
+	bool find(void* outBlock, const Key& key, unsigned int blockSize);
+
+	/**
+	 * @brief Inserts an encoded block.
+	 * @param key The key for the block.
+	 * @param block The encoded block.
+	 * @param blockSize The size of the encoded block.
+	 */
+	void insert(const Key& key, const void* block, unsigned int blockSize);
+
+	/**
+	 * @brief Gets the number of blocks that were looked up.
+	 * @return The number of lookups.
+	 */
+	std::size_t lookups() const {return m_lookups;}
+
+	/**
+	 * @brief Gets the number of blocks that were found in the cache.
+	 * @return The number of hits.
+	 */
+	std::size_t hits() const {return m_hits;}
+
+private:
+	struct KeyHash
+	{
+		std::size_t operator()(const Key& key) const
+		{
+			return static_cast<std::size_t>(key.hash[0]);
+		}
+	};
+
+	using Block = std::array<std::uint8_t, maxBlockSize>;
+
+	struct Shard
+	{
+		std::mutex mutex;
+		std::unordered_map<Key, Block, KeyHash> blocks;
+	};
+
+	static const unsigned int shardCount = 64;
+
+	Shard& getShard(const Key& key)
+	{
+		// Use the upper bits since the lower bits are used for the hash map buckets.
+		return m_shards[(key.hash[0] >> 58) % shardCount];
+	}
+
+	Shard m_shards[shardCount];
+	std::atomic<std::size_t> m_lookups;
+	std::atomic<std::size_t> m_hits;
+};
+
+} // namespace cuttlefish
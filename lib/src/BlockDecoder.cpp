@@ -0,0 +1,790 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BlockDecoder.h"
+#include "EtcTables.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+const unsigned int blockPixels = 16;
+
+// Reads bits starting from the least significant bit of the first byte, as used by BC6H and BC7.
+class BitReader
+{
+public:
+	explicit BitReader(const void* block)
+		: m_block(reinterpret_cast<const std::uint8_t*>(block)), m_position(0)
+	{
+	}
+
+	std::uint32_t read(unsigned int bits)
+	{
+		std::uint32_t value = 0;
+		for (unsigned int i = 0; i < bits; ++i, ++m_position)
+			value |= ((m_block[m_position >> 3] >> (m_position & 0x7)) & 0x1U) << i;
+		return value;
+	}
+
+private:
+	const std::uint8_t* m_block;
+	unsigned int m_position;
+};
+
+std::uint16_t readLittleEndian16(const std::uint8_t* bytes)
+{
+	return static_cast<std::uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+std::uint8_t expandBits(std::uint32_t value, unsigned int bits)
+{
+	return static_cast<std::uint8_t>((value << (8 - bits)) | (value >> (2*bits - 8)));
+}
+
+std::uint8_t interpolate(unsigned int first, unsigned int second, unsigned int firstWeight,
+	unsigned int secondWeight, unsigned int divisor)
+{
+	return static_cast<std::uint8_t>(
+		(first*firstWeight + second*secondWeight + divisor/2)/divisor);
+}
+
+// Reads the 3-bit indices for a BC4 block.
+void readBc4Indices(unsigned int outIndices[blockPixels], const std::uint8_t* block)
+{
+	std::uint64_t bits = 0;
+	for (unsigned int i = 0; i < 6; ++i)
+		bits |= static_cast<std::uint64_t>(block[i + 2]) << (i*8);
+
+	for (unsigned int i = 0; i < blockPixels; ++i)
+		outIndices[i] = static_cast<unsigned int>((bits >> (i*3)) & 0x7);
+}
+
+// BC7 mode layouts.
+struct Bc7Mode
+{
+	unsigned int subsets;
+	unsigned int partitionBits;
+	unsigned int rotationBits;
+	unsigned int indexSelectionBits;
+	unsigned int colorBits;
+	unsigned int alphaBits;
+	unsigned int endpointPBits;
+	unsigned int sharedPBits;
+	unsigned int indexBits;
+	unsigned int secondaryIndexBits;
+};
+
+const Bc7Mode bc7Modes[8] =
+{
+	{3, 4, 0, 0, 4, 0, 1, 0, 3, 0},
+	{2, 6, 0, 0, 6, 0, 0, 1, 3, 0},
+	{3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+	{2, 6, 0, 0, 7, 0, 1, 0, 2, 0},
+	{1, 0, 2, 1, 5, 6, 0, 0, 2, 3},
+	{1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+	{1, 0, 0, 0, 7, 7, 1, 0, 4, 0},
+	{2, 6, 0, 0, 5, 5, 1, 0, 2, 0}
+};
+
+// Bit masks for the pixels that belong to the second subset for 2 subset partitions.
+const std::uint16_t bc7Partitions2[64] =
+{
+	0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+	0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+	0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+	0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+	0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+	0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+	0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+	0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+};
+
+// Subset for each pixel for 3 subset partitions.
+const std::uint8_t bc7Partitions3[64][blockPixels] =
+{
+	{0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2},
+	{0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+	{0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+	{0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+	{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2},
+	{0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+	{0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1},
+	{0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+	{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2},
+	{0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+	{0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+	{0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+	{0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2},
+	{0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+	{0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+	{0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+	{0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2},
+	{0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+	{0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2},
+	{0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+	{0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2},
+	{0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+	{0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2},
+	{0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+	{0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0},
+	{0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+	{0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0},
+	{0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+	{0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2},
+	{0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+	{0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1},
+	{0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+	{0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2},
+	{0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+	{0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2},
+	{0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+	{0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0},
+	{0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+	{0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0},
+	{0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+	{0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1},
+	{0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+	{0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1},
+	{0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+	{0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1},
+	{0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+	{0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1},
+	{0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+	{0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2},
+	{0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+	{0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2},
+	{0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+	{0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2},
+	{0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+	{0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2},
+	{0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+	{0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2},
+	{0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+	{0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2},
+	{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+	{0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1},
+	{0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+	{0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
+	{0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0}
+};
+
+// Anchor index for the second subset of 2 subset partitions.
+const std::uint8_t bc7Anchors2[64] =
+{
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+	15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+	6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+};
+
+// Anchor indices for the second and third subsets of 3 subset partitions.
+const std::uint8_t bc7Anchors3Second[64] =
+{
+	3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+	3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+	8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+	3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3
+};
+
+const std::uint8_t bc7Anchors3Third[64] =
+{
+	15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+	15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+	15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+	15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8
+};
+
+const unsigned int bc7Weights2[4] = {0, 21, 43, 64};
+const unsigned int bc7Weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+const unsigned int bc7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+unsigned int getBc7Weight(unsigned int index, unsigned int bits)
+{
+	switch (bits)
+	{
+		case 2:
+			return bc7Weights2[index];
+		case 3:
+			return bc7Weights3[index];
+		default:
+			return bc7Weights4[index];
+	}
+}
+
+unsigned int getBc7Subset(unsigned int subsets, unsigned int partition, unsigned int pixel)
+{
+	switch (subsets)
+	{
+		case 2:
+			return (bc7Partitions2[partition] >> pixel) & 0x1;
+		case 3:
+			return bc7Partitions3[partition][pixel];
+		default:
+			return 0;
+	}
+}
+
+bool isBc7Anchor(unsigned int subsets, unsigned int partition, unsigned int pixel)
+{
+	if (pixel == 0)
+		return true;
+
+	switch (subsets)
+	{
+		case 2:
+			return pixel == bc7Anchors2[partition];
+		case 3:
+			return pixel == bc7Anchors3Second[partition] || pixel == bc7Anchors3Third[partition];
+		default:
+			return false;
+	}
+}
+
+void readBc7Indices(unsigned int outIndices[blockPixels], BitReader& reader, unsigned int bits,
+	unsigned int subsets, unsigned int partition)
+{
+	// Anchor pixels implicitly have the most significant index bit set to 0.
+	for (unsigned int i = 0; i < blockPixels; ++i)
+		outIndices[i] = reader.read(isBc7Anchor(subsets, partition, i) ? bits - 1 : bits);
+}
+
+// Reads the 64-bit big-endian value used by ETC and EAC blocks.
+std::uint64_t readBigEndian64(const std::uint8_t* bytes)
+{
+	std::uint64_t value = 0;
+	for (unsigned int i = 0; i < 8; ++i)
+		value = (value << 8) | bytes[i];
+	return value;
+}
+
+int getBits(std::uint64_t value, unsigned int shift, unsigned int count)
+{
+	return static_cast<int>((value >> shift) & ((1U << count) - 1));
+}
+
+std::uint8_t clampByte(int value)
+{
+	return static_cast<std::uint8_t>(std::min(std::max(value, 0), 0xFF));
+}
+
+// ETC and EAC store the pixels in column-major order, while the decoded colors are row-major.
+unsigned int getEtcPixel(unsigned int index)
+{
+	return (index & 0x3)*4 + (index >> 2);
+}
+
+unsigned int getEtcSelector(std::uint64_t bits, unsigned int index)
+{
+	return static_cast<unsigned int>(((bits >> (index + 15)) & 0x2) | ((bits >> index) & 0x1));
+}
+
+void setColor(std::uint8_t outColor[4], const int color[3], int offset, std::uint8_t alpha)
+{
+	for (unsigned int c = 0; c < 3; ++c)
+		outColor[c] = clampByte(color[c] + offset);
+	outColor[3] = alpha;
+}
+
+// Decodes the paint colors for the ETC2 T and H modes, where the selector chooses the color
+// directly. Selector 2 is transparent for punch-through alpha blocks that aren't opaque.
+void decodeEtc2Paint(std::uint8_t outColors[16][4], std::uint64_t bits, const int paint[4][3],
+	bool opaque)
+{
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		unsigned int selector = getEtcSelector(bits, i);
+		std::uint8_t* color = outColors[getEtcPixel(i)];
+		if (!opaque && selector == 2)
+			std::memset(color, 0, 4);
+		else
+			setColor(color, paint[selector], 0, 0xFF);
+	}
+}
+
+void decodeEtc2T(std::uint8_t outColors[16][4], std::uint64_t bits, bool opaque)
+{
+	int first[3] =
+	{
+		((getBits(bits, 59, 2) << 2) | getBits(bits, 56, 2))*17, getBits(bits, 52, 4)*17,
+		getBits(bits, 48, 4)*17
+	};
+	int second[3] = {getBits(bits, 44, 4)*17, getBits(bits, 40, 4)*17, getBits(bits, 36, 4)*17};
+	int distance = etc2Distances[(getBits(bits, 34, 2) << 1) | getBits(bits, 32, 1)];
+
+	int paint[4][3];
+	for (unsigned int c = 0; c < 3; ++c)
+	{
+		paint[0][c] = first[c];
+		paint[1][c] = second[c] + distance;
+		paint[2][c] = second[c];
+		paint[3][c] = second[c] - distance;
+	}
+	decodeEtc2Paint(outColors, bits, paint, opaque);
+}
+
+void decodeEtc2H(std::uint8_t outColors[16][4], std::uint64_t bits, bool opaque)
+{
+	int first[3] =
+	{
+		getBits(bits, 59, 4), (getBits(bits, 56, 3) << 1) | getBits(bits, 52, 1),
+		(getBits(bits, 51, 1) << 3) | getBits(bits, 47, 3)
+	};
+	int second[3] = {getBits(bits, 43, 4), getBits(bits, 39, 4), getBits(bits, 35, 4)};
+	int firstValue = (first[0] << 8) | (first[1] << 4) | first[2];
+	int secondValue = (second[0] << 8) | (second[1] << 4) | second[2];
+	int distance = etc2Distances[(getBits(bits, 34, 1) << 2) | (getBits(bits, 32, 1) << 1) |
+		(firstValue >= secondValue)];
+
+	int paint[4][3];
+	for (unsigned int c = 0; c < 3; ++c)
+	{
+		paint[0][c] = first[c]*17 + distance;
+		paint[1][c] = first[c]*17 - distance;
+		paint[2][c] = second[c]*17 + distance;
+		paint[3][c] = second[c]*17 - distance;
+	}
+	decodeEtc2Paint(outColors, bits, paint, opaque);
+}
+
+void decodeEtc2Planar(std::uint8_t outColors[16][4], std::uint64_t bits)
+{
+	int origin[3] =
+	{
+		expandBits(static_cast<std::uint32_t>(getBits(bits, 57, 6)), 6),
+		expandBits(static_cast<std::uint32_t>((getBits(bits, 56, 1) << 6) | getBits(bits, 49, 6)),
+			7),
+		expandBits(static_cast<std::uint32_t>((getBits(bits, 48, 1) << 5) |
+			(getBits(bits, 43, 2) << 3) | getBits(bits, 39, 3)), 6)
+	};
+	int horizontal[3] =
+	{
+		expandBits(static_cast<std::uint32_t>((getBits(bits, 34, 5) << 1) | getBits(bits, 32, 1)),
+			6),
+		expandBits(static_cast<std::uint32_t>(getBits(bits, 25, 7)), 7),
+		expandBits(static_cast<std::uint32_t>(getBits(bits, 19, 6)), 6)
+	};
+	int vertical[3] =
+	{
+		expandBits(static_cast<std::uint32_t>(getBits(bits, 13, 6)), 6),
+		expandBits(static_cast<std::uint32_t>(getBits(bits, 6, 7)), 7),
+		expandBits(static_cast<std::uint32_t>(getBits(bits, 0, 6)), 6)
+	};
+
+	for (int y = 0; y < 4; ++y)
+	{
+		for (int x = 0; x < 4; ++x)
+		{
+			std::uint8_t* color = outColors[y*4 + x];
+			for (unsigned int c = 0; c < 3; ++c)
+			{
+				int value = x*(horizontal[c] - origin[c]) + y*(vertical[c] - origin[c]) +
+					4*origin[c] + 2;
+				color[c] = clampByte(std::max(value, 0) >> 2);
+			}
+			color[3] = 0xFF;
+		}
+	}
+}
+
+// Reads the base, multiplier, and modifier table for an EAC block.
+std::uint64_t readEacBlock(int& outBase, int& outMultiplier, const int*& outModifiers,
+	const std::uint8_t* bytes)
+{
+	outBase = bytes[0];
+	outMultiplier = bytes[1] >> 4;
+	outModifiers = eacModifiers[bytes[1] & 0xF];
+	return readBigEndian64(bytes);
+}
+
+unsigned int getEacIndex(std::uint64_t bits, unsigned int index)
+{
+	return static_cast<unsigned int>((bits >> (45 - index*3)) & 0x7);
+}
+
+} // namespace
+
+float getBlockError(const ColorRGBAf* colors, const ColorRGBAf* decodedColors,
+	unsigned int count, const Texture::ColorMask& colorMask)
+{
+	const bool mask[4] = {colorMask.r, colorMask.g, colorMask.b, colorMask.a};
+	unsigned int channelCount = 0;
+	for (unsigned int c = 0; c < 4; ++c)
+	{
+		if (mask[c])
+			++channelCount;
+	}
+
+	if (count == 0 || channelCount == 0)
+		return 0.0f;
+
+	float errorSum = 0.0f;
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		auto color = reinterpret_cast<const float*>(colors + i);
+		auto decodedColor = reinterpret_cast<const float*>(decodedColors + i);
+		for (unsigned int c = 0; c < 4; ++c)
+		{
+			if (!mask[c])
+				continue;
+
+			float diff = color[c] - decodedColor[c];
+			errorSum += diff*diff;
+		}
+	}
+
+	return std::sqrt(errorSum/static_cast<float>(count*channelCount));
+}
+
+void decodeBc1(std::uint8_t outColors[16][4], const void* block, bool allowTransparent)
+{
+	auto bytes = reinterpret_cast<const std::uint8_t*>(block);
+	std::uint16_t endpoints[2] = {readLittleEndian16(bytes), readLittleEndian16(bytes + 2)};
+
+	std::uint8_t palette[4][4];
+	for (unsigned int i = 0; i < 2; ++i)
+	{
+		palette[i][0] = expandBits(endpoints[i] >> 11, 5);
+		palette[i][1] = expandBits((endpoints[i] >> 5) & 0x3F, 6);
+		palette[i][2] = expandBits(endpoints[i] & 0x1F, 5);
+		palette[i][3] = 0xFF;
+	}
+
+	if (endpoints[0] > endpoints[1] || !allowTransparent)
+	{
+		for (unsigned int c = 0; c < 3; ++c)
+		{
+			palette[2][c] = interpolate(palette[0][c], palette[1][c], 2, 1, 3);
+			palette[3][c] = interpolate(palette[0][c], palette[1][c], 1, 2, 3);
+		}
+		palette[2][3] = 0xFF;
+		palette[3][3] = 0xFF;
+	}
+	else
+	{
+		for (unsigned int c = 0; c < 3; ++c)
+			palette[2][c] = interpolate(palette[0][c], palette[1][c], 1, 1, 2);
+		palette[2][3] = 0xFF;
+		std::memset(palette[3], 0, sizeof(palette[3]));
+	}
+
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		unsigned int index = (bytes[4 + i/4] >> ((i % 4)*2)) & 0x3;
+		std::memcpy(outColors[i], palette[index], sizeof(palette[index]));
+	}
+}
+
+void decodeBc2(std::uint8_t outColors[16][4], const void* block)
+{
+	auto bytes = reinterpret_cast<const std::uint8_t*>(block);
+	decodeBc1(outColors, bytes + 8, false);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		auto alpha = static_cast<std::uint8_t>((bytes[i/2] >> ((i % 2)*4)) & 0xF);
+		outColors[i][3] = static_cast<std::uint8_t>(alpha | (alpha << 4));
+	}
+}
+
+void decodeBc3(std::uint8_t outColors[16][4], const void* block)
+{
+	auto bytes = reinterpret_cast<const std::uint8_t*>(block);
+	decodeBc1(outColors, bytes + 8, false);
+	decodeBc4(outColors[0] + 3, bytes, 4);
+}
+
+void decodeBc4(std::uint8_t* outValues, const void* block, unsigned int stride)
+{
+	auto bytes = reinterpret_cast<const std::uint8_t*>(block);
+	unsigned int palette[8] = {bytes[0], bytes[1]};
+	if (palette[0] > palette[1])
+	{
+		for (unsigned int i = 1; i < 7; ++i)
+			palette[i + 1] = interpolate(palette[0], palette[1], 7 - i, i, 7);
+	}
+	else
+	{
+		for (unsigned int i = 1; i < 5; ++i)
+			palette[i + 1] = interpolate(palette[0], palette[1], 5 - i, i, 5);
+		palette[6] = 0;
+		palette[7] = 0xFF;
+	}
+
+	unsigned int indices[blockPixels];
+	readBc4Indices(indices, bytes);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+		outValues[i*stride] = static_cast<std::uint8_t>(palette[indices[i]]);
+}
+
+void decodeBc4S(std::int8_t* outValues, const void* block, unsigned int stride)
+{
+	auto bytes = reinterpret_cast<const std::uint8_t*>(block);
+	// -128 is treated the same as -127.
+	int palette[8] =
+	{
+		std::max(static_cast<int>(static_cast<std::int8_t>(bytes[0])), -127),
+		std::max(static_cast<int>(static_cast<std::int8_t>(bytes[1])), -127)
+	};
+
+	// Interpolate in the unsigned range to keep the rounding the same as unsigned values.
+	auto first = static_cast<unsigned int>(palette[0] + 127);
+	auto second = static_cast<unsigned int>(palette[1] + 127);
+	if (palette[0] > palette[1])
+	{
+		for (unsigned int i = 1; i < 7; ++i)
+			palette[i + 1] = interpolate(first, second, 7 - i, i, 7) - 127;
+	}
+	else
+	{
+		for (unsigned int i = 1; i < 5; ++i)
+			palette[i + 1] = interpolate(first, second, 5 - i, i, 5) - 127;
+		palette[6] = -127;
+		palette[7] = 127;
+	}
+
+	unsigned int indices[blockPixels];
+	readBc4Indices(indices, bytes);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+		outValues[i*stride] = static_cast<std::int8_t>(palette[indices[i]]);
+}
+
+void decodeBc7(std::uint8_t outColors[16][4], const void* block)
+{
+	auto bytes = reinterpret_cast<const std::uint8_t*>(block);
+	unsigned int modeIndex = 0;
+	while (modeIndex < 8 && !(bytes[0] & (1 << modeIndex)))
+		++modeIndex;
+
+	if (modeIndex == 8)
+	{
+		std::memset(outColors, 0, sizeof(std::uint8_t)*blockPixels*4);
+		return;
+	}
+
+	const Bc7Mode& mode = bc7Modes[modeIndex];
+	BitReader reader(block);
+	reader.read(modeIndex + 1);
+	unsigned int partition = reader.read(mode.partitionBits);
+	unsigned int rotation = reader.read(mode.rotationBits);
+	unsigned int indexSelection = reader.read(mode.indexSelectionBits);
+
+	const unsigned int maxEndpoints = 6;
+	unsigned int endpointCount = mode.subsets*2;
+	unsigned int endpoints[maxEndpoints][4];
+	for (unsigned int c = 0; c < 3; ++c)
+	{
+		for (unsigned int i = 0; i < endpointCount; ++i)
+			endpoints[i][c] = reader.read(mode.colorBits);
+	}
+
+	for (unsigned int i = 0; i < endpointCount; ++i)
+		endpoints[i][3] = reader.read(mode.alphaBits);
+
+	// P-bits are added as the least significant bit of each channel.
+	unsigned int colorBits = mode.colorBits;
+	unsigned int alphaBits = mode.alphaBits;
+	if (mode.endpointPBits || mode.sharedPBits)
+	{
+		unsigned int pBits[maxEndpoints];
+		if (mode.endpointPBits)
+		{
+			for (unsigned int i = 0; i < endpointCount; ++i)
+				pBits[i] = reader.read(1);
+		}
+		else
+		{
+			for (unsigned int i = 0; i < mode.subsets; ++i)
+				pBits[i*2] = pBits[i*2 + 1] = reader.read(1);
+		}
+
+		for (unsigned int i = 0; i < endpointCount; ++i)
+		{
+			for (unsigned int c = 0; c < 4; ++c)
+				endpoints[i][c] = (endpoints[i][c] << 1) | pBits[i];
+		}
+
+		++colorBits;
+		if (alphaBits > 0)
+			++alphaBits;
+	}
+
+	for (unsigned int i = 0; i < endpointCount; ++i)
+	{
+		for (unsigned int c = 0; c < 3; ++c)
+			endpoints[i][c] = expandBits(endpoints[i][c], colorBits);
+		endpoints[i][3] = alphaBits > 0 ? expandBits(endpoints[i][3], alphaBits) : 0xFF;
+	}
+
+	unsigned int indices[blockPixels];
+	readBc7Indices(indices, reader, mode.indexBits, mode.subsets, partition);
+
+	unsigned int secondaryIndices[blockPixels];
+	if (mode.secondaryIndexBits)
+		readBc7Indices(secondaryIndices, reader, mode.secondaryIndexBits, 1, 0);
+
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		unsigned int subset = getBc7Subset(mode.subsets, partition, i);
+		const unsigned int* first = endpoints[subset*2];
+		const unsigned int* second = endpoints[subset*2 + 1];
+
+		unsigned int colorWeight, alphaWeight;
+		if (mode.secondaryIndexBits)
+		{
+			if (indexSelection)
+			{
+				colorWeight = getBc7Weight(secondaryIndices[i], mode.secondaryIndexBits);
+				alphaWeight = getBc7Weight(indices[i], mode.indexBits);
+			}
+			else
+			{
+				colorWeight = getBc7Weight(indices[i], mode.indexBits);
+				alphaWeight = getBc7Weight(secondaryIndices[i], mode.secondaryIndexBits);
+			}
+		}
+		else
+			colorWeight = alphaWeight = getBc7Weight(indices[i], mode.indexBits);
+
+		for (unsigned int c = 0; c < 3; ++c)
+			outColors[i][c] = interpolate(first[c], second[c], 64 - colorWeight, colorWeight, 64);
+		outColors[i][3] = interpolate(first[3], second[3], 64 - alphaWeight, alphaWeight, 64);
+
+		if (rotation > 0)
+			std::swap(outColors[i][3], outColors[i][rotation - 1]);
+	}
+}
+
+void decodeEtc2(std::uint8_t outColors[16][4], const void* block, bool punchThrough)
+{
+	auto bytes = reinterpret_cast<const std::uint8_t*>(block);
+	std::uint64_t bits = readBigEndian64(bytes);
+
+	// The differential bit is the opaque bit for punch-through alpha, which always uses
+	// differential mode.
+	bool diffBit = ((bits >> 33) & 0x1) != 0;
+	bool opaque = !punchThrough || diffBit;
+	int base[2][3];
+	if (punchThrough || diffBit)
+	{
+		for (unsigned int c = 0; c < 3; ++c)
+		{
+			int first = getBits(bits, 59 - c*8, 5);
+			int delta = getBits(bits, 56 - c*8, 3);
+			if (delta >= 4)
+				delta -= 8;
+			int second = first + delta;
+
+			// Overflowing the red, green, or blue channel selects the T, H, or planar mode.
+			if (second < 0 || second > 31)
+			{
+				if (c == 0)
+					decodeEtc2T(outColors, bits, opaque);
+				else if (c == 1)
+					decodeEtc2H(outColors, bits, opaque);
+				else
+					decodeEtc2Planar(outColors, bits);
+				return;
+			}
+
+			base[0][c] = expandBits(static_cast<std::uint32_t>(first), 5);
+			base[1][c] = expandBits(static_cast<std::uint32_t>(second), 5);
+		}
+	}
+	else
+	{
+		for (unsigned int c = 0; c < 3; ++c)
+		{
+			base[0][c] = getBits(bits, 60 - c*8, 4)*17;
+			base[1][c] = getBits(bits, 56 - c*8, 4)*17;
+		}
+	}
+
+	unsigned int tables[2] =
+	{
+		static_cast<unsigned int>(getBits(bits, 37, 3)),
+		static_cast<unsigned int>(getBits(bits, 34, 3))
+	};
+	bool flip = (bits >> 32) & 0x1;
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		unsigned int x = i >> 2;
+		unsigned int y = i & 0x3;
+		unsigned int subblock = (flip ? y : x) >= 2;
+		unsigned int selector = getEtcSelector(bits, i);
+		std::uint8_t* color = outColors[getEtcPixel(i)];
+		if (opaque)
+			setColor(color, base[subblock], getEtc1Modifier(tables[subblock], selector), 0xFF);
+		else if (selector == 2)
+			std::memset(color, 0, 4);
+		else
+		{
+			int modifier = selector == 0 ? 0 : getEtc1Modifier(tables[subblock], selector);
+			setColor(color, base[subblock], modifier, 0xFF);
+		}
+	}
+}
+
+void decodeEtc2Alpha(std::uint8_t* outValues, const void* block, unsigned int stride)
+{
+	int base, multiplier;
+	const int* modifiers;
+	std::uint64_t bits = readEacBlock(base, multiplier, modifiers,
+		reinterpret_cast<const std::uint8_t*>(block));
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		int value = base + modifiers[getEacIndex(bits, i)]*multiplier;
+		outValues[getEtcPixel(i)*stride] = clampByte(value);
+	}
+}
+
+void decodeEacR11(std::uint16_t* outValues, const void* block, unsigned int stride)
+{
+	int base, multiplier;
+	const int* modifiers;
+	std::uint64_t bits = readEacBlock(base, multiplier, modifiers,
+		reinterpret_cast<const std::uint8_t*>(block));
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		int modifier = modifiers[getEacIndex(bits, i)];
+		int value = base*8 + 4 + (multiplier == 0 ? modifier : modifier*multiplier*8);
+		outValues[getEtcPixel(i)*stride] = static_cast<std::uint16_t>(
+			std::min(std::max(value, 0), 2047));
+	}
+}
+
+void decodeEacR11S(std::int16_t* outValues, const void* block, unsigned int stride)
+{
+	int base, multiplier;
+	const int* modifiers;
+	std::uint64_t bits = readEacBlock(base, multiplier, modifiers,
+		reinterpret_cast<const std::uint8_t*>(block));
+	// -128 is treated the same as -127.
+	base = std::max(static_cast<int>(static_cast<std::int8_t>(base)), -127);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		int modifier = modifiers[getEacIndex(bits, i)];
+		int value = base*8 + (multiplier == 0 ? modifier : modifier*multiplier*8);
+		outValues[getEtcPixel(i)*stride] = static_cast<std::int16_t>(
+			std::min(std::max(value, -1023), 1023));
+	}
+}
+
+} // namespace cuttlefish
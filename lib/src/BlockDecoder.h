@@ -0,0 +1,148 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Export.h>
+#include <cuttlefish/Texture.h>
+#include <cmath>
+#include <cstdint>
+
+namespace cuttlefish
+{
+
+// Functions to decode encoded blocks and measure the error compared to the original colors.
+// These are exported for unit tests.
+
+/**
+ * @brief Gets the root mean square error between the original and decoded colors of a block.
+ * @param colors The original colors of the block.
+ * @param decodedColors The colors decoded from the encoded block.
+ * @param count The number of colors.
+ * @param colorMask The mask of channels to consider.
+ * @return The root mean square error across all pixels and channels in the color mask.
+ */
+CUTTLEFISH_EXPORT float getBlockError(const ColorRGBAf* colors, const ColorRGBAf* decodedColors,
+	unsigned int count, const Texture::ColorMask& colorMask);
+
+/**
+ * @brief Maps an HDR value to a logarithmic scale to measure the error relative to the magnitude.
+ * @param value The value to map.
+ * @return The value as log2(1 + value), mirrored for negative values.
+ */
+inline float toLogScale(float value)
+{
+	if (value < 0.0f)
+		return -std::log2(1.0f - value);
+	return std::log2(1.0f + value);
+}
+
+/**
+ * @brief Decodes a BC1 color block.
+ * @param[out] outColors The decoded RGBA colors.
+ * @param block The 8 byte block to decode.
+ * @param allowTransparent True to use 3 color mode with transparent black when the first
+ *     endpoint isn't larger than the second. This should be false for the color portion of BC2
+ *     and BC3, which always use 4 color mode.
+ */
+CUTTLEFISH_EXPORT void decodeBc1(std::uint8_t outColors[16][4], const void* block,
+	bool allowTransparent);
+
+/**
+ * @brief Decodes a BC2 block.
+ * @param[out] outColors The decoded RGBA colors.
+ * @param block The 16 byte block to decode.
+ */
+CUTTLEFISH_EXPORT void decodeBc2(std::uint8_t outColors[16][4], const void* block);
+
+/**
+ * @brief Decodes a BC3 block.
+ * @param[out] outColors The decoded RGBA colors.
+ * @param block The 16 byte block to decode.
+ */
+CUTTLEFISH_EXPORT void decodeBc3(std::uint8_t outColors[16][4], const void* block);
+
+/**
+ * @brief Decodes an unsigned BC4 block.
+ *
+ * This may also be used for the alpha of BC3 or each channel of BC5.
+ *
+ * @param[out] outValues The decoded values.
+ * @param block The 8 byte block to decode.
+ * @param stride The number of values between each pixel in outValues.
+ */
+CUTTLEFISH_EXPORT void decodeBc4(std::uint8_t* outValues, const void* block, unsigned int stride);
+
+/**
+ * @brief Decodes a signed BC4 block.
+ * @param[out] outValues The decoded values.
+ * @param block The 8 byte block to decode.
+ * @param stride The number of values between each pixel in outValues.
+ */
+CUTTLEFISH_EXPORT void decodeBc4S(std::int8_t* outValues, const void* block, unsigned int stride);
+
+/**
+ * @brief Decodes a BC7 block.
+ * @param[out] outColors The decoded RGBA colors. Invalid blocks are decoded as transparent black.
+ * @param block The 16 byte block to decode.
+ */
+CUTTLEFISH_EXPORT void decodeBc7(std::uint8_t outColors[16][4], const void* block);
+
+/**
+ * @brief Decodes an ETC2 color block.
+ *
+ * ETC2 is backwards compatible with ETC1, so this may also be used to decode ETC1 blocks.
+ *
+ * @param[out] outColors The decoded RGBA colors.
+ * @param block The 8 byte block to decode.
+ * @param punchThrough True if the block uses punch-through alpha.
+ */
+CUTTLEFISH_EXPORT void decodeEtc2(std::uint8_t outColors[16][4], const void* block,
+	bool punchThrough);
+
+/**
+ * @brief Decodes an ETC2 alpha block.
+ * @param[out] outValues The decoded values.
+ * @param block The 8 byte block to decode.
+ * @param stride The number of values between each pixel in outValues.
+ */
+CUTTLEFISH_EXPORT void decodeEtc2Alpha(std::uint8_t* outValues, const void* block,
+	unsigned int stride);
+
+/**
+ * @brief Decodes an unsigned EAC R11 block.
+ *
+ * This may also be used for each channel of EAC R11G11.
+ *
+ * @param[out] outValues The decoded values in the range [0, 2047].
+ * @param block The 8 byte block to decode.
+ * @param stride The number of values between each pixel in outValues.
+ */
+CUTTLEFISH_EXPORT void decodeEacR11(std::uint16_t* outValues, const void* block,
+	unsigned int stride);
+
+/**
+ * @brief Decodes a signed EAC R11 block.
+ * @param[out] outValues The decoded values in the range [-1023, 1023].
+ * @param block The 8 byte block to decode.
+ * @param stride The number of values between each pixel in outValues.
+ */
+CUTTLEFISH_EXPORT void decodeEacR11S(std::int16_t* outValues, const void* block,
+	unsigned int stride);
+
+} // namespace cuttlefish
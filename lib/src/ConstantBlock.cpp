@@ -0,0 +1,604 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ConstantBlock.h"
+#include "EtcTables.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+const unsigned int blockPixels = 16;
+
+// Writes bits starting from the least significant bit of the first byte, as used by BC6H and BC7.
+class BitWriter
+{
+public:
+	BitWriter(void* block, unsigned int size)
+		: m_block(reinterpret_cast<std::uint8_t*>(block)), m_position(0)
+	{
+		std::memset(m_block, 0, size);
+	}
+
+	void write(std::uint32_t value, unsigned int bits)
+	{
+		for (unsigned int i = 0; i < bits; ++i, ++m_position)
+		{
+			if (value & (1U << i))
+				m_block[m_position >> 3] |= static_cast<std::uint8_t>(1 << (m_position & 0x7));
+		}
+	}
+
+private:
+	std::uint8_t* m_block;
+	unsigned int m_position;
+};
+
+void writeLittleEndian16(std::uint8_t* bytes, std::uint16_t value)
+{
+	bytes[0] = static_cast<std::uint8_t>(value);
+	bytes[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+void writeLittleEndian32(std::uint8_t* bytes, std::uint32_t value)
+{
+	for (unsigned int i = 0; i < 4; ++i)
+		bytes[i] = static_cast<std::uint8_t>(value >> (i*8));
+}
+
+void writeBigEndian64(std::uint8_t* bytes, std::uint64_t value)
+{
+	for (unsigned int i = 0; i < 8; ++i)
+		bytes[i] = static_cast<std::uint8_t>(value >> ((7 - i)*8));
+}
+
+// Repeats a 3-bit index for all 16 pixels of an EAC block.
+std::uint64_t repeatEacIndex(unsigned int index)
+{
+	std::uint64_t indices = 0;
+	for (unsigned int i = 0; i < blockPixels; ++i)
+		indices = (indices << 3) | index;
+	return indices;
+}
+
+// Table and index within eacModifiers that has a modifier of 0.
+const unsigned int eacZeroTable = 13;
+const unsigned int eacZeroIndex = 4;
+
+const int etc1SelectorCount = 4;
+
+// Writes the modifier bits for an EAC block that uses the same modifier for every pixel. The
+// multiplier is 0 so the modifier is used directly, allowing for exact values.
+void writeEacBlock(void* block, std::uint8_t base, unsigned int table, unsigned int index)
+{
+	std::uint64_t value = (static_cast<std::uint64_t>(base) << 56) |
+		(static_cast<std::uint64_t>(table) << 48) | repeatEacIndex(index);
+	writeBigEndian64(reinterpret_cast<std::uint8_t*>(block), value);
+}
+
+void findEacModifier(std::uint8_t& outBase, unsigned int& outTable, unsigned int& outIndex,
+	int value, int minBase, int maxBase, int offset, int minValue, int maxValue)
+{
+	// Each base covers 8 values, so only need to check the closest bases. The multiplier is
+	// always 0, which uses the modifiers directly.
+	int closestBase = (value - offset)/8;
+	int bestError = std::numeric_limits<int>::max();
+	for (int base = std::max(closestBase - 2, minBase); base <= std::min(closestBase + 2, maxBase);
+		++base)
+	{
+		for (unsigned int table = 0; table < 16; ++table)
+		{
+			for (unsigned int index = 0; index < 8; ++index)
+			{
+				int decoded = std::min(std::max(base*8 + offset + eacModifiers[table][index],
+					minValue), maxValue);
+				int error = std::abs(decoded - value);
+				if (error < bestError)
+				{
+					outBase = static_cast<std::uint8_t>(base);
+					outTable = table;
+					outIndex = index;
+					bestError = error;
+					if (error == 0)
+						return;
+				}
+			}
+		}
+	}
+}
+
+struct Bc1Tables
+{
+	// Maximum and minimum endpoints for a 2/3 interpolation between them.
+	std::uint8_t match5[256][2];
+	std::uint8_t match6[256][2];
+};
+
+std::uint8_t expand5(unsigned int value)
+{
+	return static_cast<std::uint8_t>((value << 3) | (value >> 2));
+}
+
+std::uint8_t expand6(unsigned int value)
+{
+	return static_cast<std::uint8_t>((value << 2) | (value >> 4));
+}
+
+std::uint8_t expand7(unsigned int value)
+{
+	return static_cast<std::uint8_t>((value << 1) | (value >> 6));
+}
+
+void prepareBc1Table(std::uint8_t table[256][2], std::uint8_t (*expand)(unsigned int),
+	unsigned int size)
+{
+	for (int i = 0; i < 256; ++i)
+	{
+		int bestError = std::numeric_limits<int>::max();
+		for (unsigned int minIndex = 0; minIndex < size; ++minIndex)
+		{
+			int minValue = expand(minIndex);
+			for (unsigned int maxIndex = 0; maxIndex < size; ++maxIndex)
+			{
+				int maxValue = expand(maxIndex);
+				// Bias towards closer endpoints to reduce differences in decoder precision.
+				int error = std::abs((2*maxValue + minValue)/3 - i)*100 +
+					std::abs(maxValue - minValue)*3;
+				if (error < bestError)
+				{
+					table[i][0] = static_cast<std::uint8_t>(maxIndex);
+					table[i][1] = static_cast<std::uint8_t>(minIndex);
+					bestError = error;
+				}
+			}
+		}
+	}
+}
+
+const Bc1Tables& getBc1Tables()
+{
+	static Bc1Tables tables = []()
+	{
+		Bc1Tables newTables;
+		prepareBc1Table(newTables.match5, &expand5, 32);
+		prepareBc1Table(newTables.match6, &expand6, 64);
+		return newTables;
+	}();
+	return tables;
+}
+
+struct Bc7Endpoints
+{
+	std::uint8_t endpoints[2];
+	std::uint8_t error;
+};
+
+// BC7 mode 5 endpoints for index 0 and 1. Indices 2 and 3 are equivalent to 1 and 0 with the
+// endpoints swapped, and the anchor index may only use 0 or 1.
+struct Bc7Tables
+{
+	Bc7Endpoints endpoints[2][256];
+};
+
+const unsigned int bc7Mode5Weights[2] = {0, 21};
+
+const Bc7Tables& getBc7Tables()
+{
+	static Bc7Tables tables = []()
+	{
+		Bc7Tables newTables;
+		for (unsigned int index = 0; index < 2; ++index)
+		{
+			unsigned int weight = bc7Mode5Weights[index];
+			for (int i = 0; i < 256; ++i)
+			{
+				Bc7Endpoints& entry = newTables.endpoints[index][i];
+				int bestError = std::numeric_limits<int>::max();
+				for (unsigned int e0 = 0; e0 < 128; ++e0)
+				{
+					// Endpoints far apart won't improve the error from rounding.
+					unsigned int value0 = expand7(e0);
+					for (unsigned int e1 = e0 > 8 ? e0 - 8 : 0; e1 < std::min(e0 + 9, 128U);
+						++e1)
+					{
+						unsigned int value1 = expand7(e1);
+						auto decoded =
+							static_cast<int>(((64 - weight)*value0 + weight*value1 + 32) >> 6);
+						int error = std::abs(decoded - i)*256 +
+							std::abs(static_cast<int>(value1) - static_cast<int>(value0));
+						if (error < bestError)
+						{
+							entry.endpoints[0] = static_cast<std::uint8_t>(e0);
+							entry.endpoints[1] = static_cast<std::uint8_t>(e1);
+							entry.error = static_cast<std::uint8_t>(std::abs(decoded - i));
+							bestError = error;
+						}
+					}
+				}
+			}
+		}
+		return newTables;
+	}();
+	return tables;
+}
+
+struct Etc1Entry
+{
+	std::uint8_t base;
+	std::uint16_t error;
+};
+
+// Best 5-bit base for each table and selector combination.
+struct Etc1Tables
+{
+	Etc1Entry entries[8][etc1SelectorCount][256];
+};
+
+const Etc1Tables& getEtc1Tables()
+{
+	static Etc1Tables tables = []()
+	{
+		Etc1Tables newTables;
+		for (unsigned int table = 0; table < 8; ++table)
+		{
+			for (unsigned int selector = 0; selector < etc1SelectorCount; ++selector)
+			{
+				int modifier = getEtc1Modifier(table, selector);
+				for (int i = 0; i < 256; ++i)
+				{
+					Etc1Entry& entry = newTables.entries[table][selector][i];
+					int bestError = std::numeric_limits<int>::max();
+					for (unsigned int base = 0; base < 32; ++base)
+					{
+						int decoded = std::min(std::max(expand5(base) + modifier, 0), 255);
+						int error = (decoded - i)*(decoded - i);
+						if (error < bestError)
+						{
+							entry.base = static_cast<std::uint8_t>(base);
+							entry.error = static_cast<std::uint16_t>(error);
+							bestError = error;
+						}
+					}
+				}
+			}
+		}
+		return newTables;
+	}();
+	return tables;
+}
+
+const int bc6hWeights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+const int bc6hMaxEndpoint = 0x3FF;
+const int bc6hMaxHalf = 0x7BFF;
+
+int unquantizeBc6H(int value)
+{
+	if (value == 0)
+		return 0;
+	else if (value == bc6hMaxEndpoint)
+		return 0xFFFF;
+	return ((value << 16) + 0x8000) >> 10;
+}
+
+int quantizeBc6H(int value)
+{
+	return std::min(std::max((value*bc6hMaxEndpoint + 0x7FFF)/0xFFFF, 0), bc6hMaxEndpoint);
+}
+
+int decodeBc6H(int e0, int e1, int weight)
+{
+	int interpolated = (unquantizeBc6H(e0)*(64 - weight) + unquantizeBc6H(e1)*weight + 32) >> 6;
+	return (interpolated*31) >> 6;
+}
+
+int findBc6HEndpoints(int& outE0, int& outE1, int value, int weight)
+{
+	// Work backwards from the final scale of 31/64 for unsigned values.
+	int unquantized = (value*64 + 30)/31;
+	int closestE0 = quantizeBc6H(unquantized);
+	int bestError = std::numeric_limits<int>::max();
+	for (int e0 = std::max(closestE0 - 8, 0); e0 <= std::min(closestE0 + 8, bc6hMaxEndpoint);
+		++e0)
+	{
+		int closestE1 = e0;
+		if (weight > 0)
+		{
+			int unquantized1 = (unquantized*64 - unquantizeBc6H(e0)*(64 - weight))/weight;
+			closestE1 = quantizeBc6H(unquantized1);
+		}
+
+		for (int e1 = std::max(closestE1 - 1, 0); e1 <= std::min(closestE1 + 1, bc6hMaxEndpoint);
+			++e1)
+		{
+			int error = std::abs(decodeBc6H(e0, e1, weight) - value);
+			if (error < bestError)
+			{
+				outE0 = e0;
+				outE1 = e1;
+				bestError = error;
+				if (error == 0)
+					return 0;
+			}
+		}
+	}
+
+	return bestError;
+}
+
+} // namespace
+
+float getBlockRange(const ColorRGBAf* colors, unsigned int count,
+	const Texture::ColorMask& colorMask)
+{
+	assert(count > 0);
+	ColorRGBAf minColor = colors[0];
+	ColorRGBAf maxColor = colors[0];
+	for (unsigned int i = 1; i < count; ++i)
+	{
+		const ColorRGBAf& color = colors[i];
+		minColor.r = std::min(minColor.r, color.r);
+		minColor.g = std::min(minColor.g, color.g);
+		minColor.b = std::min(minColor.b, color.b);
+		minColor.a = std::min(minColor.a, color.a);
+		maxColor.r = std::max(maxColor.r, color.r);
+		maxColor.g = std::max(maxColor.g, color.g);
+		maxColor.b = std::max(maxColor.b, color.b);
+		maxColor.a = std::max(maxColor.a, color.a);
+	}
+
+	float range = 0.0f;
+	if (colorMask.r)
+		range = std::max(range, maxColor.r - minColor.r);
+	if (colorMask.g)
+		range = std::max(range, maxColor.g - minColor.g);
+	if (colorMask.b)
+		range = std::max(range, maxColor.b - minColor.b);
+	if (colorMask.a)
+		range = std::max(range, maxColor.a - minColor.a);
+	return range;
+}
+
+void encodeConstantBc1(void* block, const std::uint8_t color[3])
+{
+	const Bc1Tables& tables = getBc1Tables();
+	auto maxColor = static_cast<std::uint16_t>((tables.match5[color[0]][0] << 11) |
+		(tables.match6[color[1]][0] << 5) | tables.match5[color[2]][0]);
+	auto minColor = static_cast<std::uint16_t>((tables.match5[color[0]][1] << 11) |
+		(tables.match6[color[1]][1] << 5) | tables.match5[color[2]][1]);
+
+	// Index 2 is 2/3 of the first color and 1/3 of the second color. If the colors need to be
+	// swapped to guarantee 4-color mode, index 3 is the inverse.
+	std::uint32_t selectors = 0xAAAAAAAA;
+	if (maxColor < minColor)
+	{
+		std::swap(maxColor, minColor);
+		selectors = 0xFFFFFFFF;
+	}
+	else if (maxColor == minColor)
+		selectors = 0;
+
+	auto bytes = reinterpret_cast<std::uint8_t*>(block);
+	writeLittleEndian16(bytes, maxColor);
+	writeLittleEndian16(bytes + 2, minColor);
+	writeLittleEndian32(bytes + 4, selectors);
+}
+
+void encodeTransparentBc1(void* block)
+{
+	// Equal colors use 3-color mode, where index 3 is transparent.
+	auto bytes = reinterpret_cast<std::uint8_t*>(block);
+	writeLittleEndian16(bytes, 0);
+	writeLittleEndian16(bytes + 2, 0);
+	writeLittleEndian32(bytes + 4, 0xFFFFFFFF);
+}
+
+void encodeConstantBc4(void* block, std::uint8_t value)
+{
+	// With equal endpoints, index 0 is the first endpoint.
+	auto bytes = reinterpret_cast<std::uint8_t*>(block);
+	bytes[0] = value;
+	bytes[1] = value;
+	std::memset(bytes + 2, 0, 6);
+}
+
+void encodeConstantBc4S(void* block, std::int8_t value)
+{
+	encodeConstantBc4(block, static_cast<std::uint8_t>(value));
+}
+
+void encodeConstantBc6H(void* block, const std::uint16_t color[3])
+{
+	// Use mode 11, which has a single region with 10-bit endpoints and no deltas. All pixels share
+	// the same index, so choose the one with the lowest total error. The anchor index may only
+	// use 3 bits.
+	int value[3];
+	for (unsigned int c = 0; c < 3; ++c)
+	{
+		if (color[c] & 0x8000)
+			value[c] = 0;
+		else
+			value[c] = std::min(static_cast<int>(color[c]), bc6hMaxHalf);
+	}
+
+	int bestEndpoints[3][2] = {};
+	unsigned int bestIndex = 0;
+	int bestError = std::numeric_limits<int>::max();
+	for (unsigned int index = 0; index < 8 && bestError > 0; ++index)
+	{
+		int endpoints[3][2];
+		int error = 0;
+		for (unsigned int c = 0; c < 3; ++c)
+		{
+			error += findBc6HEndpoints(endpoints[c][0], endpoints[c][1], value[c],
+				bc6hWeights[index]);
+		}
+
+		if (error < bestError)
+		{
+			std::memcpy(bestEndpoints, endpoints, sizeof(endpoints));
+			bestIndex = index;
+			bestError = error;
+		}
+	}
+
+	BitWriter writer(block, 16);
+	writer.write(0x03, 5);
+	for (unsigned int c = 0; c < 3; ++c)
+		writer.write(static_cast<std::uint32_t>(bestEndpoints[c][0]), 10);
+	for (unsigned int c = 0; c < 3; ++c)
+		writer.write(static_cast<std::uint32_t>(bestEndpoints[c][1]), 10);
+
+	writer.write(bestIndex, 3);
+	for (unsigned int i = 1; i < blockPixels; ++i)
+		writer.write(bestIndex, 4);
+}
+
+void encodeConstantBc7(void* block, const std::uint8_t color[4])
+{
+	// Use mode 5, which has separate color and alpha indices and 8-bit alpha endpoints. This
+	// allows for alpha to be exact and the colors to be interpolated from 7-bit endpoints. All
+	// pixels share the same color index, so choose the one with the lowest total error.
+	const Bc7Tables& tables = getBc7Tables();
+	unsigned int bestIndex = 0;
+	unsigned int bestError = std::numeric_limits<unsigned int>::max();
+	for (unsigned int index = 0; index < 2; ++index)
+	{
+		unsigned int error = 0;
+		for (unsigned int c = 0; c < 3; ++c)
+			error += tables.endpoints[index][color[c]].error;
+
+		if (error < bestError)
+		{
+			bestIndex = index;
+			bestError = error;
+		}
+	}
+
+	BitWriter writer(block, 16);
+	writer.write(1 << 5, 6);
+	// No rotation.
+	writer.write(0, 2);
+	for (unsigned int c = 0; c < 3; ++c)
+	{
+		const Bc7Endpoints& endpoints = tables.endpoints[bestIndex][color[c]];
+		writer.write(endpoints.endpoints[0], 7);
+		writer.write(endpoints.endpoints[1], 7);
+	}
+	writer.write(color[3], 8);
+	writer.write(color[3], 8);
+
+	writer.write(bestIndex, 1);
+	for (unsigned int i = 1; i < blockPixels; ++i)
+		writer.write(bestIndex, 2);
+
+	// Alpha endpoints are equal, so the alpha indices are all 0.
+}
+
+void encodeConstantEtc1(void* block, const std::uint8_t color[3])
+{
+	const Etc1Tables& tables = getEtc1Tables();
+	unsigned int bestTable = 0;
+	unsigned int bestSelector = 0;
+	unsigned int bestError = std::numeric_limits<unsigned int>::max();
+	for (unsigned int table = 0; table < 8 && bestError > 0; ++table)
+	{
+		for (unsigned int selector = 0; selector < etc1SelectorCount; ++selector)
+		{
+			unsigned int error = 0;
+			for (unsigned int c = 0; c < 3; ++c)
+				error += tables.entries[table][selector][color[c]].error;
+
+			if (error < bestError)
+			{
+				bestTable = table;
+				bestSelector = selector;
+				bestError = error;
+			}
+		}
+	}
+
+	// Differential mode with no deltas, the same table for both sub-blocks, and no flip.
+	auto bytes = reinterpret_cast<std::uint8_t*>(block);
+	for (unsigned int c = 0; c < 3; ++c)
+	{
+		bytes[c] =
+			static_cast<std::uint8_t>(tables.entries[bestTable][bestSelector][color[c]].base << 3);
+	}
+	bytes[3] = static_cast<std::uint8_t>((bestTable << 5) | (bestTable << 2) | 0x2);
+
+	std::uint8_t msb = bestSelector & 0x2 ? 0xFF : 0;
+	std::uint8_t lsb = bestSelector & 0x1 ? 0xFF : 0;
+	bytes[4] = bytes[5] = msb;
+	bytes[6] = bytes[7] = lsb;
+}
+
+void encodeTransparentEtc2A1(void* block)
+{
+	// Differential mode with the opaque bit cleared, where selector 2 is transparent.
+	auto bytes = reinterpret_cast<std::uint8_t*>(block);
+	std::memset(bytes, 0, 4);
+	bytes[4] = bytes[5] = 0xFF;
+	bytes[6] = bytes[7] = 0;
+}
+
+void encodeConstantEtc2Alpha(void* block, std::uint8_t alpha)
+{
+	// Use a multiplier of 1 with a modifier of 0 to use the base value directly.
+	std::uint64_t value = (static_cast<std::uint64_t>(alpha) << 56) |
+		(static_cast<std::uint64_t>((1 << 4) | eacZeroTable) << 48) |
+		repeatEacIndex(eacZeroIndex);
+	writeBigEndian64(reinterpret_cast<std::uint8_t*>(block), value);
+}
+
+void encodeConstantEacR11(void* block, std::uint16_t value)
+{
+	assert(value <= 2047);
+	std::uint8_t base = 0;
+	unsigned int table = 0, index = 0;
+	findEacModifier(base, table, index, value, 0, 255, 4, 0, 2047);
+	writeEacBlock(block, base, table, index);
+}
+
+void encodeConstantEacR11S(void* block, std::int16_t value)
+{
+	assert(value >= -1023 && value <= 1023);
+	std::uint8_t base = 0;
+	unsigned int table = 0, index = 0;
+	// NOTE: -128 isn't allowed for the base.
+	findEacModifier(base, table, index, value, -127, 127, 0, -1023, 1023);
+	writeEacBlock(block, base, table, index);
+}
+
+void encodeConstantAstc(void* block, const std::uint16_t color[4], bool hdr)
+{
+	// Void-extent block with all extent coordinates set to 1 to signify no extent.
+	std::uint64_t header = hdr ? 0xFFFFFFFFFFFFFFFCULL : 0xFFFFFFFFFFFFFDFCULL;
+	auto bytes = reinterpret_cast<std::uint8_t*>(block);
+	for (unsigned int i = 0; i < 8; ++i)
+		bytes[i] = static_cast<std::uint8_t>(header >> (i*8));
+	for (unsigned int c = 0; c < 4; ++c)
+		writeLittleEndian16(bytes + 8 + c*2, color[c]);
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Export.h>
+#include <cuttlefish/Texture.h>
+#include <cstdint>
+
+namespace cuttlefish
+{
+
+// Functions to detect blocks with uniform colors and directly encode blocks of a single color.
+// These are exported for unit tests.
+
+/**
+ * @brief The maximum difference between channels for a block to be considered nearly constant.
+ *
+ * This is slightly larger than a single step for 8-bit values, so blocks that only differ by
+ * rounding or dithering noise will be treated as nearly constant.
+ */
+constexpr float nearConstantBlockThreshold = 2.5f/255.0f;
+
+/**
+ * @brief Gets the maximum range of any channel within a block.
+ * @param colors The colors of the block.
+ * @param count The number of colors.
+ * @param colorMask The mask of channels to consider.
+ * @return The maximum difference between the smallest and largest value of any channel.
+ */
+CUTTLEFISH_EXPORT float getBlockRange(const ColorRGBAf* colors, unsigned int count,
+	const Texture::ColorMask& colorMask);
+
+/**
+ * @brief Checks whether or not all of the colors in a block are the same.
+ * @param colors The colors of the block.
+ * @param count The number of colors.
+ * @param stride The number of values between each color.
+ * @param channelCount The number of channels to compare for each color.
+ * @return True if all colors are the same.
+ */
+template <typename T>
+bool isBlockConstant(const T* colors, unsigned int count, unsigned int stride,
+	unsigned int channelCount)
+{
+	for (unsigned int i = 1; i < count; ++i)
+	{
+		for (unsigned int c = 0; c < channelCount; ++c)
+		{
+			if (colors[i*stride + c] != colors[c])
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Encodes a BC1 color block with a single color.
+ *
+ * This never uses the transparent index, so it's also valid for the color portion of BC2 and
+ * BC3.
+ *
+ * @param[out] block The 8 byte block to write to.
+ * @param color The RGB color to encode.
+ */
+CUTTLEFISH_EXPORT void encodeConstantBc1(void* block, const std::uint8_t color[3]);
+
+/**
+ * @brief Encodes a fully transparent BC1 block.
+ * @param[out] block The 8 byte block to write to.
+ */
+CUTTLEFISH_EXPORT void encodeTransparentBc1(void* block);
+
+/**
+ * @brief Encodes an unsigned BC4 block with a single value.
+ *
+ * This may also be used for the alpha of BC3 or each channel of BC5.
+ *
+ * @param[out] block The 8 byte block to write to.
+ * @param value The value to encode.
+ */
+CUTTLEFISH_EXPORT void encodeConstantBc4(void* block, std::uint8_t value);
+
+/**
+ * @brief Encodes a signed BC4 block with a single value.
+ * @param[out] block The 8 byte block to write to.
+ * @param value The value to encode.
+ */
+CUTTLEFISH_EXPORT void encodeConstantBc4S(void* block, std::int8_t value);
+
+/**
+ * @brief Encodes an unsigned BC6H block with a single color.
+ * @param[out] block The 16 byte block to write to.
+ * @param color The half float RGB color to encode. Negative values will be clamped to 0.
+ */
+CUTTLEFISH_EXPORT void encodeConstantBc6H(void* block, const std::uint16_t color[3]);
+
+/**
+ * @brief Encodes a BC7 block with a single color.
+ * @param[out] block The 16 byte block to write to.
+ * @param color The RGBA color to encode.
+ */
+CUTTLEFISH_EXPORT void encodeConstantBc7(void* block, const std::uint8_t color[4]);
+
+/**
+ * @brief Encodes an ETC1 block with a single color.
+ *
+ * This only uses differential mode without overflow, so it's also valid for ETC2 and for opaque
+ * ETC2 punch-through alpha blocks.
+ *
+ * @param[out] block The 8 byte block to write to.
+ * @param color The RGB color to encode.
+ */
+CUTTLEFISH_EXPORT void encodeConstantEtc1(void* block, const std::uint8_t color[3]);
+
+/**
+ * @brief Encodes a fully transparent ETC2 punch-through alpha block.
+ * @param[out] block The 8 byte block to write to.
+ */
+CUTTLEFISH_EXPORT void encodeTransparentEtc2A1(void* block);
+
+/**
+ * @brief Encodes an ETC2 alpha block with a single value.
+ * @param[out] block The 8 byte block to write to.
+ * @param alpha The alpha value to encode.
+ */
+CUTTLEFISH_EXPORT void encodeConstantEtc2Alpha(void* block, std::uint8_t alpha);
+
+/**
+ * @brief Encodes an unsigned EAC R11 block with a single value.
+ * @param[out] block The 8 byte block to write to.
+ * @param value The 11-bit value to encode, in the range [0, 2047].
+ */
+CUTTLEFISH_EXPORT void encodeConstantEacR11(void* block, std::uint16_t value);
+
+/**
+ * @brief Encodes a signed EAC R11 block with a single value.
+ * @param[out] block The 8 byte block to write to.
+ * @param value The 11-bit value to encode, in the range [-1023, 1023].
+ */
+CUTTLEFISH_EXPORT void encodeConstantEacR11S(void* block, std::int16_t value);
+
+/**
+ * @brief Encodes an ASTC void-extent block with a single color.
+ * @param[out] block The 16 byte block to write to.
+ * @param color The RGBA color to encode. This is UNorm16 for LDR or half float for HDR.
+ * @param hdr True if the color is HDR.
+ */
+CUTTLEFISH_EXPORT void encodeConstantAstc(void* block, const std::uint16_t color[4], bool hdr);
+
+} // namespace cuttlefish
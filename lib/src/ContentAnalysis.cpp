@@ -0,0 +1,171 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ContentAnalysis.h"
+#include "JobProcessor.h"
+#include <vector>
+
+// SSE2 and NEON are always available on 64-bit x86 and ARM, respectively.
+#if CUTTLEFISH_X86_64
+#include <emmintrin.h>
+#define CUTTLEFISH_CONTENT_SSE 1
+#define CUTTLEFISH_CONTENT_NEON 0
+#elif CUTTLEFISH_ARM_64
+#include <arm_neon.h>
+#define CUTTLEFISH_CONTENT_SSE 0
+#define CUTTLEFISH_CONTENT_NEON 1
+#else
+#define CUTTLEFISH_CONTENT_SSE 0
+#define CUTTLEFISH_CONTENT_NEON 0
+#endif
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+enum ContentFlags : unsigned int
+{
+	OpaqueAlpha = 0x1,
+	BinaryAlpha = 0x2,
+	Grayscale = 0x4,
+	AllContent = OpaqueAlpha | BinaryAlpha | Grayscale
+};
+
+unsigned int analyzePixel(const float* pixel)
+{
+	unsigned int flags = 0;
+	if (pixel[3] >= 1.0f)
+		flags |= OpaqueAlpha | BinaryAlpha;
+	else if (pixel[3] <= 0.0f)
+		flags |= BinaryAlpha;
+
+	if (pixel[0] == pixel[1] && pixel[0] == pixel[2])
+		flags |= Grayscale;
+	return flags;
+}
+
+// Processes 4 pixels at a time with each channel in a separate register, accumulating a mask for
+// each property across the row.
+unsigned int analyzeRow(const float* pixels, unsigned int width)
+{
+	unsigned int x = 0;
+	unsigned int flags = AllContent;
+#if CUTTLEFISH_CONTENT_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128 opaque = _mm_cmpeq_ps(zero, zero);
+	__m128 binary = opaque;
+	__m128 grayscale = opaque;
+	for (; x + 4 <= width; x += 4)
+	{
+		__m128 r = _mm_loadu_ps(pixels + x*4);
+		__m128 g = _mm_loadu_ps(pixels + x*4 + 4);
+		__m128 b = _mm_loadu_ps(pixels + x*4 + 8);
+		__m128 a = _mm_loadu_ps(pixels + x*4 + 12);
+		_MM_TRANSPOSE4_PS(r, g, b, a);
+
+		__m128 aOne = _mm_cmpge_ps(a, one);
+		opaque = _mm_and_ps(opaque, aOne);
+		binary = _mm_and_ps(binary, _mm_or_ps(aOne, _mm_cmple_ps(a, zero)));
+		grayscale = _mm_and_ps(grayscale,
+			_mm_and_ps(_mm_cmpeq_ps(r, g), _mm_cmpeq_ps(r, b)));
+	}
+
+	if (_mm_movemask_ps(opaque) != 0xF)
+		flags &= ~OpaqueAlpha;
+	if (_mm_movemask_ps(binary) != 0xF)
+		flags &= ~BinaryAlpha;
+	if (_mm_movemask_ps(grayscale) != 0xF)
+		flags &= ~Grayscale;
+#elif CUTTLEFISH_CONTENT_NEON
+	const float32x4_t one = vdupq_n_f32(1.0f);
+	uint32x4_t opaque = vdupq_n_u32(0xFFFFFFFF);
+	uint32x4_t binary = opaque;
+	uint32x4_t grayscale = opaque;
+	for (; x + 4 <= width; x += 4)
+	{
+		float32x4x4_t pixel = vld4q_f32(pixels + x*4);
+		uint32x4_t aOne = vcgeq_f32(pixel.val[3], one);
+		opaque = vandq_u32(opaque, aOne);
+		binary = vandq_u32(binary, vorrq_u32(aOne, vclezq_f32(pixel.val[3])));
+		grayscale = vandq_u32(grayscale, vandq_u32(vceqq_f32(pixel.val[0], pixel.val[1]),
+			vceqq_f32(pixel.val[0], pixel.val[2])));
+	}
+
+	if (vminvq_u32(opaque) == 0)
+		flags &= ~OpaqueAlpha;
+	if (vminvq_u32(binary) == 0)
+		flags &= ~BinaryAlpha;
+	if (vminvq_u32(grayscale) == 0)
+		flags &= ~Grayscale;
+#endif
+
+	for (; x < width && flags; ++x)
+		flags &= analyzePixel(pixels + x*4);
+	return flags;
+}
+
+class ContentAnalysisJobs : public JobProcessor
+{
+public:
+	explicit ContentAnalysisJobs(const Image& image)
+		: m_image(image), m_rowFlags(image.height())
+	{
+	}
+
+	unsigned int flags() const
+	{
+		unsigned int flags = AllContent;
+		for (unsigned int rowFlags : m_rowFlags)
+			flags &= rowFlags;
+		return flags;
+	}
+
+	unsigned int jobsX() const override {return 1;}
+	unsigned int jobsY() const override {return static_cast<unsigned int>(m_rowFlags.size());}
+
+	void process(unsigned int, unsigned int y, ThreadData*) override
+	{
+		m_rowFlags[y] = analyzeRow(reinterpret_cast<const float*>(m_image.scanline(y)),
+			m_image.width());
+	}
+
+private:
+	const Image& m_image;
+	std::vector<unsigned int> m_rowFlags;
+};
+
+} // namespace
+
+bool analyzeContent(Texture::ContentProperties& inOutProperties, const Image& image,
+	unsigned int threadCount)
+{
+	if (!image.isValid() || image.format() != Image::Format::RGBAF)
+		return false;
+
+	ContentAnalysisJobs jobs(image);
+	jobs.run(threadCount);
+
+	unsigned int flags = jobs.flags();
+	inOutProperties.opaqueAlpha = inOutProperties.opaqueAlpha && (flags & OpaqueAlpha);
+	inOutProperties.binaryAlpha = inOutProperties.binaryAlpha && (flags & BinaryAlpha);
+	inOutProperties.grayscale = inOutProperties.grayscale && (flags & Grayscale);
+	return true;
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Export.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+
+namespace cuttlefish
+{
+
+/**
+ * @brief Analyzes the content of an image.
+ *
+ * This is exported for unit tests.
+ *
+ * @param[inout] inOutProperties The properties of the content. Properties that don't hold for the
+ *     image are set to false, so this should be initialized to all true before analyzing the first
+ *     image.
+ * @param image The image to analyze. This must use the RGBAF format.
+ * @param threadCount The number of threads to use.
+ * @return False if the image is invalid.
+ */
+CUTTLEFISH_EXPORT bool analyzeContent(Texture::ContentProperties& inOutProperties,
+	const Image& image, unsigned int threadCount);
+
+} // namespace cuttlefish
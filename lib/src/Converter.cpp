@@ -15,15 +15,17 @@
  */
 
 #include "AstcConverter.h"
+#include "Decoder.h"
 #include "EtcConverter.h"
+#include "IncrementalBlocks.h"
 #include "PvrtcConverter.h"
+#include "QualityMetrics.h"
 #include "S3tcConverter.h"
+#include "Shared.h"
 #include "StandardConverter.h"
 #include <cuttlefish/Texture.h>
-#include <algorithm>
-#include <atomic>
 #include <cassert>
-#include <thread>
+#include <cstring>
 #include <utility>
 
 namespace cuttlefish
@@ -338,77 +340,14 @@ static std::unique_ptr<Converter> createConverter(const Texture& texture, const
 		}
 #if CUTTLEFISH_HAS_S3TC
 		case Texture::Format::BC1_RGB:
-		{
-			if (texture.type() == Texture::Type::UNorm)
-				return std::unique_ptr<Converter>(new Bc1Converter(texture, image, quality));
-			return nullptr;
-		}
 		case Texture::Format::BC1_RGBA:
-		{
-			if (texture.type() == Texture::Type::UNorm)
-				return std::unique_ptr<Converter>(new Bc1AConverter(texture, image, quality));
-			return nullptr;
-		}
 		case Texture::Format::BC2:
-		{
-			if (texture.type() == Texture::Type::UNorm)
-				return std::unique_ptr<Converter>(new Bc2Converter(texture, image, quality));
-			return nullptr;
-		}
 		case Texture::Format::BC3:
-		{
-			if (texture.type() == Texture::Type::UNorm)
-				return std::unique_ptr<Converter>(new Bc3Converter(texture, image, quality));
-			return nullptr;
-		}
 		case Texture::Format::BC4:
-		{
-			switch (texture.type())
-			{
-				case Texture::Type::UNorm:
-					return std::unique_ptr<Converter>(new Bc4Converter(texture, image, quality,
-						false));
-				case Texture::Type::SNorm:
-					return std::unique_ptr<Converter>(new Bc4Converter(texture, image, quality,
-						true));
-				default:
-					return nullptr;
-			}
-		}
 		case Texture::Format::BC5:
-		{
-			switch (texture.type())
-			{
-				case Texture::Type::UNorm:
-					return std::unique_ptr<Converter>(new Bc5Converter(texture, image, quality,
-						false));
-				case Texture::Type::SNorm:
-					return std::unique_ptr<Converter>(new Bc5Converter(texture, image, quality,
-						true));
-				default:
-					return nullptr;
-			}
-		}
 		case Texture::Format::BC6H:
-		{
-			switch (texture.type())
-			{
-				case Texture::Type::UFloat:
-					return std::unique_ptr<Converter>(new Bc6HConverter(texture, image, quality,
-						false));
-				case Texture::Type::Float:
-					return std::unique_ptr<Converter>(new Bc6HConverter(texture, image, quality,
-						true));
-				default:
-					return nullptr;
-			}
-		}
 		case Texture::Format::BC7:
-		{
-			if (texture.type() == Texture::Type::UNorm)
-				return std::unique_ptr<Converter>(new Bc7Converter(texture, image, quality));
-			return nullptr;
-		}
+			return S3tcConverter::create(texture, image, quality);
 #endif // CUTTLEFISH_HAS_S3TC
 #if CUTTLEFISH_HAS_ETC
 		case Texture::Format::ETC1:
@@ -486,105 +425,175 @@ static std::unique_ptr<Converter> createConverter(const Texture& texture, const
 				return std::unique_ptr<Converter>(new AstcConverter(texture, image, 12, 12, quality));
 			return nullptr;
 #endif // CUTTLEFISH_HAS_ASTC
-#if CUTTLEFISH_HAS_PVRTC
-		case Texture::Format::PVRTC1_RGB_2BPP:
-		case Texture::Format::PVRTC1_RGBA_2BPP:
-		case Texture::Format::PVRTC1_RGB_4BPP:
-		case Texture::Format::PVRTC1_RGBA_4BPP:
-		case Texture::Format::PVRTC2_RGBA_2BPP:
-		case Texture::Format::PVRTC2_RGBA_4BPP:
-			if (texture.type() == Texture::Type::UNorm)
-			{
-				return std::unique_ptr<Converter>(new PvrtcConverter(texture, image, quality,
-					threadCount));
-			}
-			return nullptr;
-#endif //CUTTLEFISH_HAS_PVRTC
 		default:
 			return nullptr;
 	}
 }
 
-bool Converter::convert(const Texture& texture, MipImageList& images, MipTextureList& textureData,
-	Texture::Quality quality, unsigned int threadCount)
+bool Converter::convert(const Texture& texture, MipImageList& images, TextureArena& textureData,
+	Texture::Quality quality, unsigned int threadCount, const ConvertOptions& options)
 {
-	std::vector<std::pair<unsigned int, unsigned int>> jobs;
-	std::vector<std::unique_ptr<ThreadData>> threadData;
-	std::vector<std::thread> threads;
-	if (threadCount > 1)
+	BlockCache* blockCache = options.blockCache;
+	IncrementalBlocks* incrementalBlocks = options.incrementalBlocks;
+	std::size_t* outRefinedBlocks = options.outRefinedBlocks;
+	const SurfaceCallback* surfaceConverted = options.surfaceConverted;
+
+	// These are cleared below if they can't be used.
+	MipQualityMetricsList* outQualityMetrics = options.outQualityMetrics;
+	const MipGenerator* mipGenerator = options.mipGenerator;
+
+	if (outRefinedBlocks)
+		*outRefinedBlocks = 0;
+
+	// Quality metrics are computed by decoding the converted data, so only supported when it can
+	// be decoded.
+	if (outQualityMetrics)
 	{
-		threadData.reserve(threadCount);
-		threads.reserve(threadCount);
+		outQualityMetrics->clear();
+		if (Decoder::isFormatSupported(texture.format(), texture.type()))
+			outQualityMetrics->resize(images.size());
+		else
+			outQualityMetrics = nullptr;
 	}
 
-	textureData.resize(images.size());
-	for (unsigned int mip = 0; mip < images.size(); ++mip)
+	if (!textureData.initialize(texture, images))
+		return false;
+
+	// PVRTC converts every image in a single pass up front, leaving only the metrics and releasing
+	// the images for the loop below.
+	bool preConverted = false;
+#if CUTTLEFISH_HAS_PVRTC
+	if (PvrtcConverter::isFormatSupported(texture.format()))
 	{
-		textureData[mip].resize(images[mip].size());
-		for (unsigned int d = 0; d < images[mip].size(); ++d)
+		// All images are needed up front, so the mips can't be generated as they're converted.
+		if (mipGenerator)
 		{
-			textureData[mip][d].resize(images[mip][d].size());
-			for (unsigned int f = 0; f < images[mip][d].size(); ++f)
+			for (unsigned int d = 0; d < images[0].size(); ++d)
 			{
-				auto converter = createConverter(texture, images[mip][d][f], quality, threadCount);
-				if (!converter)
+				for (unsigned int f = 0; f < images[0][d].size(); ++f)
 				{
-					// If the converter can't be created, should only do so for the first one.
-					assert(mip == 0 && d == 0 && f == 0);
-					textureData.clear();
-					return false;
+					for (unsigned int mip = 0; mip + 1 < images.size(); ++mip)
+						(*mipGenerator)(images, mip, d, f);
 				}
+			}
+			mipGenerator = nullptr;
+		}
 
-				unsigned int jobsX = converter->jobsX();
-				unsigned int jobsY = converter->jobsY();
-				jobs.resize(jobsX*jobsY);
-				assert(!jobs.empty());
-				for (unsigned int y = 0; y < jobsY; ++y)
-				{
-					for (unsigned int x = 0; x < jobsX; ++x)
-						jobs[y*jobsX + x] = std::make_pair(x, y);
-				}
+		if (!PvrtcConverter::convert(texture, images, textureData, quality, threadCount))
+		{
+			textureData.reset();
+			return false;
+		}
+		preConverted = true;
+	}
+#endif
+
+	if (outQualityMetrics)
+	{
+		for (unsigned int mip = 0; mip < images.size(); ++mip)
+		{
+			(*outQualityMetrics)[mip].resize(images[mip].size());
+			for (unsigned int d = 0; d < images[mip].size(); ++d)
+				(*outQualityMetrics)[mip][d].resize(images[mip][d].size());
+		}
+	}
+
+	auto convertImage = [&](unsigned int mip, unsigned int d, unsigned int f) -> bool
+	{
+		if (!preConverted)
+		{
+			auto converter = createConverter(texture, images[mip][d][f], quality, threadCount);
+			if (!converter)
+			{
+				// If the converter can't be created, should only do so for the first one.
+				assert(mip == 0 && d == 0 && f == 0);
+				return false;
+			}
+
+			// The converter writes directly into the texture data.
+			assert(converter->dataSize() == textureData.size(mip, d, f));
+			if (converter->dataSize() != textureData.size(mip, d, f))
+				return false;
+
+			converter->setOutput(textureData.data(mip, d, f));
+			converter->setBlockCache(blockCache);
+			if (incrementalBlocks)
+			{
+				converter->setBlockHashes(incrementalBlocks->hashes(mip, d, f),
+					incrementalBlocks->previousHashes(mip, d, f),
+					incrementalBlocks->previousBlocks(mip, d, f));
+			}
+
+			converter->run(threadCount);
+
+			if (incrementalBlocks)
+				incrementalBlocks->addReusedBlocks(converter->reusedBlocks());
+			if (outRefinedBlocks)
+				*outRefinedBlocks += converter->refinedBlocks();
+		}
+
+		if (surfaceConverted)
+			(*surfaceConverted)(mip, d, f);
+
+		// Compute the metrics before the original image is released.
+		if (outQualityMetrics)
+		{
+			const Image& image = images[mip][d][f];
+			Image decodedImage;
+			if (!Decoder::decode(decodedImage, textureData.data(mip, d, f),
+					textureData.size(mip, d, f), texture.format(), texture.type(), image.width(),
+					image.height(), image.colorSpace(), threadCount) ||
+				!computeQualityMetrics((*outQualityMetrics)[mip][d][f], texture, image,
+					decodedImage, threadCount))
+			{
+				assert(false);
+				outQualityMetrics->clear();
+				outQualityMetrics = nullptr;
+			}
+		}
+
+		// The next mip level is generated from this image before it's released.
+		if (mipGenerator && mip + 1 < images.size())
+			(*mipGenerator)(images, mip, d, f);
+
+		images[mip][d][f].reset();
+		return true;
+	};
 
-				unsigned int curThreads = std::min(jobsX*jobsY, threadCount);
-				if (curThreads <= 1)
+	if (mipGenerator)
+	{
+		// Follow the mip chain for each image so only the current and next levels are resident.
+		for (unsigned int d = 0; d < images[0].size(); ++d)
+		{
+			for (unsigned int f = 0; f < images[0][d].size(); ++f)
+			{
+				for (unsigned int mip = 0; mip < images.size(); ++mip)
 				{
-					std::unique_ptr<ThreadData> singleThreadData = converter->createThreadData();
-					for (const std::pair<unsigned int, unsigned int>& job : jobs)
-						converter->process(job.first, job.second, singleThreadData.get());
+					if (!convertImage(mip, d, f))
+					{
+						if (!surfaceConverted)
+							textureData.reset();
+						return false;
+					}
 				}
-				else
+			}
+		}
+	}
+	else
+	{
+		for (unsigned int mip = 0; mip < images.size(); ++mip)
+		{
+			for (unsigned int d = 0; d < images[mip].size(); ++d)
+			{
+				for (unsigned int f = 0; f < images[mip][d].size(); ++f)
 				{
-					std::atomic<unsigned int> curJob(0);
-					// Initialize all thread data first in case they work with global data, such as
-					// library initialization. (some of which is beyond our control)
-					for (unsigned int i = 0; i < curThreads; ++i)
-						threadData.push_back(converter->createThreadData());
-
-					for (unsigned int i = 0; i < curThreads; ++i)
+					if (!convertImage(mip, d, f))
 					{
-						Converter::ThreadData* threadDataPtr = threadData[i].get();
-						threads.emplace_back([&curJob, &jobs, &converter, threadDataPtr]()
-							{
-								do
-								{
-									unsigned int thisJob = curJob++;
-									if (thisJob >= jobs.size())
-										return;
-
-									converter->process(jobs[thisJob].first, jobs[thisJob].second,
-										threadDataPtr);
-								} while (true);
-							});
+						if (!surfaceConverted)
+							textureData.reset();
+						return false;
 					}
-
-					for (std::thread& thread : threads)
-						thread.join();
-					threadData.clear();
-					threads.clear();
 				}
-
-				images[mip][d][f].reset();
-				textureData[mip][d][f] = std::move(converter->data());
 			}
 		}
 	}
@@ -592,9 +601,42 @@ bool Converter::convert(const Texture& texture, MipImageList& images, MipTexture
 	return true;
 }
 
-std::unique_ptr<Converter::ThreadData> Converter::createThreadData()
+bool Converter::useAdaptiveQuality(const Texture& texture, Texture::Quality quality)
+{
+	return texture.adaptiveQualityEnabled() &&
+		Texture::qualityRank(texture.adaptiveFastQuality()) < Texture::qualityRank(quality);
+}
+
+float Converter::getAdaptiveErrorThreshold(const Texture& texture)
+{
+	float threshold = texture.adaptiveErrorThreshold();
+	if (threshold < 0.0f)
+		return Texture::defaultAdaptiveErrorThreshold(texture.format(), texture.type());
+	return threshold;
+}
+
+bool Converter::findBlock(void* outBlock, unsigned int index, const BlockCache::Key& key,
+	unsigned int blockSize)
+{
+	if (m_blockHashes)
+	{
+		m_blockHashes[index] = key;
+		if (m_previousBlockHashes && m_previousBlockHashes[index] == key)
+		{
+			std::memcpy(outBlock, m_previousBlocks + index*blockSize, blockSize);
+			++m_reusedBlocks;
+			addBlock(outBlock, key, blockSize);
+			return true;
+		}
+	}
+
+	return m_blockCache && m_blockCache->find(outBlock, key, blockSize);
+}
+
+void Converter::addBlock(const void* block, const BlockCache::Key& key, unsigned int blockSize)
 {
-	return nullptr;
+	if (m_blockCache)
+		m_blockCache->insert(key, block, blockSize);
 }
 
 } // namespace cuttlefish
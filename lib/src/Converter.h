@@ -19,60 +19,143 @@
 #include <cuttlefish/Config.h>
 #include <cuttlefish/Image.h>
 #include <cuttlefish/Texture.h>
+#include "BlockCache.h"
+#include "JobProcessor.h"
+#include "TextureArena.h"
+#include <atomic>
 #include <cassert>
+#include <functional>
 #include <memory>
 #include <vector>
 
 namespace cuttlefish
 {
 
+class IncrementalBlocks;
 class Texture;
 
-class Converter
+class Converter : public JobProcessor
 {
 public:
 	using FaceImageList = std::vector<Image>;
 	using DepthImageList = std::vector<FaceImageList>;
 	using MipImageList = std::vector<DepthImageList>;
 
-	using TextureData = std::vector<std::uint8_t>;
-	using FaceTextureList = std::vector<TextureData>;
-	using DepthTextureList = std::vector<FaceTextureList>;
-	using MipTextureList = std::vector<DepthTextureList>;
+	using FaceQualityMetricsList = std::vector<Texture::QualityMetrics>;
+	using DepthQualityMetricsList = std::vector<FaceQualityMetricsList>;
+	using MipQualityMetricsList = std::vector<DepthQualityMetricsList>;
 
-	class ThreadData
+	// Generates images[mip + 1][depth][face] from images[mip][depth][face]. Only used for textures
+	// with the same number of depth levels for each mip.
+	using MipGenerator = std::function<void(MipImageList& images, unsigned int mip,
+		unsigned int depth, unsigned int face)>;
+
+	// Notified after the converted data for textureData.data(mip, depth, face) is complete.
+	using SurfaceCallback = std::function<void(unsigned int mip, unsigned int depth,
+		unsigned int face)>;
+
+	// Optional state used during conversion, where null members are ignored.
+	struct ConvertOptions
 	{
-	public:
-		virtual ~ThreadData() = default;
+		// Cache to share encoded blocks between images.
+		BlockCache* blockCache = nullptr;
+
+		// Block hashes to compute, along with blocks to reuse from a previous conversion.
+		IncrementalBlocks* incrementalBlocks = nullptr;
+
+		// Set to the number of blocks encoded again with the full quality for adaptive quality.
+		std::size_t* outRefinedBlocks = nullptr;
+
+		// Set to the quality metrics for each image when the format can be decoded.
+		MipQualityMetricsList* outQualityMetrics = nullptr;
+
+		// When provided, only the first mip level needs to be present in the images. Each mip
+		// level is then generated after the previous level has been converted and before it's
+		// released.
+		const MipGenerator* mipGenerator = nullptr;
+
+		// When provided, it's called as each image finishes converting, allowing the data to be
+		// used while the remaining images are converted.
+		const SurfaceCallback* surfaceConverted = nullptr;
 	};
 
-	static bool convert(const Texture& texture, MipImageList& images, MipTextureList& textureData,
-		Texture::Quality quality, unsigned int threadCount);
+	// The converted data for all images is written directly to textureData, which is laid out
+	// based on images. textureData is reset if conversion fails, except when surfaceConverted is
+	// provided since the data may still be in use. In that case the caller must reset textureData
+	// once it's done with the data.
+	static bool convert(const Texture& texture, MipImageList& images, TextureArena& textureData,
+		Texture::Quality quality, unsigned int threadCount, const ConvertOptions& options);
+
+	// Whether or not blocks should first be encoded with the adaptive fast quality.
+	static bool useAdaptiveQuality(const Texture& texture, Texture::Quality quality);
+
+	// The error threshold for adaptive quality, resolving the default for the format.
+	static float getAdaptiveErrorThreshold(const Texture& texture);
 
 	explicit Converter(const Image& image)
-		: m_image(&image)
+		: m_image(&image), m_data(nullptr), m_dataSize(0), m_blockCache(nullptr),
+		m_blockHashes(nullptr),
+		m_previousBlockHashes(nullptr), m_previousBlocks(nullptr), m_reusedBlocks(0),
+		m_refinedBlocks(0)
 	{
 		assert(m_image->format() == Image::Format::RGBAF);
 	}
 
-	Converter(const Converter&) = delete;
-	Converter& operator=(const Converter&) = delete;
-
-	virtual ~Converter() = default;
+	~Converter() override = default;
 
 	const Image& image() const {return *m_image;}
 
-	std::vector<std::uint8_t>& data() {return m_data;}
-	const std::vector<std::uint8_t>& data() const {return m_data;}
+	// The output for the converted data, which is only available once set with setOutput().
+	std::uint8_t* data() {return m_data;}
+	const std::uint8_t* data() const {return m_data;}
+	std::size_t dataSize() const {return m_dataSize;}
+
+	// Sets the memory to write the converted data to, which must be at least dataSize() bytes.
+	void setOutput(std::uint8_t* output) {m_data = output;}
+
+	BlockCache* blockCache() const {return m_blockCache;}
+	void setBlockCache(BlockCache* blockCache) {m_blockCache = blockCache;}
+
+	// Hashes for each block to populate, along with the hashes and encoded blocks from a previous
+	// conversion to reuse unchanged blocks from. Only used by block compressed formats.
+	void setBlockHashes(BlockCache::Key* hashes, const BlockCache::Key* previousHashes,
+		const std::uint8_t* previousBlocks)
+	{
+		m_blockHashes = hashes;
+		m_previousBlockHashes = previousHashes;
+		m_previousBlocks = previousBlocks;
+	}
+
+	std::size_t reusedBlocks() const {return m_reusedBlocks;}
+
+	// Number of blocks that were encoded again with the full quality for adaptive quality.
+	std::size_t refinedBlocks() const {return m_refinedBlocks;}
+	void addRefinedBlock() {++m_refinedBlocks;}
+
+	// Whether or not block keys need to be computed for findBlock() and addBlock().
+	bool needsBlockKeys() const {return m_blockCache || m_blockHashes;}
+
+	// Finds an already encoded block, either from the previous conversion or the block cache.
+	bool findBlock(void* outBlock, unsigned int index, const BlockCache::Key& key,
+		unsigned int blockSize);
+
+	// Adds a newly encoded block to the block cache.
+	void addBlock(const void* block, const BlockCache::Key& key, unsigned int blockSize);
 
-	virtual unsigned int jobsX() const = 0;
-	virtual unsigned int jobsY() const = 0;
-	virtual void process(unsigned int x, unsigned int y, ThreadData* threadData) = 0;
-	virtual std::unique_ptr<ThreadData> createThreadData();
+protected:
+	// Sets the size of the converted data. This should be called from the subclass constructor.
+	void setDataSize(std::size_t size) {m_dataSize = size;}
 
 private:
 	const Image* m_image;
-	std::vector<std::uint8_t> m_data;
+	std::uint8_t* m_data;
+	std::size_t m_dataSize;
+	BlockCache* m_blockCache;
+	BlockCache::Key* m_blockHashes;
+	const BlockCache::Key* m_previousBlockHashes;
+	const std::uint8_t* m_previousBlocks;
+	std::atomic<std::size_t> m_reusedBlocks;
+	std::atomic<std::size_t> m_refinedBlocks;
 };
 
 } // namespace cuttlefish
@@ -0,0 +1,584 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Decoder.h"
+#include "BlockDecoder.h"
+#include "JobProcessor.h"
+#include "Shared.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#if CUTTLEFISH_CLANG || CUTTLEFISH_GCC
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wmissing-braces"
+#endif
+
+#if CUTTLEFISH_HAS_S3TC
+#include "cmp_core.h"
+#endif
+
+#if CUTTLEFISH_HAS_ASTC
+#include "astcenc.h"
+#endif
+
+#if CUTTLEFISH_HAS_PVRTC
+#include <PVRTexLib.hpp>
+#endif
+
+#include <glm/gtc/packing.hpp>
+
+#if CUTTLEFISH_CLANG || CUTTLEFISH_GCC
+#pragma GCC diagnostic pop
+#endif
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+const unsigned int blockPixels = 16;
+const unsigned int maxBlockDim = 12;
+
+using DecodeBlockFunction = void (*)(ColorRGBAf* outColors, const std::uint8_t* block);
+
+float unormToFloat(unsigned int value, unsigned int maxValue)
+{
+	return static_cast<float>(value)/static_cast<float>(maxValue);
+}
+
+float snormToFloat(int value, int maxValue)
+{
+	return std::max(static_cast<float>(value)/static_cast<float>(maxValue), -1.0f);
+}
+
+void toFloatColors(ColorRGBAf* outColors, const std::uint8_t colors[blockPixels][4], bool alpha)
+{
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		outColors[i].r = unormToFloat(colors[i][0], 0xFF);
+		outColors[i].g = unormToFloat(colors[i][1], 0xFF);
+		outColors[i].b = unormToFloat(colors[i][2], 0xFF);
+		outColors[i].a = alpha ? unormToFloat(colors[i][3], 0xFF) : 1.0f;
+	}
+}
+
+void decodeBc1RgbBlock(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint8_t colors[blockPixels][4];
+	decodeBc1(colors, block, true);
+	toFloatColors(outColors, colors, false);
+}
+
+void decodeBc1RgbaBlock(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint8_t colors[blockPixels][4];
+	decodeBc1(colors, block, true);
+	toFloatColors(outColors, colors, true);
+}
+
+void decodeBc2Block(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint8_t colors[blockPixels][4];
+	decodeBc2(colors, block);
+	toFloatColors(outColors, colors, true);
+}
+
+void decodeBc3Block(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint8_t colors[blockPixels][4];
+	decodeBc3(colors, block);
+	toFloatColors(outColors, colors, true);
+}
+
+void decodeBc4Block(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint8_t values[blockPixels];
+	decodeBc4(values, block, 1);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+		outColors[i] = ColorRGBAf(unormToFloat(values[i], 0xFF), 0.0f, 0.0f, 1.0f);
+}
+
+void decodeBc4SBlock(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::int8_t values[blockPixels];
+	decodeBc4S(values, block, 1);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+		outColors[i] = ColorRGBAf(snormToFloat(values[i], 127), 0.0f, 0.0f, 1.0f);
+}
+
+void decodeBc5Block(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint8_t values[blockPixels][2];
+	decodeBc4(values[0], block, 2);
+	decodeBc4(values[0] + 1, block + 8, 2);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		outColors[i] = ColorRGBAf(unormToFloat(values[i][0], 0xFF),
+			unormToFloat(values[i][1], 0xFF), 0.0f, 1.0f);
+	}
+}
+
+void decodeBc5SBlock(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::int8_t values[blockPixels][2];
+	decodeBc4S(values[0], block, 2);
+	decodeBc4S(values[0] + 1, block + 8, 2);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		outColors[i] = ColorRGBAf(snormToFloat(values[i][0], 127), snormToFloat(values[i][1], 127),
+			0.0f, 1.0f);
+	}
+}
+
+void decodeBc7Block(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint8_t colors[blockPixels][4];
+	decodeBc7(colors, block);
+	toFloatColors(outColors, colors, true);
+}
+
+void decodeEtc2RgbBlock(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint8_t colors[blockPixels][4];
+	decodeEtc2(colors, block, false);
+	toFloatColors(outColors, colors, false);
+}
+
+void decodeEtc2A1Block(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint8_t colors[blockPixels][4];
+	decodeEtc2(colors, block, true);
+	toFloatColors(outColors, colors, true);
+}
+
+void decodeEtc2RgbaBlock(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint8_t colors[blockPixels][4];
+	decodeEtc2(colors, block + 8, false);
+	decodeEtc2Alpha(colors[0] + 3, block, 4);
+	toFloatColors(outColors, colors, true);
+}
+
+void decodeEacR11Block(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint16_t values[blockPixels];
+	decodeEacR11(values, block, 1);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+		outColors[i] = ColorRGBAf(unormToFloat(values[i], 2047), 0.0f, 0.0f, 1.0f);
+}
+
+void decodeEacR11SBlock(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::int16_t values[blockPixels];
+	decodeEacR11S(values, block, 1);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+		outColors[i] = ColorRGBAf(snormToFloat(values[i], 1023), 0.0f, 0.0f, 1.0f);
+}
+
+void decodeEacR11G11Block(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::uint16_t values[blockPixels][2];
+	decodeEacR11(values[0], block, 2);
+	decodeEacR11(values[0] + 1, block + 8, 2);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		outColors[i] = ColorRGBAf(unormToFloat(values[i][0], 2047),
+			unormToFloat(values[i][1], 2047), 0.0f, 1.0f);
+	}
+}
+
+void decodeEacR11G11SBlock(ColorRGBAf* outColors, const std::uint8_t* block)
+{
+	std::int16_t values[blockPixels][2];
+	decodeEacR11S(values[0], block, 2);
+	decodeEacR11S(values[0] + 1, block + 8, 2);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		outColors[i] = ColorRGBAf(snormToFloat(values[i][0], 1023),
+			snormToFloat(values[i][1], 1023), 0.0f, 1.0f);
+	}
+}
+
+// Gets the function to decode a 4x4 block that's handled without any external library.
+DecodeBlockFunction getDecodeBlockFunction(Texture::Format format, Texture::Type type)
+{
+	bool unorm = type == Texture::Type::UNorm;
+	bool snorm = type == Texture::Type::SNorm;
+	switch (format)
+	{
+		case Texture::Format::BC1_RGB:
+			return unorm ? &decodeBc1RgbBlock : nullptr;
+		case Texture::Format::BC1_RGBA:
+			return unorm ? &decodeBc1RgbaBlock : nullptr;
+		case Texture::Format::BC2:
+			return unorm ? &decodeBc2Block : nullptr;
+		case Texture::Format::BC3:
+			return unorm ? &decodeBc3Block : nullptr;
+		case Texture::Format::BC4:
+			if (unorm)
+				return &decodeBc4Block;
+			return snorm ? &decodeBc4SBlock : nullptr;
+		case Texture::Format::BC5:
+			if (unorm)
+				return &decodeBc5Block;
+			return snorm ? &decodeBc5SBlock : nullptr;
+		case Texture::Format::BC7:
+			return unorm ? &decodeBc7Block : nullptr;
+		case Texture::Format::ETC1:
+		case Texture::Format::ETC2_R8G8B8:
+			return unorm ? &decodeEtc2RgbBlock : nullptr;
+		case Texture::Format::ETC2_R8G8B8A1:
+			return unorm ? &decodeEtc2A1Block : nullptr;
+		case Texture::Format::ETC2_R8G8B8A8:
+			return unorm ? &decodeEtc2RgbaBlock : nullptr;
+		case Texture::Format::EAC_R11:
+			if (unorm)
+				return &decodeEacR11Block;
+			return snorm ? &decodeEacR11SBlock : nullptr;
+		case Texture::Format::EAC_R11G11:
+			if (unorm)
+				return &decodeEacR11G11Block;
+			return snorm ? &decodeEacR11G11SBlock : nullptr;
+		default:
+			return nullptr;
+	}
+}
+
+#if CUTTLEFISH_HAS_ASTC
+bool isAstc(Texture::Format format)
+{
+	return format >= Texture::Format::ASTC_4x4 && format <= Texture::Format::ASTC_12x12;
+}
+#endif
+
+// Decodes a row of blocks for each job since a single block is too cheap to decode to be worth
+// a job of its own.
+class BlockDecodeJobs : public JobProcessor
+{
+public:
+	BlockDecodeJobs(Image& image, const std::uint8_t* data, Texture::Format format)
+		: m_image(image), m_data(data), m_blockWidth(Texture::blockWidth(format)),
+		m_blockHeight(Texture::blockHeight(format)), m_blockSize(Texture::blockSize(format)),
+		m_blocksX((image.width() + m_blockWidth - 1)/m_blockWidth),
+		m_blocksY((image.height() + m_blockHeight - 1)/m_blockHeight)
+	{
+		assert(m_blockWidth <= maxBlockDim && m_blockHeight <= maxBlockDim);
+	}
+
+	static std::size_t dataSize(unsigned int width, unsigned int height, Texture::Format format)
+	{
+		unsigned int blockWidth = Texture::blockWidth(format);
+		unsigned int blockHeight = Texture::blockHeight(format);
+		return static_cast<std::size_t>((width + blockWidth - 1)/blockWidth)*
+			((height + blockHeight - 1)/blockHeight)*Texture::blockSize(format);
+	}
+
+	unsigned int jobsX() const override {return 1;}
+	unsigned int jobsY() const override {return m_blocksY;}
+
+	void process(unsigned int, unsigned int y, ThreadData* threadData) override
+	{
+		ColorRGBAf colors[maxBlockDim*maxBlockDim];
+		unsigned int height = std::min(m_blockHeight, m_image.height() - y*m_blockHeight);
+		for (unsigned int x = 0; x < m_blocksX; ++x)
+		{
+			decodeBlock(colors, m_data + (y*m_blocksX + x)*m_blockSize, threadData);
+
+			// Clip the partial blocks along the right and bottom edges.
+			unsigned int width = std::min(m_blockWidth, m_image.width() - x*m_blockWidth);
+			for (unsigned int j = 0; j < height; ++j)
+			{
+				auto scanline = reinterpret_cast<ColorRGBAf*>(
+					m_image.scanline(y*m_blockHeight + j));
+				std::memcpy(scanline + x*m_blockWidth, colors + j*m_blockWidth,
+					width*sizeof(ColorRGBAf));
+			}
+		}
+	}
+
+protected:
+	virtual void decodeBlock(ColorRGBAf* outColors, const std::uint8_t* block,
+		ThreadData* threadData) = 0;
+
+	Image& m_image;
+	const std::uint8_t* m_data;
+	unsigned int m_blockWidth;
+	unsigned int m_blockHeight;
+	unsigned int m_blockSize;
+	unsigned int m_blocksX;
+	unsigned int m_blocksY;
+};
+
+class FunctionDecodeJobs : public BlockDecodeJobs
+{
+public:
+	FunctionDecodeJobs(Image& image, const std::uint8_t* data, Texture::Format format,
+		DecodeBlockFunction function)
+		: BlockDecodeJobs(image, data, format), m_function(function)
+	{
+	}
+
+protected:
+	void decodeBlock(ColorRGBAf* outColors, const std::uint8_t* block, ThreadData*) override
+	{
+		m_function(outColors, block);
+	}
+
+private:
+	DecodeBlockFunction m_function;
+};
+
+#if CUTTLEFISH_HAS_S3TC
+class Bc6HDecodeJobs : public BlockDecodeJobs
+{
+public:
+	Bc6HDecodeJobs(Image& image, const std::uint8_t* data, bool keepSign)
+		: BlockDecodeJobs(image, data, Texture::Format::BC6H), m_options(nullptr)
+	{
+		CreateOptionsBC6(&m_options);
+		assert(m_options);
+		SetSignedBC6(m_options, keepSign);
+	}
+
+	~Bc6HDecodeJobs()
+	{
+		DestroyOptionsBC6(m_options);
+	}
+
+protected:
+	void decodeBlock(ColorRGBAf* outColors, const std::uint8_t* block, ThreadData*) override
+	{
+		std::uint16_t colorBlock[blockPixels][3];
+		DecompressBlockBC6(block, reinterpret_cast<std::uint16_t*>(colorBlock), m_options);
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			outColors[i].r = glm::unpackHalf1x16(colorBlock[i][0]);
+			outColors[i].g = glm::unpackHalf1x16(colorBlock[i][1]);
+			outColors[i].b = glm::unpackHalf1x16(colorBlock[i][2]);
+			outColors[i].a = 1.0f;
+		}
+	}
+
+private:
+	void* m_options;
+};
+#endif // CUTTLEFISH_HAS_S3TC
+
+#if CUTTLEFISH_HAS_ASTC
+class AstcDecodeJobs : public BlockDecodeJobs
+{
+public:
+	class AstcThreadData : public ThreadData
+	{
+	public:
+		explicit AstcThreadData(const astcenc_config& config)
+			: context(nullptr)
+		{
+			astcenc_context_alloc(&config, 1, &context);
+		}
+
+		~AstcThreadData()
+		{
+			if (context)
+				astcenc_context_free(context);
+		}
+
+		astcenc_context* context;
+	};
+
+	AstcDecodeJobs(Image& image, const std::uint8_t* data, Texture::Format format, bool hdr)
+		: BlockDecodeJobs(image, data, format)
+	{
+		astcenc_config_init(hdr ? ASTCENC_PRF_HDR : ASTCENC_PRF_LDR, m_blockWidth, m_blockHeight,
+			1, ASTCENC_PRE_FASTEST, ASTCENC_FLG_DECOMPRESS_ONLY, &m_config);
+	}
+
+	std::unique_ptr<ThreadData> createThreadData() override
+	{
+		return std::unique_ptr<ThreadData>(new AstcThreadData(m_config));
+	}
+
+protected:
+	void decodeBlock(ColorRGBAf* outColors, const std::uint8_t* block,
+		ThreadData* threadData) override
+	{
+		void* rows[maxBlockDim];
+		for (unsigned int j = 0; j < m_blockHeight; ++j)
+			rows[j] = outColors + j*m_blockWidth;
+
+		astcenc_image image;
+		image.dim_x = m_blockWidth;
+		image.dim_y = m_blockHeight;
+		image.dim_z = 1;
+		image.data_type = ASTCENC_TYPE_F32;
+		image.data = rows;
+
+		const astcenc_swizzle swizzle = {ASTCENC_SWZ_R, ASTCENC_SWZ_G, ASTCENC_SWZ_B,
+			ASTCENC_SWZ_A};
+		astcenc_context* context = static_cast<AstcThreadData*>(threadData)->context;
+		astcenc_decompress_image(context, block, m_blockSize, &image, &swizzle, 0);
+		astcenc_decompress_reset(context);
+	}
+
+private:
+	astcenc_config m_config;
+};
+#endif // CUTTLEFISH_HAS_ASTC
+
+#if CUTTLEFISH_HAS_PVRTC
+// PVRTC blocks depend on their neighbors, so the full image is decoded with PVRTexLib in a
+// single job.
+class PvrtcDecodeJobs : public JobProcessor
+{
+public:
+	PvrtcDecodeJobs(Image& image, const void* data, std::size_t dataSize, Texture::Format format)
+		: m_image(image), m_data(data), m_dataSize(dataSize), m_format(format)
+	{
+	}
+
+	unsigned int jobsX() const override {return 1;}
+	unsigned int jobsY() const override {return 1;}
+
+	void process(unsigned int, unsigned int, ThreadData*) override
+	{
+		PVRTuint64 pixelType;
+		switch (m_format)
+		{
+			case Texture::Format::PVRTC1_RGB_2BPP:
+				pixelType = PVRTLPF_PVRTCI_2bpp_RGB;
+				break;
+			case Texture::Format::PVRTC1_RGBA_2BPP:
+				pixelType = PVRTLPF_PVRTCI_2bpp_RGBA;
+				break;
+			case Texture::Format::PVRTC1_RGB_4BPP:
+				pixelType = PVRTLPF_PVRTCI_4bpp_RGB;
+				break;
+			case Texture::Format::PVRTC1_RGBA_4BPP:
+				pixelType = PVRTLPF_PVRTCI_4bpp_RGBA;
+				break;
+			case Texture::Format::PVRTC2_RGBA_2BPP:
+				pixelType = PVRTLPF_PVRTCII_2bpp;
+				break;
+			case Texture::Format::PVRTC2_RGBA_4BPP:
+				pixelType = PVRTLPF_PVRTCII_4bpp;
+				break;
+			default:
+				assert(false);
+				return;
+		}
+
+		unsigned int width = m_image.width(), height = m_image.height();
+		pvrtexlib::PVRTexture pvrTexture(pvrtexlib::PVRTextureHeader(pixelType, width, height, 1,
+			1, 1, 1, PVRTLCS_Linear, PVRTLVT_UnsignedByteNorm, false), nullptr);
+		std::memcpy(pvrTexture.GetTextureDataPointer(), m_data,
+			std::min(m_dataSize, static_cast<std::size_t>(pvrTexture.GetTextureDataSize())));
+
+		const PVRTuint64 outPixelType = PVRTGENPIXELID4('r', 'g', 'b', 'a', 8, 8, 8, 8);
+		pvrTexture.Transcode(outPixelType, PVRTLVT_UnsignedByteNorm, PVRTLCS_Linear);
+
+		bool alpha = m_format != Texture::Format::PVRTC1_RGB_2BPP &&
+			m_format != Texture::Format::PVRTC1_RGB_4BPP;
+		auto colors = reinterpret_cast<const std::uint8_t*>(pvrTexture.GetTextureDataPointer());
+		for (unsigned int y = 0; y < height; ++y)
+		{
+			auto scanline = reinterpret_cast<ColorRGBAf*>(m_image.scanline(y));
+			for (unsigned int x = 0; x < width; ++x)
+			{
+				const std::uint8_t* color = colors + (y*width + x)*4;
+				scanline[x].r = unormToFloat(color[0], 0xFF);
+				scanline[x].g = unormToFloat(color[1], 0xFF);
+				scanline[x].b = unormToFloat(color[2], 0xFF);
+				scanline[x].a = alpha ? unormToFloat(color[3], 0xFF) : 1.0f;
+			}
+		}
+	}
+
+private:
+	Image& m_image;
+	const void* m_data;
+	std::size_t m_dataSize;
+	Texture::Format m_format;
+};
+#endif // CUTTLEFISH_HAS_PVRTC
+
+} // namespace
+
+bool Decoder::isFormatSupported(Texture::Format format, Texture::Type type)
+{
+	if (getDecodeBlockFunction(format, type))
+		return true;
+
+#if CUTTLEFISH_HAS_S3TC
+	if (format == Texture::Format::BC6H &&
+		(type == Texture::Type::UFloat || type == Texture::Type::Float))
+	{
+		return true;
+	}
+#endif
+
+#if CUTTLEFISH_HAS_ASTC
+	if (isAstc(format) && (type == Texture::Type::UNorm || type == Texture::Type::UFloat))
+		return true;
+#endif
+
+#if CUTTLEFISH_HAS_PVRTC
+	if (isPvrtc(format) && type == Texture::Type::UNorm)
+		return true;
+#endif
+
+	return false;
+}
+
+bool Decoder::decode(Image& outImage, const void* data, std::size_t dataSize,
+	Texture::Format format, Texture::Type type, unsigned int width, unsigned int height,
+	ColorSpace colorSpace, unsigned int threadCount)
+{
+	if (!data || !isFormatSupported(format, type) || width == 0 || height == 0)
+		return false;
+
+	// PVRTC data is padded to the minimum dimensions rather than whole blocks.
+	if (!isPvrtc(format) && dataSize < BlockDecodeJobs::dataSize(width, height, format))
+		return false;
+
+	if (!outImage.initialize(Image::Format::RGBAF, width, height, colorSpace))
+		return false;
+
+	auto bytes = reinterpret_cast<const std::uint8_t*>(data);
+	std::unique_ptr<JobProcessor> jobs;
+	if (DecodeBlockFunction function = getDecodeBlockFunction(format, type))
+		jobs.reset(new FunctionDecodeJobs(outImage, bytes, format, function));
+#if CUTTLEFISH_HAS_S3TC
+	else if (format == Texture::Format::BC6H)
+		jobs.reset(new Bc6HDecodeJobs(outImage, bytes, type == Texture::Type::Float));
+#endif
+#if CUTTLEFISH_HAS_ASTC
+	else if (isAstc(format))
+		jobs.reset(new AstcDecodeJobs(outImage, bytes, format, type == Texture::Type::UFloat));
+#endif
+#if CUTTLEFISH_HAS_PVRTC
+	else if (isPvrtc(format))
+		jobs.reset(new PvrtcDecodeJobs(outImage, data, dataSize, format));
+#endif
+
+	assert(jobs);
+	jobs->run(threadCount);
+	return true;
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+#include <cstddef>
+
+namespace cuttlefish
+{
+
+class Decoder
+{
+public:
+	static bool isFormatSupported(Texture::Format format, Texture::Type type);
+
+	// Decodes the data for a single surface of a texture to an RGBAF image.
+	static bool decode(Image& outImage, const void* data, std::size_t dataSize,
+		Texture::Format format, Texture::Type type, unsigned int width, unsigned int height,
+		ColorSpace colorSpace, unsigned int threadCount);
+};
+
+} // namespace cuttlefish
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EncoderStateCache.h"
+#include <algorithm>
+#include <list>
+#include <thread>
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+struct Entry
+{
+	Entry(const EncoderStateCache::Key& _key, std::unique_ptr<EncoderStateCache::State> _state)
+		: key(_key), state(std::move(_state))
+	{
+	}
+
+	EncoderStateCache::Key key;
+	std::unique_ptr<EncoderStateCache::State> state;
+};
+
+// Most recently released states are at the front.
+thread_local std::list<Entry> t_states;
+
+} // namespace
+
+const unsigned int EncoderStateCache::maxStates =
+	4*std::max(std::thread::hardware_concurrency(), 1U);
+
+std::unique_ptr<EncoderStateCache::State> EncoderStateCache::acquire(const Key& key)
+{
+	for (auto it = t_states.begin(); it != t_states.end(); ++it)
+	{
+		if (!(it->key == key))
+			continue;
+
+		std::unique_ptr<State> state = std::move(it->state);
+		t_states.erase(it);
+		return state;
+	}
+
+	return nullptr;
+}
+
+void EncoderStateCache::release(const Key& key, std::unique_ptr<State> state)
+{
+	if (!state)
+		return;
+
+	while (t_states.size() >= maxStates)
+		t_states.pop_back();
+
+	t_states.emplace_front(key, std::move(state));
+}
+
+std::size_t EncoderStateCache::size()
+{
+	return t_states.size();
+}
+
+void EncoderStateCache::clear()
+{
+	t_states.clear();
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Export.h>
+#include <cuttlefish/Texture.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace cuttlefish
+{
+
+/**
+ * @brief Cache of encoder state that's expensive to set up, such as encoder contexts and option
+ *     blocks.
+ *
+ * Converters are created for every face and mip level, and thread data for every run, so setting
+ * up the encoder state each time can dominate the time for small textures. States are instead
+ * returned to the cache when they're done and re-used by later converters with the same key,
+ * including across textures.
+ *
+ * Converters and thread data are always created and destroyed on the thread that performs the
+ * conversion, with the worker threads only using the states they're given. The cache is therefore
+ * kept per thread, so acquiring and releasing states never takes a lock.
+ */
+class CUTTLEFISH_EXPORT EncoderStateCache
+{
+public:
+	/**
+	 * @brief The maximum number of states kept per thread. The least recently released states are
+	 * destroyed first.
+	 */
+	static const unsigned int maxStates;
+
+	/**
+	 * @brief The kind of encoder state, which distinguishes states for the same format.
+	 */
+	enum class Kind
+	{
+		AstcContext,           ///< astcenc context.
+		CompressonatorOptions, ///< Compressonator options for BC4, BC5, and BC6H.
+		Bc6hIspcSettings,      ///< ispc_texcomp settings for BC6H.
+		Bc7Params              ///< bc7e or bc7enc parameters for BC7.
+	};
+
+	/**
+	 * @brief Base class for a cached state. The destructor frees any resources for the state.
+	 */
+	class State
+	{
+	public:
+		virtual ~State() = default;
+	};
+
+	/**
+	 * @brief State holding a plain value, such as a parameter struct.
+	 */
+	template <typename T>
+	class Value : public State
+	{
+	public:
+		T value;
+	};
+
+	/**
+	 * @brief Key to look up a state.
+	 */
+	class Key
+	{
+	public:
+		/**
+		 * @brief Constructs the key.
+		 * @param kind The kind of state.
+		 * @param format The texture format.
+		 * @param type The texture type.
+		 * @param quality The quality the state was set up for.
+		 * @param params Any further parameters used to set up the state. This must be a trivially
+		 *     copyable type, and is compared by its bytes.
+		 */
+		template <typename T>
+		Key(Kind kind, Texture::Format format, Texture::Type type, Texture::Quality quality,
+			const T& params)
+		{
+			static_assert(std::is_trivially_copyable<T>::value,
+				"Key parameters must be trivially copyable.");
+			struct Header
+			{
+				Kind kind;
+				Texture::Format format;
+				Texture::Type type;
+				Texture::Quality quality;
+			};
+
+			Header header = {kind, format, type, quality};
+			m_data.reserve(sizeof(Header) + sizeof(T));
+			m_data.append(reinterpret_cast<const char*>(&header), sizeof(Header));
+			m_data.append(reinterpret_cast<const char*>(&params), sizeof(T));
+		}
+
+		/**
+		 * @brief Constructs the key without any further parameters.
+		 * @param kind The kind of state.
+		 * @param format The texture format.
+		 * @param type The texture type.
+		 * @param quality The quality the state was set up for.
+		 */
+		Key(Kind kind, Texture::Format format, Texture::Type type, Texture::Quality quality)
+			: Key(kind, format, type, quality, false)
+		{
+		}
+
+		bool operator==(const Key& other) const {return m_data == other.m_data;}
+
+	private:
+		std::string m_data;
+	};
+
+	/**
+	 * @brief Handle for a state acquired from the cache, which is returned to the cache when
+	 *     destroyed.
+	 */
+	template <typename T>
+	class Handle
+	{
+	public:
+		Handle() = default;
+
+		Handle(Key key, std::unique_ptr<T> state)
+			: m_key(new Key(std::move(key))), m_state(std::move(state))
+		{
+		}
+
+		Handle(Handle&&) = default;
+		Handle& operator=(Handle&& other)
+		{
+			reset();
+			m_key = std::move(other.m_key);
+			m_state = std::move(other.m_state);
+			return *this;
+		}
+
+		Handle(const Handle&) = delete;
+		Handle& operator=(const Handle&) = delete;
+
+		~Handle()
+		{
+			reset();
+		}
+
+		T* get() const {return m_state.get();}
+		T* operator->() const {return m_state.get();}
+		explicit operator bool() const {return m_state != nullptr;}
+
+		void reset()
+		{
+			if (m_state)
+				EncoderStateCache::release(*m_key, std::move(m_state));
+			m_key.reset();
+		}
+
+	private:
+		std::unique_ptr<Key> m_key;
+		std::unique_ptr<T> m_state;
+	};
+
+	/**
+	 * @brief Gets a state from the cache, creating it if one isn't available.
+	 * @param key The key for the state.
+	 * @param create Function to create a new state, returning a pointer to T, when one isn't in
+	 *     the cache.
+	 * @return The handle to the state.
+	 */
+	template <typename T, typename CreateFunc>
+	static Handle<T> get(Key key, CreateFunc&& create)
+	{
+		std::unique_ptr<State> state = acquire(key);
+		if (!state)
+			state.reset(create());
+		return Handle<T>(std::move(key), std::unique_ptr<T>(static_cast<T*>(state.release())));
+	}
+
+	/**
+	 * @brief Removes a state from the cache.
+	 * @param key The key for the state.
+	 * @return The state, or null if there wasn't a state with the key.
+	 */
+	static std::unique_ptr<State> acquire(const Key& key);
+
+	/**
+	 * @brief Returns a state to the cache.
+	 * @param key The key for the state.
+	 * @param state The state to return.
+	 */
+	static void release(const Key& key, std::unique_ptr<State> state);
+
+	/**
+	 * @brief Gets the number of states currently cached for this thread.
+	 * @return The number of states.
+	 */
+	static std::size_t size();
+
+	/**
+	 * @brief Destroys all states cached for this thread.
+	 */
+	static void clear();
+};
+
+} // namespace cuttlefish
@@ -17,40 +17,126 @@
 #if CUTTLEFISH_HAS_ETC
 
 #include "EtcConverter.h"
+#include "BlockCache.h"
+#include "ConstantBlock.h"
+#include "PreviewEncoder.h"
+#include "Shared.h"
 #include <cuttlefish/Color.h>
 #include <cassert>
 #include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <vector>
 
 #include <Etc.h>
 
+#if CUTTLEFISH_ISPC
+#include "ispc_texcomp.h"
+#endif
+
 namespace cuttlefish
 {
 
-EtcConverter::EtcConverter(const Texture& texture, const Image& image, Texture::Quality quality)
-	: Converter(image), m_jobsX((image.width() + blockDim - 1)/blockDim),
-	m_jobsY((image.height() + blockDim - 1)/blockDim)
+static std::uint8_t toUNorm8(float value)
+{
+	return static_cast<std::uint8_t>(std::round(clamp(value, 0.0f, 1.0f)*0xFF));
+}
+
+static bool getConstantColor(std::uint8_t outColor[4], const ColorRGBAf* pixels,
+	unsigned int pixelCount, unsigned int channelCount)
+{
+	const unsigned int maxPixels = EtcConverter::blockDim*EtcConverter::blockDim;
+	std::uint8_t colors[maxPixels][4];
+	for (unsigned int i = 0; i < pixelCount; ++i)
+	{
+		colors[i][0] = toUNorm8(pixels[i].r);
+		colors[i][1] = toUNorm8(pixels[i].g);
+		colors[i][2] = toUNorm8(pixels[i].b);
+		colors[i][3] = toUNorm8(pixels[i].a);
+	}
+
+	if (!isBlockConstant(colors[0], pixelCount, 4, channelCount))
+		return false;
+
+	std::memcpy(outColor, colors[0], sizeof(colors[0]));
+	return true;
+}
+
+static bool getConstantEacValue(std::uint16_t& outValue, const ColorRGBAf* pixels,
+	unsigned int pixelCount, unsigned int channel)
+{
+	const unsigned int maxPixels = EtcConverter::blockDim*EtcConverter::blockDim;
+	std::uint16_t values[maxPixels];
+	for (unsigned int i = 0; i < pixelCount; ++i)
+	{
+		float value = reinterpret_cast<const float*>(pixels + i)[channel];
+		values[i] = static_cast<std::uint16_t>(std::round(clamp(value, 0.0f, 1.0f)*2047));
+	}
+
+	if (!isBlockConstant(values, pixelCount, 1, 1))
+		return false;
+
+	outValue = values[0];
+	return true;
+}
+
+static bool getConstantSignedEacValue(std::int16_t& outValue, const ColorRGBAf* pixels,
+	unsigned int pixelCount, unsigned int channel)
+{
+	const unsigned int maxPixels = EtcConverter::blockDim*EtcConverter::blockDim;
+	std::int16_t values[maxPixels];
+	for (unsigned int i = 0; i < pixelCount; ++i)
+	{
+		float value = reinterpret_cast<const float*>(pixels + i)[channel];
+		values[i] = static_cast<std::int16_t>(std::round(clamp(value, -1.0f, 1.0f)*1023));
+	}
+
+	if (!isBlockConstant(values, pixelCount, 1, 1))
+		return false;
+
+	outValue = values[0];
+	return true;
+}
+
+static float getEffort(Texture::Quality quality)
 {
 	switch (quality)
 	{
+		case Texture::Quality::Preview:
 		case Texture::Quality::Lowest:
-			m_effort = ETCCOMP_MIN_EFFORT_LEVEL;
-			break;
+			return ETCCOMP_MIN_EFFORT_LEVEL;
 		case Texture::Quality::Low:
-			m_effort = (ETCCOMP_MIN_EFFORT_LEVEL + ETCCOMP_DEFAULT_EFFORT_LEVEL)/2;
-			break;
+			return (ETCCOMP_MIN_EFFORT_LEVEL + ETCCOMP_DEFAULT_EFFORT_LEVEL)/2;
 		case Texture::Quality::Normal:
-			m_effort = ETCCOMP_DEFAULT_EFFORT_LEVEL;
-			break;
+			return ETCCOMP_DEFAULT_EFFORT_LEVEL;
 		case Texture::Quality::High:
-			m_effort = (ETCCOMP_DEFAULT_EFFORT_LEVEL + ETCCOMP_MAX_EFFORT_LEVEL)/2;
-			break;
+			return (ETCCOMP_DEFAULT_EFFORT_LEVEL + ETCCOMP_MAX_EFFORT_LEVEL)/2;
 		case Texture::Quality::Highest:
-			m_effort = ETCCOMP_MAX_EFFORT_LEVEL;
-			break;
+			return ETCCOMP_MAX_EFFORT_LEVEL;
 		default:
 			assert(false);
-			break;
+			return ETCCOMP_DEFAULT_EFFORT_LEVEL;
+	}
+}
+
+class EtcConverter::EtcThreadData : public Converter::ThreadData
+{
+public:
+	std::vector<std::uint8_t> rowData;
+	std::vector<BlockCache::Key> rowKeys;
+	std::vector<bool> rowPending;
+};
+
+EtcConverter::EtcConverter(const Texture& texture, const Image& image, Texture::Quality quality)
+	: Converter(image), m_jobsX((image.width() + blockDim - 1)/blockDim),
+	m_jobsY((image.height() + blockDim - 1)/blockDim), m_uniformMask(texture.colorMask()),
+	m_effort(getEffort(quality)), m_fastEffort(m_effort), m_errorThreshold(0.0f),
+	m_preview(false), m_ispcSettings(nullptr)
+{
+	if (useAdaptiveQuality(texture, quality))
+	{
+		m_fastEffort = getEffort(texture.adaptiveFastQuality());
+		m_errorThreshold = getAdaptiveErrorThreshold(texture);
 	}
 
 	switch (texture.format())
@@ -114,41 +200,389 @@ EtcConverter::EtcConverter(const Texture& texture, const Image& image, Texture::
 			break;
 	}
 
-	data().resize(m_jobsX*m_jobsY*m_blockSize);
+	// Only consider the channels stored in the format when checking for uniform blocks.
+	switch (m_format)
+	{
+		case Etc::Image::Format::ETC1:
+		case Etc::Image::Format::RGB8:
+			m_uniformMask.a = false;
+			break;
+		case Etc::Image::Format::R11:
+		case Etc::Image::Format::SIGNED_R11:
+			m_uniformMask.g = false;
+			m_uniformMask.b = false;
+			m_uniformMask.a = false;
+			break;
+		case Etc::Image::Format::RG11:
+		case Etc::Image::Format::SIGNED_RG11:
+			m_uniformMask.b = false;
+			m_uniformMask.a = false;
+			break;
+		default:
+			break;
+	}
+
+	// Only the RGB formats have preview encoders, others use the lowest effort.
+	if (quality == Texture::Quality::Preview)
+	{
+		m_preview = m_format == Etc::Image::Format::ETC1 ||
+			m_format == Etc::Image::Format::RGB8 || m_format == Etc::Image::Format::RGBA8;
+	}
+
+#if CUTTLEFISH_ISPC
+	// ispc_texcomp is much faster than etc2comp at low effort levels. ETC1 blocks are also valid
+	// for ETC2 RGB.
+	if ((quality == Texture::Quality::Lowest || quality == Texture::Quality::Low) &&
+		m_fastEffort == m_effort && (m_format == Etc::Image::Format::ETC1 ||
+			m_format == Etc::Image::Format::RGB8))
+	{
+		m_ispcSettings = new etc_enc_settings;
+		GetProfile_etc_slow(m_ispcSettings);
+	}
+#endif
+
+	setDataSize(m_jobsX*m_jobsY*m_blockSize);
 }
 
-void EtcConverter::process(unsigned int x, unsigned int y, ThreadData*)
+EtcConverter::~EtcConverter()
 {
+#if CUTTLEFISH_ISPC
+	delete m_ispcSettings;
+#endif
+}
+
+void EtcConverter::process(unsigned int x, unsigned int y, ThreadData* threadData)
+{
+	if (m_ispcSettings)
+	{
+		assert(x == 0);
+		CUTTLEFISH_UNUSED(x);
+		processRow(y, static_cast<EtcThreadData*>(threadData));
+		return;
+	}
+
 	ColorRGBAf pixels[blockDim*blockDim];
+	unsigned int width, height;
+	loadBlock(pixels, width, height, x, y);
+
+	unsigned int blockIndex = y*m_jobsX + x;
+	void* block = data() + blockIndex*m_blockSize;
+	unsigned int pixelCount = width*height;
+
+	bool useKey = needsBlockKeys();
+	BlockCache::Key key = {};
+	if (useKey)
+	{
+		key = computeBlockKey(pixels, width, height);
+		if (findBlock(block, blockIndex, key, m_blockSize))
+			return;
+	}
+
+	bool encoded = false;
+	float effort = m_effort;
+	if (getBlockRange(pixels, pixelCount, m_uniformMask) <= nearConstantBlockThreshold)
+	{
+		encoded = encodeConstantBlock(block, pixels, pixelCount);
+
+		// Nearly constant blocks don't benefit from a more thorough search.
+		effort = ETCCOMP_MIN_EFFORT_LEVEL;
+	}
+
+	if (!encoded && m_preview)
+		encodePreviewBlock(block, pixels, width, height);
+	else if (!encoded)
+	{
+		// Signed formats expect inputs in the range [0, 1].
+		if (m_format == Etc::Image::Format::SIGNED_R11 ||
+			m_format == Etc::Image::Format::SIGNED_RG11)
+		{
+			for (unsigned int j = 0, index = 0; j < blockDim; ++j)
+			{
+				for (unsigned int i = 0; i < blockDim; ++i, ++index)
+				{
+					pixels[index].r = pixels[index].r*0.5f + 0.5f;
+					pixels[index].g = pixels[index].g*0.5f + 0.5f;
+				}
+			}
+		}
+
+		if (effort > m_fastEffort)
+		{
+			float error = encodeBlock(block, pixels, width, height, m_fastEffort);
+			if (error > m_errorThreshold)
+			{
+				encodeBlock(block, pixels, width, height, effort);
+				addRefinedBlock();
+			}
+		}
+		else
+			encodeBlock(block, pixels, width, height, effort);
+	}
+
+	if (useKey)
+		addBlock(block, key, m_blockSize);
+}
+
+std::unique_ptr<Converter::ThreadData> EtcConverter::createThreadData()
+{
+	// Only the row path needs per-thread buffers.
+	if (!m_ispcSettings)
+		return nullptr;
+	return std::unique_ptr<ThreadData>(new EtcThreadData);
+}
+
+void EtcConverter::loadBlock(ColorRGBAf* outPixels, unsigned int& outWidth,
+	unsigned int& outHeight, unsigned int x, unsigned int y) const
+{
 	unsigned int limitX = std::min((x + 1)*blockDim, image().width());
 	unsigned int limitY = std::min((y + 1)*blockDim, image().height());
 	for (unsigned int j = y*blockDim, index = 0; j < limitY; ++j)
 	{
 		auto scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(j));
 		for (unsigned int i = x*blockDim; i < limitX; ++i, ++index)
-			pixels[index] = scanline[i];
+			outPixels[index] = scanline[i];
 	}
 
-	// Signed formats expect inputs in the range [0, 1].
-	if (m_format == Etc::Image::Format::SIGNED_R11 || m_format == Etc::Image::Format::SIGNED_RG11)
+	outWidth = limitX - x*blockDim;
+	outHeight = limitY - y*blockDim;
+}
+
+BlockCache::Key EtcConverter::computeBlockKey(const ColorRGBAf* pixels, unsigned int width,
+	unsigned int height) const
+{
+	// Only the pixels within the image are encoded, so include the dimensions to distinguish
+	// partial blocks.
+	return BlockCache::computeKey(pixels, width*height*sizeof(ColorRGBAf), width | height << 8);
+}
+
+void EtcConverter::processRow(unsigned int y, EtcThreadData* threadData)
+{
+	// Blocks are handled the same as process() before encoding, so the results don't depend on
+	// whether the blocks are tracked. Spans of the remaining blocks are then encoded together.
+	bool useKey = needsBlockKeys();
+	auto blocks = data() + y*m_jobsX*m_blockSize;
+	threadData->rowKeys.resize(m_jobsX);
+	threadData->rowPending.assign(m_jobsX, false);
+	bool anyPending = false;
+	for (unsigned int x = 0; x < m_jobsX; ++x)
 	{
-		for (unsigned int j = 0, index = 0; j < blockDim; ++j)
+		ColorRGBAf pixels[blockDim*blockDim];
+		unsigned int width, height;
+		loadBlock(pixels, width, height, x, y);
+		auto block = blocks + x*m_blockSize;
+		if (useKey)
 		{
-			for (unsigned int i = 0; i < blockDim; ++i, ++index)
-			{
-				pixels[index].r = pixels[index].r*0.5f + 0.5f;
-				pixels[index].g = pixels[index].g*0.5f + 0.5f;
-			}
+			BlockCache::Key& key = threadData->rowKeys[x];
+			key = computeBlockKey(pixels, width, height);
+			if (findBlock(block, y*m_jobsX + x, key, m_blockSize))
+				continue;
 		}
+
+		unsigned int pixelCount = width*height;
+		if (getBlockRange(pixels, pixelCount, m_uniformMask) <= nearConstantBlockThreshold &&
+			encodeConstantBlock(block, pixels, pixelCount))
+		{
+			if (useKey)
+				addBlock(block, threadData->rowKeys[x], m_blockSize);
+			continue;
+		}
+
+		threadData->rowPending[x] = true;
+		anyPending = true;
 	}
 
-	Etc::Image etcImage(reinterpret_cast<float*>(pixels), limitX - x*blockDim, limitY - y*blockDim,
-		m_metric);
-	etcImage.Encode(m_format, m_metric, m_effort, 1, 1);
+	if (!anyPending)
+		return;
+
+	for (unsigned int x = 0; x < m_jobsX;)
+	{
+		if (!threadData->rowPending[x])
+		{
+			++x;
+			continue;
+		}
+
+		unsigned int spanEnd = x + 1;
+		while (spanEnd < m_jobsX && threadData->rowPending[spanEnd])
+			++spanEnd;
+		encodeRowSpan(y, x, spanEnd - x, threadData);
+		if (useKey)
+		{
+			for (; x < spanEnd; ++x)
+				addBlock(blocks + x*m_blockSize, threadData->rowKeys[x], m_blockSize);
+		}
+		x = spanEnd;
+	}
+}
+
+void EtcConverter::encodeRowSpan(unsigned int y, unsigned int firstBlock, unsigned int blockCount,
+	EtcThreadData* threadData)
+{
+#if CUTTLEFISH_ISPC
+	// Pad the span to a multiple of the block size with the edge pixels.
+	unsigned int spanStart = firstBlock*blockDim;
+	unsigned int spanWidth = blockCount*blockDim;
+	threadData->rowData.resize(spanWidth*blockDim*4);
+	for (unsigned int j = 0; j < blockDim; ++j)
+	{
+		std::uint8_t* row = threadData->rowData.data() + j*spanWidth*4;
+		auto scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(
+			std::min(y*blockDim + j, image().height() - 1)));
+		for (unsigned int i = 0; i < spanWidth; ++i)
+		{
+			const ColorRGBAf& pixel = scanline[std::min(spanStart + i, image().width() - 1)];
+			row[i*4] = toUNorm8(pixel.r);
+			row[i*4 + 1] = toUNorm8(pixel.g);
+			row[i*4 + 2] = toUNorm8(pixel.b);
+			row[i*4 + 3] = 0xFF;
+		}
+	}
+
+	rgba_surface surface = {threadData->rowData.data(), static_cast<std::int32_t>(spanWidth),
+		blockDim, static_cast<std::int32_t>(spanWidth*4)};
+	CompressBlocksETC1(&surface, data() + (y*m_jobsX + firstBlock)*m_blockSize, m_ispcSettings);
+#else
+	CUTTLEFISH_UNUSED(y);
+	CUTTLEFISH_UNUSED(firstBlock);
+	CUTTLEFISH_UNUSED(blockCount);
+	CUTTLEFISH_UNUSED(threadData);
+	assert(false);
+#endif
+}
+
+float EtcConverter::encodeBlock(void* block, ColorRGBAf* pixels, unsigned int width,
+	unsigned int height, float effort)
+{
+	Etc::Image etcImage(reinterpret_cast<float*>(pixels), width, height, m_metric);
+	etcImage.Encode(m_format, m_metric, effort, 1, 1);
 
 	assert(etcImage.GetEncodingBitsBytes() == m_blockSize);
-	void* block = data().data() + (y*m_jobsX + x)*m_blockSize;
 	std::memcpy(block, etcImage.GetEncodingBits(), m_blockSize);
+
+	// The error is the sum of the squared error for each pixel using the error metric. This is
+	// only approximately the mean square error per channel for the perceptual metric.
+	unsigned int channelCount;
+	switch (m_format)
+	{
+		case Etc::Image::Format::R11:
+		case Etc::Image::Format::SIGNED_R11:
+			channelCount = 1;
+			break;
+		case Etc::Image::Format::RG11:
+		case Etc::Image::Format::SIGNED_RG11:
+			channelCount = 2;
+			break;
+		case Etc::Image::Format::RGB8A1:
+		case Etc::Image::Format::RGBA8:
+			channelCount = 4;
+			break;
+		default:
+			channelCount = 3;
+			break;
+	}
+	return std::sqrt(etcImage.GetError()/static_cast<float>(width*height*channelCount));
+}
+
+void EtcConverter::encodePreviewBlock(void* block, const ColorRGBAf* pixels, unsigned int width,
+	unsigned int height)
+{
+	// Pad partial blocks with the edge pixels since the preview encoders always use full blocks.
+	std::uint8_t colors[blockDim*blockDim][4];
+	for (unsigned int j = 0, index = 0; j < blockDim; ++j)
+	{
+		const ColorRGBAf* row = pixels + std::min(j, height - 1)*width;
+		for (unsigned int i = 0; i < blockDim; ++i, ++index)
+		{
+			const ColorRGBAf& pixel = row[std::min(i, width - 1)];
+			colors[index][0] = toUNorm8(pixel.r);
+			colors[index][1] = toUNorm8(pixel.g);
+			colors[index][2] = toUNorm8(pixel.b);
+			colors[index][3] = toUNorm8(pixel.a);
+		}
+	}
+
+	auto compressedBlock = reinterpret_cast<std::uint8_t*>(block);
+	if (m_format == Etc::Image::Format::RGBA8)
+	{
+		encodeEtc2AlphaPreview(compressedBlock, colors[0] + 3, 4);
+		compressedBlock += 8;
+	}
+	encodeEtc1Preview(compressedBlock, colors);
+}
+
+bool EtcConverter::encodeConstantBlock(void* block, const ColorRGBAf* pixels,
+	unsigned int pixelCount)
+{
+	auto compressedBlock = reinterpret_cast<std::uint8_t*>(block);
+	std::uint8_t color[4];
+	switch (m_format)
+	{
+		case Etc::Image::Format::ETC1:
+		case Etc::Image::Format::RGB8:
+			if (!getConstantColor(color, pixels, pixelCount, 3))
+				return false;
+			encodeConstantEtc1(block, color);
+			return true;
+		case Etc::Image::Format::RGB8A1:
+		{
+			unsigned int transparentCount = 0;
+			for (unsigned int i = 0; i < pixelCount; ++i)
+			{
+				if (pixels[i].a < 0.5f)
+					++transparentCount;
+			}
+
+			if (transparentCount == pixelCount)
+			{
+				encodeTransparentEtc2A1(block);
+				return true;
+			}
+			else if (transparentCount > 0 || !getConstantColor(color, pixels, pixelCount, 3))
+				return false;
+
+			// The opaque bit is in the same position as the differential bit for ETC1.
+			encodeConstantEtc1(block, color);
+			return true;
+		}
+		case Etc::Image::Format::RGBA8:
+			if (!getConstantColor(color, pixels, pixelCount, 4))
+				return false;
+			encodeConstantEtc2Alpha(compressedBlock, color[3]);
+			encodeConstantEtc1(compressedBlock + 8, color);
+			return true;
+		case Etc::Image::Format::R11:
+		case Etc::Image::Format::RG11:
+		{
+			unsigned int channelCount = m_format == Etc::Image::Format::RG11 ? 2 : 1;
+			std::uint16_t values[2];
+			for (unsigned int c = 0; c < channelCount; ++c)
+			{
+				if (!getConstantEacValue(values[c], pixels, pixelCount, c))
+					return false;
+			}
+
+			for (unsigned int c = 0; c < channelCount; ++c)
+				encodeConstantEacR11(compressedBlock + c*8, values[c]);
+			return true;
+		}
+		case Etc::Image::Format::SIGNED_R11:
+		case Etc::Image::Format::SIGNED_RG11:
+		{
+			unsigned int channelCount = m_format == Etc::Image::Format::SIGNED_RG11 ? 2 : 1;
+			std::int16_t values[2];
+			for (unsigned int c = 0; c < channelCount; ++c)
+			{
+				if (!getConstantSignedEacValue(values[c], pixels, pixelCount, c))
+					return false;
+			}
+
+			for (unsigned int c = 0; c < channelCount; ++c)
+				encodeConstantEacR11S(compressedBlock + c*8, values[c]);
+			return true;
+		}
+		default:
+			return false;
+	}
 }
 
 } // namespace cuttlefish
@@ -33,6 +33,7 @@
 #endif
 
 namespace Etc { class Image; }
+struct etc_enc_settings;
 
 namespace cuttlefish
 {
@@ -43,18 +44,45 @@ public:
 	static const unsigned int blockDim = 4;
 
 	EtcConverter(const Texture& texture, const Image& image, Texture::Quality quality);
+	~EtcConverter();
 
-	unsigned int jobsX() const override {return m_jobsX;}
+	// The ispc_texcomp encoder processes a full row of blocks at a time.
+	unsigned int jobsX() const override {return m_ispcSettings ? 1 : m_jobsX;}
 	unsigned int jobsY() const override {return m_jobsY;}
 	void process(unsigned int x, unsigned int y, ThreadData* threadData) override;
+	std::unique_ptr<ThreadData> createThreadData() override;
 
 private:
+	class EtcThreadData;
+
+	void loadBlock(ColorRGBAf* outPixels, unsigned int& outWidth, unsigned int& outHeight,
+		unsigned int x, unsigned int y) const;
+	BlockCache::Key computeBlockKey(const ColorRGBAf* pixels, unsigned int width,
+		unsigned int height) const;
+	void processRow(unsigned int y, EtcThreadData* threadData);
+	void encodeRowSpan(unsigned int y, unsigned int firstBlock, unsigned int blockCount,
+		EtcThreadData* threadData);
+	float encodeBlock(void* block, ColorRGBAf* pixels, unsigned int width, unsigned int height,
+		float effort);
+	void encodePreviewBlock(void* block, const ColorRGBAf* pixels, unsigned int width,
+		unsigned int height);
+	bool encodeConstantBlock(void* block, const ColorRGBAf* pixels, unsigned int pixelCount);
+
 	unsigned int m_blockSize;
 	unsigned int m_jobsX;
 	unsigned int m_jobsY;
 	Etc::Image::Format m_format;
 	Etc::ErrorMetric m_metric;
+	Texture::ColorMask m_uniformMask;
 	float m_effort;
+	float m_fastEffort;
+	float m_errorThreshold;
+	bool m_preview;
+
+	// ispc_texcomp is used for ETC1 and ETC2 RGB at low qualities. Unlike etc2comp, it always
+	// uses a uniform RGB error metric rather than m_metric. Neither encoder applies the color
+	// mask, which only affects the check for constant blocks.
+	etc_enc_settings* m_ispcSettings;
 };
 
 } // namespace cuttlefish
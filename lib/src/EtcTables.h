@@ -0,0 +1,39 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+
+namespace cuttlefish
+{
+
+// Tables shared between the ETC and EAC encoders and decoders.
+
+extern const int eacModifiers[16][8];
+extern const int etc1Modifiers[8][2];
+
+// Distances between the paint colors for the ETC2 T and H modes.
+extern const int etc2Distances[8];
+
+inline int getEtc1Modifier(unsigned int table, unsigned int selector)
+{
+	// Selectors 0 and 1 are positive, 2 and 3 are negative.
+	int modifier = etc1Modifiers[table][selector & 0x1];
+	return selector & 0x2 ? -modifier : modifier;
+}
+
+} // namespace cuttlefish
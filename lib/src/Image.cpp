@@ -16,6 +16,7 @@
 
 #include <cuttlefish/Image.h>
 
+#include "MappedFile.h"
 #include "Shared.h"
 #include <cuttlefish/Color.h>
 #include <FreeImage.h>
@@ -23,8 +24,10 @@
 #include <cassert>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <istream>
 #include <limits>
+#include <memory>
 #include <ostream>
 #include <sstream>
 
@@ -48,6 +51,9 @@ public:
 	}
 };
 
+// FreeImage memory handles store the size as a DWORD.
+const std::size_t maxMemoryHandleSize = std::numeric_limits<DWORD>::max();
+
 void freeImageInitialize()
 {
 	static FreeImageInitialize initializer;
@@ -248,6 +254,119 @@ long tellIStream(fi_handle handle)
 
 FreeImageIO istreamIO{&readIStream, &writeIStream, &seekIStream, tellIStream};
 
+// Streams that can't seek are read on demand, retaining what was read in fixed-size chunks so the
+// decoder may seek back to data it has already seen. Only as much of the stream as the decoder
+// reaches is read, and the chunks avoid re-allocating and copying a growing buffer.
+class BufferedIStream
+{
+public:
+	explicit BufferedIStream(std::istream& stream)
+		: m_stream(stream)
+		, m_size(0)
+		, m_position(0)
+		, m_finished(false)
+	{
+	}
+
+	std::size_t read(void* buffer, std::size_t size)
+	{
+		fill(m_position + size);
+		size = std::min(size, m_size - std::min(m_position, m_size));
+
+		auto bytes = reinterpret_cast<std::uint8_t*>(buffer);
+		for (std::size_t remaining = size; remaining > 0;)
+		{
+			std::size_t chunkOffset = m_position % chunkSize;
+			std::size_t copySize = std::min(remaining, chunkSize - chunkOffset);
+			std::memcpy(bytes, m_chunks[m_position/chunkSize].get() + chunkOffset, copySize);
+			bytes += copySize;
+			m_position += copySize;
+			remaining -= copySize;
+		}
+		return size;
+	}
+
+	bool seek(long offset, int origin)
+	{
+		long base;
+		switch (origin)
+		{
+			case SEEK_SET:
+				base = 0;
+				break;
+			case SEEK_CUR:
+				base = static_cast<long>(m_position);
+				break;
+			case SEEK_END:
+				fill(std::numeric_limits<std::size_t>::max());
+				base = static_cast<long>(m_size);
+				break;
+			default:
+				return false;
+		}
+
+		if (base + offset < 0)
+			return false;
+
+		m_position = static_cast<std::size_t>(base + offset);
+		return true;
+	}
+
+	long tell() const
+	{
+		return static_cast<long>(m_position);
+	}
+
+private:
+	static const std::size_t chunkSize = 64*1024;
+
+	void fill(std::size_t end)
+	{
+		while (m_size < end && !m_finished)
+		{
+			std::size_t chunkOffset = m_size % chunkSize;
+			if (chunkOffset == 0)
+				m_chunks.emplace_back(new std::uint8_t[chunkSize]);
+
+			m_stream.read(reinterpret_cast<char*>(m_chunks.back().get() + chunkOffset),
+				static_cast<std::streamsize>(chunkSize - chunkOffset));
+			auto readSize = static_cast<std::size_t>(m_stream.gcount());
+			m_size += readSize;
+			m_finished = readSize == 0 || !m_stream;
+		}
+	}
+
+	std::istream& m_stream;
+	std::vector<std::unique_ptr<std::uint8_t[]>> m_chunks;
+	std::size_t m_size;
+	std::size_t m_position;
+	bool m_finished;
+};
+
+unsigned int readBufferedIStream(void* buffer, unsigned int size, unsigned int count,
+	fi_handle handle)
+{
+	if (size == 0)
+		return 0;
+
+	auto stream = reinterpret_cast<BufferedIStream*>(handle);
+	return static_cast<unsigned int>(
+		stream->read(buffer, static_cast<std::size_t>(size)*count)/size);
+}
+
+int seekBufferedIStream(fi_handle handle, long offset, int origin)
+{
+	return reinterpret_cast<BufferedIStream*>(handle)->seek(offset, origin) ? 0 : -1;
+}
+
+long tellBufferedIStream(fi_handle handle)
+{
+	return reinterpret_cast<BufferedIStream*>(handle)->tell();
+}
+
+FreeImageIO bufferedIStreamIO{&readBufferedIStream, &writeIStream, &seekBufferedIStream,
+	&tellBufferedIStream};
+
 unsigned int readOStream(void*, unsigned int, unsigned int, fi_handle)
 {
 	return 0;
@@ -337,9 +456,17 @@ std::uint8_t fromDoubleNorm6(double d)
 	return static_cast<std::uint8_t>(std::round(clamp(d)*63));
 }
 
-void* getScanlineImpl(FIBITMAP* image, unsigned int height, unsigned int y)
+FIBITMAP* createBottomUpImage(FIBITMAP* image)
+{
+	FIBITMAP* bottomUpImage = FreeImage_Clone(image);
+	if (bottomUpImage)
+		FreeImage_FlipVertical(bottomUpImage);
+	return bottomUpImage;
+}
+
+void* getScanlineImpl(FIBITMAP* image, unsigned int height, bool topDown, unsigned int y)
 {
-	return FreeImage_GetScanLine(image, height - y - 1);
+	return FreeImage_GetScanLine(image, topDown ? y : height - y - 1);
 }
 
 bool getPixelImpl(ColorRGBAd& outColor, Image::Format format, const void* scanline, unsigned int x)
@@ -745,7 +872,7 @@ struct Image::Impl
 		redMask(FreeImage_GetRedMask(img)), greenMask(FreeImage_GetGreenMask(img)),
 		blueMask(FreeImage_GetGreenMask(img)),
 		alphaMask(format == Format::RGBA8 ? FI_RGBA_ALPHA_MASK : 0), redShift(0),
-		greenShift(0), blueShift(0), alphaShift(0)
+		greenShift(0), blueShift(0), alphaShift(0), topDown(false), externalMemory(false)
 	{
 		if (redMask == FI_RGBA_RED)
 			redShift = FI_RGBA_RED_SHIFT;
@@ -778,6 +905,35 @@ struct Image::Impl
 			FreeImage_Unload(image);
 	}
 
+	static Impl* clone(const Impl& other)
+	{
+		FIBITMAP* image = FreeImage_Clone(other.image);
+		if (!image)
+			return nullptr;
+
+		Impl* impl = create(image, other.colorSpace, other.format);
+		if (impl)
+			impl->topDown = other.topDown;
+		return impl;
+	}
+
+	// Pixels are shared between copies of an image until one of them is modified.
+	static bool detach(std::shared_ptr<Impl>& impl)
+	{
+		if (!impl)
+			return false;
+
+		if (impl.use_count() == 1)
+			return true;
+
+		Impl* copy = clone(*impl);
+		if (!copy)
+			return false;
+
+		impl.reset(copy);
+		return true;
+	}
+
 	Impl(const Impl& other) = delete;
 	Impl& operator=(const Impl& other) = delete;
 
@@ -795,6 +951,13 @@ struct Image::Impl
 	unsigned int greenShift;
 	unsigned int blueShift;
 	unsigned int alphaShift;
+
+	// FreeImage stores rows from bottom to top. Images wrapping external memory store them from
+	// top to bottom instead, which is preserved for any images derived from them.
+	bool topDown;
+
+	// External memory is never shared between copies since its lifetime is owned by the caller.
+	bool externalMemory;
 };
 
 Image::Image()
@@ -826,16 +989,24 @@ Image::Image(Format format, unsigned int width, unsigned int height, ColorSpace
 	initialize(format, width, height, colorSpace);
 }
 
+Image::Image(Format format, unsigned int width, unsigned int height, void* data,
+	std::size_t stride, ColorSpace colorSpace)
+	: Image()
+{
+	initialize(format, width, height, data, stride, colorSpace);
+}
+
 Image::~Image() = default;
 
 Image::Image(const Image& other)
 {
-	if (other.m_impl)
-	{
-		FIBITMAP* image = FreeImage_Clone(other.m_impl->image);
-		if (image)
-			m_impl.reset(Impl::create(image, other.m_impl->colorSpace, other.m_impl->format));
-	}
+	if (!other.m_impl)
+		return;
+
+	if (other.m_impl->externalMemory)
+		m_impl.reset(Impl::clone(*other.m_impl));
+	else
+		m_impl = other.m_impl;
 }
 
 Image::Image(Image&& other) noexcept = default;
@@ -845,13 +1016,12 @@ Image& Image::operator=(const Image& other)
 	if (this == &other)
 		return *this;
 
-	reset();
-	if (other.m_impl)
-	{
-		FIBITMAP* image = FreeImage_Clone(other.m_impl->image);
-		if (image)
-			m_impl.reset(Impl::create(image, other.m_impl->colorSpace, other.m_impl->format));
-	}
+	if (!other.m_impl)
+		reset();
+	else if (other.m_impl->externalMemory)
+		m_impl.reset(Impl::clone(*other.m_impl));
+	else
+		m_impl = other.m_impl;
 	return *this;
 }
 
@@ -869,6 +1039,13 @@ Image::operator bool() const
 
 bool Image::load(const char* fileName, ColorSpace colorSpace)
 {
+	// Decode directly from a mapping of the file to avoid reading it through an intermediate
+	// buffer. Fall back to FreeImage's own file reading for files that can't be mapped or are too
+	// large for a memory handle.
+	MappedFile file;
+	if (file.open(fileName) && file.data() && file.size() <= maxMemoryHandleSize)
+		return load(file.data(), file.size(), colorSpace);
+
 	reset();
 
 	FREE_IMAGE_FORMAT format = FreeImage_GetFileType(fileName);
@@ -881,15 +1058,23 @@ bool Image::load(const char* fileName, ColorSpace colorSpace)
 
 bool Image::load(std::istream& stream, ColorSpace colorSpace)
 {
-	// Seeking is needed to detect the file type.
+	reset();
+
+	// Seeking is needed to detect the file type and by most decoders, so only read on demand
+	// through a buffer when the stream itself can't seek.
 	if (stream.tellg() < 0)
 	{
-		std::vector<std::uint8_t> data;
-		readStreamData(data, stream);
-		return load(data.data(), data.size(), colorSpace);
-	}
+		stream.clear();
+		BufferedIStream bufferedStream(stream);
+		FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromHandle(&bufferedIStreamIO,
+			&bufferedStream);
+		if (format == FIF_UNKNOWN)
+			return false;
 
-	reset();
+		m_impl.reset(Impl::create(FreeImage_LoadFromHandle(format, &bufferedIStreamIO,
+			&bufferedStream), colorSpace, Format::Invalid));
+		return m_impl != nullptr;
+	}
 
 	FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromHandle(&istreamIO, &stream);
 	if (format == FIF_UNKNOWN)
@@ -904,6 +1089,9 @@ bool Image::load(const void* data, std::size_t size, ColorSpace colorSpace)
 {
 	reset();
 
+	if (size > maxMemoryHandleSize)
+		return false;
+
 	FIMEMORY* memoryStream = FreeImage_OpenMemory((BYTE*)data, (DWORD)size);
 	if (!memoryStream)
 		return false;
@@ -930,7 +1118,18 @@ bool Image::save(const char* fileName)
 	if (format == FIF_UNKNOWN)
 		return false;
 
-	return FreeImage_Save(format, m_impl->image, fileName) != false;
+	FIBITMAP* image = m_impl->image;
+	if (m_impl->topDown)
+	{
+		image = createBottomUpImage(image);
+		if (!image)
+			return false;
+	}
+
+	bool success = FreeImage_Save(format, image, fileName) != false;
+	if (image != m_impl->image)
+		FreeImage_Unload(image);
+	return success;
 }
 
 bool Image::save(std::ostream& stream, const char* fileName)
@@ -942,7 +1141,18 @@ bool Image::save(std::ostream& stream, const char* fileName)
 	if (format == FIF_UNKNOWN)
 		return false;
 
-	return FreeImage_SaveToHandle(format, m_impl->image, &ostreamIO, &stream) != false;
+	FIBITMAP* image = m_impl->image;
+	if (m_impl->topDown)
+	{
+		image = createBottomUpImage(image);
+		if (!image)
+			return false;
+	}
+
+	bool success = FreeImage_SaveToHandle(format, image, &ostreamIO, &stream) != false;
+	if (image != m_impl->image)
+		FreeImage_Unload(image);
+	return success;
 }
 
 bool Image::save(std::vector<std::uint8_t>& outData, const char* fileName)
@@ -972,6 +1182,32 @@ bool Image::initialize(Format format, unsigned int width, unsigned int height,
 	return m_impl != nullptr;
 }
 
+bool Image::initialize(Format format, unsigned int width, unsigned int height, void* data,
+	std::size_t stride, ColorSpace colorSpace)
+{
+	reset();
+
+	unsigned int bpp, redMask, greenMask, blueMask;
+	FREE_IMAGE_TYPE type = getFreeImageFormat(format, bpp, redMask, greenMask, blueMask);
+	if (type == FIT_UNKNOWN || !data || width == 0 || height == 0 ||
+		stride < (static_cast<std::size_t>(width)*bpp + 7)/8 ||
+		stride > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+	{
+		return false;
+	}
+
+	// Wrap the memory rather than copying it, keeping the caller's top to bottom row order.
+	m_impl.reset(Impl::create(FreeImage_ConvertFromRawBitsEx(false,
+		reinterpret_cast<BYTE*>(data), type, static_cast<int>(width), static_cast<int>(height),
+		static_cast<int>(stride), bpp, redMask, greenMask, blueMask, false), colorSpace, format));
+	if (!m_impl)
+		return false;
+
+	m_impl->topDown = true;
+	m_impl->externalMemory = true;
+	return true;
+}
+
 void Image::reset()
 {
 	m_impl.reset();
@@ -993,6 +1229,11 @@ ColorSpace Image::colorSpace() const
 	return m_impl->colorSpace;
 }
 
+bool Image::isExternal() const
+{
+	return m_impl && m_impl->externalMemory;
+}
+
 unsigned int Image::bitsPerPixel() const
 {
 	if (!m_impl)
@@ -1083,10 +1324,10 @@ unsigned int Image::alphaShift() const
 
 void* Image::scanline(unsigned int y)
 {
-	if (!m_impl || y >= m_impl->height)
+	if (!m_impl || y >= m_impl->height || !Impl::detach(m_impl))
 		return nullptr;
 
-	return getScanlineImpl(m_impl->image, m_impl->height, y);
+	return getScanlineImpl(m_impl->image, m_impl->height, m_impl->topDown, y);
 }
 
 const void* Image::scanline(unsigned int y) const
@@ -1094,7 +1335,7 @@ const void* Image::scanline(unsigned int y) const
 	if (!m_impl || y >= m_impl->height)
 		return nullptr;
 
-	return getScanlineImpl(m_impl->image, m_impl->height, y);
+	return getScanlineImpl(m_impl->image, m_impl->height, m_impl->topDown, y);
 }
 
 bool Image::getPixel(ColorRGBAd& outColor, unsigned int x, unsigned int y) const
@@ -1102,16 +1343,16 @@ bool Image::getPixel(ColorRGBAd& outColor, unsigned int x, unsigned int y) const
 	if (!m_impl || x >= m_impl->width || y >= m_impl->height)
 		return false;
 
-	return getPixelImpl(outColor, m_impl->format, getScanlineImpl(m_impl->image, m_impl->height, y),
-		x);
+	return getPixelImpl(outColor, m_impl->format,
+		getScanlineImpl(m_impl->image, m_impl->height, m_impl->topDown, y), x);
 }
 
 bool Image::setPixel(unsigned int x, unsigned int y, const ColorRGBAd& color, bool convertGrayscale)
 {
-	if (!m_impl || x >= m_impl->width || y >= m_impl->height)
+	if (!m_impl || x >= m_impl->width || y >= m_impl->height || !Impl::detach(m_impl))
 		return false;
 
-	void* scanline = getScanlineImpl(m_impl->image, m_impl->height, y);
+	void* scanline = getScanlineImpl(m_impl->image, m_impl->height, m_impl->topDown, y);
 	if (convertGrayscale)
 	{
 		if (m_impl->colorSpace == ColorSpace::sRGB && isGrayscaleFormat(m_impl->format))
@@ -1318,6 +1559,7 @@ Image Image::convert(Format dstFormat, bool convertGrayscale) const
 		}
 	}
 
+	image.m_impl->topDown = m_impl->topDown;
 	return image;
 }
 
@@ -1507,6 +1749,8 @@ Image Image::resize(unsigned int width, unsigned int height, ResizeFilter filter
 				return image;
 		}
 	}
+
+	image.m_impl->topDown = m_impl->topDown;
 	return image;
 }
 
@@ -1516,6 +1760,24 @@ Image Image::rotate(RotateAngle angle) const
 	if (!m_impl)
 		return image;
 
+	// Rotating the stored rows of a top-down image rotates in the opposite direction.
+	if (m_impl->topDown)
+	{
+		switch (angle)
+		{
+			case RotateAngle::CCW90:
+			case RotateAngle::CW270:
+				angle = RotateAngle::CW90;
+				break;
+			case RotateAngle::CCW270:
+			case RotateAngle::CW90:
+				angle = RotateAngle::CCW90;
+				break;
+			default:
+				break;
+		}
+	}
+
 	double degrees = 0.0;
 	switch (angle)
 	{
@@ -1599,12 +1861,14 @@ Image Image::rotate(RotateAngle angle) const
 		}
 	}
 
+	if (image)
+		image.m_impl->topDown = m_impl->topDown;
 	return image;
 }
 
 bool Image::flipHorizontal()
 {
-	if (!m_impl)
+	if (!Impl::detach(m_impl))
 		return false;
 
 	return FreeImage_FlipHorizontal(m_impl->image) != 0;
@@ -1612,7 +1876,7 @@ bool Image::flipHorizontal()
 
 bool Image::flipVertical()
 {
-	if (!m_impl)
+	if (!Impl::detach(m_impl))
 		return false;
 
 	return FreeImage_FlipVertical(m_impl->image) != 0;
@@ -1620,7 +1884,7 @@ bool Image::flipVertical()
 
 bool Image::preMultiplyAlpha()
 {
-	if (!m_impl)
+	if (!Impl::detach(m_impl))
 		return false;
 
 	ColorRGBAd color = {0.0, 0.0, 0.0, 0.0};
@@ -1672,6 +1936,9 @@ bool Image::changeColorSpace(ColorSpace colorSpace)
 	if (colorSpace == m_impl->colorSpace)
 		return true;
 
+	if (!Impl::detach(m_impl))
+		return false;
+
 	ColorRGBAd color = {0.0, 0.0, 0.0, 0.0};
 	if (colorSpace == ColorSpace::Linear)
 	{
@@ -1713,7 +1980,7 @@ bool Image::changeColorSpace(ColorSpace colorSpace)
 
 bool Image::grayscale()
 {
-	if (!m_impl)
+	if (!Impl::detach(m_impl))
 		return false;
 
 	ColorRGBAd color = {0.0, 0.0, 0.0, 0.0};
@@ -1747,7 +2014,7 @@ bool Image::grayscale()
 
 bool Image::swizzle(Channel red, Channel green, Channel blue, Channel alpha)
 {
-	if (!m_impl)
+	if (!Impl::detach(m_impl))
 		return false;
 
 	for (unsigned int y = 0; y < m_impl->height; ++y)
@@ -1789,6 +2056,8 @@ Image Image::createNormalMap(NormalOptions options, double height, Format dstFor
 	if (!image.initialize(dstFormat, m_impl->width, m_impl->height, m_impl->colorSpace))
 		return image;
 
+	image.m_impl->topDown = m_impl->topDown;
+
 	for (unsigned int y = 0; y < m_impl->height; ++y)
 	{
 		const void* scanline1 = FreeImage_GetScanLine(m_impl->image, y);
@@ -1830,6 +2099,8 @@ Image Image::createNormalMap(NormalOptions options, double height, Format dstFor
 			getPixelImpl(curColor0, m_impl->format, scanline0, x);
 			getPixelImpl(curColor1, m_impl->format, scanline2, x);
 			double dy = (curColor0.r - curColor1.r)*height/distY;
+			if (m_impl->topDown)
+				dy = -dy;
 
 			double distX = 2.0;
 			if (x == 0)
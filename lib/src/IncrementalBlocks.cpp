@@ -0,0 +1,353 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "IncrementalBlocks.h"
+#include "Converter.h"
+#include "Shared.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+namespace cuttlefish
+{
+
+static const std::uint32_t hashFileMagic = FOURCC('C', 'F', 'B', 'H');
+static const std::uint32_t hashFileVersion = 4;
+
+static bool readFile(std::vector<std::uint8_t>& outData, const char* fileName)
+{
+	std::ifstream stream(fileName, std::ifstream::binary);
+	if (!stream.is_open())
+		return false;
+
+	readStreamData(outData, stream);
+	return !stream.bad();
+}
+
+static unsigned int mipDepth(const IncrementalBlocks::Header& header, unsigned int mipLevel)
+{
+	if (header.dimension == static_cast<std::uint32_t>(Texture::Dimension::Dim3D))
+		return std::max(header.depth >> mipLevel, 1U);
+	return std::max(header.depth, 1U);
+}
+
+static std::size_t blockCount(const IncrementalBlocks::Header& header, unsigned int mipLevel)
+{
+	auto format = static_cast<Texture::Format>(header.format);
+	unsigned int blockWidth = Texture::blockWidth(format);
+	unsigned int blockHeight = Texture::blockHeight(format);
+	unsigned int width = std::max(header.width >> mipLevel, 1U);
+	unsigned int height = std::max(header.height >> mipLevel, 1U);
+	return static_cast<std::size_t>((width + blockWidth - 1)/blockWidth)*
+		((height + blockHeight - 1)/blockHeight);
+}
+
+static IncrementalBlocks::Key combineHash(const IncrementalBlocks::Key& hash, const void* data,
+	std::size_t size)
+{
+	return BlockCache::computeKey(data, size, hash.hash[0] ^ (hash.hash[1] << 1));
+}
+
+bool IncrementalBlocks::isFormatSupported(Texture::Format format)
+{
+	return format >= Texture::Format::BC1_RGB && format < Texture::Format::PVRTC1_RGB_2BPP;
+}
+
+bool IncrementalBlocks::loadPrevious(const char* outputFileName, const char* hashFileName,
+	Texture::FileType fileType)
+{
+	clearPrevious();
+	if (!outputFileName || !hashFileName)
+		return false;
+
+	if (fileType == Texture::FileType::Auto)
+		fileType = Texture::fileType(outputFileName);
+	if (fileType == Texture::FileType::Auto)
+		return false;
+
+	std::vector<std::uint8_t> hashData;
+	if (!readFile(hashData, hashFileName) || hashData.size() < sizeof(Header))
+		return false;
+
+	Header header;
+	std::memcpy(&header, hashData.data(), sizeof(Header));
+	if (header.magic != hashFileMagic || header.version != hashFileVersion ||
+		!isFormatSupported(static_cast<Texture::Format>(header.format)) || header.faces == 0 ||
+		header.mipLevels == 0)
+	{
+		return false;
+	}
+
+	std::vector<SurfaceHashes> hashes;
+	std::size_t offset = sizeof(Header);
+	for (unsigned int mip = 0; mip < header.mipLevels; ++mip)
+	{
+		std::size_t count = blockCount(header, mip);
+		unsigned int surfaces = mipDepth(header, mip)*header.faces;
+		for (unsigned int i = 0; i < surfaces; ++i)
+		{
+			std::size_t size = count*sizeof(Key);
+			if (offset + size > hashData.size())
+				return false;
+
+			hashes.emplace_back(count);
+			std::memcpy(hashes.back().data(), hashData.data() + offset, size);
+			offset += size;
+		}
+	}
+
+	if (!readFile(m_previousFile, outputFileName))
+	{
+		m_previousFile.clear();
+		return false;
+	}
+
+	m_previousFileType = fileType;
+	m_previousHeader = header;
+	m_previousHashes = std::move(hashes);
+	return true;
+}
+
+void IncrementalBlocks::clearPrevious()
+{
+	m_previousFileType = Texture::FileType::Auto;
+	m_previousFile.clear();
+	m_previousFile.shrink_to_fit();
+	m_previousHeader = Header();
+	m_previousHashes.clear();
+	m_previousBlocks.clear();
+}
+
+void IncrementalBlocks::begin(const Texture& texture, Texture::Quality quality)
+{
+	m_hashes.clear();
+	m_mipSurfaceOffsets.clear();
+	m_previousBlocks.clear();
+	m_reusedBlocks = 0;
+	if (!isFormatSupported(texture.format()))
+		return;
+
+	Texture::ColorMask colorMask = texture.colorMask();
+	m_header = Header();
+	m_header.magic = hashFileMagic;
+	m_header.version = hashFileVersion;
+	m_header.format = static_cast<std::uint32_t>(texture.format());
+	m_header.type = static_cast<std::uint32_t>(texture.type());
+	m_header.quality = static_cast<std::uint32_t>(quality);
+	m_header.alphaType = static_cast<std::uint32_t>(texture.alphaType());
+	m_header.colorMask = (colorMask.r ? 0x1 : 0) | (colorMask.g ? 0x2 : 0) |
+		(colorMask.b ? 0x4 : 0) | (colorMask.a ? 0x8 : 0);
+	m_header.colorSpace = static_cast<std::uint32_t>(texture.colorSpace());
+	m_header.dimension = static_cast<std::uint32_t>(texture.dimension());
+	m_header.width = texture.width();
+	m_header.height = texture.height();
+	m_header.depth = texture.isArray() || texture.dimension() == Texture::Dimension::Dim3D ?
+		texture.depth() : 0;
+	m_header.mipLevels = texture.mipLevelCount();
+	m_header.faces = texture.faceCount();
+	m_header.encoder = static_cast<std::uint32_t>(texture.encoder(texture.format()));
+	// Adaptive quality changes which blocks are encoded with the full quality.
+	if (Converter::useAdaptiveQuality(texture, quality))
+	{
+		m_header.adaptiveQuality =
+			static_cast<std::uint32_t>(texture.adaptiveFastQuality()) + 1;
+		m_header.adaptiveErrorThreshold = Converter::getAdaptiveErrorThreshold(texture);
+	}
+
+	for (unsigned int mip = 0; mip < m_header.mipLevels; ++mip)
+	{
+		m_mipSurfaceOffsets.push_back(static_cast<unsigned int>(m_hashes.size()));
+		std::size_t count = blockCount(m_header, mip);
+		unsigned int surfaces = mipDepth(m_header, mip)*m_header.faces;
+		for (unsigned int i = 0; i < surfaces; ++i)
+			m_hashes.emplace_back(count);
+	}
+
+	if (!hasPrevious())
+		return;
+
+	// Everything except the data hash must match to use the previous output.
+	if (std::memcmp(&m_header, &m_previousHeader, offsetof(Header, dataHash)) != 0 ||
+		!findPreviousBlocks())
+	{
+		m_previousBlocks.clear();
+	}
+}
+
+IncrementalBlocks::Key* IncrementalBlocks::hashes(unsigned int mipLevel, unsigned int depth,
+	unsigned int face)
+{
+	if (m_hashes.empty())
+		return nullptr;
+
+	return m_hashes[surfaceIndex(mipLevel, depth, face)].data();
+}
+
+const IncrementalBlocks::Key* IncrementalBlocks::previousHashes(unsigned int mipLevel,
+	unsigned int depth, unsigned int face) const
+{
+	if (m_previousBlocks.empty())
+		return nullptr;
+
+	return m_previousHashes[surfaceIndex(mipLevel, depth, face)].data();
+}
+
+const std::uint8_t* IncrementalBlocks::previousBlocks(unsigned int mipLevel, unsigned int depth,
+	unsigned int face) const
+{
+	if (m_previousBlocks.empty())
+		return nullptr;
+
+	return m_previousBlocks[surfaceIndex(mipLevel, depth, face)];
+}
+
+bool IncrementalBlocks::saveHashes(const char* fileName, const Texture& texture) const
+{
+	if (m_hashes.empty() || !texture.converted() || !fileName)
+		return false;
+
+	Header header = m_header;
+	Key dataHash = computeDataHash(texture);
+	header.dataHash[0] = dataHash.hash[0];
+	header.dataHash[1] = dataHash.hash[1];
+
+	std::ofstream stream(fileName, std::ofstream::binary);
+	if (!stream.is_open() || !write(stream, header))
+		return false;
+
+	for (const SurfaceHashes& surface : m_hashes)
+	{
+		stream.write(reinterpret_cast<const char*>(surface.data()), surface.size()*sizeof(Key));
+		if (!stream.good())
+			return false;
+	}
+
+	return true;
+}
+
+IncrementalBlocks::Key IncrementalBlocks::computeDataHash(const Texture& texture)
+{
+	Key hash = {};
+	for (unsigned int mip = 0; mip < texture.mipLevelCount(); ++mip)
+	{
+		for (unsigned int d = 0; d < texture.depth(mip); ++d)
+		{
+			for (unsigned int f = 0; f < texture.faceCount(); ++f)
+			{
+				auto face = static_cast<Texture::CubeFace>(f);
+				hash = combineHash(hash, texture.data(face, mip, d), texture.dataSize(face, mip, d));
+			}
+		}
+	}
+
+	return hash;
+}
+
+std::size_t IncrementalBlocks::surfaceIndex(unsigned int mipLevel, unsigned int depth,
+	unsigned int face) const
+{
+	assert(mipLevel < m_mipSurfaceOffsets.size());
+	assert(depth < mipDepth(m_header, mipLevel));
+	assert(face < m_header.faces);
+	return m_mipSurfaceOffsets[mipLevel] + depth*m_header.faces + face;
+}
+
+bool IncrementalBlocks::findPreviousBlocks()
+{
+	// The surface data is always at the end of the file for all supported file types, so the
+	// headers don't need to be parsed. The layout is validated with the data hash.
+	auto format = static_cast<Texture::Format>(m_header.format);
+	std::size_t blockSize = Texture::blockSize(format);
+	std::size_t dataSize = 0;
+	for (unsigned int mip = 0; mip < m_header.mipLevels; ++mip)
+		dataSize += blockCount(m_header, mip)*blockSize*mipDepth(m_header, mip)*m_header.faces;
+	if (m_previousFileType == Texture::FileType::KTX)
+		dataSize += m_header.mipLevels*sizeof(std::uint32_t);
+
+	if (dataSize > m_previousFile.size())
+		return false;
+
+	const std::uint8_t* data = m_previousFile.data() + m_previousFile.size() - dataSize;
+	m_previousBlocks.resize(m_hashes.size());
+	switch (m_previousFileType)
+	{
+		case Texture::FileType::DDS:
+		{
+			bool isArray = m_header.dimension !=
+				static_cast<std::uint32_t>(Texture::Dimension::Dim3D) && m_header.depth > 0;
+			unsigned int elements = isArray ? m_header.depth : 1;
+			for (unsigned int element = 0; element < elements; ++element)
+			{
+				for (unsigned int face = 0; face < m_header.faces; ++face)
+				{
+					for (unsigned int mip = 0; mip < m_header.mipLevels; ++mip)
+					{
+						unsigned int volumes = isArray ? 1 : mipDepth(m_header, mip);
+						std::size_t surfaceSize = blockCount(m_header, mip)*blockSize;
+						for (unsigned int volume = 0; volume < volumes; ++volume)
+						{
+							m_previousBlocks[surfaceIndex(mip, volume + element, face)] = data;
+							data += surfaceSize;
+						}
+					}
+				}
+			}
+			break;
+		}
+		case Texture::FileType::KTX:
+		case Texture::FileType::PVR:
+		{
+			for (unsigned int mip = 0; mip < m_header.mipLevels; ++mip)
+			{
+				// KTX has the image size before each mip level.
+				if (m_previousFileType == Texture::FileType::KTX)
+					data += sizeof(std::uint32_t);
+
+				std::size_t surfaceSize = blockCount(m_header, mip)*blockSize;
+				for (unsigned int d = 0; d < mipDepth(m_header, mip); ++d)
+				{
+					for (unsigned int face = 0; face < m_header.faces; ++face)
+					{
+						m_previousBlocks[surfaceIndex(mip, d, face)] = data;
+						data += surfaceSize;
+					}
+				}
+			}
+			break;
+		}
+		default:
+			return false;
+	}
+	assert(data == m_previousFile.data() + m_previousFile.size());
+
+	Key hash = {};
+	for (unsigned int mip = 0; mip < m_header.mipLevels; ++mip)
+	{
+		std::size_t surfaceSize = blockCount(m_header, mip)*blockSize;
+		for (unsigned int d = 0; d < mipDepth(m_header, mip); ++d)
+		{
+			for (unsigned int face = 0; face < m_header.faces; ++face)
+				hash = combineHash(hash, m_previousBlocks[surfaceIndex(mip, d, face)], surfaceSize);
+		}
+	}
+
+	return hash.hash[0] == m_previousHeader.dataHash[0] &&
+		hash.hash[1] == m_previousHeader.dataHash[1];
+}
+
+} // namespace cuttlefish
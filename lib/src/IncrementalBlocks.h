@@ -0,0 +1,192 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Export.h>
+#include <cuttlefish/Texture.h>
+#include "BlockCache.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cuttlefish
+{
+
+/**
+ * @brief Per-block source hashes used to only re-encode blocks that changed since a previous
+ *     conversion.
+ *
+ * The hashes for each block are recorded during conversion and may be saved to a sidecar file
+ * next to the output texture. On a later conversion, the previous output and sidecar file are
+ * loaded, and any block whose source hash is unchanged will copy the previously encoded block
+ * rather than encoding it again.
+ *
+ * The sidecar file records the conversion parameters and a hash of the encoded data, so the
+ * previous output is ignored if it doesn't match the current conversion.
+ */
+class CUTTLEFISH_EXPORT IncrementalBlocks
+{
+public:
+	using Key = BlockCache::Key;
+
+	/**
+	 * @brief Checks whether or not a format can be converted incrementally.
+	 *
+	 * This requires that each block is encoded independently, so PVRTC formats aren't supported.
+	 *
+	 * @param format The texture format.
+	 * @return True if the format is supported.
+	 */
+	static bool isFormatSupported(Texture::Format format);
+
+	/**
+	 * @brief Loads the previous output of a conversion.
+	 * @param outputFileName The file name for the previous output texture.
+	 * @param hashFileName The file name for the block hashes saved with the previous output.
+	 * @param fileType The file type of the output texture.
+	 * @return False if the files couldn't be read or the hash file is invalid.
+	 */
+	bool loadPrevious(const char* outputFileName, const char* hashFileName,
+		Texture::FileType fileType);
+
+	/**
+	 * @brief Clears the previous output.
+	 */
+	void clearPrevious();
+
+	/**
+	 * @brief Returns whether or not the previous output has been loaded.
+	 * @return True if the previous output was loaded.
+	 */
+	bool hasPrevious() const {return !m_previousFile.empty();}
+
+	/**
+	 * @brief Prepares for converting a texture.
+	 *
+	 * This will allocate the hashes for each block and find the blocks from the previous output.
+	 * The previous output is ignored if it doesn't match the texture.
+	 *
+	 * @param texture The texture being converted. The format, type, alpha type, and color mask
+	 *     must already be set.
+	 * @param quality The quality of the conversion.
+	 */
+	void begin(const Texture& texture, Texture::Quality quality);
+
+	/**
+	 * @brief Gets the hashes to populate for a surface.
+	 * @param mipLevel The mip level.
+	 * @param depth The depth level.
+	 * @param face The cube face.
+	 * @return The hashes, or null if the format isn't supported.
+	 */
+	Key* hashes(unsigned int mipLevel, unsigned int depth, unsigned int face);
+
+	/**
+	 * @brief Gets the hashes from the previous output for a surface.
+	 * @param mipLevel The mip level.
+	 * @param depth The depth level.
+	 * @param face The cube face.
+	 * @return The hashes, or null if there is no matching previous output.
+	 */
+	const Key* previousHashes(unsigned int mipLevel, unsigned int depth, unsigned int face) const;
+
+	/**
+	 * @brief Gets the encoded blocks from the previous output for a surface.
+	 * @param mipLevel The mip level.
+	 * @param depth The depth level.
+	 * @param face The cube face.
+	 * @return The blocks, or null if there is no matching previous output.
+	 */
+	const std::uint8_t* previousBlocks(unsigned int mipLevel, unsigned int depth,
+		unsigned int face) const;
+
+	/**
+	 * @brief Adds to the number of blocks reused from the previous output.
+	 * @param count The number of blocks.
+	 */
+	void addReusedBlocks(std::size_t count) {m_reusedBlocks += count;}
+
+	/**
+	 * @brief Gets the number of blocks reused from the previous output.
+	 * @return The number of blocks.
+	 */
+	std::size_t reusedBlocks() const {return m_reusedBlocks;}
+
+	/**
+	 * @brief Returns whether or not there are hashes to save.
+	 * @return True if there are hashes.
+	 */
+	bool hasHashes() const {return !m_hashes.empty();}
+
+	/**
+	 * @brief Saves the block hashes.
+	 * @param fileName The file name to save to.
+	 * @param texture The converted texture.
+	 * @return False if there are no hashes or the file couldn't be written.
+	 */
+	bool saveHashes(const char* fileName, const Texture& texture) const;
+
+	/**
+	 * @brief Computes the hash for the encoded data of a texture.
+	 * @param texture The converted texture.
+	 * @return The hash of the data for all surfaces.
+	 */
+	static Key computeDataHash(const Texture& texture);
+
+	struct Header
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t format;
+		std::uint32_t type;
+		std::uint32_t quality;
+		std::uint32_t alphaType;
+		std::uint32_t colorMask;
+		std::uint32_t colorSpace;
+		std::uint32_t dimension;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t depth;
+		std::uint32_t mipLevels;
+		std::uint32_t faces;
+		std::uint32_t adaptiveQuality;
+		float adaptiveErrorThreshold;
+		std::uint32_t encoder;
+		std::uint64_t dataHash[2];
+	};
+
+private:
+	using SurfaceHashes = std::vector<Key>;
+
+	std::size_t surfaceIndex(unsigned int mipLevel, unsigned int depth, unsigned int face) const;
+	bool findPreviousBlocks();
+
+	Header m_header = {};
+	std::vector<SurfaceHashes> m_hashes;
+	std::vector<unsigned int> m_mipSurfaceOffsets;
+
+	Texture::FileType m_previousFileType = Texture::FileType::Auto;
+	std::vector<std::uint8_t> m_previousFile;
+	Header m_previousHeader = {};
+	std::vector<SurfaceHashes> m_previousHashes;
+	std::vector<const std::uint8_t*> m_previousBlocks;
+
+	std::size_t m_reusedBlocks = 0;
+};
+
+} // namespace cuttlefish
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "JobProcessor.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+namespace cuttlefish
+{
+
+void JobProcessor::run(unsigned int threadCount)
+{
+	unsigned int curJobsX = jobsX();
+	unsigned int jobCount = curJobsX*jobsY();
+	assert(jobCount > 0);
+
+	unsigned int curThreads = std::min(jobCount, threadCount);
+	if (curThreads <= 1)
+	{
+		std::unique_ptr<ThreadData> singleThreadData = createThreadData();
+		for (unsigned int i = 0; i < jobCount; ++i)
+			process(i % curJobsX, i/curJobsX, singleThreadData.get());
+		return;
+	}
+
+	// Initialize all thread data first in case they work with global data, such as library
+	// initialization. (some of which is beyond our control)
+	std::vector<std::unique_ptr<ThreadData>> threadData;
+	threadData.reserve(curThreads);
+	for (unsigned int i = 0; i < curThreads; ++i)
+		threadData.push_back(createThreadData());
+
+	std::atomic<unsigned int> curJob(0);
+	std::vector<std::thread> threads;
+	threads.reserve(curThreads);
+	for (unsigned int i = 0; i < curThreads; ++i)
+	{
+		ThreadData* threadDataPtr = threadData[i].get();
+		threads.emplace_back([this, &curJob, jobCount, curJobsX, threadDataPtr]()
+			{
+				do
+				{
+					unsigned int thisJob = curJob++;
+					if (thisJob >= jobCount)
+						return;
+
+					process(thisJob % curJobsX, thisJob/curJobsX, threadDataPtr);
+				} while (true);
+			});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+std::unique_ptr<JobProcessor::ThreadData> JobProcessor::createThreadData()
+{
+	return nullptr;
+}
+
+} // namespace cuttlefish
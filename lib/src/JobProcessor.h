@@ -0,0 +1,51 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <memory>
+
+namespace cuttlefish
+{
+
+// Base class for work that's split into a grid of jobs that may be processed across multiple
+// threads. Used both to encode and decode textures.
+class JobProcessor
+{
+public:
+	class ThreadData
+	{
+	public:
+		virtual ~ThreadData() = default;
+	};
+
+	JobProcessor() = default;
+	JobProcessor(const JobProcessor&) = delete;
+	JobProcessor& operator=(const JobProcessor&) = delete;
+
+	virtual ~JobProcessor() = default;
+
+	// Processes all of the jobs, distributing them across up to threadCount threads.
+	void run(unsigned int threadCount);
+
+	virtual unsigned int jobsX() const = 0;
+	virtual unsigned int jobsY() const = 0;
+	virtual void process(unsigned int x, unsigned int y, ThreadData* threadData) = 0;
+	virtual std::unique_ptr<ThreadData> createThreadData();
+};
+
+} // namespace cuttlefish
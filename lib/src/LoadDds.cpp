@@ -0,0 +1,163 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LoadDds.h"
+#include "SaveDds.h"
+#include "Shared.h"
+#include <algorithm>
+#include <cstring>
+
+namespace cuttlefish
+{
+
+bool loadDds(LoadedTexture& outTexture, const std::uint8_t* data, std::size_t size)
+{
+	std::uint32_t magicNumber;
+	DdsHeader header;
+	std::size_t offset = sizeof(magicNumber) + sizeof(header);
+	if (size < offset)
+		return false;
+
+	std::memcpy(&magicNumber, data, sizeof(magicNumber));
+	std::memcpy(&header, data + sizeof(magicNumber), sizeof(header));
+	if (magicNumber != ddsMagicNumber || header.size != sizeof(DdsHeader) ||
+		header.ddspf.size != sizeof(DdsPixelFormat) ||
+		!(header.ddspf.flags & DdsFormatFlags_FourCC))
+	{
+		return false;
+	}
+
+	std::uint32_t dxgiFormat;
+	std::uint32_t arraySize = 0;
+	bool hasAlpha = true;
+	if (header.ddspf.fourCC == FOURCC('D', 'X', '1', '0'))
+	{
+		DdsHeaderDxt10 dxt10Header;
+		if (size - offset < sizeof(dxt10Header))
+			return false;
+
+		std::memcpy(&dxt10Header, data + offset, sizeof(dxt10Header));
+		offset += sizeof(dxt10Header);
+
+		dxgiFormat = dxt10Header.dxgiFormat;
+		arraySize = dxt10Header.arraySize;
+		switch (dxt10Header.resourceDimension)
+		{
+			case DdsTextureDim_TEXTURE1D:
+				outTexture.dimension = Texture::Dimension::Dim1D;
+				break;
+			case DdsTextureDim_TEXTURE2D:
+				if (dxt10Header.miscFlag & DdsDxt10MiscFlag_CubeMap)
+					outTexture.dimension = Texture::Dimension::Cube;
+				else
+					outTexture.dimension = Texture::Dimension::Dim2D;
+				break;
+			case DdsTextureDim_TEXTURE3D:
+				outTexture.dimension = Texture::Dimension::Dim3D;
+				break;
+			default:
+				return false;
+		}
+
+		switch (dxt10Header.miscFlags2 & 0x7)
+		{
+			case DdsDxt10MiscFlags2_AlphaModeOpaque:
+				outTexture.alphaType = Texture::Alpha::None;
+				hasAlpha = false;
+				break;
+			case DdsDxt10MiscFlags2_AlphaModePreMultiplied:
+				outTexture.alphaType = Texture::Alpha::PreMultiplied;
+				break;
+			case DdsDxt10MiscFlags2_AlphaModeCustom:
+				outTexture.alphaType = Texture::Alpha::Encoded;
+				break;
+			default:
+				outTexture.alphaType = Texture::Alpha::Standard;
+				break;
+		}
+	}
+	else
+	{
+		// Legacy headers are only supported for the common block compressed formats.
+		dxgiFormat = getDdsFourCCFormat(header.ddspf.fourCC);
+		if (header.ddspf.fourCC == FOURCC('D', 'X', 'T', '2') ||
+			header.ddspf.fourCC == FOURCC('D', 'X', 'T', '4'))
+		{
+			outTexture.alphaType = Texture::Alpha::PreMultiplied;
+		}
+
+		if (header.caps2 & DdsCaps2Flags_Cube)
+		{
+			const std::uint32_t allFaces = DdsCaps2Flags_PosX | DdsCaps2Flags_NegX |
+				DdsCaps2Flags_PosY | DdsCaps2Flags_NegY | DdsCaps2Flags_PosZ | DdsCaps2Flags_NegZ;
+			if ((header.caps2 & allFaces) != allFaces)
+				return false;
+			outTexture.dimension = Texture::Dimension::Cube;
+		}
+		else if (header.caps2 & DdsCaps2Flags_Volume)
+			outTexture.dimension = Texture::Dimension::Dim3D;
+		else
+			outTexture.dimension = Texture::Dimension::Dim2D;
+	}
+
+	if (!findDdsFormat(outTexture.format, outTexture.type, outTexture.colorSpace, dxgiFormat,
+			hasAlpha))
+	{
+		return false;
+	}
+
+	outTexture.width = header.width;
+	outTexture.height = header.height;
+	// The array size in the DX10 header is the depth for array textures, including arrays with a
+	// single element, and 0 for other textures as written by saveDds(). A single element is laid
+	// out the same as a texture that isn't an array, so it's safe to treat it as an array.
+	if (outTexture.dimension == Texture::Dimension::Dim3D)
+		outTexture.depth = header.depth;
+	else
+		outTexture.depth = arraySize;
+	if ((header.flags & DdsFlags_MipmapCount) && header.mipMapCount > 0)
+		outTexture.mipLevels = header.mipMapCount;
+	else
+		outTexture.mipLevels = 1;
+	outTexture.rowAlignment = 1;
+
+	if (!outTexture.initializeSurfaces(size))
+		return false;
+
+	// Each array element stores the mip chain for each face, with the depth slices of 3D
+	// textures stored for each mip level.
+	bool is3D = outTexture.dimension == Texture::Dimension::Dim3D;
+	unsigned int elements = is3D ? 1 : std::max(outTexture.depth, 1U);
+	for (unsigned int element = 0; element < elements; ++element)
+	{
+		for (unsigned int face = 0; face < outTexture.faces(); ++face)
+		{
+			for (unsigned int mip = 0; mip < outTexture.mipLevels; ++mip)
+			{
+				unsigned int volumes = is3D ? outTexture.mipDepth(mip) : 1;
+				for (unsigned int volume = 0; volume < volumes; ++volume)
+				{
+					if (!outTexture.takeSurface(offset, data, size, mip, volume + element, face))
+						return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+} // namespace cuttlefish
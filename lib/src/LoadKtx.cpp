@@ -0,0 +1,133 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LoadKtx.h"
+#include "SaveKtx.h"
+#include <algorithm>
+#include <cstring>
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+struct KtxHeader
+{
+	char identifier[12];
+	std::uint32_t endianness;
+	std::uint32_t glType;
+	std::uint32_t glTypeSize;
+	std::uint32_t glFormat;
+	std::uint32_t glInternalFormat;
+	std::uint32_t glBaseInternalFormat;
+	std::uint32_t pixelWidth;
+	std::uint32_t pixelHeight;
+	std::uint32_t pixelDepth;
+	std::uint32_t numberOfArrayElements;
+	std::uint32_t numberOfFaces;
+	std::uint32_t numberOfMipmapLevels;
+	std::uint32_t bytesOfKeyValueData;
+};
+
+bool alignOffset(std::size_t& offset, std::size_t size)
+{
+	std::size_t alignedOffset = (offset + 3)/4*4;
+	if (alignedOffset > size)
+		return false;
+
+	offset = alignedOffset;
+	return true;
+}
+
+} // namespace
+
+bool loadKtx(LoadedTexture& outTexture, const std::uint8_t* data, std::size_t size)
+{
+	KtxHeader header;
+	std::size_t offset = sizeof(header);
+	if (size < offset)
+		return false;
+
+	// Files with the opposite endianness would need every value to be swapped.
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.identifier, ktxIdentifier, sizeof(ktxIdentifier)) != 0 ||
+		header.endianness != ktxEndianness ||
+		(header.numberOfFaces != 1 && header.numberOfFaces != 6) ||
+		(header.pixelDepth > 0 && (header.numberOfArrayElements > 0 ||
+			header.numberOfFaces != 1)) ||
+		size - offset < header.bytesOfKeyValueData)
+	{
+		return false;
+	}
+	offset += header.bytesOfKeyValueData;
+
+	if (!findKtxFormat(outTexture.format, outTexture.type, outTexture.colorSpace, header.glType,
+			header.glFormat, header.glInternalFormat))
+	{
+		return false;
+	}
+
+	outTexture.alphaType = Texture::Alpha::Standard;
+	outTexture.width = header.pixelWidth;
+	outTexture.height = std::max(header.pixelHeight, 1U);
+	if (header.numberOfFaces == 6)
+	{
+		outTexture.dimension = Texture::Dimension::Cube;
+		outTexture.depth = header.numberOfArrayElements;
+	}
+	else if (header.pixelDepth > 0)
+	{
+		outTexture.dimension = Texture::Dimension::Dim3D;
+		outTexture.depth = header.pixelDepth;
+	}
+	else
+	{
+		outTexture.dimension = header.pixelHeight == 0 ? Texture::Dimension::Dim1D :
+			Texture::Dimension::Dim2D;
+		outTexture.depth = header.numberOfArrayElements;
+	}
+	outTexture.mipLevels = std::max(header.numberOfMipmapLevels, 1U);
+
+	// Scanlines are 4-byte aligned.
+	outTexture.rowAlignment = 4;
+	if (!outTexture.initializeSurfaces(size))
+		return false;
+
+	for (unsigned int mip = 0; mip < outTexture.mipLevels; ++mip)
+	{
+		// The image size is computed from the dimensions instead.
+		if (!alignOffset(offset, size) || size - offset < sizeof(std::uint32_t))
+			return false;
+		offset += sizeof(std::uint32_t);
+
+		for (unsigned int d = 0; d < outTexture.mipDepth(mip); ++d)
+		{
+			for (unsigned int face = 0; face < outTexture.faces(); ++face)
+			{
+				if (!alignOffset(offset, size) ||
+					!outTexture.takeSurface(offset, data, size, mip, d, face))
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+} // namespace cuttlefish
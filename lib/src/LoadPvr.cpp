@@ -0,0 +1,161 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LoadPvr.h"
+#include "SavePvr.h"
+#include "Shared.h"
+#include <cstddef>
+#include <cstring>
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+struct PvrHeader
+{
+	std::uint32_t version;
+	std::uint32_t flags;
+	std::uint64_t pixelFormat;
+	std::uint32_t colorSpace;
+	std::uint32_t channelType;
+	std::uint32_t height;
+	std::uint32_t width;
+	std::uint32_t depth;
+	std::uint32_t surfaceCount;
+	std::uint32_t faceCount;
+	std::uint32_t mipCount;
+	std::uint32_t metadataSize;
+};
+
+struct PvrMetadataHeader
+{
+	std::uint32_t fourCC;
+	std::uint32_t key;
+	std::uint32_t size;
+};
+
+const std::uint32_t preMultipliedFlag = 0x2;
+
+} // namespace
+
+bool loadPvr(LoadedTexture& outTexture, const std::uint8_t* data, std::size_t size)
+{
+	// The size of the structure is padded to 8 bytes, while the file header is 52 bytes.
+	PvrHeader header;
+	const std::size_t headerSize = offsetof(PvrHeader, metadataSize) + sizeof(std::uint32_t);
+	static_assert(headerSize == 52, "unexpected PVR header size");
+	if (size < headerSize)
+		return false;
+
+	std::memcpy(&header, data, headerSize);
+	std::size_t offset = headerSize;
+	if (header.version != FOURCC('P', 'V', 'R', 3) ||
+		(header.faceCount != 1 && header.faceCount != 6) || header.surfaceCount == 0 ||
+		(header.depth > 1 && (header.surfaceCount > 1 || header.faceCount != 1)) ||
+		size - offset < header.metadataSize)
+	{
+		return false;
+	}
+
+	// Metadata written by Cuttlefish to preserve the texture properties.
+	bool bc1Alpha = true;
+	bool isArray = header.surfaceCount > 1;
+	bool is1D = false;
+	std::size_t metadataEnd = offset + header.metadataSize;
+	while (metadataEnd - offset >= sizeof(PvrMetadataHeader))
+	{
+		PvrMetadataHeader metadata;
+		std::memcpy(&metadata, data + offset, sizeof(metadata));
+		offset += sizeof(metadata);
+		if (metadataEnd - offset < metadata.size)
+			return false;
+
+		if (metadata.fourCC == FOURCC('C', 'T', 'F', 'S'))
+		{
+			switch (metadata.key)
+			{
+				case FOURCC('B', 'C', '1', 'A'):
+					bc1Alpha = true;
+					break;
+				case FOURCC('B', 'C', '1', 0):
+					bc1Alpha = false;
+					break;
+				case FOURCC('A', 'R', 'R', 'Y'):
+					isArray = true;
+					break;
+				case FOURCC('D', 'I', 'M', '1'):
+					is1D = true;
+					break;
+				default:
+					break;
+			}
+		}
+		offset += metadata.size;
+	}
+	offset = metadataEnd;
+
+	bool preMultiplied = (header.flags & preMultipliedFlag) != 0;
+	if (!findPvrFormat(outTexture.format, outTexture.type, header.pixelFormat, header.channelType,
+			preMultiplied, bc1Alpha))
+	{
+		return false;
+	}
+
+	outTexture.colorSpace = header.colorSpace == 1 ? ColorSpace::sRGB : ColorSpace::Linear;
+	outTexture.alphaType = preMultiplied ? Texture::Alpha::PreMultiplied :
+		Texture::Alpha::Standard;
+	outTexture.width = header.width;
+	outTexture.height = header.height;
+	if (header.faceCount == 6)
+	{
+		outTexture.dimension = Texture::Dimension::Cube;
+		outTexture.depth = isArray ? header.surfaceCount : 0;
+	}
+	else if (header.depth > 1)
+	{
+		outTexture.dimension = Texture::Dimension::Dim3D;
+		outTexture.depth = header.depth;
+	}
+	else
+	{
+		outTexture.dimension = is1D ? Texture::Dimension::Dim1D : Texture::Dimension::Dim2D;
+		outTexture.depth = isArray ? header.surfaceCount : 0;
+	}
+	outTexture.mipLevels = header.mipCount;
+	outTexture.rowAlignment = 1;
+
+	if (!outTexture.initializeSurfaces(size))
+		return false;
+
+	// Each mip level stores the faces for each array element or depth slice.
+	for (unsigned int mip = 0; mip < outTexture.mipLevels; ++mip)
+	{
+		for (unsigned int d = 0; d < outTexture.mipDepth(mip); ++d)
+		{
+			for (unsigned int face = 0; face < outTexture.faces(); ++face)
+			{
+				if (!outTexture.takeSurface(offset, data, size, mip, d, face))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LoadedTexture.h"
+#include "TextureArena.h"
+#include <algorithm>
+#include <cassert>
+
+namespace cuttlefish
+{
+
+unsigned int LoadedTexture::mipWidth(unsigned int mip) const
+{
+	return std::max(width >> mip, 1U);
+}
+
+unsigned int LoadedTexture::mipHeight(unsigned int mip) const
+{
+	return std::max(height >> mip, 1U);
+}
+
+unsigned int LoadedTexture::mipDepth(unsigned int mip) const
+{
+	if (dimension == Texture::Dimension::Dim3D)
+		return std::max(depth >> mip, 1U);
+	return std::max(depth, 1U);
+}
+
+std::size_t LoadedTexture::surfaceSize(unsigned int mip) const
+{
+	if (rowAlignment <= 1 || Texture::blockWidth(format) > 1)
+		return TextureArena::imageSize(format, mipWidth(mip), mipHeight(mip));
+
+	std::size_t rowSize = static_cast<std::size_t>(mipWidth(mip))*Texture::blockSize(format);
+	return (rowSize + rowAlignment - 1)/rowAlignment*rowAlignment*mipHeight(mip);
+}
+
+bool LoadedTexture::hasRowPadding() const
+{
+	if (rowAlignment <= 1 || Texture::blockWidth(format) > 1)
+		return false;
+
+	for (unsigned int mip = 0; mip < mipLevels; ++mip)
+	{
+		if (mipWidth(mip)*Texture::blockSize(format) % rowAlignment != 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool LoadedTexture::initializeSurfaces(std::size_t fileSize)
+{
+	if (format == Texture::Format::Unknown || width == 0 || height == 0 ||
+		(dimension == Texture::Dimension::Dim3D && depth == 0) || mipLevels == 0 ||
+		mipLevels > Texture::maxMipmapLevels(dimension, width, height, depth))
+	{
+		return false;
+	}
+
+	std::size_t count = 0;
+	for (unsigned int mip = 0; mip < mipLevels; ++mip)
+	{
+		count += static_cast<std::size_t>(mipDepth(mip))*faces();
+		if (count > fileSize)
+			return false;
+	}
+
+	surfaces.assign(count, nullptr);
+	return true;
+}
+
+bool LoadedTexture::takeSurface(std::size_t& offset, const std::uint8_t* data, std::size_t size,
+	unsigned int mip, unsigned int d, unsigned int face)
+{
+	assert(offset <= size);
+	std::size_t curSize = surfaceSize(mip);
+	if (curSize == 0 || size - offset < curSize)
+		return false;
+
+	std::size_t index = 0;
+	for (unsigned int i = 0; i < mip; ++i)
+		index += mipDepth(i)*faces();
+	index += d*faces() + face;
+	assert(index < surfaces.size());
+
+	surfaces[index] = data + offset;
+	offset += curSize;
+	return true;
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Texture.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cuttlefish
+{
+
+// Texture loaded from a file, with the surfaces referencing the file data.
+struct LoadedTexture
+{
+	Texture::Dimension dimension = Texture::Dimension::Dim2D;
+	Texture::Format format = Texture::Format::Unknown;
+	Texture::Type type = Texture::Type::UNorm;
+	ColorSpace colorSpace = ColorSpace::Linear;
+	Texture::Alpha alphaType = Texture::Alpha::Standard;
+	unsigned int width = 0;
+	unsigned int height = 0;
+	// Same as Texture, which is the depth for 3D textures or the array layers, or 0 if not an
+	// array.
+	unsigned int depth = 0;
+	unsigned int mipLevels = 0;
+
+	// Alignment for each row of uncompressed formats within the file.
+	unsigned int rowAlignment = 1;
+
+	// Start of the data for each surface, ordered by mip level, depth, then face.
+	std::vector<const std::uint8_t*> surfaces;
+
+	unsigned int faces() const {return dimension == Texture::Dimension::Cube ? 6 : 1;}
+	unsigned int mipWidth(unsigned int mip) const;
+	unsigned int mipHeight(unsigned int mip) const;
+	unsigned int mipDepth(unsigned int mip) const;
+
+	// Size of each surface for a mip level within the file, including any row padding.
+	std::size_t surfaceSize(unsigned int mip) const;
+
+	// Whether or not the rows are padded within the file for any mip level.
+	bool hasRowPadding() const;
+
+	// Validates the dimensions and allocates the surfaces once the other members are set. Each
+	// surface must take at least one byte, which limits the number of surfaces for invalid files.
+	bool initializeSurfaces(std::size_t fileSize);
+
+	// Sets the surface to the data at offset, advancing offset past it. Returns false if the
+	// surface extends past the end of the data.
+	bool takeSurface(std::size_t& offset, const std::uint8_t* data, std::size_t size,
+		unsigned int mip, unsigned int d, unsigned int face);
+};
+
+} // namespace cuttlefish
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MappedFile.h"
+#include <limits>
+
+#if CUTTLEFISH_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cuttlefish
+{
+
+MappedFile::MappedFile()
+	: m_data(nullptr)
+	, m_size(0)
+	, m_open(false)
+#if CUTTLEFISH_WINDOWS
+	, m_file(INVALID_HANDLE_VALUE)
+	, m_mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const char* fileName)
+{
+	close();
+	if (!fileName)
+		return false;
+
+#if CUTTLEFISH_WINDOWS
+	// Allow the file to be replaced while it's mapped, such as when saving over a loaded texture.
+	HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || static_cast<std::uint64_t>(size.QuadPart) >
+		std::numeric_limits<std::size_t>::max())
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_size = static_cast<std::size_t>(size.QuadPart);
+	m_open = true;
+
+	// Empty files can't be mapped.
+	if (m_size == 0)
+		return true;
+
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping)
+	{
+		close();
+		return false;
+	}
+
+	m_data = reinterpret_cast<const std::uint8_t*>(
+		MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_data)
+	{
+		close();
+		return false;
+	}
+#else
+	int fd = ::open(fileName, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) ||
+		static_cast<std::uint64_t>(fileStat.st_size) > std::numeric_limits<std::size_t>::max())
+	{
+		::close(fd);
+		return false;
+	}
+
+	m_size = static_cast<std::size_t>(fileStat.st_size);
+	m_open = true;
+
+	// Empty files can't be mapped.
+	if (m_size == 0)
+	{
+		::close(fd);
+		return true;
+	}
+
+	// The mapping keeps the file referenced, so the descriptor isn't needed afterward.
+	void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		m_size = 0;
+		m_open = false;
+		return false;
+	}
+
+	m_data = reinterpret_cast<const std::uint8_t*>(data);
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#if CUTTLEFISH_WINDOWS
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data)
+		munmap(const_cast<std::uint8_t*>(m_data), m_size);
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+	m_open = false;
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace cuttlefish
+{
+
+// Read-only memory mapping of a file. The data remains valid until the file is closed.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const char* fileName);
+	void close();
+
+	bool isOpen() const {return m_open;}
+
+	// Null for empty files.
+	const std::uint8_t* data() const {return m_data;}
+	std::size_t size() const {return m_size;}
+
+private:
+	const std::uint8_t* m_data;
+	std::size_t m_size;
+	bool m_open;
+#if CUTTLEFISH_WINDOWS
+	void* m_file;
+	void* m_mapping;
+#endif
+};
+
+} // namespace cuttlefish
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OutputSlices.h"
+#include "Shared.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+
+#if !CUTTLEFISH_WINDOWS
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace cuttlefish
+{
+
+static const char zeroPadding[64] = {};
+
+#if !CUTTLEFISH_WINDOWS && !defined(IOV_MAX)
+#define IOV_MAX 1024
+#endif
+
+OutputSlices::OutputSlices()
+	: m_size(0)
+	, m_streamBuf(*this)
+	, m_stream(&m_streamBuf)
+{
+}
+
+void OutputSlices::add(const void* data, std::size_t size)
+{
+	if (size == 0)
+		return;
+
+	// Merge with the previous slice when the data is contiguous, such as consecutive images within
+	// the converted texture data.
+	auto charData = reinterpret_cast<const char*>(data);
+	if (!m_slices.empty() && m_slices.back().data &&
+		m_slices.back().data + m_slices.back().size == charData)
+	{
+		m_slices.back().size += size;
+	}
+	else
+		m_slices.push_back(Slice{charData, 0, size});
+	m_size += size;
+}
+
+void OutputSlices::add(std::vector<std::uint8_t>&& data)
+{
+	if (data.empty())
+		return;
+
+	// Moving the vector keeps the same allocation, so the slice remains valid as more are added.
+	m_ownedData.push_back(std::move(data));
+	add(m_ownedData.back().data(), m_ownedData.back().size());
+}
+
+void OutputSlices::addPadding(std::size_t size)
+{
+	while (size > 0)
+	{
+		std::size_t curSize = std::min(size, sizeof(zeroPadding));
+		add(zeroPadding, curSize);
+		size -= curSize;
+	}
+}
+
+bool OutputSlices::write(std::ostream& stream) const
+{
+	for (const Slice& slice : m_slices)
+	{
+		stream.write(sliceData(slice), slice.size);
+		if (!stream.good())
+			return false;
+	}
+
+	return true;
+}
+
+bool OutputSlices::write(void* outData, std::size_t size) const
+{
+	if (size < m_size)
+		return false;
+
+	auto dst = reinterpret_cast<char*>(outData);
+	for (const Slice& slice : m_slices)
+	{
+		std::memcpy(dst, sliceData(slice), slice.size);
+		dst += slice.size;
+	}
+
+	return true;
+}
+
+bool OutputSlices::write(const char* fileName) const
+{
+	// Write to a temporary file and replace the original once complete. This keeps the original
+	// file intact if writing fails, and allows saving over a file that's memory mapped by a loaded
+	// texture that's being saved.
+	std::string tempName = tempFileName(fileName);
+	if (!writeFile(tempName.c_str()))
+	{
+		std::remove(tempName.c_str());
+		return false;
+	}
+
+	return replaceFile(tempName.c_str(), fileName);
+}
+
+bool OutputSlices::writeFile(const char* fileName) const
+{
+#if CUTTLEFISH_WINDOWS
+	std::ofstream stream(fileName, std::ofstream::binary);
+	if (!stream.is_open())
+		return false;
+
+	if (!write(stream))
+		return false;
+
+	stream.close();
+	return !stream.fail();
+#else
+	int fd = open(fileName, O_WRONLY | O_CREAT | O_EXCL, 0666);
+	if (fd < 0)
+		return false;
+
+	// Write up to IOV_MAX slices at a time, resuming after partial writes.
+	std::vector<iovec> vectors;
+	vectors.reserve(std::min(m_slices.size(), static_cast<std::size_t>(IOV_MAX)));
+	std::size_t curSlice = 0;
+	std::size_t sliceOffset = 0;
+	bool success = true;
+	while (curSlice < m_slices.size())
+	{
+		vectors.clear();
+		for (std::size_t i = curSlice; i < m_slices.size() && vectors.size() < IOV_MAX; ++i)
+		{
+			const Slice& slice = m_slices[i];
+			std::size_t offset = i == curSlice ? sliceOffset : 0;
+			vectors.push_back(iovec{const_cast<char*>(sliceData(slice) + offset),
+				slice.size - offset});
+		}
+
+		ssize_t written = writev(fd, vectors.data(), static_cast<int>(vectors.size()));
+		if (written <= 0)
+		{
+			if (written < 0 && errno == EINTR)
+				continue;
+
+			success = false;
+			break;
+		}
+
+		auto remaining = static_cast<std::size_t>(written);
+		while (curSlice < m_slices.size() && remaining >= m_slices[curSlice].size - sliceOffset)
+		{
+			remaining -= m_slices[curSlice].size - sliceOffset;
+			sliceOffset = 0;
+			++curSlice;
+		}
+		sliceOffset += remaining;
+	}
+
+	if (close(fd) != 0)
+		success = false;
+	return success;
+#endif
+}
+
+OutputSlices::CopyStreamBuf::int_type OutputSlices::CopyStreamBuf::overflow(int_type c)
+{
+	if (!traits_type::eq_int_type(c, traits_type::eof()))
+	{
+		char value = traits_type::to_char_type(c);
+		m_slices.addCopy(&value, 1);
+	}
+	return traits_type::not_eof(c);
+}
+
+std::streamsize OutputSlices::CopyStreamBuf::xsputn(const char_type* s, std::streamsize count)
+{
+	m_slices.addCopy(s, static_cast<std::size_t>(count));
+	return count;
+}
+
+void OutputSlices::forEachSlice(
+	const std::function<void(const void* data, std::size_t size)>& function) const
+{
+	for (const Slice& slice : m_slices)
+		function(sliceData(slice), slice.size);
+}
+
+const char* OutputSlices::sliceData(const Slice& slice) const
+{
+	if (slice.data)
+		return slice.data;
+	return m_copiedData.data() + slice.offset;
+}
+
+void OutputSlices::addCopy(const char* data, std::size_t size)
+{
+	if (size == 0)
+		return;
+
+	// Extend the previous slice when it was also copied.
+	if (!m_slices.empty() && !m_slices.back().data &&
+		m_slices.back().offset + m_slices.back().size == m_copiedData.size())
+	{
+		m_slices.back().size += size;
+	}
+	else
+		m_slices.push_back(Slice{nullptr, m_copiedData.size(), size});
+
+	m_copiedData.insert(m_copiedData.end(), data, data + size);
+	m_size += size;
+}
+
+} // namespace cuttlefish
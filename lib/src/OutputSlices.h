@@ -0,0 +1,104 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Export.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+namespace cuttlefish
+{
+
+// List of slices of memory to write to a file in order. Large blocks of texture data are referenced
+// directly, while small values such as headers are copied through stream(). This allows the file to
+// be written with a single gather write rather than many small writes.
+class CUTTLEFISH_EXPORT OutputSlices
+{
+public:
+	OutputSlices();
+
+	OutputSlices(const OutputSlices&) = delete;
+	OutputSlices& operator=(const OutputSlices&) = delete;
+
+	// Stream to write values that are copied into the slices.
+	std::ostream& stream() {return m_stream;}
+
+	// Adds a reference to data, which must remain valid until the slices are written.
+	void add(const void* data, std::size_t size);
+
+	// Adds data that's owned by the slices, such as data that was compressed while saving.
+	void add(std::vector<std::uint8_t>&& data);
+
+	// Adds zero bytes for padding.
+	void addPadding(std::size_t size);
+
+	// The total size of all slices.
+	std::size_t size() const {return m_size;}
+
+	bool write(std::ostream& stream) const;
+	bool write(void* outData, std::size_t size) const;
+
+	// Writes to a temporary file in the same directory, which then replaces fileName.
+	bool write(const char* fileName) const;
+
+	// Calls function with the data and size of each slice in order.
+	void forEachSlice(const std::function<void(const void* data, std::size_t size)>& function)
+		const;
+
+private:
+	class CopyStreamBuf : public std::streambuf
+	{
+	public:
+		explicit CopyStreamBuf(OutputSlices& slices)
+			: m_slices(slices)
+		{
+		}
+
+	protected:
+		int_type overflow(int_type c) override;
+		std::streamsize xsputn(const char_type* s, std::streamsize count) override;
+
+	private:
+		OutputSlices& m_slices;
+	};
+
+	struct Slice
+	{
+		// Null for data copied into m_copiedData, in which case offset is used.
+		const char* data;
+		std::size_t offset;
+		std::size_t size;
+	};
+
+	const char* sliceData(const Slice& slice) const;
+	bool writeFile(const char* fileName) const;
+	void addCopy(const char* data, std::size_t size);
+
+	std::vector<Slice> m_slices;
+	std::vector<char> m_copiedData;
+	std::vector<std::vector<std::uint8_t>> m_ownedData;
+	std::size_t m_size;
+	CopyStreamBuf m_streamBuf;
+	std::ostream m_stream;
+};
+
+} // namespace cuttlefish
@@ -0,0 +1,486 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PreviewEncoder.h"
+#include "EtcTables.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+const unsigned int blockPixels = 16;
+
+// Maps the level along the axis from the second endpoint to the first to the BC1 index.
+const unsigned int bc1LevelIndices[4] = {1, 3, 2, 0};
+
+class Bc7BlockWriter
+{
+public:
+	void write(std::uint64_t value, unsigned int bits)
+	{
+		if (m_position < 64)
+		{
+			m_low |= value << m_position;
+			if (m_position + bits > 64)
+				m_high |= value >> (64 - m_position);
+		}
+		else
+			m_high |= value << (m_position - 64);
+		m_position += bits;
+	}
+
+	void store(void* block) const
+	{
+		auto bytes = reinterpret_cast<std::uint8_t*>(block);
+		for (unsigned int i = 0; i < 8; ++i)
+		{
+			bytes[i] = static_cast<std::uint8_t>(m_low >> (i*8));
+			bytes[i + 8] = static_cast<std::uint8_t>(m_high >> (i*8));
+		}
+	}
+
+private:
+	std::uint64_t m_low = 0;
+	std::uint64_t m_high = 0;
+	unsigned int m_position = 0;
+};
+
+inline int quantize(int value, int maxValue)
+{
+	return (value*maxValue + 127)/255;
+}
+
+inline std::uint16_t pack565(const int color[3])
+{
+	return static_cast<std::uint16_t>((quantize(color[0], 31) << 11) |
+		(quantize(color[1], 63) << 5) | quantize(color[2], 31));
+}
+
+inline void unpack565(int outColor[3], std::uint16_t color)
+{
+	int r = (color >> 11) & 0x1F;
+	int g = (color >> 5) & 0x3F;
+	int b = color & 0x1F;
+	outColor[0] = (r << 3) | (r >> 2);
+	outColor[1] = (g << 2) | (g >> 4);
+	outColor[2] = (b << 3) | (b >> 2);
+}
+
+// Gets the level along the axis between two endpoints, rounded to the nearest of levels + 1
+// evenly spaced values. The scale is levels divided by the squared length of the axis, which
+// avoids a division for each pixel.
+inline unsigned int getAxisLevel(int projection, float scale, int levels)
+{
+	auto level = static_cast<int>(static_cast<float>(projection)*scale + 0.5f);
+	return static_cast<unsigned int>(std::min(std::max(level, 0), levels));
+}
+
+// Swaps the bounds of channels that decrease as the channel with the largest range increases, so
+// the diagonal of the bounding box follows the colors of the block.
+void selectDiagonal(int minColor[4], int maxColor[4], const std::uint8_t colors[16][4],
+	unsigned int channelCount)
+{
+	unsigned int reference = 0;
+	for (unsigned int c = 1; c < channelCount; ++c)
+	{
+		if (maxColor[c] - minColor[c] > maxColor[reference] - minColor[reference])
+			reference = c;
+	}
+
+	int referenceCenter = minColor[reference] + maxColor[reference];
+	for (unsigned int c = 0; c < channelCount; ++c)
+	{
+		if (c == reference)
+			continue;
+
+		int center = minColor[c] + maxColor[c];
+		int covariance = 0;
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			covariance += (colors[i][reference]*2 - referenceCenter)*
+				(colors[i][c]*2 - center);
+		}
+
+		if (covariance < 0)
+			std::swap(minColor[c], maxColor[c]);
+	}
+}
+
+void getBounds(int outMinColor[4], int outMaxColor[4], const std::uint8_t colors[16][4],
+	unsigned int channelCount)
+{
+	for (unsigned int c = 0; c < channelCount; ++c)
+		outMinColor[c] = outMaxColor[c] = colors[0][c];
+
+	for (unsigned int i = 1; i < blockPixels; ++i)
+	{
+		for (unsigned int c = 0; c < channelCount; ++c)
+		{
+			outMinColor[c] = std::min(outMinColor[c], static_cast<int>(colors[i][c]));
+			outMaxColor[c] = std::max(outMaxColor[c], static_cast<int>(colors[i][c]));
+		}
+	}
+
+	selectDiagonal(outMinColor, outMaxColor, colors, channelCount);
+}
+
+template <typename T>
+void encodeBc4Impl(void* block, const T* values, unsigned int stride)
+{
+	int minValue = values[0];
+	int maxValue = values[0];
+	for (unsigned int i = 1; i < blockPixels; ++i)
+	{
+		int value = values[i*stride];
+		minValue = std::min(minValue, value);
+		maxValue = std::max(maxValue, value);
+	}
+
+	// The first endpoint is larger to use 8 value mode. Equal endpoints always use index 0.
+	auto bytes = reinterpret_cast<std::uint8_t*>(block);
+	bytes[0] = static_cast<std::uint8_t>(static_cast<T>(maxValue));
+	bytes[1] = static_cast<std::uint8_t>(static_cast<T>(minValue));
+
+	std::uint64_t indices = 0;
+	int range = maxValue - minValue;
+	if (range > 0)
+	{
+		float scale = 7.0f/static_cast<float>(range);
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			unsigned int level = getAxisLevel(values[i*stride] - minValue, scale, 7);
+			unsigned int index = level == 7 ? 0 : level == 0 ? 1 : 8 - level;
+			indices |= static_cast<std::uint64_t>(index) << (i*3);
+		}
+	}
+
+	for (unsigned int i = 0; i < 6; ++i)
+		bytes[i + 2] = static_cast<std::uint8_t>(indices >> (i*8));
+}
+
+void quantizeBc7Endpoint(int outEndpoint[4], unsigned int& outPBit, const int color[4])
+{
+	int bestError = std::numeric_limits<int>::max();
+	for (unsigned int pBit = 0; pBit < 2; ++pBit)
+	{
+		int endpoint[4];
+		int error = 0;
+		for (unsigned int c = 0; c < 4; ++c)
+		{
+			endpoint[c] = std::min((color[c] - static_cast<int>(pBit) + 1) >> 1, 0x7F);
+			int diff = ((endpoint[c] << 1) | static_cast<int>(pBit)) - color[c];
+			error += diff*diff;
+		}
+
+		if (error < bestError)
+		{
+			bestError = error;
+			outPBit = pBit;
+			std::copy(endpoint, endpoint + 4, outEndpoint);
+		}
+	}
+}
+
+} // namespace
+
+void encodeBc1Preview(void* block, const std::uint8_t colors[16][4])
+{
+	int minColor[4], maxColor[4];
+	getBounds(minColor, maxColor, colors, 3);
+
+	// Inset the bounding box, since the extremes are rarely the best endpoints.
+	for (unsigned int c = 0; c < 3; ++c)
+	{
+		int inset = (maxColor[c] - minColor[c])/16;
+		minColor[c] += inset;
+		maxColor[c] -= inset;
+	}
+
+	std::uint16_t endpoints[2] = {pack565(maxColor), pack565(minColor)};
+	if (endpoints[0] < endpoints[1])
+		std::swap(endpoints[0], endpoints[1]);
+
+	auto bytes = reinterpret_cast<std::uint8_t*>(block);
+	for (unsigned int i = 0; i < 2; ++i)
+	{
+		bytes[i*2] = static_cast<std::uint8_t>(endpoints[i]);
+		bytes[i*2 + 1] = static_cast<std::uint8_t>(endpoints[i] >> 8);
+	}
+
+	// Equal endpoints use index 0 for every pixel.
+	std::uint32_t indices = 0;
+	if (endpoints[0] != endpoints[1])
+	{
+		int first[3], second[3], axis[3];
+		unpack565(first, endpoints[0]);
+		unpack565(second, endpoints[1]);
+		int axisLength2 = 0;
+		for (unsigned int c = 0; c < 3; ++c)
+		{
+			axis[c] = first[c] - second[c];
+			axisLength2 += axis[c]*axis[c];
+		}
+
+		float scale = 3.0f/static_cast<float>(axisLength2);
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			int projection = 0;
+			for (unsigned int c = 0; c < 3; ++c)
+				projection += (colors[i][c] - second[c])*axis[c];
+			indices |= bc1LevelIndices[getAxisLevel(projection, scale, 3)] << (i*2);
+		}
+	}
+
+	for (unsigned int i = 0; i < 4; ++i)
+		bytes[i + 4] = static_cast<std::uint8_t>(indices >> (i*8));
+}
+
+void encodeBc3Preview(void* block, const std::uint8_t colors[16][4])
+{
+	auto bytes = reinterpret_cast<std::uint8_t*>(block);
+	encodeBc4Preview(bytes, colors[0] + 3, 4);
+	encodeBc1Preview(bytes + 8, colors);
+}
+
+void encodeBc4Preview(void* block, const std::uint8_t* values, unsigned int stride)
+{
+	encodeBc4Impl(block, values, stride);
+}
+
+void encodeBc4SPreview(void* block, const std::int8_t* values, unsigned int stride)
+{
+	encodeBc4Impl(block, values, stride);
+}
+
+void encodeBc7Preview(void* block, const std::uint8_t colors[16][4])
+{
+	int minColor[4], maxColor[4];
+	getBounds(minColor, maxColor, colors, 4);
+
+	int endpoints[2][4];
+	unsigned int pBits[2];
+	quantizeBc7Endpoint(endpoints[0], pBits[0], minColor);
+	quantizeBc7Endpoint(endpoints[1], pBits[1], maxColor);
+
+	int first[4], axis[4];
+	int axisLength2 = 0;
+	for (unsigned int c = 0; c < 4; ++c)
+	{
+		first[c] = (endpoints[0][c] << 1) | static_cast<int>(pBits[0]);
+		axis[c] = ((endpoints[1][c] << 1) | static_cast<int>(pBits[1])) - first[c];
+		axisLength2 += axis[c]*axis[c];
+	}
+
+	unsigned int indices[blockPixels] = {};
+	if (axisLength2 > 0)
+	{
+		float scale = 15.0f/static_cast<float>(axisLength2);
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			int projection = 0;
+			for (unsigned int c = 0; c < 4; ++c)
+				projection += (colors[i][c] - first[c])*axis[c];
+			indices[i] = getAxisLevel(projection, scale, 15);
+		}
+	}
+
+	// The anchor index only stores 3 bits, so swap the endpoints if its high bit is set.
+	if (indices[0] & 0x8)
+	{
+		std::swap(endpoints[0], endpoints[1]);
+		std::swap(pBits[0], pBits[1]);
+		for (unsigned int i = 0; i < blockPixels; ++i)
+			indices[i] = 15 - indices[i];
+	}
+
+	Bc7BlockWriter writer;
+	writer.write(1 << 6, 7);
+	for (unsigned int c = 0; c < 4; ++c)
+	{
+		writer.write(static_cast<std::uint64_t>(endpoints[0][c]), 7);
+		writer.write(static_cast<std::uint64_t>(endpoints[1][c]), 7);
+	}
+	writer.write(pBits[0], 1);
+	writer.write(pBits[1], 1);
+	writer.write(indices[0], 3);
+	for (unsigned int i = 1; i < blockPixels; ++i)
+		writer.write(indices[i], 4);
+	writer.store(block);
+}
+
+void encodeEtc1Preview(void* block, const std::uint8_t colors[16][4])
+{
+	// Without flipping, the sub-blocks are the left and right halves of the block.
+	int average[2][3] = {};
+	for (unsigned int y = 0; y < 4; ++y)
+	{
+		for (unsigned int x = 0; x < 4; ++x)
+		{
+			for (unsigned int c = 0; c < 3; ++c)
+				average[x >> 1][c] += colors[y*4 + x][c];
+		}
+	}
+
+	int quantized[2][3];
+	bool differential = true;
+	for (unsigned int c = 0; c < 3; ++c)
+	{
+		for (unsigned int s = 0; s < 2; ++s)
+		{
+			average[s][c] = (average[s][c] + 4)/8;
+			quantized[s][c] = quantize(average[s][c], 31);
+		}
+
+		int diff = quantized[1][c] - quantized[0][c];
+		if (diff < -4 || diff > 3)
+			differential = false;
+	}
+
+	auto bytes = reinterpret_cast<std::uint8_t*>(block);
+	int base[2][3];
+	for (unsigned int c = 0; c < 3; ++c)
+	{
+		if (differential)
+		{
+			bytes[c] = static_cast<std::uint8_t>((quantized[0][c] << 3) |
+				((quantized[1][c] - quantized[0][c]) & 0x7));
+			for (unsigned int s = 0; s < 2; ++s)
+				base[s][c] = (quantized[s][c] << 3) | (quantized[s][c] >> 2);
+		}
+		else
+		{
+			for (unsigned int s = 0; s < 2; ++s)
+			{
+				quantized[s][c] = quantize(average[s][c], 15);
+				base[s][c] = quantized[s][c]*17;
+			}
+			bytes[c] = static_cast<std::uint8_t>((quantized[0][c] << 4) | quantized[1][c]);
+		}
+	}
+
+	// Take the table with the large modifier closest to the largest deviation from the base color
+	// of each sub-block, and the nearest modifier for each pixel.
+	int deviations[blockPixels];
+	int maxDeviation[2] = {};
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		unsigned int s = (i & 0x3) >> 1;
+		int deviation = 0;
+		for (unsigned int c = 0; c < 3; ++c)
+			deviation += colors[i][c] - base[s][c];
+		deviations[i] = deviation/3;
+		maxDeviation[s] = std::max(maxDeviation[s], std::abs(deviations[i]));
+	}
+
+	unsigned int tables[2];
+	for (unsigned int s = 0; s < 2; ++s)
+	{
+		tables[s] = 0;
+		for (unsigned int t = 1; t < 8; ++t)
+		{
+			if (std::abs(etc1Modifiers[t][1] - maxDeviation[s]) <
+				std::abs(etc1Modifiers[tables[s]][1] - maxDeviation[s]))
+			{
+				tables[s] = t;
+			}
+		}
+	}
+
+	bytes[3] = static_cast<std::uint8_t>((tables[0] << 5) | (tables[1] << 2) |
+		(differential ? 0x2 : 0));
+
+	// Selectors are stored in column-major order.
+	unsigned int msb = 0, lsb = 0;
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		unsigned int x = i & 0x3, y = i >> 2;
+		unsigned int table = tables[x >> 1];
+		unsigned int bestSelector = 0;
+		int bestError = std::numeric_limits<int>::max();
+		for (unsigned int selector = 0; selector < 4; ++selector)
+		{
+			int error = std::abs(getEtc1Modifier(table, selector) - deviations[i]);
+			if (error < bestError)
+			{
+				bestSelector = selector;
+				bestError = error;
+			}
+		}
+
+		unsigned int index = x*4 + y;
+		msb |= (bestSelector >> 1) << index;
+		lsb |= (bestSelector & 0x1) << index;
+	}
+
+	bytes[4] = static_cast<std::uint8_t>(msb >> 8);
+	bytes[5] = static_cast<std::uint8_t>(msb);
+	bytes[6] = static_cast<std::uint8_t>(lsb >> 8);
+	bytes[7] = static_cast<std::uint8_t>(lsb);
+}
+
+void encodeEtc2AlphaPreview(void* block, const std::uint8_t* values, unsigned int stride)
+{
+	int minValue = values[0];
+	int maxValue = values[0];
+	for (unsigned int i = 1; i < blockPixels; ++i)
+	{
+		int value = values[i*stride];
+		minValue = std::min(minValue, value);
+		maxValue = std::max(maxValue, value);
+	}
+
+	// This table has nearly evenly spaced modifiers from -10 to 9, so scale it with the
+	// multiplier to cover the range of the block.
+	const unsigned int table = 11;
+	int multiplier = std::min(std::max((maxValue - minValue + 18)/19, 1), 15);
+	int base = std::min((minValue + maxValue + multiplier + 1)/2, 0xFF);
+
+	int palette[8];
+	for (unsigned int i = 0; i < 8; ++i)
+		palette[i] = std::min(std::max(base + eacModifiers[table][i]*multiplier, 0), 0xFF);
+
+	// Indices are stored in column-major order.
+	std::uint64_t indices = 0;
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		int value = values[((i & 0x3)*4 + (i >> 2))*stride];
+		unsigned int bestIndex = 0;
+		int bestError = std::numeric_limits<int>::max();
+		for (unsigned int j = 0; j < 8; ++j)
+		{
+			int error = std::abs(palette[j] - value);
+			if (error < bestError)
+			{
+				bestIndex = j;
+				bestError = error;
+			}
+		}
+		indices |= static_cast<std::uint64_t>(bestIndex) << (45 - i*3);
+	}
+
+	auto bytes = reinterpret_cast<std::uint8_t*>(block);
+	bytes[0] = static_cast<std::uint8_t>(base);
+	bytes[1] = static_cast<std::uint8_t>((multiplier << 4) | table);
+	for (unsigned int i = 0; i < 6; ++i)
+		bytes[i + 2] = static_cast<std::uint8_t>(indices >> ((5 - i)*8));
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Export.h>
+#include <cstdint>
+
+namespace cuttlefish
+{
+
+// Real-time encoders for Texture::Quality::Preview. These choose endpoints from the bounding box
+// of each block in a single pass without any search, trading quality for speed. Colors are in
+// row-major order. These are exported for unit tests.
+
+/**
+ * @brief Encodes a BC1 color block.
+ *
+ * This always uses 4 color mode, so it's also valid for the color portion of BC2 and BC3.
+ *
+ * @param[out] block The 8 byte block to write to.
+ * @param colors The RGBA colors to encode. Alpha is ignored.
+ */
+CUTTLEFISH_EXPORT void encodeBc1Preview(void* block, const std::uint8_t colors[16][4]);
+
+/**
+ * @brief Encodes a BC3 block.
+ * @param[out] block The 16 byte block to write to.
+ * @param colors The RGBA colors to encode.
+ */
+CUTTLEFISH_EXPORT void encodeBc3Preview(void* block, const std::uint8_t colors[16][4]);
+
+/**
+ * @brief Encodes an unsigned BC4 block.
+ *
+ * This may also be used for each channel of BC5.
+ *
+ * @param[out] block The 8 byte block to write to.
+ * @param values The values to encode.
+ * @param stride The number of values between each pixel in values.
+ */
+CUTTLEFISH_EXPORT void encodeBc4Preview(void* block, const std::uint8_t* values,
+	unsigned int stride);
+
+/**
+ * @brief Encodes a signed BC4 block.
+ * @param[out] block The 8 byte block to write to.
+ * @param values The values to encode in the range [-127, 127].
+ * @param stride The number of values between each pixel in values.
+ */
+CUTTLEFISH_EXPORT void encodeBc4SPreview(void* block, const std::int8_t* values,
+	unsigned int stride);
+
+/**
+ * @brief Encodes a BC7 block.
+ *
+ * This always uses mode 6, with a single subset for RGBA and 4-bit indices.
+ *
+ * @param[out] block The 16 byte block to write to.
+ * @param colors The RGBA colors to encode.
+ */
+CUTTLEFISH_EXPORT void encodeBc7Preview(void* block, const std::uint8_t colors[16][4]);
+
+/**
+ * @brief Encodes an ETC1 block.
+ *
+ * This uses the average color of each sub-block without flipping and never overflows the
+ * differential colors, so it's also valid for opaque ETC2 blocks.
+ *
+ * @param[out] block The 8 byte block to write to.
+ * @param colors The RGBA colors to encode. Alpha is ignored.
+ */
+CUTTLEFISH_EXPORT void encodeEtc1Preview(void* block, const std::uint8_t colors[16][4]);
+
+/**
+ * @brief Encodes an ETC2 alpha block.
+ * @param[out] block The 8 byte block to write to.
+ * @param values The values to encode.
+ * @param stride The number of values between each pixel in values.
+ */
+CUTTLEFISH_EXPORT void encodeEtc2AlphaPreview(void* block, const std::uint8_t* values,
+	unsigned int stride);
+
+} // namespace cuttlefish
@@ -17,10 +17,15 @@
 #if CUTTLEFISH_HAS_PVRTC
 
 #include "PvrtcConverter.h"
+#include "JobProcessor.h"
 #include "Shared.h"
 #include <cuttlefish/Color.h>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
 
 #if CUTTLEFISH_GCC || CUTTLEFISH_CLANG
 #pragma GCC diagnostic push
@@ -37,43 +42,86 @@
 namespace cuttlefish
 {
 
-PvrtcConverter::PvrtcConverter(const Texture& texture, const Image& image, Texture::Quality quality,
-	unsigned int threadCount)
-	: Converter(image)
-	, m_format(texture.format())
-	, m_quality(quality)
-	, m_threadCount(threadCount)
-	, m_premultipliedAlpha(texture.alphaType() == Texture::Alpha::PreMultiplied)
+namespace
 {
-}
 
-void PvrtcConverter::process(unsigned int, unsigned int, ThreadData*)
+// Fills the 8-bit input surfaces of the PVRTexLib texture in parallel, one job per scanline of
+// each surface.
+class PvrtcInputJobs : public JobProcessor
 {
-	unsigned int width = image().width(), height = image().height();
-	const PVRTuint64 inPixelType = PVRTGENPIXELID4('r', 'g', 'b', 'a', 8, 8, 8, 8);
-	pvrtexlib::PVRTexture pvrTexture(pvrtexlib::PVRTextureHeader(inPixelType, width, height, 1, 1,
-		1, 1, PVRTLCS_Linear, PVRTLVT_UnsignedByteNorm, m_premultipliedAlpha), nullptr);
+public:
+	struct Surface
+	{
+		const Image* image;
+		std::uint8_t* data;
+	};
+
+	PvrtcInputJobs(std::vector<Surface> surfaces, unsigned int maxHeight)
+		: m_surfaces(std::move(surfaces))
+		, m_maxHeight(maxHeight)
+	{
+	}
 
-	auto dstData = reinterpret_cast<std::uint8_t*>(pvrTexture.GetTextureDataPointer());
-	for (unsigned int y = 0; y < height; ++y)
+	unsigned int jobsX() const override {return static_cast<unsigned int>(m_surfaces.size());}
+	unsigned int jobsY() const override {return m_maxHeight;}
+
+	void process(unsigned int x, unsigned int y, ThreadData*) override
 	{
-		const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(y));
-		for (unsigned int x = 0; x < width; ++x)
+		const Surface& surface = m_surfaces[x];
+		unsigned int width = surface.image->width();
+		if (y >= surface.image->height())
+			return;
+
+		const ColorRGBAf* scanline =
+			reinterpret_cast<const ColorRGBAf*>(surface.image->scanline(y));
+		std::uint8_t* dstData = surface.data + y*width*4;
+		for (unsigned int i = 0; i < width; ++i)
 		{
-			unsigned int index = (y*width + x)*4;
-			dstData[index] = static_cast<std::uint8_t>(
-				std::round(clamp(scanline[x].r, 0.0f, 1.0f)*0xFF));
-			dstData[index + 1] = static_cast<std::uint8_t>(
-				std::round(clamp(scanline[x].g, 0.0f, 1.0f)*0xFF));
-			dstData[index + 2] = static_cast<std::uint8_t>(
-				std::round(clamp(scanline[x].b, 0.0f, 1.0f)*0xFF));
-			dstData[index + 3] = static_cast<std::uint8_t>(
-				std::round(clamp(scanline[x].a, 0.0f, 1.0f)*0xFF));
+			dstData[i*4] = static_cast<std::uint8_t>(
+				std::round(clamp(scanline[i].r, 0.0f, 1.0f)*0xFF));
+			dstData[i*4 + 1] = static_cast<std::uint8_t>(
+				std::round(clamp(scanline[i].g, 0.0f, 1.0f)*0xFF));
+			dstData[i*4 + 2] = static_cast<std::uint8_t>(
+				std::round(clamp(scanline[i].b, 0.0f, 1.0f)*0xFF));
+			dstData[i*4 + 3] = static_cast<std::uint8_t>(
+				std::round(clamp(scanline[i].a, 0.0f, 1.0f)*0xFF));
 		}
 	}
 
+private:
+	std::vector<Surface> m_surfaces;
+	unsigned int m_maxHeight;
+};
+
+} // namespace
+
+bool PvrtcConverter::isFormatSupported(Texture::Format format)
+{
+	switch (format)
+	{
+		case Texture::Format::PVRTC1_RGB_2BPP:
+		case Texture::Format::PVRTC1_RGBA_2BPP:
+		case Texture::Format::PVRTC1_RGB_4BPP:
+		case Texture::Format::PVRTC1_RGBA_4BPP:
+		case Texture::Format::PVRTC2_RGBA_2BPP:
+		case Texture::Format::PVRTC2_RGBA_4BPP:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool PvrtcConverter::convert(const Texture& texture, const Converter::MipImageList& images,
+	TextureArena& textureData, Texture::Quality quality, unsigned int threadCount)
+{
+	if (texture.type() != Texture::Type::UNorm || images.empty() || images[0].empty() ||
+		images[0][0].empty())
+	{
+		return false;
+	}
+
 	std::uint64_t pixelType;
-	switch (m_format)
+	switch (texture.format())
 	{
 		case Texture::Format::PVRTC1_RGB_2BPP:
 			pixelType = PVRTLPF_PVRTCI_2bpp_RGB;
@@ -94,38 +142,100 @@ void PvrtcConverter::process(unsigned int, unsigned int, ThreadData*)
 			pixelType = PVRTLPF_PVRTCII_4bpp;
 			break;
 		default:
-			assert(false);
-			return;
+			return false;
 	}
 
-	PVRTexLibCompressorQuality quality;
-	switch (m_quality)
+	PVRTexLibCompressorQuality pvrQuality;
+	switch (quality)
 	{
+		case Texture::Quality::Preview:
 		case Texture::Quality::Lowest:
-			quality = PVRTLCQ_PVRTCFastest;
+			pvrQuality = PVRTLCQ_PVRTCFastest;
 			break;
 		case Texture::Quality::Low:
-			quality = PVRTLCQ_PVRTCLow;
+			pvrQuality = PVRTLCQ_PVRTCLow;
 			break;
 		case Texture::Quality::Normal:
-			quality = PVRTLCQ_PVRTCNormal;
+			pvrQuality = PVRTLCQ_PVRTCNormal;
 			break;
 		case Texture::Quality::High:
-			quality = PVRTLCQ_PVRTCHigh;
+			pvrQuality = PVRTLCQ_PVRTCHigh;
 			break;
 		case Texture::Quality::Highest:
-			quality = PVRTLCQ_PVRTCBest;
+			pvrQuality = PVRTLCQ_PVRTCBest;
 			break;
 		default:
 			assert(false);
-			return;
+			return false;
+	}
+
+	// 3D textures store the depth slices for each mip, otherwise the depth index is the array
+	// layer.
+	bool is3D = texture.dimension() == Texture::Dimension::Dim3D;
+	auto mipLevels = static_cast<PVRTuint32>(images.size());
+	auto depth = is3D ? static_cast<PVRTuint32>(images[0].size()) : 1U;
+	auto arrayCount = is3D ? 1U : static_cast<PVRTuint32>(images[0].size());
+	auto faceCount = static_cast<PVRTuint32>(images[0][0].size());
+
+	const Image& firstImage = images[0][0][0];
+	const PVRTuint64 inPixelType = PVRTGENPIXELID4('r', 'g', 'b', 'a', 8, 8, 8, 8);
+	pvrtexlib::PVRTexture pvrTexture(pvrtexlib::PVRTextureHeader(inPixelType,
+		firstImage.width(), firstImage.height(), depth, mipLevels, arrayCount, faceCount,
+		PVRTLCS_Linear, PVRTLVT_UnsignedByteNorm,
+		texture.alphaType() == Texture::Alpha::PreMultiplied), nullptr);
+
+	std::vector<PvrtcInputJobs::Surface> surfaces;
+	for (PVRTuint32 mip = 0; mip < mipLevels; ++mip)
+	{
+		for (std::size_t d = 0; d < images[mip].size(); ++d)
+		{
+			for (PVRTuint32 f = 0; f < faceCount; ++f)
+			{
+				auto dIndex = static_cast<PVRTuint32>(d);
+				void* surfaceData = is3D ? pvrTexture.GetTextureDataPointer(mip, 0, f, dIndex) :
+					pvrTexture.GetTextureDataPointer(mip, dIndex, f);
+				surfaces.push_back(PvrtcInputJobs::Surface{&images[mip][d][f],
+					reinterpret_cast<std::uint8_t*>(surfaceData)});
+			}
+		}
+	}
+
+	PvrtcInputJobs inputJobs(std::move(surfaces), firstImage.height());
+	inputJobs.run(threadCount);
+
+	if (!pvrTexture.Transcode(pixelType, PVRTLVT_UnsignedByteNorm, PVRTLCS_Linear, pvrQuality,
+			threadCount))
+	{
+		return false;
 	}
 
-	pvrTexture.Transcode(pixelType, PVRTLVT_UnsignedByteNorm, PVRTLCS_Linear, quality,
-		m_threadCount);
+	for (PVRTuint32 mip = 0; mip < mipLevels; ++mip)
+	{
+		// Size of a single surface for this mip level.
+		auto surfaceSize = static_cast<std::size_t>(
+			pvrTexture.GetTextureDataSize(static_cast<PVRTint32>(mip), false, false));
+		if (is3D)
+			surfaceSize /= images[mip].size();
+
+		for (std::size_t d = 0; d < images[mip].size(); ++d)
+		{
+			for (PVRTuint32 f = 0; f < faceCount; ++f)
+			{
+				auto dIndex = static_cast<PVRTuint32>(d);
+				auto surfaceData = reinterpret_cast<const std::uint8_t*>(is3D ?
+					pvrTexture.GetTextureDataPointer(mip, 0, f, dIndex) :
+					pvrTexture.GetTextureDataPointer(mip, dIndex, f));
+				std::uint8_t* dstData = textureData.data(mip, dIndex, f);
+				assert(surfaceSize == textureData.size(mip, dIndex, f));
+				if (!dstData || surfaceSize != textureData.size(mip, dIndex, f))
+					return false;
+
+				std::memcpy(dstData, surfaceData, surfaceSize);
+			}
+		}
+	}
 
-	auto textureData = reinterpret_cast<const std::uint8_t*>(pvrTexture.GetTextureDataPointer());
-	data().assign(textureData, textureData + pvrTexture.GetTextureDataSize());
+	return true;
 }
 
 } // namespace cuttlefish
@@ -21,28 +21,24 @@
 
 #if CUTTLEFISH_HAS_PVRTC
 
-namespace pvrtexture { class CPVRTexture; }
-
 namespace cuttlefish
 {
 
-class PvrtcConverter : public Converter
+// PVRTexLib doesn't expose individual blocks to compress, so rather than converting each image
+// separately the full set of mips, array layers, and faces are placed in a single PVRTexLib
+// texture and transcoded together. This lets PVRTexLib distribute all of the work across the
+// threads in one pass.
+class PvrtcConverter
 {
 public:
 	static const unsigned int blockDim = 4;
 
-	PvrtcConverter(const Texture& texture, const Image& image, Texture::Quality quality,
-		unsigned int threadCount);
-
-	unsigned int jobsX() const override {return 1;}
-	unsigned int jobsY() const override {return 1;}
-	void process(unsigned int x, unsigned int y, ThreadData* threadData) override;
+	static bool isFormatSupported(Texture::Format format);
 
-private:
-	Texture::Format m_format;
-	Texture::Quality m_quality;
-	unsigned int m_threadCount;
-	bool m_premultipliedAlpha;
+	// Converts all of the images to textureData, which must already be laid out for images. The
+	// images are left intact.
+	static bool convert(const Texture& texture, const Converter::MipImageList& images,
+		TextureArena& textureData, Texture::Quality quality, unsigned int threadCount);
 };
 
 } // namespace cuttlefish
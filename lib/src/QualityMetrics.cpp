@@ -0,0 +1,272 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "QualityMetrics.h"
+#include "JobProcessor.h"
+#include "Shared.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+const unsigned int channelCount = 4;
+const unsigned int ssimWindow = 8;
+
+// SSIM stabilization constants for a dynamic range of 1.
+const double ssimC1 = 0.01*0.01;
+const double ssimC2 = 0.03*0.03;
+
+// Rec. 709 luminance weights, scaled so they have the same total weight as the unweighted color
+// channels.
+const double perceptualWeights[channelCount] = {0.2126*3.0, 0.7152*3.0, 0.0722*3.0, 1.0};
+
+struct RowMetrics
+{
+	double squaredError[channelCount];
+	double ssim[channelCount];
+	float maxValue[channelCount];
+	unsigned int windows;
+};
+
+unsigned int getFormatChannels(Texture::Format format)
+{
+	switch (format)
+	{
+		case Texture::Format::BC4:
+		case Texture::Format::EAC_R11:
+			return 1;
+		case Texture::Format::BC5:
+		case Texture::Format::EAC_R11G11:
+			return 2;
+		default:
+			return Texture::hasAlpha(format) ? 4 : 3;
+	}
+}
+
+// Clamps the original values to the range that can be represented by the type, since that's the
+// best the converted data can do.
+float getSourceValue(float value, Texture::Type type)
+{
+	switch (type)
+	{
+		case Texture::Type::UNorm:
+			return clamp(value, 0.0f, 1.0f);
+		case Texture::Type::SNorm:
+			return clamp(value, -1.0f, 1.0f);
+		case Texture::Type::UFloat:
+			return std::max(value, 0.0f);
+		default:
+			return value;
+	}
+}
+
+// Computes the metrics for each row of SSIM windows. The sums for each channel are kept in
+// separate arrays, and the inner loop covers the fixed number of channels of each pixel so it may
+// be unrolled and vectorized across channels.
+class QualityMetricsJobs : public JobProcessor
+{
+public:
+	QualityMetricsJobs(const Image& image, const Image& decodedImage, Texture::Type type,
+		const bool enabled[channelCount], bool ssim)
+		: m_image(image), m_decodedImage(decodedImage), m_type(type), m_ssim(ssim),
+		m_rows((image.height() + ssimWindow - 1)/ssimWindow)
+	{
+		for (unsigned int c = 0; c < channelCount; ++c)
+			m_enabled[c] = enabled[c];
+	}
+
+	const std::vector<RowMetrics>& rows() const {return m_rows;}
+
+	unsigned int jobsX() const override {return 1;}
+	unsigned int jobsY() const override {return static_cast<unsigned int>(m_rows.size());}
+
+	void process(unsigned int, unsigned int y, ThreadData*) override
+	{
+		RowMetrics& row = m_rows[y];
+		for (unsigned int c = 0; c < channelCount; ++c)
+		{
+			row.squaredError[c] = 0.0;
+			row.ssim[c] = 0.0;
+			row.maxValue[c] = 0.0f;
+		}
+		row.windows = 0;
+
+		unsigned int width = m_image.width();
+		unsigned int startY = y*ssimWindow;
+		unsigned int endY = std::min(startY + ssimWindow, m_image.height());
+		for (unsigned int startX = 0; startX < width; startX += ssimWindow)
+		{
+			unsigned int endX = std::min(startX + ssimWindow, width);
+			double sum[channelCount] = {}, decodedSum[channelCount] = {};
+			double squaredSum[channelCount] = {}, decodedSquaredSum[channelCount] = {};
+			double productSum[channelCount] = {};
+			for (unsigned int j = startY; j < endY; ++j)
+			{
+				auto scanline = reinterpret_cast<const float*>(m_image.scanline(j));
+				auto decodedScanline = reinterpret_cast<const float*>(m_decodedImage.scanline(j));
+				for (unsigned int x = startX; x < endX; ++x)
+				{
+					const float* pixel = scanline + x*channelCount;
+					const float* decodedPixel = decodedScanline + x*channelCount;
+					for (unsigned int c = 0; c < channelCount; ++c)
+					{
+						double value = getSourceValue(pixel[c], m_type);
+						double decodedValue = decodedPixel[c];
+						double diff = value - decodedValue;
+						row.squaredError[c] += diff*diff;
+						row.maxValue[c] = std::max(row.maxValue[c],
+							static_cast<float>(std::abs(value)));
+
+						sum[c] += value;
+						decodedSum[c] += decodedValue;
+						squaredSum[c] += value*value;
+						decodedSquaredSum[c] += decodedValue*decodedValue;
+						productSum[c] += value*decodedValue;
+					}
+				}
+			}
+
+			if (!m_ssim)
+				continue;
+
+			double invCount = 1.0/static_cast<double>((endX - startX)*(endY - startY));
+			for (unsigned int c = 0; c < channelCount; ++c)
+			{
+				if (!m_enabled[c])
+					continue;
+
+				double mean = sum[c]*invCount;
+				double decodedMean = decodedSum[c]*invCount;
+				double variance = squaredSum[c]*invCount - mean*mean;
+				double decodedVariance = decodedSquaredSum[c]*invCount - decodedMean*decodedMean;
+				double covariance = productSum[c]*invCount - mean*decodedMean;
+				row.ssim[c] += ((2.0*mean*decodedMean + ssimC1)*(2.0*covariance + ssimC2))/
+					((mean*mean + decodedMean*decodedMean + ssimC1)*
+						(variance + decodedVariance + ssimC2));
+			}
+			++row.windows;
+		}
+	}
+
+private:
+	const Image& m_image;
+	const Image& m_decodedImage;
+	Texture::Type m_type;
+	bool m_enabled[channelCount];
+	bool m_ssim;
+	std::vector<RowMetrics> m_rows;
+};
+
+double getPsnr(double meanSquaredError, double peak)
+{
+	if (meanSquaredError <= 0.0)
+		return std::numeric_limits<double>::infinity();
+	return 10.0*std::log10(peak*peak/meanSquaredError);
+}
+
+} // namespace
+
+bool computeQualityMetrics(Texture::QualityMetrics& outMetrics, const Texture& texture,
+	const Image& image, const Image& decodedImage, unsigned int threadCount)
+{
+	if (!image.isValid() || !decodedImage.isValid() ||
+		image.format() != Image::Format::RGBAF || decodedImage.format() != Image::Format::RGBAF ||
+		image.width() != decodedImage.width() || image.height() != decodedImage.height())
+	{
+		return false;
+	}
+
+	Texture::ColorMask colorMask = texture.colorMask();
+	unsigned int formatChannels = getFormatChannels(texture.format());
+	bool enabled[channelCount] =
+	{
+		colorMask.r, colorMask.g && formatChannels >= 2, colorMask.b && formatChannels >= 3,
+		colorMask.a && formatChannels == 4 && texture.alphaType() != Texture::Alpha::None
+	};
+
+	bool ssim = texture.qualityMetricsSsimEnabled();
+	QualityMetricsJobs jobs(image, decodedImage, texture.type(), enabled, ssim);
+	jobs.run(threadCount);
+
+	double squaredError[channelCount] = {}, ssimSum[channelCount] = {};
+	float maxValue[channelCount] = {};
+	unsigned int windows = 0;
+	for (const RowMetrics& row : jobs.rows())
+	{
+		for (unsigned int c = 0; c < channelCount; ++c)
+		{
+			squaredError[c] += row.squaredError[c];
+			ssimSum[c] += row.ssim[c];
+			maxValue[c] = std::max(maxValue[c], row.maxValue[c]);
+		}
+		windows += row.windows;
+	}
+
+	// The peak for normalized types is the span of the value range, which is 2 for SNorm.
+	double normalizedPeak = 0.0;
+	if (texture.type() == Texture::Type::UNorm)
+		normalizedPeak = 1.0;
+	else if (texture.type() == Texture::Type::SNorm)
+		normalizedPeak = 2.0;
+	bool perceptual = texture.colorSpace() == ColorSpace::sRGB;
+	double pixelCount = static_cast<double>(image.width())*image.height();
+	double rmse[channelCount], psnr[channelCount];
+	double weightedError = 0.0, weightedSsim = 0.0, totalWeight = 0.0, combinedPeak = 1.0;
+	for (unsigned int c = 0; c < channelCount; ++c)
+	{
+		if (!enabled[c])
+		{
+			rmse[c] = 0.0;
+			psnr[c] = std::numeric_limits<double>::infinity();
+			continue;
+		}
+
+		double meanSquaredError = squaredError[c]/pixelCount;
+		double peak = normalizedPeak > 0.0 ? normalizedPeak :
+			std::max(static_cast<double>(maxValue[c]), 1.0);
+		rmse[c] = std::sqrt(meanSquaredError);
+		psnr[c] = getPsnr(meanSquaredError, peak);
+
+		double weight = perceptual ? perceptualWeights[c] : 1.0;
+		weightedError += meanSquaredError*weight;
+		if (windows > 0)
+			weightedSsim += ssimSum[c]/windows*weight;
+		totalWeight += weight;
+		combinedPeak = std::max(combinedPeak, peak);
+	}
+
+	outMetrics.rmse = ColorRGBAd(rmse[0], rmse[1], rmse[2], rmse[3]);
+	outMetrics.psnr = ColorRGBAd(psnr[0], psnr[1], psnr[2], psnr[3]);
+	if (totalWeight > 0.0)
+	{
+		weightedError /= totalWeight;
+		weightedSsim /= totalWeight;
+	}
+	else
+		weightedSsim = 1.0;
+	outMetrics.combinedRmse = std::sqrt(weightedError);
+	outMetrics.combinedPsnr = getPsnr(weightedError, combinedPeak);
+	outMetrics.ssim = ssim ? weightedSsim : -1.0;
+	return true;
+}
+
+} // namespace cuttlefish
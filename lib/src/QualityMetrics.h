@@ -0,0 +1,44 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Export.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+
+namespace cuttlefish
+{
+
+/**
+ * @brief Computes the quality metrics for a converted image.
+ *
+ * This is exported for unit tests.
+ *
+ * @param[out] outMetrics The quality metrics.
+ * @param texture The texture that was converted. The format, type, alpha type, color mask, and
+ *     color space are used from the texture.
+ * @param image The original image.
+ * @param decodedImage The image decoded from the converted data.
+ * @param threadCount The number of threads to use.
+ * @return False if the images are invalid or don't match in size.
+ */
+CUTTLEFISH_EXPORT bool computeQualityMetrics(Texture::QualityMetrics& outMetrics,
+	const Texture& texture, const Image& image, const Image& decodedImage,
+	unsigned int threadCount);
+
+} // namespace cuttlefish
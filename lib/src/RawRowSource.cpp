@@ -0,0 +1,93 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cuttlefish/Texture.h>
+#include <FreeImage.h>
+#include <fstream>
+#include <utility>
+
+namespace cuttlefish
+{
+
+struct Texture::RawRowSource::Impl
+{
+	std::ifstream stream;
+	Image::Format format;
+	unsigned int width;
+	ColorSpace colorSpace;
+};
+
+Texture::RawRowSource::RawRowSource(const char* fileName, Image::Format format,
+	unsigned int width, ColorSpace colorSpace, std::uint64_t offset)
+	: m_impl(new Impl)
+{
+	m_impl->format = format;
+	m_impl->width = width;
+	m_impl->colorSpace = colorSpace;
+	if (!fileName)
+		return;
+
+	m_impl->stream.open(fileName, std::ifstream::binary);
+	if (m_impl->stream.is_open() && offset > 0)
+		m_impl->stream.seekg(static_cast<std::streamoff>(offset));
+}
+
+Texture::RawRowSource::~RawRowSource()
+{
+}
+
+bool Texture::RawRowSource::isOpen() const
+{
+	return m_impl->stream.is_open() && m_impl->stream.good();
+}
+
+bool Texture::RawRowSource::read(Image& outImage, unsigned int rowCount)
+{
+	if (!isOpen() || !outImage.initialize(m_impl->format, m_impl->width, rowCount,
+			m_impl->colorSpace))
+	{
+		return false;
+	}
+
+	unsigned int bitsPerPixel = outImage.bitsPerPixel();
+	if (bitsPerPixel % 8 != 0)
+		return false;
+
+	std::size_t rowSize = m_impl->width*(bitsPerPixel/8);
+	for (unsigned int y = 0; y < rowCount; ++y)
+	{
+		auto scanline = reinterpret_cast<std::uint8_t*>(outImage.scanline(y));
+		if (!m_impl->stream.read(reinterpret_cast<char*>(scanline),
+				static_cast<std::streamsize>(rowSize)))
+		{
+			return false;
+		}
+
+#if FREEIMAGE_COLORORDER == FREEIMAGE_COLORORDER_BGR
+		// The raw file is always in RGB order, while FreeImage may store 8-bit colors as BGR.
+		if (m_impl->format == Image::Format::RGB8 || m_impl->format == Image::Format::RGBA8)
+		{
+			unsigned int pixelSize = bitsPerPixel/8;
+			for (std::size_t i = 0; i < rowSize; i += pixelSize)
+				std::swap(scanline[i], scanline[i + 2]);
+		}
+#endif
+	}
+
+	return true;
+}
+
+} // namespace cuttlefish
@@ -18,11 +18,17 @@
 
 #include "S3tcConverter.h"
 
+#include "BlockCache.h"
+#include "BlockDecoder.h"
+#include "ConstantBlock.h"
+#include "EncoderStateCache.h"
 #include "HalfFloat.h"
+#include "PreviewEncoder.h"
 #include "Shared.h"
 #include <cuttlefish/Color.h>
 
 #include <cassert>
+#include <cstring>
 
 #if CUTTLEFISH_CLANG || CUTTLEFISH_GCC
 #pragma GCC diagnostic push
@@ -63,24 +69,105 @@ static void initializeRgbcx()
 	CUTTLEFISH_UNUSED(initialized);
 }
 
+// Preview quality uses the lowest level for any encoder that doesn't have a dedicated preview path.
+static uint32_t getQualityIndex(Texture::Quality quality)
+{
+	if (quality == Texture::Quality::Preview)
+		return 0;
+	return static_cast<uint32_t>(quality) - static_cast<uint32_t>(Texture::Quality::Lowest);
+}
+
 static uint32_t getRgbcxQualityLevel(Texture::Quality quality)
 {
-	auto qualityCount = static_cast<uint32_t>(Texture::Quality::Highest);
-	auto qualityValue = static_cast<uint32_t>(quality);
+	uint32_t qualityCount = getQualityIndex(Texture::Quality::Highest);
+	uint32_t qualityValue = getQualityIndex(quality);
 	return rgbcx::MIN_LEVEL + (rgbcx::MAX_LEVEL - rgbcx::MIN_LEVEL)*qualityValue/qualityCount;
 }
 
 static float getCompressonatorQualityLevel(Texture::Quality quality)
 {
-	auto qualityCount = static_cast<float>(Texture::Quality::Highest);
-	auto qualityValue = static_cast<float>(quality);
+	auto qualityCount = static_cast<float>(getQualityIndex(Texture::Quality::Highest));
+	auto qualityValue = static_cast<float>(getQualityIndex(quality));
 	return qualityValue/qualityCount;
 }
 
+// Compressonator options are kept in the encoder state cache to avoid re-creating them for every
+// image.
+class CompressonatorOptions : public EncoderStateCache::State
+{
+public:
+	CompressonatorOptions(Texture::Format _format, Texture::Quality quality, bool keepSign)
+		: format(_format), options(nullptr)
+	{
+		float qualityLevel = getCompressonatorQualityLevel(quality);
+		switch (format)
+		{
+			case Texture::Format::BC4:
+				CreateOptionsBC4(&options);
+				assert(options);
+				SetQualityBC4(options, qualityLevel);
+				break;
+			case Texture::Format::BC5:
+				CreateOptionsBC5(&options);
+				assert(options);
+				SetQualityBC5(options, qualityLevel);
+				break;
+			case Texture::Format::BC6H:
+				CreateOptionsBC6(&options);
+				assert(options);
+				SetQualityBC6(options, qualityLevel);
+				SetSignedBC6(options, keepSign);
+				break;
+			default:
+				assert(false);
+				break;
+		}
+	}
+
+	~CompressonatorOptions()
+	{
+		if (!options)
+			return;
+
+		switch (format)
+		{
+			case Texture::Format::BC4:
+				DestroyOptionsBC4(options);
+				break;
+			case Texture::Format::BC5:
+				DestroyOptionsBC5(options);
+				break;
+			case Texture::Format::BC6H:
+				DestroyOptionsBC6(options);
+				break;
+			default:
+				assert(false);
+				break;
+		}
+	}
+
+	Texture::Format format;
+	void* options;
+};
+
+static void* getCompressonatorOptions(EncoderStateCache::Handle<CompressonatorOptions>& outHandle,
+	const Texture& texture, Texture::Quality quality, bool keepSign)
+{
+	EncoderStateCache::Key key(EncoderStateCache::Kind::CompressonatorOptions, texture.format(),
+		texture.type(), quality, keepSign);
+	outHandle = EncoderStateCache::get<CompressonatorOptions>(std::move(key),
+		[&texture, quality, keepSign]()
+		{
+			return new CompressonatorOptions(texture.format(), quality, keepSign);
+		});
+	return outHandle->options;
+}
+
 static uint32_t getSearchRadius(Texture::Quality quality)
 {
 	switch (quality)
 	{
+		case Texture::Quality::Preview:
 		case Texture::Quality::Lowest:
 		case Texture::Quality::Low:
 			return 3;
@@ -94,6 +181,67 @@ static uint32_t getSearchRadius(Texture::Quality quality)
 	return 0;
 }
 
+static int getSquishFlags(int format, Texture::Quality quality)
+{
+	int flags = format;
+	if (Texture::qualityRank(quality) <= Texture::qualityRank(Texture::Quality::Low))
+		flags |= squish::kColourRangeFit;
+	else if (quality == Texture::Quality::Highest)
+		flags |= squish::kColourIterativeClusterFit;
+	return flags;
+}
+
+static void getSquishWeights(float outWeights[3], const S3tcConverter& converter)
+{
+	bool srgb = converter.colorSpace() == ColorSpace::sRGB;
+	outWeights[0] = converter.colorMask().r ? (srgb ? 0.2126f : 1.0f) : 0.0f;
+	outWeights[1] = converter.colorMask().g ? (srgb ? 0.7152f : 1.0f) : 0.0f;
+	outWeights[2] = converter.colorMask().b ? (srgb ? 0.0722f : 1.0f) : 0.0f;
+}
+
+#if CUTTLEFISH_ISPC
+// Compresses a single block with ispc_texcomp, with pixelSize bytes for each pixel.
+static void compressIspcTexcompBlock(void (*compress)(const rgba_surface*, std::uint8_t*),
+	void* block, void* pixels, unsigned int pixelSize)
+{
+	rgba_surface surface = {reinterpret_cast<std::uint8_t*>(pixels), blockDim, blockDim,
+		static_cast<std::int32_t>(pixelSize*blockDim)};
+	compress(&surface, reinterpret_cast<std::uint8_t*>(block));
+}
+#endif
+
+static Texture::Encoder getEncoder(const Texture& texture)
+{
+	Texture::Encoder encoder = texture.encoder(texture.format());
+	if (encoder != Texture::Encoder::Default)
+		return encoder;
+
+	switch (texture.format())
+	{
+		case Texture::Format::BC1_RGB:
+		case Texture::Format::BC2:
+		case Texture::Format::BC3:
+			return Texture::Encoder::Rgbcx;
+		case Texture::Format::BC4:
+		case Texture::Format::BC5:
+			// rgbcx doesn't support signed BC4 and BC5.
+			if (texture.type() == Texture::Type::SNorm)
+				return Texture::Encoder::Compressonator;
+			return Texture::Encoder::Rgbcx;
+		case Texture::Format::BC6H:
+#if CUTTLEFISH_ISPC
+			// NOTE: ispc_texcomp only supports unsigned BC6H.
+			if (texture.type() == Texture::Type::UFloat)
+				return Texture::Encoder::IspcTexcomp;
+#endif
+			return Texture::Encoder::Compressonator;
+		case Texture::Format::BC7:
+			return Texture::Encoder::Bc7enc;
+		default:
+			return Texture::Encoder::Default;
+	}
+}
+
 static void toColorBlock(std::uint8_t outBlock[blockPixels][4],
 	const ColorRGBAf* blockColors)
 {
@@ -110,6 +258,19 @@ static void toColorBlock(std::uint8_t outBlock[blockPixels][4],
 	}
 }
 
+static void fromColorBlock(ColorRGBAf* outColors,
+	const std::uint8_t colorBlock[blockPixels][4])
+{
+	const float scale = 1.0f/255.0f;
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		outColors[i].r = static_cast<float>(colorBlock[i][0])*scale;
+		outColors[i].g = static_cast<float>(colorBlock[i][1])*scale;
+		outColors[i].b = static_cast<float>(colorBlock[i][2])*scale;
+		outColors[i].a = static_cast<float>(colorBlock[i][3])*scale;
+	}
+}
+
 CUTTLEFISH_START_HALF_FLOAT()
 #if CUTTLEFISH_ISPC
 static void packHalfFloatBlockHardware(std::uint16_t colorBlock[blockPixels][4],
@@ -128,6 +289,24 @@ static void packHalfFloatBlockHardware(std::uint16_t colorBlock[blockPixels][3],
 }
 CUTTLEFISH_END_HALF_FLOAT()
 
+static void packHalfFloatBlock(std::uint16_t colorBlock[blockPixels][3],
+	ColorRGBAf* blockColors)
+{
+	if (hasHardwareHalfFloat)
+		packHalfFloatBlockHardware(colorBlock, blockColors);
+	else
+	{
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			for (unsigned int j = 0; j < 3; ++j)
+			{
+				colorBlock[i][j] =
+					glm::packHalf(glm::vec1(reinterpret_cast<float*>(blockColors + i)[j])).x;
+			}
+		}
+	}
+}
+
 static void packBc2Alpha(std::uint8_t outAlpha[8], std::uint8_t colorBlock[16][4])
 {
 	const float alphaScale = 15.0f/255.0f;
@@ -167,13 +346,15 @@ static void initializeBc7enc()
 	CUTTLEFISH_UNUSED(initialized);
 }
 
-static bc7enc_compress_block_params createBc7BlockParams(const S3tcConverter& converter)
+static bc7enc_compress_block_params createBc7BlockParams(const S3tcConverter& converter,
+	Texture::Quality quality)
 {
 	bc7enc_compress_block_params params;
 
 	bc7enc_compress_block_params_init(&params);
-	switch (converter.quality())
+	switch (quality)
 	{
+		case Texture::Quality::Preview:
 		case Texture::Quality::Lowest:
 			params.m_max_partitions = 0;
 			params.m_uber_level = 0;
@@ -227,21 +408,142 @@ static bc7enc_compress_block_params createBc7BlockParams(const S3tcConverter& co
 }
 #endif
 
+static std::unique_ptr<S3tcConverter> createS3tcConverter(const Texture& texture,
+	const Image& image, Texture::Quality quality)
+{
+	switch (texture.format())
+	{
+		case Texture::Format::BC1_RGB:
+		{
+			if (texture.type() == Texture::Type::UNorm)
+				return std::unique_ptr<S3tcConverter>(new Bc1Converter(texture, image, quality));
+			return nullptr;
+		}
+		case Texture::Format::BC1_RGBA:
+		{
+			if (texture.type() == Texture::Type::UNorm)
+				return std::unique_ptr<S3tcConverter>(new Bc1AConverter(texture, image, quality));
+			return nullptr;
+		}
+		case Texture::Format::BC2:
+		{
+			if (texture.type() == Texture::Type::UNorm)
+				return std::unique_ptr<S3tcConverter>(new Bc2Converter(texture, image, quality));
+			return nullptr;
+		}
+		case Texture::Format::BC3:
+		{
+			if (texture.type() == Texture::Type::UNorm)
+				return std::unique_ptr<S3tcConverter>(new Bc3Converter(texture, image, quality));
+			return nullptr;
+		}
+		case Texture::Format::BC4:
+		{
+			switch (texture.type())
+			{
+				case Texture::Type::UNorm:
+					return std::unique_ptr<S3tcConverter>(new Bc4Converter(texture, image, quality,
+						false));
+				case Texture::Type::SNorm:
+					return std::unique_ptr<S3tcConverter>(new Bc4Converter(texture, image, quality,
+						true));
+				default:
+					return nullptr;
+			}
+		}
+		case Texture::Format::BC5:
+		{
+			switch (texture.type())
+			{
+				case Texture::Type::UNorm:
+					return std::unique_ptr<S3tcConverter>(new Bc5Converter(texture, image, quality,
+						false));
+				case Texture::Type::SNorm:
+					return std::unique_ptr<S3tcConverter>(new Bc5Converter(texture, image, quality,
+						true));
+				default:
+					return nullptr;
+			}
+		}
+		case Texture::Format::BC6H:
+		{
+			switch (texture.type())
+			{
+				case Texture::Type::UFloat:
+					return std::unique_ptr<S3tcConverter>(new Bc6HConverter(texture, image,
+						quality, false));
+				case Texture::Type::Float:
+					return std::unique_ptr<S3tcConverter>(new Bc6HConverter(texture, image,
+						quality, true));
+				default:
+					return nullptr;
+			}
+		}
+		case Texture::Format::BC7:
+		{
+			if (texture.type() == Texture::Type::UNorm)
+				return std::unique_ptr<S3tcConverter>(new Bc7Converter(texture, image, quality));
+			return nullptr;
+		}
+		default:
+			return nullptr;
+	}
+}
+
+std::unique_ptr<S3tcConverter> S3tcConverter::create(const Texture& texture, const Image& image,
+	Texture::Quality quality)
+{
+	std::unique_ptr<S3tcConverter> converter = createS3tcConverter(texture, image, quality);
+	if (!converter || !useAdaptiveQuality(texture, quality))
+		return converter;
+
+	converter->m_fastConverter = createS3tcConverter(texture, image,
+		texture.adaptiveFastQuality());
+	converter->m_errorThreshold = getAdaptiveErrorThreshold(texture);
+
+	// The fast converter only encodes individual blocks, so its output is never set.
+	return converter;
+}
+
 S3tcConverter::S3tcConverter(const Texture& texture, const Image& image, unsigned int blockSize,
 	Texture::Quality quality)
-	: Converter(image), m_blockSize(blockSize),
+	: Converter(image), m_errorThreshold(0.0f),
+	m_minValue(texture.type() == Texture::Type::SNorm ? -1.0f : 0.0f), m_blockSize(blockSize),
 	m_jobsX((image.width() + blockDim - 1)/blockDim),
 	m_jobsY((image.height() + blockDim - 1)/blockDim), m_colorSpace(image.colorSpace()),
-	m_quality(quality), m_colorMask(texture.colorMask()),
+	m_quality(quality), m_encoder(getEncoder(texture)),
+	m_usePreviewEncoder(quality == Texture::Quality::Preview &&
+		texture.encoder(texture.format()) == Texture::Encoder::Default),
+	m_colorMask(texture.colorMask()), m_uniformMask(texture.colorMask()),
 	m_weightAlpha(texture.alphaType() == Texture::Alpha::Standard ||
 		texture.alphaType() == Texture::Alpha::PreMultiplied)
 {
-	data().resize(m_jobsX*m_jobsY*m_blockSize);
+	// Only consider the channels stored in the format when checking for uniform blocks.
+	switch (texture.format())
+	{
+		case Texture::Format::BC4:
+			m_uniformMask.g = false;
+			m_uniformMask.b = false;
+			m_uniformMask.a = false;
+			break;
+		case Texture::Format::BC5:
+			m_uniformMask.b = false;
+			m_uniformMask.a = false;
+			break;
+		case Texture::Format::BC1_RGB:
+		case Texture::Format::BC6H:
+			m_uniformMask.a = false;
+			break;
+		default:
+			break;
+	}
+	setDataSize(m_jobsX*m_jobsY*m_blockSize);
 }
 
 void S3tcConverter::process(unsigned int x, unsigned int y, ThreadData*)
 {
-	void* block = data().data() + (y*m_jobsX + x)*m_blockSize;
+	unsigned int blockIndex = y*m_jobsX + x;
+	void* block = data() + blockIndex*m_blockSize;
 	ColorRGBAf blockColors[blockDim][blockDim];
 	for (unsigned int j = 0; j < blockDim; ++j)
 	{
@@ -251,11 +553,65 @@ void S3tcConverter::process(unsigned int x, unsigned int y, ThreadData*)
 			blockColors[j][i] = scanline[std::min(x*blockDim + i, image().width() - 1)];
 	}
 
-	compressBlock(block, reinterpret_cast<ColorRGBAf*>(blockColors));
+	// Partial blocks are padded with the edge pixels, so the padded block fully determines the
+	// result. Compute the key before compressing since the compressors may modify the colors.
+	bool useKey = needsBlockKeys();
+	BlockCache::Key key = {};
+	if (useKey)
+	{
+		key = BlockCache::computeKey(blockColors, sizeof(blockColors));
+		if (findBlock(block, blockIndex, key, m_blockSize))
+			return;
+	}
+
+	auto colors = reinterpret_cast<ColorRGBAf*>(blockColors);
+	if (getBlockRange(colors, blockPixels, m_uniformMask) <= nearConstantBlockThreshold)
+		compressUniformBlock(block, colors);
+	else if (m_fastConverter)
+	{
+		// Keep the original colors to measure the error and for encoding again.
+		ColorRGBAf fastColors[blockPixels];
+		std::memcpy(fastColors, colors, sizeof(fastColors));
+		m_fastConverter->compressBlock(block, fastColors);
+		if (blockError(block, colors) > m_errorThreshold)
+		{
+			compressBlock(block, colors);
+			addRefinedBlock();
+		}
+	}
+	else
+		compressBlock(block, colors);
+
+	if (useKey)
+		addBlock(block, key, m_blockSize);
+}
+
+void S3tcConverter::compressUniformBlock(void* block, ColorRGBAf* blockColors)
+{
+	compressBlock(block, blockColors);
+}
+
+float S3tcConverter::blockError(const void* block, const ColorRGBAf* blockColors) const
+{
+	// Compare against the range that can be represented by the format.
+	ColorRGBAf colors[blockPixels];
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		colors[i].r = clamp(blockColors[i].r, m_minValue, 1.0f);
+		colors[i].g = clamp(blockColors[i].g, m_minValue, 1.0f);
+		colors[i].b = clamp(blockColors[i].b, m_minValue, 1.0f);
+		colors[i].a = clamp(blockColors[i].a, m_minValue, 1.0f);
+	}
+
+	ColorRGBAf decodedColors[blockPixels];
+	decodeBlock(decodedColors, block);
+	return getBlockError(colors, decodedColors, blockPixels, m_uniformMask);
 }
 
 Bc1Converter::Bc1Converter(const Texture& texture, const Image& image, Texture::Quality quality)
-	: S3tcConverter(texture, image, 8, quality), m_qualityLevel(getRgbcxQualityLevel(quality))
+	: S3tcConverter(texture, image, 8, quality),
+	m_squishFlags(getSquishFlags(squish::kDxt1, quality)),
+	m_qualityLevel(getRgbcxQualityLevel(quality))
 {
 	initializeRgbcx();
 }
@@ -264,19 +620,64 @@ void Bc1Converter::compressBlock(void* block, ColorRGBAf* blockColors)
 {
 	std::uint8_t colorBlock[blockPixels][4];
 	toColorBlock(colorBlock, blockColors);
-	// Fully utilize 3-color mode since alpha channel will be ignored.
-	rgbcx::encode_bc1(m_qualityLevel, block, reinterpret_cast<std::uint8_t*>(colorBlock), true,
-		true, nullptr);
+	if (usePreviewEncoder())
+	{
+		encodeBc1Preview(block, colorBlock);
+		return;
+	}
+
+	switch (encoder())
+	{
+		case Texture::Encoder::Squish:
+		{
+			// Alpha is ignored, so avoid squish using transparent pixels.
+			for (unsigned int i = 0; i < blockPixels; ++i)
+				colorBlock[i][3] = 0xFF;
+
+			float weights[3];
+			getSquishWeights(weights, *this);
+			squish::Compress(reinterpret_cast<std::uint8_t*>(colorBlock), block, m_squishFlags,
+				weights);
+			break;
+		}
+#if CUTTLEFISH_ISPC
+		case Texture::Encoder::IspcTexcomp:
+			compressIspcTexcompBlock(&CompressBlocksBC1, block, colorBlock, 4);
+			break;
+#endif
+		default:
+			// Fully utilize 3-color mode since alpha channel will be ignored.
+			rgbcx::encode_bc1(m_qualityLevel, block, reinterpret_cast<std::uint8_t*>(colorBlock),
+				true, true, nullptr);
+			break;
+	}
+}
+
+void Bc1Converter::compressUniformBlock(void* block, ColorRGBAf* blockColors)
+{
+	std::uint8_t colorBlock[blockPixels][4];
+	toColorBlock(colorBlock, blockColors);
+	if (isBlockConstant(colorBlock[0], blockPixels, 4, 3))
+		encodeConstantBc1(block, colorBlock[0]);
+	else
+	{
+		rgbcx::encode_bc1(rgbcx::MIN_LEVEL, block, reinterpret_cast<std::uint8_t*>(colorBlock),
+			true, true, nullptr);
+	}
+}
+
+void Bc1Converter::decodeBlock(ColorRGBAf* outColors, const void* block) const
+{
+	std::uint8_t colorBlock[blockPixels][4];
+	decodeBc1(colorBlock, block, true);
+	fromColorBlock(outColors, colorBlock);
 }
 
 Bc1AConverter::Bc1AConverter(const Texture& texture, const Image& image, Texture::Quality quality)
-	: S3tcConverter(texture, image, 8, quality), m_squishFlags(squish::kDxt1),
+	: S3tcConverter(texture, image, 8, quality),
+	m_squishFlags(getSquishFlags(squish::kDxt1, quality)),
 	m_qualityLevel(getRgbcxQualityLevel(quality))
 {
-	if (quality <= Texture::Quality::Low)
-		m_squishFlags |= squish::kColourRangeFit;
-	else if (quality == Texture::Quality::Highest)
-		m_squishFlags |= squish::kColourIterativeClusterFit;
 	initializeRgbcx();
 }
 
@@ -291,40 +692,11 @@ void Bc1AConverter::compressBlock(void* block, ColorRGBAf* blockColors)
 
 	std::uint8_t colorBlock[blockPixels][4];
 	toColorBlock(colorBlock, blockColors);
-	if (hasAlpha)
+	// The default uses squish only for blocks with transparent pixels since rgbcx is faster.
+	if (hasAlpha || encoder() == Texture::Encoder::Squish)
 	{
 		float weights[3];
-		bool srgb = colorSpace() == ColorSpace::sRGB;
-		if (colorMask().r)
-		{
-			if (srgb)
-				weights[0] = 0.2126f;
-			else
-				weights[0] = 1.0f;
-		}
-		else
-			weights[0] = 0.0f;
-
-		if (colorMask().g)
-		{
-			if (srgb)
-				weights[1] = 0.7152f;
-			else
-				weights[1] = 1.0f;
-		}
-		else
-			weights[1] = 0.0f;
-
-		if (colorMask().b)
-		{
-			if (srgb)
-				weights[2] = 0.0722f;
-			else
-				weights[2] = 1.0f;
-		}
-		else
-			weights[2] = 0.0f;
-
+		getSquishWeights(weights, *this);
 		squish::Compress(
 			reinterpret_cast<std::uint8_t*>(colorBlock), block, m_squishFlags, weights);
 	}
@@ -337,8 +709,62 @@ void Bc1AConverter::compressBlock(void* block, ColorRGBAf* blockColors)
 	}
 }
 
+void Bc1AConverter::compressUniformBlock(void* block, ColorRGBAf* blockColors)
+{
+	unsigned int transparentCount = 0;
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		if (blockColors[i].a < 0.5f)
+			++transparentCount;
+	}
+
+	if (transparentCount == blockPixels)
+	{
+		encodeTransparentBc1(block);
+		return;
+	}
+	else if (transparentCount > 0)
+	{
+		// Alpha straddles the cutoff, so the colors need to be chosen carefully.
+		compressBlock(block, blockColors);
+		return;
+	}
+
+	std::uint8_t colorBlock[blockPixels][4];
+	toColorBlock(colorBlock, blockColors);
+	if (isBlockConstant(colorBlock[0], blockPixels, 4, 3))
+		encodeConstantBc1(block, colorBlock[0]);
+	else
+	{
+		rgbcx::encode_bc1(rgbcx::MIN_LEVEL, block, reinterpret_cast<std::uint8_t*>(colorBlock),
+			true, false, nullptr);
+	}
+}
+
+void Bc1AConverter::decodeBlock(ColorRGBAf* outColors, const void* block) const
+{
+	std::uint8_t colorBlock[blockPixels][4];
+	decodeBc1(colorBlock, block, true);
+	fromColorBlock(outColors, colorBlock);
+}
+
+float Bc1AConverter::blockError(const void* block, const ColorRGBAf* blockColors) const
+{
+	// Alpha can only be fully opaque or transparent, so compare against the alpha cutoff.
+	ColorRGBAf colors[blockPixels];
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		colors[i] = blockColors[i];
+		colors[i].a = blockColors[i].a < 0.5f ? 0.0f : 1.0f;
+	}
+
+	return S3tcConverter::blockError(block, colors);
+}
+
 Bc2Converter::Bc2Converter(const Texture& texture, const Image& image, Texture::Quality quality)
-	: S3tcConverter(texture, image, 16, quality), m_qualityLevel(getRgbcxQualityLevel(quality))
+	: S3tcConverter(texture, image, 16, quality),
+	m_squishFlags(getSquishFlags(squish::kDxt3, quality)),
+	m_qualityLevel(getRgbcxQualityLevel(quality))
 {
 	initializeRgbcx();
 }
@@ -347,17 +773,56 @@ void Bc2Converter::compressBlock(void* block, ColorRGBAf* blockColors)
 {
 	std::uint8_t colorBlock[16][4];
 	toColorBlock(colorBlock, blockColors);
+	if (encoder() == Texture::Encoder::Squish)
+	{
+		float weights[3];
+		getSquishWeights(weights, *this);
+		squish::Compress(reinterpret_cast<std::uint8_t*>(colorBlock), block, m_squishFlags,
+			weights);
+		return;
+	}
+
 	auto compressedAlphaBlock = reinterpret_cast<std::uint8_t*>(block);
 	std::uint8_t* compressedColorBlock = compressedAlphaBlock + 8;
 	packBc2Alpha(compressedAlphaBlock, colorBlock);
+	if (usePreviewEncoder())
+	{
+		encodeBc1Preview(compressedColorBlock, colorBlock);
+		return;
+	}
+
 	// NOTE: BC2 only supports 4 color mode, so disable all 3 color mode options.
 	rgbcx::encode_bc1(m_qualityLevel, compressedColorBlock,
 		reinterpret_cast<std::uint8_t*>(colorBlock), false, false, nullptr);
 }
 
+void Bc2Converter::compressUniformBlock(void* block, ColorRGBAf* blockColors)
+{
+	std::uint8_t colorBlock[16][4];
+	toColorBlock(colorBlock, blockColors);
+	auto compressedAlphaBlock = reinterpret_cast<std::uint8_t*>(block);
+	std::uint8_t* compressedColorBlock = compressedAlphaBlock + 8;
+	packBc2Alpha(compressedAlphaBlock, colorBlock);
+	if (isBlockConstant(colorBlock[0], blockPixels, 4, 3))
+		encodeConstantBc1(compressedColorBlock, colorBlock[0]);
+	else
+	{
+		rgbcx::encode_bc1(rgbcx::MIN_LEVEL, compressedColorBlock,
+			reinterpret_cast<std::uint8_t*>(colorBlock), false, false, nullptr);
+	}
+}
+
+void Bc2Converter::decodeBlock(ColorRGBAf* outColors, const void* block) const
+{
+	std::uint8_t colorBlock[blockPixels][4];
+	decodeBc2(colorBlock, block);
+	fromColorBlock(outColors, colorBlock);
+}
+
 Bc3Converter::Bc3Converter(const Texture& texture, const Image& image, Texture::Quality quality)
-	: S3tcConverter(texture, image, 16, quality), m_qualityLevel(getRgbcxQualityLevel(quality)),
-	m_searchRadius(getSearchRadius(quality))
+	: S3tcConverter(texture, image, 16, quality),
+	m_squishFlags(getSquishFlags(squish::kDxt5, quality)),
+	m_qualityLevel(getRgbcxQualityLevel(quality)), m_searchRadius(getSearchRadius(quality))
 {
 	initializeRgbcx();
 }
@@ -366,7 +831,20 @@ void Bc3Converter::compressBlock(void* block, ColorRGBAf* blockColors)
 {
 	std::uint8_t colorBlock[blockPixels][4];
 	toColorBlock(colorBlock, blockColors);
-	if (quality() <= Texture::Quality::Low)
+	if (usePreviewEncoder())
+		encodeBc3Preview(block, colorBlock);
+	else if (encoder() == Texture::Encoder::Squish)
+	{
+		float weights[3];
+		getSquishWeights(weights, *this);
+		squish::Compress(reinterpret_cast<std::uint8_t*>(colorBlock), block, m_squishFlags,
+			weights);
+	}
+#if CUTTLEFISH_ISPC
+	else if (encoder() == Texture::Encoder::IspcTexcomp)
+		compressIspcTexcompBlock(&CompressBlocksBC3, block, colorBlock, 4);
+#endif
+	else if (Texture::qualityRank(quality()) <= Texture::qualityRank(Texture::Quality::Low))
 		rgbcx::encode_bc3(m_qualityLevel, block, reinterpret_cast<std::uint8_t*>(colorBlock));
 	else
 	{
@@ -375,26 +853,51 @@ void Bc3Converter::compressBlock(void* block, ColorRGBAf* blockColors)
 	}
 }
 
+void Bc3Converter::compressUniformBlock(void* block, ColorRGBAf* blockColors)
+{
+	std::uint8_t colorBlock[blockPixels][4];
+	toColorBlock(colorBlock, blockColors);
+	auto compressedAlphaBlock = reinterpret_cast<std::uint8_t*>(block);
+	std::uint8_t* compressedColorBlock = compressedAlphaBlock + 8;
+	if (isBlockConstant(colorBlock[0] + 3, blockPixels, 4, 1))
+		encodeConstantBc4(compressedAlphaBlock, colorBlock[0][3]);
+	else
+		rgbcx::encode_bc4(compressedAlphaBlock, colorBlock[0] + 3, 4);
+
+	if (isBlockConstant(colorBlock[0], blockPixels, 4, 3))
+		encodeConstantBc1(compressedColorBlock, colorBlock[0]);
+	else
+	{
+		rgbcx::encode_bc1(rgbcx::MIN_LEVEL, compressedColorBlock,
+			reinterpret_cast<std::uint8_t*>(colorBlock), false, false, nullptr);
+	}
+}
+
+void Bc3Converter::decodeBlock(ColorRGBAf* outColors, const void* block) const
+{
+	std::uint8_t colorBlock[blockPixels][4];
+	decodeBc3(colorBlock, block);
+	fromColorBlock(outColors, colorBlock);
+}
+
 Bc4Converter::Bc4Converter(const Texture& texture, const Image& image, Texture::Quality quality,
 	bool keepSign)
 	: S3tcConverter(texture, image, 8, quality), m_signed(keepSign),
 	m_searchRadius(getSearchRadius(quality)), m_compressonatorOptions(nullptr)
 {
-	if (m_signed)
+	if (encoder() == Texture::Encoder::Compressonator)
 	{
-		// rgbcx doesn't support signed BC4 so use Compressonator instead.
-		CreateOptionsBC4(&m_compressonatorOptions);
-		assert(m_compressonatorOptions);
-		SetQualityBC4(m_compressonatorOptions, getCompressonatorQualityLevel(quality));
+		m_compressonatorOptions = getCompressonatorOptions(m_compressonatorState, texture, quality,
+			keepSign);
 	}
-	else
+
+	// Uniform blocks always use rgbcx when unsigned.
+	if (!m_signed)
 		initializeRgbcx();
 }
 
 Bc4Converter::~Bc4Converter()
 {
-	if (m_compressonatorOptions)
-		DestroyOptionsBC4(m_compressonatorOptions);
 }
 
 void Bc4Converter::compressBlock(void* block, ColorRGBAf* blockColors)
@@ -408,6 +911,12 @@ void Bc4Converter::compressBlock(void* block, ColorRGBAf* blockColors)
 				static_cast<std::int8_t>(std::round(clamp(blockColors[i].r, -1.0f, 1.0f)*0x7F));
 		}
 
+		if (usePreviewEncoder())
+		{
+			encodeBc4SPreview(block, reinterpret_cast<const std::int8_t*>(colorBlock), 1);
+			return;
+		}
+
 		assert(m_compressonatorOptions);
 		CompressBlockBC4S(reinterpret_cast<const char*>(colorBlock), blockDim,
 			reinterpret_cast<std::uint8_t*>(block), m_compressonatorOptions);
@@ -421,33 +930,102 @@ void Bc4Converter::compressBlock(void* block, ColorRGBAf* blockColors)
 				static_cast<std::uint8_t>(std::round(clamp(blockColors[i].r, 0.0f, 1.0f)*0xFF));
 		}
 
-		if (quality() <= Texture::Quality::Low)
+		if (usePreviewEncoder())
+			encodeBc4Preview(block, colorBlock, 1);
+		else if (encoder() == Texture::Encoder::Compressonator)
+		{
+			assert(m_compressonatorOptions);
+			CompressBlockBC4(colorBlock, blockDim, reinterpret_cast<std::uint8_t*>(block),
+				m_compressonatorOptions);
+		}
+#if CUTTLEFISH_ISPC
+		else if (encoder() == Texture::Encoder::IspcTexcomp)
+			compressIspcTexcompBlock(&CompressBlocksBC4, block, colorBlock, 1);
+#endif
+		else if (Texture::qualityRank(quality()) <= Texture::qualityRank(Texture::Quality::Low))
 			rgbcx::encode_bc4(block, colorBlock, 1);
 		else
 			rgbcx::encode_bc4_hq(block, colorBlock, 1, m_searchRadius);
 	}
 }
 
+void Bc4Converter::compressUniformBlock(void* block, ColorRGBAf* blockColors)
+{
+	if (m_signed)
+	{
+		std::int8_t colorBlock[blockPixels];
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			colorBlock[i] =
+				static_cast<std::int8_t>(std::round(clamp(blockColors[i].r, -1.0f, 1.0f)*0x7F));
+		}
+
+		if (isBlockConstant(colorBlock, blockPixels, 1, 1))
+			encodeConstantBc4S(block, colorBlock[0]);
+		else
+			compressBlock(block, blockColors);
+	}
+	else
+	{
+		std::uint8_t colorBlock[blockPixels];
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			colorBlock[i] =
+				static_cast<std::uint8_t>(std::round(clamp(blockColors[i].r, 0.0f, 1.0f)*0xFF));
+		}
+
+		if (isBlockConstant(colorBlock, blockPixels, 1, 1))
+			encodeConstantBc4(block, colorBlock[0]);
+		else
+			rgbcx::encode_bc4(block, colorBlock, 1);
+	}
+}
+
+void Bc4Converter::decodeBlock(ColorRGBAf* outColors, const void* block) const
+{
+	float values[blockPixels];
+	if (m_signed)
+	{
+		std::int8_t colorBlock[blockPixels];
+		decodeBc4S(colorBlock, block, 1);
+		for (unsigned int i = 0; i < blockPixels; ++i)
+			values[i] = static_cast<float>(colorBlock[i])/0x7F;
+	}
+	else
+	{
+		std::uint8_t colorBlock[blockPixels];
+		decodeBc4(colorBlock, block, 1);
+		for (unsigned int i = 0; i < blockPixels; ++i)
+			values[i] = static_cast<float>(colorBlock[i])/0xFF;
+	}
+
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		outColors[i].r = values[i];
+		outColors[i].g = 0.0f;
+		outColors[i].b = 0.0f;
+		outColors[i].a = 1.0f;
+	}
+}
+
 Bc5Converter::Bc5Converter(const Texture& texture, const Image& image, Texture::Quality quality,
 	bool keepSign)
 	: S3tcConverter(texture, image, 16, quality), m_signed(keepSign),
 	m_searchRadius(getSearchRadius(quality)), m_compressonatorOptions(nullptr)
 {
-	if (m_signed)
+	if (encoder() == Texture::Encoder::Compressonator)
 	{
-		// rgbcx doesn't support signed BC4 so use Compressonator instead.
-		CreateOptionsBC5(&m_compressonatorOptions);
-		assert(m_compressonatorOptions);
-		SetQualityBC5(m_compressonatorOptions, getCompressonatorQualityLevel(quality));
+		m_compressonatorOptions = getCompressonatorOptions(m_compressonatorState, texture, quality,
+			keepSign);
 	}
-	else
+
+	// Uniform blocks always use rgbcx when unsigned.
+	if (!m_signed)
 		initializeRgbcx();
 }
 
 Bc5Converter::~Bc5Converter()
 {
-	if (m_compressonatorOptions)
-		DestroyOptionsBC5(m_compressonatorOptions);
 }
 
 void Bc5Converter::compressBlock(void* block, ColorRGBAf* blockColors)
@@ -463,6 +1041,16 @@ void Bc5Converter::compressBlock(void* block, ColorRGBAf* blockColors)
 				static_cast<std::int8_t>(std::round(clamp(blockColors[i].g, -1.0f, 1.0f)*0x7F));
 		}
 
+		if (usePreviewEncoder())
+		{
+			auto compressedBlocks = reinterpret_cast<std::uint8_t*>(block);
+			encodeBc4SPreview(compressedBlocks,
+				reinterpret_cast<const std::int8_t*>(colorBlock[0]), 1);
+			encodeBc4SPreview(compressedBlocks + 8,
+				reinterpret_cast<const std::int8_t*>(colorBlock[1]), 1);
+			return;
+		}
+
 		assert(m_compressonatorOptions);
 		CompressBlockBC5S(reinterpret_cast<const char*>(&colorBlock[0]), blockDim,
 			reinterpret_cast<const char*>(&colorBlock[1]), blockDim,
@@ -479,7 +1067,23 @@ void Bc5Converter::compressBlock(void* block, ColorRGBAf* blockColors)
 				static_cast<std::uint8_t>(std::round(clamp(blockColors[i].g, 0.0f, 1.0f)*0xFF));
 		}
 
-		if (quality() <= Texture::Quality::Low)
+		if (usePreviewEncoder())
+		{
+			auto compressedBlocks = reinterpret_cast<std::uint8_t*>(block);
+			encodeBc4Preview(compressedBlocks, colorBlock[0], 2);
+			encodeBc4Preview(compressedBlocks + 8, colorBlock[0] + 1, 2);
+		}
+		else if (encoder() == Texture::Encoder::Compressonator)
+		{
+			assert(m_compressonatorOptions);
+			CompressBlockBC5(colorBlock[0], blockDim*2, colorBlock[0] + 1, blockDim*2,
+				reinterpret_cast<std::uint8_t*>(block), m_compressonatorOptions);
+		}
+#if CUTTLEFISH_ISPC
+		else if (encoder() == Texture::Encoder::IspcTexcomp)
+			compressIspcTexcompBlock(&CompressBlocksBC5, block, colorBlock, 2);
+#endif
+		else if (Texture::qualityRank(quality()) <= Texture::qualityRank(Texture::Quality::Low))
 			rgbcx::encode_bc5(block, reinterpret_cast<uint8_t*>(colorBlock), 0, 1, 2);
 		else
 		{
@@ -489,58 +1093,142 @@ void Bc5Converter::compressBlock(void* block, ColorRGBAf* blockColors)
 	}
 }
 
+void Bc5Converter::compressUniformBlock(void* block, ColorRGBAf* blockColors)
+{
+	auto compressedBlocks = reinterpret_cast<std::uint8_t*>(block);
+	if (m_signed)
+	{
+		std::int8_t colorBlock[blockPixels][2];
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			colorBlock[i][0] =
+				static_cast<std::int8_t>(std::round(clamp(blockColors[i].r, -1.0f, 1.0f)*0x7F));
+			colorBlock[i][1] =
+				static_cast<std::int8_t>(std::round(clamp(blockColors[i].g, -1.0f, 1.0f)*0x7F));
+		}
+
+		if (isBlockConstant(colorBlock[0], blockPixels, 2, 2))
+		{
+			encodeConstantBc4S(compressedBlocks, colorBlock[0][0]);
+			encodeConstantBc4S(compressedBlocks + 8, colorBlock[0][1]);
+		}
+		else
+			compressBlock(block, blockColors);
+	}
+	else
+	{
+		std::uint8_t colorBlock[blockPixels][2];
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			colorBlock[i][0] =
+				static_cast<std::uint8_t>(std::round(clamp(blockColors[i].r, 0.0f, 1.0f)*0xFF));
+			colorBlock[i][1] =
+				static_cast<std::uint8_t>(std::round(clamp(blockColors[i].g, 0.0f, 1.0f)*0xFF));
+		}
+
+		for (unsigned int c = 0; c < 2; ++c)
+		{
+			std::uint8_t* compressedBlock = compressedBlocks + c*8;
+			if (isBlockConstant(colorBlock[0] + c, blockPixels, 2, 1))
+				encodeConstantBc4(compressedBlock, colorBlock[0][c]);
+			else
+				rgbcx::encode_bc4(compressedBlock, colorBlock[0] + c, 2);
+		}
+	}
+}
+
+void Bc5Converter::decodeBlock(ColorRGBAf* outColors, const void* block) const
+{
+	auto compressedBlocks = reinterpret_cast<const std::uint8_t*>(block);
+	float values[blockPixels][2];
+	if (m_signed)
+	{
+		std::int8_t colorBlock[blockPixels][2];
+		decodeBc4S(colorBlock[0], compressedBlocks, 2);
+		decodeBc4S(colorBlock[0] + 1, compressedBlocks + 8, 2);
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			values[i][0] = static_cast<float>(colorBlock[i][0])/0x7F;
+			values[i][1] = static_cast<float>(colorBlock[i][1])/0x7F;
+		}
+	}
+	else
+	{
+		std::uint8_t colorBlock[blockPixels][2];
+		decodeBc4(colorBlock[0], compressedBlocks, 2);
+		decodeBc4(colorBlock[0] + 1, compressedBlocks + 8, 2);
+		for (unsigned int i = 0; i < blockPixels; ++i)
+		{
+			values[i][0] = static_cast<float>(colorBlock[i][0])/0xFF;
+			values[i][1] = static_cast<float>(colorBlock[i][1])/0xFF;
+		}
+	}
+
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		outColors[i].r = values[i][0];
+		outColors[i].g = values[i][1];
+		outColors[i].b = 0.0f;
+		outColors[i].a = 1.0f;
+	}
+}
+
 Bc6HConverter::Bc6HConverter(const Texture& texture, const Image& image, Texture::Quality quality,
 	bool keepSign)
-	: S3tcConverter(texture, image, 16, quality), m_compressonatorOptions(nullptr)
+	: S3tcConverter(texture, image, 16, quality), m_signed(keepSign),
+	m_compressonatorOptions(nullptr)
 {
 	bool useCompressonator = true;
 #if CUTTLEFISH_ISPC
 	m_ispcTexcompSettings = nullptr;
-	if (!keepSign)
+	if (encoder() == Texture::Encoder::IspcTexcomp)
 	{
 		// NOTE: ispc_texcomp only supports unsigned BC6H.
+		assert(!keepSign);
 		useCompressonator = false;
-		m_ispcTexcompSettings = new bc6h_enc_settings;
-		switch (quality)
-		{
-			case Texture::Quality::Lowest:
-				GetProfile_bc6h_veryfast(m_ispcTexcompSettings);
-				break;
-			case Texture::Quality::Low:
-				GetProfile_bc6h_fast(m_ispcTexcompSettings);
-				break;
-			case Texture::Quality::Normal:
-				GetProfile_bc6h_basic(m_ispcTexcompSettings);
-				break;
-			case Texture::Quality::High:
-				GetProfile_bc6h_slow(m_ispcTexcompSettings);
-				break;
-			case Texture::Quality::Highest:
-				GetProfile_bc6h_veryslow(m_ispcTexcompSettings);
-				break;
-			default:
-				assert(false);
-				break;
-		}
+		EncoderStateCache::Key key(EncoderStateCache::Kind::Bc6hIspcSettings, texture.format(),
+			texture.type(), quality);
+		m_ispcTexcompState = EncoderStateCache::get<EncoderStateCache::Value<bc6h_enc_settings>>(
+			std::move(key), [quality]()
+			{
+				auto settings = new EncoderStateCache::Value<bc6h_enc_settings>;
+				switch (quality)
+				{
+					case Texture::Quality::Preview:
+					case Texture::Quality::Lowest:
+						GetProfile_bc6h_veryfast(&settings->value);
+						break;
+					case Texture::Quality::Low:
+						GetProfile_bc6h_fast(&settings->value);
+						break;
+					case Texture::Quality::Normal:
+						GetProfile_bc6h_basic(&settings->value);
+						break;
+					case Texture::Quality::High:
+						GetProfile_bc6h_slow(&settings->value);
+						break;
+					case Texture::Quality::Highest:
+						GetProfile_bc6h_veryslow(&settings->value);
+						break;
+					default:
+						assert(false);
+						break;
+				}
+				return settings;
+			});
+		m_ispcTexcompSettings = &m_ispcTexcompState->value;
 	}
 #endif
 
 	if (useCompressonator)
 	{
-		CreateOptionsBC6(&m_compressonatorOptions);
-		assert(m_compressonatorOptions);
-		SetQualityBC6(m_compressonatorOptions, getCompressonatorQualityLevel(quality));
-		SetSignedBC6(m_compressonatorOptions, keepSign);
+		m_compressonatorOptions = getCompressonatorOptions(m_compressonatorState, texture, quality,
+			keepSign);
 	}
 }
 
 Bc6HConverter::~Bc6HConverter()
 {
-#if CUTTLEFISH_ISPC
-	delete m_ispcTexcompSettings;
-#endif
-	if (m_compressonatorOptions)
-		DestroyOptionsBC6(m_compressonatorOptions);
 }
 
 void Bc6HConverter::compressBlock(void* block, ColorRGBAf* blockColors)
@@ -572,67 +1260,160 @@ void Bc6HConverter::compressBlock(void* block, ColorRGBAf* blockColors)
 
 	assert(m_compressonatorOptions);
 	std::uint16_t colorBlock[blockPixels][3];
-	if (hasHardwareHalfFloat)
-		packHalfFloatBlockHardware(colorBlock, blockColors);
-	else
+	packHalfFloatBlock(colorBlock, blockColors);
+	CompressBlockBC6(reinterpret_cast<std::uint16_t*>(colorBlock), 3*blockDim,
+		reinterpret_cast<std::uint8_t*>(block), m_compressonatorOptions);
+}
+
+void Bc6HConverter::compressUniformBlock(void* block, ColorRGBAf* blockColors)
+{
+	// Only exactly constant unsigned blocks have a dedicated encoding. The near constant threshold
+	// isn't meaningful for HDR values, so all other blocks use the standard encoder.
+	if (!m_signed)
 	{
-		for (unsigned int i = 0; i < blockPixels; ++i)
+		std::uint16_t colorBlock[blockPixels][3];
+		packHalfFloatBlock(colorBlock, blockColors);
+		if (isBlockConstant(colorBlock[0], blockPixels, 3, 3))
 		{
-			for (unsigned int j = 0; j < 3; ++j)
-			{
-				colorBlock[i][j] =
-					glm::packHalf(glm::vec1(reinterpret_cast<float*>(blockColors + i)[j])).x;
-			}
+			encodeConstantBc6H(block, colorBlock[0]);
+			return;
 		}
 	}
 
-	CompressBlockBC6(reinterpret_cast<std::uint16_t*>(colorBlock), 3*blockDim,
-		reinterpret_cast<std::uint8_t*>(block), m_compressonatorOptions);
+	compressBlock(block, blockColors);
+}
+
+void Bc6HConverter::decodeBlock(ColorRGBAf* outColors, const void* block) const
+{
+	// NOTE: Compressonator defaults to unsigned when no options are provided, which matches the
+	// only case where ispc_texcomp is used instead.
+	std::uint16_t colorBlock[blockPixels][3];
+	DecompressBlockBC6(reinterpret_cast<const std::uint8_t*>(block),
+		reinterpret_cast<std::uint16_t*>(colorBlock), m_compressonatorOptions);
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		outColors[i].r = glm::unpackHalf1x16(colorBlock[i][0]);
+		outColors[i].g = glm::unpackHalf1x16(colorBlock[i][1]);
+		outColors[i].b = glm::unpackHalf1x16(colorBlock[i][2]);
+		outColors[i].a = 1.0f;
+	}
+}
+
+float Bc6HConverter::blockError(const void* block, const ColorRGBAf* blockColors) const
+{
+	ColorRGBAf decodedColors[blockPixels];
+	decodeBlock(decodedColors, block);
+
+	ColorRGBAf colors[blockPixels];
+	for (unsigned int i = 0; i < blockPixels; ++i)
+	{
+		auto color = reinterpret_cast<const float*>(blockColors + i);
+		auto logColor = reinterpret_cast<float*>(colors + i);
+		auto decodedColor = reinterpret_cast<float*>(decodedColors + i);
+		for (unsigned int c = 0; c < 4; ++c)
+		{
+			logColor[c] = toLogScale(m_signed ? color[c] : std::max(color[c], 0.0f));
+			decodedColor[c] = toLogScale(decodedColor[c]);
+		}
+	}
+
+	Texture::ColorMask mask = colorMask();
+	mask.a = false;
+	return getBlockError(colors, decodedColors, blockPixels, mask);
 }
 
 Bc7Converter::Bc7Converter(const Texture& texture, const Image& image, Texture::Quality quality)
-	: S3tcConverter(texture, image, 16, quality), m_params(nullptr)
+	: S3tcConverter(texture, image, 16, quality), m_params(nullptr), m_uniformParams(nullptr)
 {
+	// The parameters depend on the color space and mask in addition to the quality.
+	struct KeyParams
+	{
+		Texture::ColorMask colorMask;
+		bool perceptual;
+	};
+
+	KeyParams keyParams = {colorMask(), image.colorSpace() == ColorSpace::sRGB};
+	using ParamsValue = EncoderStateCache::Value<Bc7Params>;
 #if CUTTLEFISH_ISPC
 	initializeBc7e();
-	m_params = new ispc::bc7e_compress_block_params;
-	bool perceptual = image.colorSpace() == ColorSpace::sRGB;
-	switch (quality)
-	{
-		case Texture::Quality::Lowest:
-			ispc::bc7e_compress_block_params_init_ultrafast(m_params, perceptual);
-			break;
-		case Texture::Quality::Low:
-			ispc::bc7e_compress_block_params_init_fast(m_params, perceptual);
-			break;
-		case Texture::Quality::Normal:
-			ispc::bc7e_compress_block_params_init_basic(m_params, perceptual);
-			break;
-		case Texture::Quality::High:
-			ispc::bc7e_compress_block_params_init_slow(m_params, perceptual);
-			break;
-		case Texture::Quality::Highest:
-			ispc::bc7e_compress_block_params_init_slowest(m_params, perceptual);
-			break;
-		default:
-			assert(false);
-			break;
-	}
+	bool perceptual = keyParams.perceptual;
+	m_paramsState = EncoderStateCache::get<ParamsValue>(
+		EncoderStateCache::Key(EncoderStateCache::Kind::Bc7Params, texture.format(),
+			texture.type(), quality, keyParams),
+		[quality, perceptual]()
+		{
+			auto params = new ParamsValue;
+			switch (quality)
+			{
+				case Texture::Quality::Preview:
+				case Texture::Quality::Lowest:
+					ispc::bc7e_compress_block_params_init_ultrafast(&params->value, perceptual);
+					break;
+				case Texture::Quality::Low:
+					ispc::bc7e_compress_block_params_init_fast(&params->value, perceptual);
+					break;
+				case Texture::Quality::Normal:
+					ispc::bc7e_compress_block_params_init_basic(&params->value, perceptual);
+					break;
+				case Texture::Quality::High:
+					ispc::bc7e_compress_block_params_init_slow(&params->value, perceptual);
+					break;
+				case Texture::Quality::Highest:
+					ispc::bc7e_compress_block_params_init_slowest(&params->value, perceptual);
+					break;
+				default:
+					assert(false);
+					break;
+			}
+			return params;
+		});
+	m_uniformParamsState = EncoderStateCache::get<ParamsValue>(
+		EncoderStateCache::Key(EncoderStateCache::Kind::Bc7Params, texture.format(),
+			texture.type(), Texture::Quality::Lowest, keyParams),
+		[perceptual]()
+		{
+			auto params = new ParamsValue;
+			ispc::bc7e_compress_block_params_init_ultrafast(&params->value, perceptual);
+			return params;
+		});
 #else
 	initializeBc7enc();
-	m_params = new bc7enc_compress_block_params(createBc7BlockParams(*this));
+	m_paramsState = EncoderStateCache::get<ParamsValue>(
+		EncoderStateCache::Key(EncoderStateCache::Kind::Bc7Params, texture.format(),
+			texture.type(), quality, keyParams),
+		[this, quality]()
+		{
+			auto params = new ParamsValue;
+			params->value = createBc7BlockParams(*this, quality);
+			return params;
+		});
+	m_uniformParamsState = EncoderStateCache::get<ParamsValue>(
+		EncoderStateCache::Key(EncoderStateCache::Kind::Bc7Params, texture.format(),
+			texture.type(), Texture::Quality::Lowest, keyParams),
+		[this]()
+		{
+			auto params = new ParamsValue;
+			params->value = createBc7BlockParams(*this, Texture::Quality::Lowest);
+			return params;
+		});
 #endif
+	m_params = &m_paramsState->value;
+	m_uniformParams = &m_uniformParamsState->value;
 }
 
 Bc7Converter::~Bc7Converter()
 {
-	delete m_params;
 }
 
 void Bc7Converter::compressBlock(void* block, ColorRGBAf* blockColors)
 {
 	std::uint8_t colorBlock[blockPixels][4];
 	toColorBlock(colorBlock, blockColors);
+	if (usePreviewEncoder())
+	{
+		encodeBc7Preview(block, colorBlock);
+		return;
+	}
 
 #if CUTTLEFISH_ISPC
 	ispc::bc7e_compress_blocks(1, reinterpret_cast<std::uint64_t*>(block),
@@ -645,6 +1426,31 @@ void Bc7Converter::compressBlock(void* block, ColorRGBAf* blockColors)
 #endif
 }
 
+void Bc7Converter::compressUniformBlock(void* block, ColorRGBAf* blockColors)
+{
+	std::uint8_t colorBlock[blockPixels][4];
+	toColorBlock(colorBlock, blockColors);
+	if (isBlockConstant(colorBlock[0], blockPixels, 4, 4))
+	{
+		encodeConstantBc7(block, colorBlock[0]);
+		return;
+	}
+
+#if CUTTLEFISH_ISPC
+	ispc::bc7e_compress_blocks(1, reinterpret_cast<std::uint64_t*>(block),
+		reinterpret_cast<std::uint32_t*>(colorBlock), m_uniformParams);
+#else
+	bc7enc_compress_block(block, colorBlock, m_uniformParams);
+#endif
+}
+
+void Bc7Converter::decodeBlock(ColorRGBAf* outColors, const void* block) const
+{
+	std::uint8_t colorBlock[blockPixels][4];
+	decodeBc7(colorBlock, block);
+	fromColorBlock(outColors, colorBlock);
+}
+
 } // namespace cuttlefish
 
 #endif // CUTTLEFISH_HAS_S3TC
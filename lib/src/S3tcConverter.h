@@ -18,6 +18,7 @@
 
 #include <cuttlefish/Config.h>
 #include "Converter.h"
+#include "EncoderStateCache.h"
 
 #if CUTTLEFISH_HAS_S3TC
 
@@ -32,9 +33,16 @@ namespace ispc
 namespace cuttlefish
 {
 
+class CompressonatorOptions;
+
 class S3tcConverter : public Converter
 {
 public:
+	// Creates the converter for the texture format, or null if the type isn't supported. This
+	// also creates the converter for the fast quality when adaptive quality is used.
+	static std::unique_ptr<S3tcConverter> create(const Texture& texture, const Image& image,
+		Texture::Quality quality);
+
 	S3tcConverter(const Texture& texture, const Image& image, unsigned int blockSize,
 		Texture::Quality quality);
 
@@ -43,18 +51,42 @@ public:
 	void process(unsigned int x, unsigned int y, ThreadData* threadData) override;
 
 	Texture::Quality quality() const {return m_quality;}
+
+	// The encoder to use, resolving the default for the format. The default for BC1 with alpha
+	// remains Default since it combines squish and rgbcx.
+	Texture::Encoder encoder() const {return m_encoder;}
+
+	// The preview encoders are only used when the encoder wasn't explicitly chosen.
+	bool usePreviewEncoder() const {return m_usePreviewEncoder;}
+
 	ColorSpace colorSpace() const {return m_colorSpace;}
 	Texture::ColorMask colorMask() const {return m_colorMask;}
 	bool weightAlpha() const {return m_weightAlpha;}
 	virtual void compressBlock(void* block, ColorRGBAf* blockColors) = 0;
 
+	// Compresses a block where all channels are constant or nearly constant. This should encode
+	// constant blocks directly and use the cheapest encoder otherwise. Defaults to compressBlock().
+	virtual void compressUniformBlock(void* block, ColorRGBAf* blockColors);
+
+	// Decodes a block to measure the error for adaptive quality.
+	virtual void decodeBlock(ColorRGBAf* outColors, const void* block) const = 0;
+
+	// Gets the error of an encoded block compared to the original colors for adaptive quality.
+	virtual float blockError(const void* block, const ColorRGBAf* blockColors) const;
+
 private:
+	std::unique_ptr<S3tcConverter> m_fastConverter;
+	float m_errorThreshold;
+	float m_minValue;
 	unsigned int m_blockSize;
 	unsigned int m_jobsX;
 	unsigned int m_jobsY;
 	ColorSpace m_colorSpace;
 	Texture::Quality m_quality;
+	Texture::Encoder m_encoder;
+	bool m_usePreviewEncoder;
 	Texture::ColorMask m_colorMask;
+	Texture::ColorMask m_uniformMask;
 	bool m_weightAlpha;
 };
 
@@ -63,8 +95,11 @@ class Bc1Converter : public S3tcConverter
 public:
 	Bc1Converter(const Texture& texture, const Image& image, Texture::Quality quality);
 	void compressBlock(void* block, ColorRGBAf* blockColors) override;
+	void compressUniformBlock(void* block, ColorRGBAf* blockColors) override;
+	void decodeBlock(ColorRGBAf* outColors, const void* block) const override;
 
 private:
+	int m_squishFlags;
 	std::uint32_t m_qualityLevel;
 };
 
@@ -73,6 +108,9 @@ class Bc1AConverter : public S3tcConverter
 public:
 	Bc1AConverter(const Texture& texture, const Image& image, Texture::Quality quality);
 	void compressBlock(void* block, ColorRGBAf* blockColors) override;
+	void compressUniformBlock(void* block, ColorRGBAf* blockColors) override;
+	void decodeBlock(ColorRGBAf* outColors, const void* block) const override;
+	float blockError(const void* block, const ColorRGBAf* blockColors) const override;
 
 private:
 	int m_squishFlags;
@@ -84,8 +122,11 @@ class Bc2Converter : public S3tcConverter
 public:
 	Bc2Converter(const Texture& texture, const Image& image, Texture::Quality quality);
 	void compressBlock(void* block, ColorRGBAf* blockColors) override;
+	void compressUniformBlock(void* block, ColorRGBAf* blockColors) override;
+	void decodeBlock(ColorRGBAf* outColors, const void* block) const override;
 
 private:
+	int m_squishFlags;
 	std::uint32_t m_qualityLevel;
 };
 
@@ -94,8 +135,11 @@ class Bc3Converter : public S3tcConverter
 public:
 	Bc3Converter(const Texture& texture, const Image& image, Texture::Quality quality);
 	void compressBlock(void* block, ColorRGBAf* blockColors) override;
+	void compressUniformBlock(void* block, ColorRGBAf* blockColors) override;
+	void decodeBlock(ColorRGBAf* outColors, const void* block) const override;
 
 private:
+	int m_squishFlags;
 	std::uint32_t m_qualityLevel;
 	std::uint32_t m_searchRadius;
 };
@@ -107,10 +151,13 @@ public:
 		bool keepSign);
 	~Bc4Converter();
 	void compressBlock(void* block, ColorRGBAf* blockColors) override;
+	void compressUniformBlock(void* block, ColorRGBAf* blockColors) override;
+	void decodeBlock(ColorRGBAf* outColors, const void* block) const override;
 
 private:
 	bool m_signed;
 	std::uint32_t m_searchRadius;
+	EncoderStateCache::Handle<CompressonatorOptions> m_compressonatorState;
 	void* m_compressonatorOptions;
 };
 
@@ -121,10 +168,13 @@ public:
 		bool keepSign);
 	~Bc5Converter();
 	void compressBlock(void* block, ColorRGBAf* blockColors) override;
+	void compressUniformBlock(void* block, ColorRGBAf* blockColors) override;
+	void decodeBlock(ColorRGBAf* outColors, const void* block) const override;
 
 private:
 	bool m_signed;
 	std::uint32_t m_searchRadius;
+	EncoderStateCache::Handle<CompressonatorOptions> m_compressonatorState;
 	void* m_compressonatorOptions;
 };
 
@@ -135,11 +185,17 @@ public:
 		bool keepSign);
 	~Bc6HConverter();
 	void compressBlock(void* block, ColorRGBAf* blockColors) override;
+	void compressUniformBlock(void* block, ColorRGBAf* blockColors) override;
+	void decodeBlock(ColorRGBAf* outColors, const void* block) const override;
+	float blockError(const void* block, const ColorRGBAf* blockColors) const override;
 
 private:
+	bool m_signed;
 #if CUTTLEFISH_ISPC
+	EncoderStateCache::Handle<EncoderStateCache::Value<bc6h_enc_settings>> m_ispcTexcompState;
 	bc6h_enc_settings* m_ispcTexcompSettings;
 #endif
+	EncoderStateCache::Handle<CompressonatorOptions> m_compressonatorState;
 	void* m_compressonatorOptions;
 };
 
@@ -149,13 +205,20 @@ public:
 	Bc7Converter(const Texture& texture, const Image& image, Texture::Quality quality);
 	~Bc7Converter();
 	void compressBlock(void* block, ColorRGBAf* blockColors) override;
+	void compressUniformBlock(void* block, ColorRGBAf* blockColors) override;
+	void decodeBlock(ColorRGBAf* outColors, const void* block) const override;
 
 private:
 #if CUTTLEFISH_ISPC
-	ispc::bc7e_compress_block_params* m_params;
+	using Bc7Params = ispc::bc7e_compress_block_params;
 #else
-	bc7enc_compress_block_params* m_params;
+	using Bc7Params = bc7enc_compress_block_params;
 #endif
+
+	EncoderStateCache::Handle<EncoderStateCache::Value<Bc7Params>> m_paramsState;
+	EncoderStateCache::Handle<EncoderStateCache::Value<Bc7Params>> m_uniformParamsState;
+	Bc7Params* m_params;
+	Bc7Params* m_uniformParams;
 };
 
 } // namespace cuttlefish
@@ -23,50 +23,6 @@
 namespace cuttlefish
 {
 
-static const std::uint32_t magicNumber = 0x20534444;
-
-enum DdsFlags
-{
-	DdsFlags_Caps = 0x1,
-	DdsFlags_Height = 0x2,
-	DdsFlags_Width = 0x4,
-	DdsFlags_Pitch = 0x8,
-	DdsFlags_PixelFormat = 0x1000,
-	DdsFlags_MipmapCount = 0x20000,
-	DdsFlags_LinearSize = 0x80000,
-	DdsFlags_Depth = 0x800000,
-	DdsFlags_Requred = DdsFlags_Caps | DdsFlags_Height | DdsFlags_Width | DdsFlags_PixelFormat
-};
-
-enum DdsFormatFlags
-{
-	DdsFormatFlags_AlphaPixels = 0x1,
-	DdsFormatFlags_Alpha = 0x2,
-	DdsFormatFlags_FourCC = 0x4,
-	DdsFormatFlags_Rgb = 0x40,
-	DdsFormatFlags_Yuv = 0x200,
-	DdsFormatFlags_Luminance = 0x20000
-};
-
-enum DdsCapsFlags
-{
-	DdsCapsFlags_Complex = 0x8,
-	DdsCapsFlags_Mipmap = 0x400000,
-	DdsCapsFlags_Texture = 0x1000
-};
-
-enum DdsCaps2Flags
-{
-	DdsCaps2Flags_Cube = 0x200,
-	DdsCaps2Flags_PosX = 0x400,
-	DdsCaps2Flags_NegX = 0x800,
-	DdsCaps2Flags_PosY = 0x1000,
-	DdsCaps2Flags_NegY = 0x2000,
-	DdsCaps2Flags_PosZ = 0x4000,
-	DdsCaps2Flags_NegZ = 0x8000,
-	DdsCaps2Flags_Volume = 0x200000
-};
-
 enum DdsDxt10Format
 {
 	DdsDxt10Format_UNKNOWN                     = 0,
@@ -190,68 +146,6 @@ enum DdsDxt10Format
 	DdsDxt10Format_V408                        = 132,
 };
 
-enum DdsTextureDim
-{
-  DdsTextureDim_UNKNOWN    = 0,
-  DdsTextureDim_BUFFER     = 1,
-  DdsTextureDim_TEXTURE1D  = 2,
-  DdsTextureDim_TEXTURE2D  = 3,
-  DdsTextureDim_TEXTURE3D  = 4
-};
-
-enum DdsDxt10MiscFlag
-{
-	DdsDxt10MiscFlag_CubeMap = 0x4
-};
-
-enum DdsDxt10MiscFlags2
-{
-	DdsDxt10MiscFlags2_AlphaModeUnknown       = 0,
-	DdsDxt10MiscFlags2_AlphaModeStraight      = 1,
-	DdsDxt10MiscFlags2_AlphaModePreMultiplied = 2,
-	DdsDxt10MiscFlags2_AlphaModeOpaque        = 3,
-	DdsDxt10MiscFlags2_AlphaModeCustom        = 4,
-};
-
-struct DdsPixelFormat
-{
-	std::uint32_t size;
-	std::uint32_t flags;
-	std::uint32_t fourCC;
-	std::uint32_t rgbBitCount;
-	std::uint32_t rBitMask;
-	std::uint32_t gBitMask;
-	std::uint32_t bBitMask;
-	std::uint32_t aBitMask;
-};
-
-struct DdsHeader
-{
-	std::uint32_t size;
-	std::uint32_t flags;
-	std::uint32_t height;
-	std::uint32_t width;
-	std::uint32_t pitchOrLinearSize;
-	std::uint32_t depth;
-	std::uint32_t mipMapCount;
-	std::uint32_t reserved1[11];
-	DdsPixelFormat ddspf;
-	std::uint32_t caps;
-	std::uint32_t caps2;
-	std::uint32_t caps3;
-	std::uint32_t caps4;
-	std::uint32_t reserved2;
-};
-
-struct DdsHeaderDxt10
-{
-	std::uint32_t dxgiFormat;
-	std::uint32_t resourceDimension;
-	std::uint32_t miscFlag;
-	std::uint32_t arraySize;
-	std::uint32_t miscFlags2;
-};
-
 static DdsDxt10Format getDdsFormat(Texture::Format format, Texture::Type type,
 	ColorSpace colorSpace)
 {
@@ -562,14 +456,91 @@ bool isValidForDds(Texture::Format format, Texture::Type type)
 	return getDdsFormat(format, type, ColorSpace::Linear) != DdsDxt10Format_UNKNOWN;
 }
 
-Texture::SaveResult saveDds(const Texture& texture, std::ostream& stream)
+bool findDdsFormat(Texture::Format& outFormat, Texture::Type& outType, ColorSpace& outColorSpace,
+	std::uint32_t dxgiFormat, bool hasAlpha)
+{
+	if (dxgiFormat == DdsDxt10Format_UNKNOWN)
+		return false;
+
+	// Search the formats that are saved for a match, preferring a linear color space and a format
+	// where the presence of alpha matches.
+	const ColorSpace colorSpaces[] = {ColorSpace::Linear, ColorSpace::sRGB};
+	bool found = false;
+	for (ColorSpace colorSpace : colorSpaces)
+	{
+		for (int i = static_cast<int>(Texture::Format::R4G4);
+			i <= static_cast<int>(Texture::Format::PVRTC2_RGBA_4BPP); ++i)
+		{
+			auto format = static_cast<Texture::Format>(i);
+			for (int j = static_cast<int>(Texture::Type::UNorm);
+				j <= static_cast<int>(Texture::Type::Float); ++j)
+			{
+				auto type = static_cast<Texture::Type>(j);
+				if (static_cast<std::uint32_t>(getDdsFormat(format, type, colorSpace)) !=
+					dxgiFormat)
+				{
+					continue;
+				}
+
+				if (Texture::hasAlpha(format) == hasAlpha)
+				{
+					outFormat = format;
+					outType = type;
+					outColorSpace = colorSpace;
+					return true;
+				}
+				else if (!found)
+				{
+					outFormat = format;
+					outType = type;
+					outColorSpace = colorSpace;
+					found = true;
+				}
+			}
+		}
+
+		if (found)
+			return true;
+	}
+
+	return false;
+}
+
+std::uint32_t getDdsFourCCFormat(std::uint32_t fourCC)
+{
+	switch (fourCC)
+	{
+		case FOURCC('D', 'X', 'T', '1'):
+			return DdsDxt10Format_BC1_UNORM;
+		case FOURCC('D', 'X', 'T', '2'):
+		case FOURCC('D', 'X', 'T', '3'):
+			return DdsDxt10Format_BC2_UNORM;
+		case FOURCC('D', 'X', 'T', '4'):
+		case FOURCC('D', 'X', 'T', '5'):
+			return DdsDxt10Format_BC3_UNORM;
+		case FOURCC('A', 'T', 'I', '1'):
+		case FOURCC('B', 'C', '4', 'U'):
+			return DdsDxt10Format_BC4_UNORM;
+		case FOURCC('B', 'C', '4', 'S'):
+			return DdsDxt10Format_BC4_SNORM;
+		case FOURCC('A', 'T', 'I', '2'):
+		case FOURCC('B', 'C', '5', 'U'):
+			return DdsDxt10Format_BC5_UNORM;
+		case FOURCC('B', 'C', '5', 'S'):
+			return DdsDxt10Format_BC5_SNORM;
+		default:
+			return DdsDxt10Format_UNKNOWN;
+	}
+}
+
+Texture::SaveResult saveDdsHeader(const Texture& texture, std::ostream& stream)
 {
 	DdsDxt10Format ddsFormat = getDdsFormat(texture.format(), texture.type(),
 		texture.colorSpace());
 	if (ddsFormat == DdsDxt10Format_UNKNOWN)
 		return Texture::SaveResult::Unsupported;
 
-	if (!write(stream, magicNumber))
+	if (!write(stream, ddsMagicNumber))
 		return Texture::SaveResult::WriteError;
 
 	DdsHeader header;
@@ -654,6 +625,15 @@ Texture::SaveResult saveDds(const Texture& texture, std::ostream& stream)
 	if (!write(stream, dxt10Header))
 		return Texture::SaveResult::WriteError;
 
+	return Texture::SaveResult::Success;
+}
+
+Texture::SaveResult saveDds(const Texture& texture, OutputSlices& output)
+{
+	Texture::SaveResult result = saveDdsHeader(texture, output.stream());
+	if (result != Texture::SaveResult::Success)
+		return result;
+
 	unsigned int elements = texture.isArray() ? texture.depth() : 1;
 	for (unsigned int element = 0; element < elements; ++element)
 	{
@@ -669,11 +649,8 @@ Texture::SaveResult saveDds(const Texture& texture, std::ostream& stream)
 					assert(element == 0 || volume == 0);
 					unsigned int index = volume + element;
 					assert(texture.dataSize(faceEnum, level, index) > 0);
-					stream.write(
-						reinterpret_cast<const char*>(texture.data(faceEnum, level, index)),
+					output.add(texture.data(faceEnum, level, index),
 						texture.dataSize(faceEnum, level, index));
-					if (!stream.good())
-						return Texture::SaveResult::WriteError;
 				}
 			}
 		}
@@ -18,11 +18,129 @@
 
 #include <cuttlefish/Config.h>
 #include <cuttlefish/Texture.h>
+#include "OutputSlices.h"
+#include <cstdint>
 
 namespace cuttlefish
 {
 
+// File structures shared between saving and loading.
+static const std::uint32_t ddsMagicNumber = 0x20534444;
+
+enum DdsFlags
+{
+	DdsFlags_Caps = 0x1,
+	DdsFlags_Height = 0x2,
+	DdsFlags_Width = 0x4,
+	DdsFlags_Pitch = 0x8,
+	DdsFlags_PixelFormat = 0x1000,
+	DdsFlags_MipmapCount = 0x20000,
+	DdsFlags_LinearSize = 0x80000,
+	DdsFlags_Depth = 0x800000,
+	DdsFlags_Requred = DdsFlags_Caps | DdsFlags_Height | DdsFlags_Width | DdsFlags_PixelFormat
+};
+
+enum DdsFormatFlags
+{
+	DdsFormatFlags_AlphaPixels = 0x1,
+	DdsFormatFlags_Alpha = 0x2,
+	DdsFormatFlags_FourCC = 0x4,
+	DdsFormatFlags_Rgb = 0x40,
+	DdsFormatFlags_Yuv = 0x200,
+	DdsFormatFlags_Luminance = 0x20000
+};
+
+enum DdsCapsFlags
+{
+	DdsCapsFlags_Complex = 0x8,
+	DdsCapsFlags_Mipmap = 0x400000,
+	DdsCapsFlags_Texture = 0x1000
+};
+
+enum DdsCaps2Flags
+{
+	DdsCaps2Flags_Cube = 0x200,
+	DdsCaps2Flags_PosX = 0x400,
+	DdsCaps2Flags_NegX = 0x800,
+	DdsCaps2Flags_PosY = 0x1000,
+	DdsCaps2Flags_NegY = 0x2000,
+	DdsCaps2Flags_PosZ = 0x4000,
+	DdsCaps2Flags_NegZ = 0x8000,
+	DdsCaps2Flags_Volume = 0x200000
+};
+enum DdsTextureDim
+{
+  DdsTextureDim_UNKNOWN    = 0,
+  DdsTextureDim_BUFFER     = 1,
+  DdsTextureDim_TEXTURE1D  = 2,
+  DdsTextureDim_TEXTURE2D  = 3,
+  DdsTextureDim_TEXTURE3D  = 4
+};
+
+enum DdsDxt10MiscFlag
+{
+	DdsDxt10MiscFlag_CubeMap = 0x4
+};
+
+enum DdsDxt10MiscFlags2
+{
+	DdsDxt10MiscFlags2_AlphaModeUnknown       = 0,
+	DdsDxt10MiscFlags2_AlphaModeStraight      = 1,
+	DdsDxt10MiscFlags2_AlphaModePreMultiplied = 2,
+	DdsDxt10MiscFlags2_AlphaModeOpaque        = 3,
+	DdsDxt10MiscFlags2_AlphaModeCustom        = 4,
+};
+
+struct DdsPixelFormat
+{
+	std::uint32_t size;
+	std::uint32_t flags;
+	std::uint32_t fourCC;
+	std::uint32_t rgbBitCount;
+	std::uint32_t rBitMask;
+	std::uint32_t gBitMask;
+	std::uint32_t bBitMask;
+	std::uint32_t aBitMask;
+};
+
+struct DdsHeader
+{
+	std::uint32_t size;
+	std::uint32_t flags;
+	std::uint32_t height;
+	std::uint32_t width;
+	std::uint32_t pitchOrLinearSize;
+	std::uint32_t depth;
+	std::uint32_t mipMapCount;
+	std::uint32_t reserved1[11];
+	DdsPixelFormat ddspf;
+	std::uint32_t caps;
+	std::uint32_t caps2;
+	std::uint32_t caps3;
+	std::uint32_t caps4;
+	std::uint32_t reserved2;
+};
+
+struct DdsHeaderDxt10
+{
+	std::uint32_t dxgiFormat;
+	std::uint32_t resourceDimension;
+	std::uint32_t miscFlag;
+	std::uint32_t arraySize;
+	std::uint32_t miscFlags2;
+};
+
 bool isValidForDds(Texture::Format format, Texture::Type type);
-Texture::SaveResult saveDds(const Texture& texture, std::ostream& stream);
+// Writes only the header, leaving the stream positioned at the start of the image data.
+Texture::SaveResult saveDdsHeader(const Texture& texture, std::ostream& stream);
+// Adds the header and references to the texture data to output.
+Texture::SaveResult saveDds(const Texture& texture, OutputSlices& output);
+
+// Finds the format, type, and color space that are saved with a DXGI format. When the same DXGI
+// format is used for formats with and without alpha, such as BC1, hasAlpha selects between them.
+bool findDdsFormat(Texture::Format& outFormat, Texture::Type& outType, ColorSpace& outColorSpace,
+	std::uint32_t dxgiFormat, bool hasAlpha);
+// Gets the DXGI format for the FourCC of a legacy DDS header, or 0 if unsupported.
+std::uint32_t getDdsFourCCFormat(std::uint32_t fourCC);
 
 } // namespace cuttlefish
@@ -190,13 +190,6 @@ struct FormatInfo
 	std::uint32_t baseInternalFormat;
 };
 
-static char header[12] =
-{
-	'\xAB', 'K', 'T', 'X', ' ', '1', '1', '\xBB', '\r', '\n', '\x1A', '\n'
-};
-
-static const std::uint32_t endianness = 0x04030201;
-
 static bool getFormatInfo(FormatInfo& info, Texture::Format format, Texture::Type type,
 	ColorSpace colorSpace)
 {
@@ -1186,7 +1179,38 @@ bool isValidForKtx(Texture::Format format, Texture::Type type)
 	return getFormatInfo(info, format, type, ColorSpace::Linear);
 }
 
-Texture::SaveResult saveKtx(const Texture& texture, std::ostream& stream)
+bool findKtxFormat(Texture::Format& outFormat, Texture::Type& outType, ColorSpace& outColorSpace,
+	std::uint32_t glType, std::uint32_t glFormat, std::uint32_t glInternalFormat)
+{
+	// Search the formats that are saved for a match, preferring a linear color space.
+	const ColorSpace colorSpaces[] = {ColorSpace::Linear, ColorSpace::sRGB};
+	for (ColorSpace colorSpace : colorSpaces)
+	{
+		for (int i = static_cast<int>(Texture::Format::R4G4);
+			i <= static_cast<int>(Texture::Format::PVRTC2_RGBA_4BPP); ++i)
+		{
+			auto format = static_cast<Texture::Format>(i);
+			for (int j = static_cast<int>(Texture::Type::UNorm);
+				j <= static_cast<int>(Texture::Type::Float); ++j)
+			{
+				auto type = static_cast<Texture::Type>(j);
+				FormatInfo info;
+				if (getFormatInfo(info, format, type, colorSpace) && info.type == glType &&
+					info.format == glFormat && info.internalFormat == glInternalFormat)
+				{
+					outFormat = format;
+					outType = type;
+					outColorSpace = colorSpace;
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+Texture::SaveResult saveKtxHeader(const Texture& texture, std::ostream& stream)
 {
 	static_assert(sizeof(0U) == sizeof(std::uint32_t), "unexpected integer size");
 	static_assert(sizeof(unsigned int) == sizeof(std::uint32_t), "unexpected integer size");
@@ -1195,10 +1219,10 @@ Texture::SaveResult saveKtx(const Texture& texture, std::ostream& stream)
 	if (!getFormatInfo(info, texture.format(), texture.type(), texture.colorSpace()))
 		return Texture::SaveResult::Unsupported;
 
-	if (!write(stream, header))
+	if (!write(stream, ktxIdentifier))
 		return Texture::SaveResult::WriteError;
 
-	if (!write(stream, endianness))
+	if (!write(stream, ktxEndianness))
 		return Texture::SaveResult::WriteError;
 
 	if (!write(stream, info))
@@ -1219,6 +1243,15 @@ Texture::SaveResult saveKtx(const Texture& texture, std::ostream& stream)
 	if (!write(stream, 0U))
 		return Texture::SaveResult::WriteError;
 
+	return Texture::SaveResult::Success;
+}
+
+Texture::SaveResult saveKtx(const Texture& texture, OutputSlices& output)
+{
+	Texture::SaveResult result = saveKtxHeader(texture, output.stream());
+	if (result != Texture::SaveResult::Success)
+		return result;
+
 	bool compressed = Texture::blockWidth(texture.format()) > 1;
 	unsigned int formatSize = Texture::blockSize(texture.format());
 	for (unsigned int level = 0; level < texture.mipLevelCount(); ++level)
@@ -1244,43 +1277,37 @@ Texture::SaveResult saveKtx(const Texture& texture, std::ostream& stream)
 		// Compressed formats should be at least 4-byte aligned. We should never have to write
 		// padding bytes for cube faces or mipmaps.
 		assert(imageSize % 4 == 0);
-		if (!write(stream, imageSize))
+		if (!write(output.stream(), imageSize))
 			return Texture::SaveResult::WriteError;
 
-		if (compressed)
+		unsigned int padding = 0;
+		if (!compressed)
 		{
-			for (unsigned int depth = 0; depth < texture.depth(level); ++depth)
-			{
-				for (unsigned int face = 0; face < texture.faceCount(); ++face)
-				{
-					stream.write(reinterpret_cast<const char*>(texture.data(
-						static_cast<Texture::CubeFace>(face), level, depth)), texture.dataSize(
-						static_cast<Texture::CubeFace>(face), level, depth));
-					if (!stream.good())
-						return Texture::SaveResult::WriteError;
-				}
-			}
+			padding = (texture.width(level)*formatSize) % 4;
+			if (padding != 0)
+				padding = 4 - padding;
 		}
-		else
+
+		for (unsigned int depth = 0; depth < texture.depth(level); ++depth)
 		{
-			for (unsigned int depth = 0; depth < texture.depth(level); ++depth)
+			for (unsigned int face = 0; face < texture.faceCount(); ++face)
 			{
-				for (unsigned int face = 0; face < texture.faceCount(); ++face)
+				auto cubeFace = static_cast<Texture::CubeFace>(face);
+				if (padding == 0)
+				{
+					output.add(texture.data(cubeFace, level, depth),
+						texture.dataSize(cubeFace, level, depth));
+					continue;
+				}
+
+				// Reference each row separately with the shared padding between them.
+				auto data = reinterpret_cast<const std::uint8_t*>(
+					texture.data(cubeFace, level, depth));
+				unsigned int rowSize = texture.width(level)*formatSize;
+				for (unsigned int y = 0; y < texture.height(level); ++y, data += rowSize)
 				{
-					const char* data = reinterpret_cast<const char*>(texture.data(
-						static_cast<Texture::CubeFace>(face), level, depth));
-					unsigned int rowSize = texture.width(level)*formatSize;
-					unsigned int padding = rowSize % 4;
-					if (padding != 0)
-						padding = 4 - padding;
-					for (unsigned int y = 0; y < texture.height(level); ++y, data += rowSize)
-					{
-						stream.write(data, rowSize);
-						for (unsigned int i = 0; i < padding; ++i)
-							stream.put(0);
-						if (!stream.good())
-							return Texture::SaveResult::WriteError;
-					}
+					output.add(data, rowSize);
+					output.addPadding(padding);
 				}
 			}
 		}
@@ -18,11 +18,28 @@
 
 #include <cuttlefish/Config.h>
 #include <cuttlefish/Texture.h>
+#include "OutputSlices.h"
+#include <cstdint>
 
 namespace cuttlefish
 {
 
+static const char ktxIdentifier[12] =
+{
+	'\xAB', 'K', 'T', 'X', ' ', '1', '1', '\xBB', '\r', '\n', '\x1A', '\n'
+};
+
+static const std::uint32_t ktxEndianness = 0x04030201;
+
 bool isValidForKtx(Texture::Format format, Texture::Type type);
-Texture::SaveResult saveKtx(const Texture& texture, std::ostream& stream);
+// Writes only the header, leaving the stream positioned at the start of the image data.
+Texture::SaveResult saveKtxHeader(const Texture& texture, std::ostream& stream);
+// Adds the header and references to the texture data to output.
+Texture::SaveResult saveKtx(const Texture& texture, OutputSlices& output);
+
+// Finds the format, type, and color space that are saved with the OpenGL type, format, and
+// internal format.
+bool findKtxFormat(Texture::Format& outFormat, Texture::Type& outType, ColorSpace& outColorSpace,
+	std::uint32_t glType, std::uint32_t glFormat, std::uint32_t glInternalFormat);
 
 } // namespace cuttlefish
@@ -0,0 +1,938 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SaveKtx2.h"
+#include "JobProcessor.h"
+#include "Shared.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <initializer_list>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#if CUTTLEFISH_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#define VK_FORMAT_R4G4_UNORM_PACK8                 1
+#define VK_FORMAT_R4G4B4A4_UNORM_PACK16            2
+#define VK_FORMAT_B4G4R4A4_UNORM_PACK16            3
+#define VK_FORMAT_R5G6B5_UNORM_PACK16              4
+#define VK_FORMAT_B5G6R5_UNORM_PACK16              5
+#define VK_FORMAT_R5G5B5A1_UNORM_PACK16            6
+#define VK_FORMAT_B5G5R5A1_UNORM_PACK16            7
+#define VK_FORMAT_A1R5G5B5_UNORM_PACK16            8
+#define VK_FORMAT_R8_UNORM                         9
+#define VK_FORMAT_R8G8_UNORM                       16
+#define VK_FORMAT_R8G8B8_UNORM                     23
+#define VK_FORMAT_B8G8R8_UNORM                     30
+#define VK_FORMAT_R8G8B8A8_UNORM                   37
+#define VK_FORMAT_B8G8R8A8_UNORM                   44
+#define VK_FORMAT_A2R10G10B10_UNORM_PACK32         58
+#define VK_FORMAT_A2B10G10R10_UNORM_PACK32         64
+#define VK_FORMAT_R16_UNORM                        70
+#define VK_FORMAT_R16G16_UNORM                     77
+#define VK_FORMAT_R16G16B16_UNORM                  84
+#define VK_FORMAT_R16G16B16A16_UNORM               91
+#define VK_FORMAT_R32_UINT                         98
+#define VK_FORMAT_R32G32_UINT                      101
+#define VK_FORMAT_R32G32B32_UINT                   104
+#define VK_FORMAT_R32G32B32A32_UINT                107
+#define VK_FORMAT_B10G11R11_UFLOAT_PACK32          122
+#define VK_FORMAT_E5B9G9R9_UFLOAT_PACK32           123
+#define VK_FORMAT_BC1_RGB_UNORM_BLOCK              131
+#define VK_FORMAT_BC1_RGBA_UNORM_BLOCK             133
+#define VK_FORMAT_BC2_UNORM_BLOCK                  135
+#define VK_FORMAT_BC3_UNORM_BLOCK                  137
+#define VK_FORMAT_BC4_UNORM_BLOCK                  139
+#define VK_FORMAT_BC5_UNORM_BLOCK                  141
+#define VK_FORMAT_BC6H_UFLOAT_BLOCK                143
+#define VK_FORMAT_BC7_UNORM_BLOCK                  145
+#define VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK          147
+#define VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK        149
+#define VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK        151
+#define VK_FORMAT_EAC_R11_UNORM_BLOCK              153
+#define VK_FORMAT_EAC_R11G11_UNORM_BLOCK           155
+#define VK_FORMAT_ASTC_4x4_UNORM_BLOCK             157
+#define VK_FORMAT_PVRTC1_2BPP_UNORM_BLOCK_IMG      1000054000
+#define VK_FORMAT_PVRTC1_4BPP_UNORM_BLOCK_IMG      1000054001
+#define VK_FORMAT_PVRTC2_2BPP_UNORM_BLOCK_IMG      1000054002
+#define VK_FORMAT_PVRTC2_4BPP_UNORM_BLOCK_IMG      1000054003
+#define VK_FORMAT_ASTC_4x4_SFLOAT_BLOCK            1000066000
+#define VK_FORMAT_A4R4G4B4_UNORM_PACK16            1000340000
+
+// Values from the Khronos Data Format Specification.
+#define KHR_DF_VERSIONNUMBER_1_3                   2
+#define KHR_DF_MODEL_RGBSDA                        1
+#define KHR_DF_MODEL_BC1A                          128
+#define KHR_DF_MODEL_BC2                           129
+#define KHR_DF_MODEL_BC3                           130
+#define KHR_DF_MODEL_BC4                           131
+#define KHR_DF_MODEL_BC5                           132
+#define KHR_DF_MODEL_BC6H                          133
+#define KHR_DF_MODEL_BC7                           134
+#define KHR_DF_MODEL_ETC1                          160
+#define KHR_DF_MODEL_ETC2                          161
+#define KHR_DF_MODEL_ASTC                          162
+#define KHR_DF_MODEL_PVRTC                         164
+#define KHR_DF_MODEL_PVRTC2                        165
+#define KHR_DF_PRIMARIES_BT709                     1
+#define KHR_DF_TRANSFER_LINEAR                     1
+#define KHR_DF_TRANSFER_SRGB                       2
+#define KHR_DF_FLAG_ALPHA_PREMULTIPLIED            1
+#define KHR_DF_CHANNEL_RED                         0
+#define KHR_DF_CHANNEL_GREEN                       1
+#define KHR_DF_CHANNEL_BLUE                        2
+#define KHR_DF_CHANNEL_COLOR                       0
+#define KHR_DF_CHANNEL_BC1A_ALPHAPRESENT           1
+#define KHR_DF_CHANNEL_ETC2_COLOR                  2
+#define KHR_DF_CHANNEL_ALPHA                       15
+#define KHR_DF_SAMPLE_DATATYPE_LINEAR              0x80
+#define KHR_DF_SAMPLE_DATATYPE_EXPONENT            0x40
+#define KHR_DF_SAMPLE_DATATYPE_SIGNED              0x20
+#define KHR_DF_SAMPLE_DATATYPE_FLOAT               0x10
+
+#define KTX2_SUPERCOMPRESSION_NONE                 0U
+#define KTX2_SUPERCOMPRESSION_ZSTD                 2U
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+struct DfdSample
+{
+	std::uint8_t channel;
+	std::uint8_t qualifiers;
+	std::uint16_t bitOffset;
+	std::uint8_t bitLength;
+	std::uint32_t lower;
+	std::uint32_t upper;
+};
+
+struct Ktx2FormatInfo
+{
+	static const unsigned int maxSamples = 6;
+
+	std::uint32_t vkFormat;
+	std::uint32_t typeSize;
+	std::uint8_t colorModel;
+	unsigned int sampleCount;
+	DfdSample samples[maxSamples];
+};
+
+struct LevelData
+{
+	std::size_t uncompressedSize;
+	std::size_t size;
+	std::uint64_t offset;
+	std::vector<std::uint8_t> compressed;
+};
+
+const char identifier[12] =
+{
+	'\xAB', 'K', 'T', 'X', ' ', '2', '0', '\xBB', '\r', '\n', '\x1A', '\n'
+};
+
+const std::uint32_t headerSize = 80;
+const std::uint32_t levelIndexEntrySize = 24;
+const std::uint32_t basicDescriptorHeaderSize = 24;
+const std::uint32_t sampleSize = 16;
+
+const char writerKey[] = "KTXwriter";
+const char writerValue[] = "Cuttlefish";
+
+void addSample(Ktx2FormatInfo& info, std::uint8_t channel, unsigned int bitOffset,
+	unsigned int bitLength)
+{
+	assert(info.sampleCount < Ktx2FormatInfo::maxSamples);
+	DfdSample& sample = info.samples[info.sampleCount++];
+	sample.channel = channel;
+	sample.qualifiers = 0;
+	sample.bitOffset = static_cast<std::uint16_t>(bitOffset);
+	sample.bitLength = static_cast<std::uint8_t>(bitLength);
+	sample.lower = 0;
+	sample.upper = 0;
+}
+
+// Adds samples for formats with each channel stored consecutively with the same size.
+void addChannelSamples(Ktx2FormatInfo& info, std::initializer_list<std::uint8_t> channels,
+	unsigned int bitLength)
+{
+	unsigned int bitOffset = 0;
+	for (std::uint8_t channel : channels)
+	{
+		addSample(info, channel, bitOffset, bitLength);
+		bitOffset += bitLength;
+	}
+}
+
+// Vulkan orders the types of the 8 and 16-bit formats as UNorm, SNorm, UScaled, SScaled, UInt,
+// Int, then sRGB for 8-bit or Float for 16-bit.
+std::uint32_t typedVkFormat(std::uint32_t unormFormat, Texture::Type type, bool srgb)
+{
+	switch (type)
+	{
+		case Texture::Type::UNorm:
+			return srgb ? unormFormat + 6 : unormFormat;
+		case Texture::Type::SNorm:
+			return unormFormat + 1;
+		case Texture::Type::UInt:
+			return unormFormat + 4;
+		case Texture::Type::Int:
+			return unormFormat + 5;
+		case Texture::Type::Float:
+			return unormFormat + 6;
+		default:
+			return 0;
+	}
+}
+
+// The 32-bit formats are ordered as UInt, Int, then Float.
+std::uint32_t typedVkFormat32(std::uint32_t uintFormat, Texture::Type type)
+{
+	switch (type)
+	{
+		case Texture::Type::UInt:
+			return uintFormat;
+		case Texture::Type::Int:
+			return uintFormat + 1;
+		case Texture::Type::Float:
+			return uintFormat + 2;
+		default:
+			return 0;
+	}
+}
+
+// Fills in the qualifiers and range of each sample that wasn't set explicitly based on the type.
+void setSampleRanges(Ktx2FormatInfo& info, Texture::Type type)
+{
+	const std::uint32_t floatOne = 0x3F800000;
+	const std::uint32_t floatNegOne = 0xBF800000;
+	bool compressed = info.colorModel != KHR_DF_MODEL_RGBSDA;
+	for (unsigned int i = 0; i < info.sampleCount; ++i)
+	{
+		DfdSample& sample = info.samples[i];
+		if (sample.upper != 0)
+			continue;
+
+		switch (type)
+		{
+			case Texture::Type::UNorm:
+				sample.lower = 0;
+				sample.upper = compressed ? 0xFFFFFFFF : (1U << sample.bitLength) - 1;
+				break;
+			case Texture::Type::SNorm:
+				sample.qualifiers = KHR_DF_SAMPLE_DATATYPE_SIGNED;
+				if (compressed)
+				{
+					sample.lower = 0x80000000;
+					sample.upper = 0x7FFFFFFF;
+				}
+				else
+				{
+					sample.upper = (1U << (sample.bitLength - 1)) - 1;
+					sample.lower = 0U - sample.upper;
+				}
+				break;
+			case Texture::Type::UInt:
+				sample.lower = 0;
+				sample.upper = 1;
+				break;
+			case Texture::Type::Int:
+				sample.qualifiers = KHR_DF_SAMPLE_DATATYPE_SIGNED;
+				sample.lower = 0xFFFFFFFF;
+				sample.upper = 1;
+				break;
+			case Texture::Type::UFloat:
+				sample.qualifiers = KHR_DF_SAMPLE_DATATYPE_FLOAT;
+				sample.lower = 0;
+				sample.upper = floatOne;
+				break;
+			case Texture::Type::Float:
+				sample.qualifiers = KHR_DF_SAMPLE_DATATYPE_SIGNED | KHR_DF_SAMPLE_DATATYPE_FLOAT;
+				sample.lower = floatNegOne;
+				sample.upper = floatOne;
+				break;
+		}
+	}
+}
+
+bool setPackedFormat(Ktx2FormatInfo& info, std::uint32_t vkFormat, std::uint32_t typeSize,
+	Texture::Type type)
+{
+	info.vkFormat = vkFormat;
+	info.typeSize = typeSize;
+	return type == Texture::Type::UNorm;
+}
+
+bool getFormatInfo(Ktx2FormatInfo& info, Texture::Format format, Texture::Type type,
+	ColorSpace colorSpace)
+{
+	bool srgb = colorSpace == ColorSpace::sRGB;
+	info.vkFormat = 0;
+	info.typeSize = 1;
+	info.colorModel = KHR_DF_MODEL_RGBSDA;
+	info.sampleCount = 0;
+
+	// Samples for packed formats are listed from the least significant bit.
+	bool valid;
+	switch (format)
+	{
+		case Texture::Format::R4G4:
+			addSample(info, KHR_DF_CHANNEL_GREEN, 0, 4);
+			addSample(info, KHR_DF_CHANNEL_RED, 4, 4);
+			valid = setPackedFormat(info, VK_FORMAT_R4G4_UNORM_PACK8, 1, type);
+			break;
+		case Texture::Format::R4G4B4A4:
+			addSample(info, KHR_DF_CHANNEL_ALPHA, 0, 4);
+			addSample(info, KHR_DF_CHANNEL_BLUE, 4, 4);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 8, 4);
+			addSample(info, KHR_DF_CHANNEL_RED, 12, 4);
+			valid = setPackedFormat(info, VK_FORMAT_R4G4B4A4_UNORM_PACK16, 2, type);
+			break;
+		case Texture::Format::B4G4R4A4:
+			addSample(info, KHR_DF_CHANNEL_ALPHA, 0, 4);
+			addSample(info, KHR_DF_CHANNEL_RED, 4, 4);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 8, 4);
+			addSample(info, KHR_DF_CHANNEL_BLUE, 12, 4);
+			valid = setPackedFormat(info, VK_FORMAT_B4G4R4A4_UNORM_PACK16, 2, type);
+			break;
+		case Texture::Format::A4R4G4B4:
+			addSample(info, KHR_DF_CHANNEL_BLUE, 0, 4);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 4, 4);
+			addSample(info, KHR_DF_CHANNEL_RED, 8, 4);
+			addSample(info, KHR_DF_CHANNEL_ALPHA, 12, 4);
+			valid = setPackedFormat(info, VK_FORMAT_A4R4G4B4_UNORM_PACK16, 2, type);
+			break;
+		case Texture::Format::R5G6B5:
+			addSample(info, KHR_DF_CHANNEL_BLUE, 0, 5);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 5, 6);
+			addSample(info, KHR_DF_CHANNEL_RED, 11, 5);
+			valid = setPackedFormat(info, VK_FORMAT_R5G6B5_UNORM_PACK16, 2, type);
+			break;
+		case Texture::Format::B5G6R5:
+			addSample(info, KHR_DF_CHANNEL_RED, 0, 5);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 5, 6);
+			addSample(info, KHR_DF_CHANNEL_BLUE, 11, 5);
+			valid = setPackedFormat(info, VK_FORMAT_B5G6R5_UNORM_PACK16, 2, type);
+			break;
+		case Texture::Format::R5G5B5A1:
+			addSample(info, KHR_DF_CHANNEL_ALPHA, 0, 1);
+			addSample(info, KHR_DF_CHANNEL_BLUE, 1, 5);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 6, 5);
+			addSample(info, KHR_DF_CHANNEL_RED, 11, 5);
+			valid = setPackedFormat(info, VK_FORMAT_R5G5B5A1_UNORM_PACK16, 2, type);
+			break;
+		case Texture::Format::B5G5R5A1:
+			addSample(info, KHR_DF_CHANNEL_ALPHA, 0, 1);
+			addSample(info, KHR_DF_CHANNEL_RED, 1, 5);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 6, 5);
+			addSample(info, KHR_DF_CHANNEL_BLUE, 11, 5);
+			valid = setPackedFormat(info, VK_FORMAT_B5G5R5A1_UNORM_PACK16, 2, type);
+			break;
+		case Texture::Format::A1R5G5B5:
+			addSample(info, KHR_DF_CHANNEL_BLUE, 0, 5);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 5, 5);
+			addSample(info, KHR_DF_CHANNEL_RED, 10, 5);
+			addSample(info, KHR_DF_CHANNEL_ALPHA, 15, 1);
+			valid = setPackedFormat(info, VK_FORMAT_A1R5G5B5_UNORM_PACK16, 2, type);
+			break;
+		case Texture::Format::R8:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED}, 8);
+			info.vkFormat = typedVkFormat(VK_FORMAT_R8_UNORM, type, false);
+			valid = type != Texture::Type::Float;
+			break;
+		case Texture::Format::R8G8:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED, KHR_DF_CHANNEL_GREEN}, 8);
+			info.vkFormat = typedVkFormat(VK_FORMAT_R8G8_UNORM, type, false);
+			valid = type != Texture::Type::Float;
+			break;
+		case Texture::Format::R8G8B8:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED, KHR_DF_CHANNEL_GREEN,
+				KHR_DF_CHANNEL_BLUE}, 8);
+			info.vkFormat = typedVkFormat(VK_FORMAT_R8G8B8_UNORM, type, srgb);
+			valid = type != Texture::Type::Float;
+			break;
+		case Texture::Format::B8G8R8:
+			addChannelSamples(info, {KHR_DF_CHANNEL_BLUE, KHR_DF_CHANNEL_GREEN,
+				KHR_DF_CHANNEL_RED}, 8);
+			info.vkFormat = typedVkFormat(VK_FORMAT_B8G8R8_UNORM, type, srgb);
+			valid = type != Texture::Type::Float;
+			break;
+		case Texture::Format::R8G8B8A8:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED, KHR_DF_CHANNEL_GREEN,
+				KHR_DF_CHANNEL_BLUE, KHR_DF_CHANNEL_ALPHA}, 8);
+			info.vkFormat = typedVkFormat(VK_FORMAT_R8G8B8A8_UNORM, type, srgb);
+			valid = type != Texture::Type::Float;
+			break;
+		case Texture::Format::B8G8R8A8:
+			addChannelSamples(info, {KHR_DF_CHANNEL_BLUE, KHR_DF_CHANNEL_GREEN,
+				KHR_DF_CHANNEL_RED, KHR_DF_CHANNEL_ALPHA}, 8);
+			info.vkFormat = typedVkFormat(VK_FORMAT_B8G8R8A8_UNORM, type, srgb);
+			valid = type != Texture::Type::Float;
+			break;
+		case Texture::Format::A2R10G10B10:
+			addSample(info, KHR_DF_CHANNEL_BLUE, 0, 10);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 10, 10);
+			addSample(info, KHR_DF_CHANNEL_RED, 20, 10);
+			addSample(info, KHR_DF_CHANNEL_ALPHA, 30, 2);
+			info.vkFormat = typedVkFormat(VK_FORMAT_A2R10G10B10_UNORM_PACK32, type, false);
+			info.typeSize = 4;
+			valid = type == Texture::Type::UNorm || type == Texture::Type::UInt;
+			break;
+		case Texture::Format::A2B10G10R10:
+			addSample(info, KHR_DF_CHANNEL_RED, 0, 10);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 10, 10);
+			addSample(info, KHR_DF_CHANNEL_BLUE, 20, 10);
+			addSample(info, KHR_DF_CHANNEL_ALPHA, 30, 2);
+			info.vkFormat = typedVkFormat(VK_FORMAT_A2B10G10R10_UNORM_PACK32, type, false);
+			info.typeSize = 4;
+			valid = type == Texture::Type::UNorm || type == Texture::Type::UInt;
+			break;
+		case Texture::Format::R16:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED}, 16);
+			info.vkFormat = typedVkFormat(VK_FORMAT_R16_UNORM, type, false);
+			info.typeSize = 2;
+			valid = type != Texture::Type::UFloat;
+			break;
+		case Texture::Format::R16G16:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED, KHR_DF_CHANNEL_GREEN}, 16);
+			info.vkFormat = typedVkFormat(VK_FORMAT_R16G16_UNORM, type, false);
+			info.typeSize = 2;
+			valid = type != Texture::Type::UFloat;
+			break;
+		case Texture::Format::R16G16B16:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED, KHR_DF_CHANNEL_GREEN,
+				KHR_DF_CHANNEL_BLUE}, 16);
+			info.vkFormat = typedVkFormat(VK_FORMAT_R16G16B16_UNORM, type, false);
+			info.typeSize = 2;
+			valid = type != Texture::Type::UFloat;
+			break;
+		case Texture::Format::R16G16B16A16:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED, KHR_DF_CHANNEL_GREEN,
+				KHR_DF_CHANNEL_BLUE, KHR_DF_CHANNEL_ALPHA}, 16);
+			info.vkFormat = typedVkFormat(VK_FORMAT_R16G16B16A16_UNORM, type, false);
+			info.typeSize = 2;
+			valid = type != Texture::Type::UFloat;
+			break;
+		case Texture::Format::R32:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED}, 32);
+			info.vkFormat = typedVkFormat32(VK_FORMAT_R32_UINT, type);
+			info.typeSize = 4;
+			valid = info.vkFormat != 0;
+			break;
+		case Texture::Format::R32G32:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED, KHR_DF_CHANNEL_GREEN}, 32);
+			info.vkFormat = typedVkFormat32(VK_FORMAT_R32G32_UINT, type);
+			info.typeSize = 4;
+			valid = info.vkFormat != 0;
+			break;
+		case Texture::Format::R32G32B32:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED, KHR_DF_CHANNEL_GREEN,
+				KHR_DF_CHANNEL_BLUE}, 32);
+			info.vkFormat = typedVkFormat32(VK_FORMAT_R32G32B32_UINT, type);
+			info.typeSize = 4;
+			valid = info.vkFormat != 0;
+			break;
+		case Texture::Format::R32G32B32A32:
+			addChannelSamples(info, {KHR_DF_CHANNEL_RED, KHR_DF_CHANNEL_GREEN,
+				KHR_DF_CHANNEL_BLUE, KHR_DF_CHANNEL_ALPHA}, 32);
+			info.vkFormat = typedVkFormat32(VK_FORMAT_R32G32B32A32_UINT, type);
+			info.typeSize = 4;
+			valid = info.vkFormat != 0;
+			break;
+		case Texture::Format::B10G11R11_UFloat:
+			addSample(info, KHR_DF_CHANNEL_RED, 0, 11);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 11, 11);
+			addSample(info, KHR_DF_CHANNEL_BLUE, 22, 10);
+			info.vkFormat = VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+			info.typeSize = 4;
+			valid = type == Texture::Type::UFloat;
+			break;
+		case Texture::Format::E5B9G9R9_UFloat:
+		{
+			// Each channel is described by the mantissa followed by the shared exponent.
+			const std::uint8_t channels[] = {KHR_DF_CHANNEL_RED, KHR_DF_CHANNEL_GREEN,
+				KHR_DF_CHANNEL_BLUE};
+			for (unsigned int i = 0; i < 3; ++i)
+			{
+				addSample(info, channels[i], i*9, 9);
+				info.samples[info.sampleCount - 1].upper = 8448;
+
+				addSample(info, channels[i], 27, 5);
+				DfdSample& exponent = info.samples[info.sampleCount - 1];
+				exponent.qualifiers = KHR_DF_SAMPLE_DATATYPE_EXPONENT;
+				exponent.lower = 15;
+				exponent.upper = 31;
+			}
+			info.vkFormat = VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+			info.typeSize = 4;
+			valid = type == Texture::Type::UFloat;
+			break;
+		}
+
+		case Texture::Format::BC1_RGB:
+			info.colorModel = KHR_DF_MODEL_BC1A;
+			addSample(info, KHR_DF_CHANNEL_COLOR, 0, 64);
+			info.vkFormat = VK_FORMAT_BC1_RGB_UNORM_BLOCK + srgb;
+			valid = type == Texture::Type::UNorm;
+			break;
+		case Texture::Format::BC1_RGBA:
+			info.colorModel = KHR_DF_MODEL_BC1A;
+			addSample(info, KHR_DF_CHANNEL_BC1A_ALPHAPRESENT, 0, 64);
+			info.vkFormat = VK_FORMAT_BC1_RGBA_UNORM_BLOCK + srgb;
+			valid = type == Texture::Type::UNorm;
+			break;
+		case Texture::Format::BC2:
+			info.colorModel = KHR_DF_MODEL_BC2;
+			addSample(info, KHR_DF_CHANNEL_ALPHA, 0, 64);
+			addSample(info, KHR_DF_CHANNEL_COLOR, 64, 64);
+			info.vkFormat = VK_FORMAT_BC2_UNORM_BLOCK + srgb;
+			valid = type == Texture::Type::UNorm;
+			break;
+		case Texture::Format::BC3:
+			info.colorModel = KHR_DF_MODEL_BC3;
+			addSample(info, KHR_DF_CHANNEL_ALPHA, 0, 64);
+			addSample(info, KHR_DF_CHANNEL_COLOR, 64, 64);
+			info.vkFormat = VK_FORMAT_BC3_UNORM_BLOCK + srgb;
+			valid = type == Texture::Type::UNorm;
+			break;
+		case Texture::Format::BC4:
+			info.colorModel = KHR_DF_MODEL_BC4;
+			addSample(info, KHR_DF_CHANNEL_RED, 0, 64);
+			info.vkFormat = VK_FORMAT_BC4_UNORM_BLOCK + (type == Texture::Type::SNorm);
+			valid = type == Texture::Type::UNorm || type == Texture::Type::SNorm;
+			break;
+		case Texture::Format::BC5:
+			info.colorModel = KHR_DF_MODEL_BC5;
+			addSample(info, KHR_DF_CHANNEL_RED, 0, 64);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 64, 64);
+			info.vkFormat = VK_FORMAT_BC5_UNORM_BLOCK + (type == Texture::Type::SNorm);
+			valid = type == Texture::Type::UNorm || type == Texture::Type::SNorm;
+			break;
+		case Texture::Format::BC6H:
+			info.colorModel = KHR_DF_MODEL_BC6H;
+			addSample(info, KHR_DF_CHANNEL_COLOR, 0, 128);
+			info.vkFormat = VK_FORMAT_BC6H_UFLOAT_BLOCK + (type == Texture::Type::Float);
+			valid = type == Texture::Type::UFloat || type == Texture::Type::Float;
+			break;
+		case Texture::Format::BC7:
+			info.colorModel = KHR_DF_MODEL_BC7;
+			addSample(info, KHR_DF_CHANNEL_COLOR, 0, 128);
+			info.vkFormat = VK_FORMAT_BC7_UNORM_BLOCK + srgb;
+			valid = type == Texture::Type::UNorm;
+			break;
+		case Texture::Format::ETC1:
+			// Vulkan doesn't have a separate ETC1 format since ETC2 decoders also accept ETC1
+			// data. The DFD still identifies the data as ETC1.
+			info.colorModel = KHR_DF_MODEL_ETC1;
+			addSample(info, KHR_DF_CHANNEL_COLOR, 0, 64);
+			info.vkFormat = VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+			valid = type == Texture::Type::UNorm && !srgb;
+			break;
+		case Texture::Format::ETC2_R8G8B8:
+			info.colorModel = KHR_DF_MODEL_ETC2;
+			addSample(info, KHR_DF_CHANNEL_ETC2_COLOR, 0, 64);
+			info.vkFormat = VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK + srgb;
+			valid = type == Texture::Type::UNorm;
+			break;
+		case Texture::Format::ETC2_R8G8B8A1:
+			info.colorModel = KHR_DF_MODEL_ETC2;
+			addSample(info, KHR_DF_CHANNEL_ETC2_COLOR, 0, 64);
+			info.vkFormat = VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK + srgb;
+			valid = type == Texture::Type::UNorm;
+			break;
+		case Texture::Format::ETC2_R8G8B8A8:
+			info.colorModel = KHR_DF_MODEL_ETC2;
+			addSample(info, KHR_DF_CHANNEL_ALPHA, 0, 64);
+			addSample(info, KHR_DF_CHANNEL_ETC2_COLOR, 64, 64);
+			info.vkFormat = VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK + srgb;
+			valid = type == Texture::Type::UNorm;
+			break;
+		case Texture::Format::EAC_R11:
+			info.colorModel = KHR_DF_MODEL_ETC2;
+			addSample(info, KHR_DF_CHANNEL_RED, 0, 64);
+			info.vkFormat = VK_FORMAT_EAC_R11_UNORM_BLOCK + (type == Texture::Type::SNorm);
+			valid = type == Texture::Type::UNorm || type == Texture::Type::SNorm;
+			break;
+		case Texture::Format::EAC_R11G11:
+			info.colorModel = KHR_DF_MODEL_ETC2;
+			addSample(info, KHR_DF_CHANNEL_RED, 0, 64);
+			addSample(info, KHR_DF_CHANNEL_GREEN, 64, 64);
+			info.vkFormat = VK_FORMAT_EAC_R11G11_UNORM_BLOCK + (type == Texture::Type::SNorm);
+			valid = type == Texture::Type::UNorm || type == Texture::Type::SNorm;
+			break;
+		case Texture::Format::ASTC_4x4:
+		case Texture::Format::ASTC_5x4:
+		case Texture::Format::ASTC_5x5:
+		case Texture::Format::ASTC_6x5:
+		case Texture::Format::ASTC_6x6:
+		case Texture::Format::ASTC_8x5:
+		case Texture::Format::ASTC_8x6:
+		case Texture::Format::ASTC_8x8:
+		case Texture::Format::ASTC_10x5:
+		case Texture::Format::ASTC_10x6:
+		case Texture::Format::ASTC_10x8:
+		case Texture::Format::ASTC_10x10:
+		case Texture::Format::ASTC_12x10:
+		case Texture::Format::ASTC_12x12:
+		{
+			// The ASTC formats are in the same order for Vulkan, with the UNorm and sRGB variants
+			// interleaved.
+			auto index = static_cast<std::uint32_t>(format) -
+				static_cast<std::uint32_t>(Texture::Format::ASTC_4x4);
+			info.colorModel = KHR_DF_MODEL_ASTC;
+			addSample(info, KHR_DF_CHANNEL_COLOR, 0, 128);
+			if (type == Texture::Type::UFloat)
+			{
+				info.vkFormat = VK_FORMAT_ASTC_4x4_SFLOAT_BLOCK + index;
+				info.samples[0].qualifiers =
+					KHR_DF_SAMPLE_DATATYPE_SIGNED | KHR_DF_SAMPLE_DATATYPE_FLOAT;
+				info.samples[0].lower = 0xBF800000;
+				info.samples[0].upper = 0x3F800000;
+				valid = true;
+			}
+			else
+			{
+				info.vkFormat = VK_FORMAT_ASTC_4x4_UNORM_BLOCK + index*2 + srgb;
+				valid = type == Texture::Type::UNorm;
+			}
+			break;
+		}
+		case Texture::Format::PVRTC1_RGB_2BPP:
+		case Texture::Format::PVRTC1_RGBA_2BPP:
+			info.colorModel = KHR_DF_MODEL_PVRTC;
+			addSample(info, KHR_DF_CHANNEL_COLOR, 0, 64);
+			info.vkFormat = VK_FORMAT_PVRTC1_2BPP_UNORM_BLOCK_IMG + srgb*4;
+			valid = type == Texture::Type::UNorm;
+			break;
+		case Texture::Format::PVRTC1_RGB_4BPP:
+		case Texture::Format::PVRTC1_RGBA_4BPP:
+			info.colorModel = KHR_DF_MODEL_PVRTC;
+			addSample(info, KHR_DF_CHANNEL_COLOR, 0, 64);
+			info.vkFormat = VK_FORMAT_PVRTC1_4BPP_UNORM_BLOCK_IMG + srgb*4;
+			valid = type == Texture::Type::UNorm;
+			break;
+		case Texture::Format::PVRTC2_RGBA_2BPP:
+			info.colorModel = KHR_DF_MODEL_PVRTC2;
+			addSample(info, KHR_DF_CHANNEL_COLOR, 0, 64);
+			info.vkFormat = VK_FORMAT_PVRTC2_2BPP_UNORM_BLOCK_IMG + srgb*4;
+			valid = type == Texture::Type::UNorm;
+			break;
+		case Texture::Format::PVRTC2_RGBA_4BPP:
+			info.colorModel = KHR_DF_MODEL_PVRTC2;
+			addSample(info, KHR_DF_CHANNEL_COLOR, 0, 64);
+			info.vkFormat = VK_FORMAT_PVRTC2_4BPP_UNORM_BLOCK_IMG + srgb*4;
+			valid = type == Texture::Type::UNorm;
+			break;
+
+		// A8B8G8R8 is stored with alpha in the first byte, which doesn't match any Vulkan format.
+		default:
+			return false;
+	}
+
+	if (!valid || info.vkFormat == 0)
+		return false;
+
+	setSampleRanges(info, type);
+	return true;
+}
+
+// Least common multiple of the block size and 4, which is the required alignment for each mip
+// level without supercompression.
+std::size_t levelAlignment(unsigned int blockSize)
+{
+	switch (blockSize % 4)
+	{
+		case 0:
+			return blockSize;
+		case 2:
+			return blockSize*2;
+		default:
+			return blockSize*4;
+	}
+}
+
+std::size_t levelSize(const Texture& texture, unsigned int level)
+{
+	std::size_t size = 0;
+	for (unsigned int depth = 0; depth < texture.depth(level); ++depth)
+	{
+		for (unsigned int face = 0; face < texture.faceCount(); ++face)
+			size += texture.dataSize(static_cast<Texture::CubeFace>(face), level, depth);
+	}
+	return size;
+}
+
+#if CUTTLEFISH_HAS_ZSTD
+
+// Compresses each mip level with Zstandard, one job per mip level.
+class ZstdLevelJobs : public JobProcessor
+{
+public:
+	ZstdLevelJobs(const Texture& texture, std::vector<LevelData>& levels, int compressionLevel)
+		: m_texture(texture)
+		, m_levels(levels)
+		, m_compressionLevel(compressionLevel)
+	{
+	}
+
+	unsigned int jobsX() const override {return static_cast<unsigned int>(m_levels.size());}
+	unsigned int jobsY() const override {return 1;}
+
+	void process(unsigned int x, unsigned int, ThreadData*) override
+	{
+		// The images for a mip level are normally adjacent in memory, in which case they can be
+		// compressed in place.
+		LevelData& level = m_levels[x];
+		auto levelData = reinterpret_cast<const std::uint8_t*>(
+			m_texture.data(Texture::CubeFace::PosX, x, 0));
+		std::vector<std::uint8_t> levelCopy;
+		std::size_t offset = 0;
+		for (unsigned int depth = 0; depth < m_texture.depth(x); ++depth)
+		{
+			for (unsigned int face = 0; face < m_texture.faceCount(); ++face)
+			{
+				auto cubeFace = static_cast<Texture::CubeFace>(face);
+				auto data = reinterpret_cast<const std::uint8_t*>(
+					m_texture.data(cubeFace, x, depth));
+				std::size_t size = m_texture.dataSize(cubeFace, x, depth);
+				if (levelCopy.empty() && data != levelData + offset)
+				{
+					levelCopy.resize(level.uncompressedSize);
+					std::memcpy(levelCopy.data(), levelData, offset);
+				}
+
+				if (!levelCopy.empty())
+					std::memcpy(levelCopy.data() + offset, data, size);
+				offset += size;
+			}
+		}
+		assert(offset == level.uncompressedSize);
+		if (!levelCopy.empty())
+			levelData = levelCopy.data();
+
+		level.compressed.resize(ZSTD_compressBound(level.uncompressedSize));
+		std::size_t compressedSize = ZSTD_compress(level.compressed.data(),
+			level.compressed.size(), levelData, level.uncompressedSize, m_compressionLevel);
+		if (ZSTD_isError(compressedSize))
+		{
+			level.compressed.clear();
+			return;
+		}
+
+		level.compressed.resize(compressedSize);
+		level.size = compressedSize;
+	}
+
+private:
+	const Texture& m_texture;
+	std::vector<LevelData>& m_levels;
+	int m_compressionLevel;
+};
+
+#endif // CUTTLEFISH_HAS_ZSTD
+
+} // namespace
+
+bool isValidForKtx2(Texture::Format format, Texture::Type type)
+{
+	Ktx2FormatInfo info;
+	return getFormatInfo(info, format, type, ColorSpace::Linear);
+}
+
+Texture::SaveResult saveKtx2(const Texture& texture, unsigned int zstdLevel,
+	OutputSlices& output)
+{
+	static_assert(sizeof(unsigned int) == sizeof(std::uint32_t), "unexpected integer size");
+
+	Ktx2FormatInfo info;
+	if (!getFormatInfo(info, texture.format(), texture.type(), texture.colorSpace()))
+		return Texture::SaveResult::Unsupported;
+
+	unsigned int levelCount = texture.mipLevelCount();
+	std::vector<LevelData> levels(levelCount);
+	for (unsigned int level = 0; level < levelCount; ++level)
+	{
+		levels[level].uncompressedSize = levelSize(texture, level);
+		levels[level].size = levels[level].uncompressedSize;
+	}
+
+	bool supercompressed = zstdLevel > 0;
+	if (supercompressed)
+	{
+#if CUTTLEFISH_HAS_ZSTD
+		// Most of the data is in the first mip levels, so compress each level on its own thread.
+		ZstdLevelJobs jobs(texture, levels,
+			std::min(static_cast<int>(zstdLevel), ZSTD_maxCLevel()));
+		jobs.run(std::max(std::thread::hardware_concurrency(), 1U));
+		for (const LevelData& level : levels)
+		{
+			if (level.compressed.empty())
+				return Texture::SaveResult::WriteError;
+		}
+#else
+		return Texture::SaveResult::Unsupported;
+#endif
+	}
+
+	unsigned int blockSize = Texture::blockSize(texture.format());
+	std::uint32_t dfdOffset = headerSize + levelIndexEntrySize*levelCount;
+	std::uint32_t dfdSize = static_cast<std::uint32_t>(sizeof(std::uint32_t)) +
+		basicDescriptorHeaderSize + sampleSize*info.sampleCount;
+	std::uint32_t kvdOffset = dfdOffset + dfdSize;
+	auto keyValueSize = static_cast<std::uint32_t>(sizeof(writerKey) + sizeof(writerValue));
+	std::uint32_t keyValuePadding = (4 - keyValueSize % 4) % 4;
+	std::uint32_t kvdSize = static_cast<std::uint32_t>(sizeof(std::uint32_t)) + keyValueSize +
+		keyValuePadding;
+
+	// Mip levels are stored from smallest to largest so the file can be streamed with the small
+	// levels available first.
+	std::size_t alignment = supercompressed ? 1 : levelAlignment(blockSize);
+	std::uint64_t offset = kvdOffset + kvdSize;
+	for (unsigned int level = levelCount; level-- > 0;)
+	{
+		offset = (offset + alignment - 1)/alignment*alignment;
+		levels[level].offset = offset;
+		offset += levels[level].size;
+	}
+
+	std::ostream& stream = output.stream();
+	std::size_t startSize = output.size();
+	if (!stream.write(identifier, sizeof(identifier)))
+		return Texture::SaveResult::WriteError;
+
+	const std::uint32_t header[] =
+	{
+		info.vkFormat,
+		info.typeSize,
+		texture.width(),
+		texture.dimension() == Texture::Dimension::Dim1D ? 0U : texture.height(),
+		texture.dimension() == Texture::Dimension::Dim3D ? texture.depth() : 0U,
+		texture.isArray() ? texture.depth() : 0U,
+		texture.faceCount(),
+		levelCount,
+		supercompressed ? KTX2_SUPERCOMPRESSION_ZSTD : KTX2_SUPERCOMPRESSION_NONE,
+		dfdOffset,
+		dfdSize,
+		kvdOffset,
+		kvdSize
+	};
+	if (!write(stream, header))
+		return Texture::SaveResult::WriteError;
+
+	// No supercompression global data.
+	const std::uint64_t sgdIndex[] = {0, 0};
+	if (!write(stream, sgdIndex))
+		return Texture::SaveResult::WriteError;
+
+	for (const LevelData& level : levels)
+	{
+		const std::uint64_t levelIndex[] = {level.offset, level.size, level.uncompressedSize};
+		if (!write(stream, levelIndex))
+			return Texture::SaveResult::WriteError;
+	}
+
+	// Basic data format descriptor.
+	const std::uint32_t descriptorHeader[] =
+	{
+		dfdSize,
+		0, // Khronos vendor and basic descriptor type.
+		KHR_DF_VERSIONNUMBER_1_3 | (dfdSize - static_cast<std::uint32_t>(sizeof(std::uint32_t)))
+			<< 16
+	};
+	if (!write(stream, descriptorHeader))
+		return Texture::SaveResult::WriteError;
+
+	bool srgb = texture.colorSpace() == ColorSpace::sRGB;
+	const std::uint8_t descriptorModel[] =
+	{
+		info.colorModel,
+		KHR_DF_PRIMARIES_BT709,
+		static_cast<std::uint8_t>(srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR),
+		static_cast<std::uint8_t>(texture.alphaType() == Texture::Alpha::PreMultiplied ?
+			KHR_DF_FLAG_ALPHA_PREMULTIPLIED : 0),
+		static_cast<std::uint8_t>(Texture::blockWidth(texture.format()) - 1),
+		static_cast<std::uint8_t>(Texture::blockHeight(texture.format()) - 1),
+		0,
+		0,
+		static_cast<std::uint8_t>(blockSize),
+		0, 0, 0, 0, 0, 0, 0
+	};
+	if (!write(stream, descriptorModel))
+		return Texture::SaveResult::WriteError;
+
+	for (unsigned int i = 0; i < info.sampleCount; ++i)
+	{
+		const DfdSample& sample = info.samples[i];
+		// Alpha is always linear, even with the sRGB transfer function.
+		std::uint8_t qualifiers = sample.qualifiers;
+		if (srgb && sample.channel == KHR_DF_CHANNEL_ALPHA)
+			qualifiers |= KHR_DF_SAMPLE_DATATYPE_LINEAR;
+
+		const std::uint8_t sampleInfo[] =
+		{
+			static_cast<std::uint8_t>(sample.bitOffset & 0xFF),
+			static_cast<std::uint8_t>(sample.bitOffset >> 8),
+			static_cast<std::uint8_t>(sample.bitLength - 1),
+			static_cast<std::uint8_t>(sample.channel | qualifiers),
+			0, 0, 0, 0 // Sample position.
+		};
+		if (!write(stream, sampleInfo) || !write(stream, sample.lower) ||
+			!write(stream, sample.upper))
+		{
+			return Texture::SaveResult::WriteError;
+		}
+	}
+
+	// Key/value data.
+	if (!write(stream, keyValueSize) || !stream.write(writerKey, sizeof(writerKey)) ||
+		!stream.write(writerValue, sizeof(writerValue)))
+	{
+		return Texture::SaveResult::WriteError;
+	}
+	output.addPadding(keyValuePadding);
+	assert(output.size() - startSize == kvdOffset + kvdSize);
+
+	for (unsigned int level = levelCount; level-- > 0;)
+	{
+		LevelData& levelData = levels[level];
+		output.addPadding(static_cast<std::size_t>(levelData.offset - (output.size() - startSize)));
+		if (supercompressed)
+		{
+			output.add(std::move(levelData.compressed));
+			continue;
+		}
+
+		for (unsigned int depth = 0; depth < texture.depth(level); ++depth)
+		{
+			for (unsigned int face = 0; face < texture.faceCount(); ++face)
+			{
+				auto cubeFace = static_cast<Texture::CubeFace>(face);
+				output.add(texture.data(cubeFace, level, depth),
+					texture.dataSize(cubeFace, level, depth));
+			}
+		}
+	}
+
+	return Texture::SaveResult::Success;
+}
+
+} // namespace cuttlefish
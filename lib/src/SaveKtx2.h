@@ -0,0 +1,32 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Texture.h>
+#include "OutputSlices.h"
+
+namespace cuttlefish
+{
+
+bool isValidForKtx2(Texture::Format format, Texture::Type type);
+// Adds the header and the texture data to output. Each mip level is supercompressed with Zstandard
+// when zstdLevel is non-zero.
+Texture::SaveResult saveKtx2(const Texture& texture, unsigned int zstdLevel,
+	OutputSlices& output);
+
+} // namespace cuttlefish
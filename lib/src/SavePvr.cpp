@@ -106,12 +106,12 @@ enum PvrSpecialFormat
 };
 static_assert(PvrSpecialFormatCount == 51, "invalid PVR special format enum");
 
-static PvrChannelType getChannelType(const Texture& texture)
+static PvrChannelType getChannelType(Texture::Format format, Texture::Type type)
 {
-	switch (texture.type())
+	switch (type)
 	{
 		case Texture::Type::UNorm:
-			switch (texture.format())
+			switch (format)
 			{
 				case Texture::Format::R4G4:
 				case Texture::Format::R8:
@@ -150,7 +150,7 @@ static PvrChannelType getChannelType(const Texture& texture)
 					return PvrChannelType_UByteN;
 			}
 		case Texture::Type::SNorm:
-			switch (texture.format())
+			switch (format)
 			{
 				case Texture::Format::R4G4:
 				case Texture::Format::R8:
@@ -189,7 +189,7 @@ static PvrChannelType getChannelType(const Texture& texture)
 					return PvrChannelType_SByteN;
 			}
 		case Texture::Type::UInt:
-			switch (texture.format())
+			switch (format)
 			{
 				case Texture::Format::R4G4:
 				case Texture::Format::R8:
@@ -224,7 +224,7 @@ static PvrChannelType getChannelType(const Texture& texture)
 					return PvrChannelType_UByte;
 			}
 		case Texture::Type::Int:
-			switch (texture.format())
+			switch (format)
 			{
 				case Texture::Format::R4G4:
 				case Texture::Format::R8:
@@ -475,7 +475,41 @@ bool isValidForPvr(Texture::Format format, Texture::Type)
 	return getPixelFormat(pixelFormat, format, Texture::Alpha::Standard);
 }
 
-Texture::SaveResult savePvr(const Texture& texture, std::ostream& stream)
+bool findPvrFormat(Texture::Format& outFormat, Texture::Type& outType, std::uint64_t pixelFormat,
+	std::uint32_t channelType, bool preMultiplied, bool bc1Alpha)
+{
+	Texture::Alpha alphaType = preMultiplied ? Texture::Alpha::PreMultiplied :
+		Texture::Alpha::Standard;
+	for (int i = static_cast<int>(Texture::Format::R4G4);
+		i <= static_cast<int>(Texture::Format::PVRTC2_RGBA_4BPP); ++i)
+	{
+		auto format = static_cast<Texture::Format>(i);
+		std::uint64_t curPixelFormat;
+		if (!getPixelFormat(curPixelFormat, format, alphaType) || curPixelFormat != pixelFormat)
+			continue;
+
+		// BC1 with and without alpha share the same pixel format.
+		if (format == Texture::Format::BC1_RGB && bc1Alpha)
+			continue;
+
+		for (int j = static_cast<int>(Texture::Type::UNorm);
+			j <= static_cast<int>(Texture::Type::Float); ++j)
+		{
+			auto type = static_cast<Texture::Type>(j);
+			if (Texture::isFormatValid(format, type) &&
+				static_cast<std::uint32_t>(getChannelType(format, type)) == channelType)
+			{
+				outFormat = format;
+				outType = type;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+Texture::SaveResult savePvrHeader(const Texture& texture, std::ostream& stream)
 {
 	static_assert(sizeof(0U) == sizeof(std::uint32_t), "unexpected integer size");
 	static_assert(sizeof(unsigned int) == sizeof(std::uint32_t), "unexpected integer size");
@@ -503,7 +537,7 @@ Texture::SaveResult savePvr(const Texture& texture, std::ostream& stream)
 	if (!write(stream, colorSpace))
 		return Texture::SaveResult::WriteError;
 
-	std::uint32_t channelType = getChannelType(texture);
+	std::uint32_t channelType = getChannelType(texture.format(), texture.type());
 	if (!write(stream, channelType))
 		return Texture::SaveResult::WriteError;
 
@@ -581,17 +615,23 @@ Texture::SaveResult savePvr(const Texture& texture, std::ostream& stream)
 			return Texture::SaveResult::WriteError;
 	}
 
+	return Texture::SaveResult::Success;
+}
+
+Texture::SaveResult savePvr(const Texture& texture, OutputSlices& output)
+{
+	Texture::SaveResult result = savePvrHeader(texture, output.stream());
+	if (result != Texture::SaveResult::Success)
+		return result;
+
 	for (unsigned int level = 0; level < texture.mipLevelCount(); ++level)
 	{
 		for (unsigned int depth = 0; depth < texture.depth(level); ++depth)
 		{
 			for (unsigned int face = 0; face < texture.faceCount(); ++face)
 			{
-				stream.write(reinterpret_cast<const char*>(texture.data(
-					static_cast<Texture::CubeFace>(face), level, depth)), texture.dataSize(
-					static_cast<Texture::CubeFace>(face), level, depth));
-				if (!stream.good())
-					return Texture::SaveResult::WriteError;
+				output.add(texture.data(static_cast<Texture::CubeFace>(face), level, depth),
+					texture.dataSize(static_cast<Texture::CubeFace>(face), level, depth));
 			}
 		}
 	}
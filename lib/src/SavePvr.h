@@ -18,11 +18,21 @@
 
 #include <cuttlefish/Config.h>
 #include <cuttlefish/Texture.h>
+#include "OutputSlices.h"
+#include <cstdint>
 
 namespace cuttlefish
 {
 
 bool isValidForPvr(Texture::Format format, Texture::Type type);
-Texture::SaveResult savePvr(const Texture& texture, std::ostream& stream);
+// Writes only the header, leaving the stream positioned at the start of the image data.
+Texture::SaveResult savePvrHeader(const Texture& texture, std::ostream& stream);
+// Adds the header and references to the texture data to output.
+Texture::SaveResult savePvr(const Texture& texture, OutputSlices& output);
+
+// Finds the format and type that are saved with the pixel format and channel type. bc1Alpha
+// selects between BC1 with and without alpha, which share the same pixel format.
+bool findPvrFormat(Texture::Format& outFormat, Texture::Type& outType, std::uint64_t pixelFormat,
+	std::uint32_t channelType, bool preMultiplied, bool bc1Alpha);
 
 } // namespace cuttlefish
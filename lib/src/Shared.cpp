@@ -15,8 +15,18 @@
  */
 
 #include "Shared.h"
+#include <atomic>
+#include <cstdio>
 #include <istream>
 
+#if CUTTLEFISH_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace cuttlefish
 {
 
@@ -55,4 +65,31 @@ void readStreamData(std::vector<std::uint8_t>& outData, std::istream& stream)
 	stream.read(reinterpret_cast<char*>(outData.data()), size);
 }
 
+std::string tempFileName(const char* fileName)
+{
+	static std::atomic<unsigned int> counter(0);
+#if CUTTLEFISH_WINDOWS
+	unsigned long processId = GetCurrentProcessId();
+#else
+	long processId = getpid();
+#endif
+	return std::string(fileName) + "." + std::to_string(processId) + "." +
+		std::to_string(counter++) + ".tmp";
+}
+
+bool replaceFile(const char* tempFileName, const char* fileName)
+{
+#if CUTTLEFISH_WINDOWS
+	if (MoveFileExA(tempFileName, fileName, MOVEFILE_REPLACE_EXISTING))
+#else
+	if (std::rename(tempFileName, fileName) == 0)
+#endif
+	{
+		return true;
+	}
+
+	std::remove(tempFileName);
+	return false;
+}
+
 } // namespace cuttlefish
@@ -16,9 +16,11 @@
 
 #pragma once
 
+#include <cuttlefish/Texture.h>
 #include <cstdint>
 #include <iosfwd>
 #include <ostream>
+#include <string>
 #include <vector>
 
 #define FOURCC(a, b, c, d) ((std::uint32_t)(a) | ((std::uint32_t)(b) << 8) | \
@@ -36,6 +38,22 @@ inline float clamp(float v, float minVal, float maxVal)
 	return v;
 }
 
+inline bool isPvrtc(Texture::Format format)
+{
+	switch (format)
+	{
+		case Texture::Format::PVRTC1_RGB_2BPP:
+		case Texture::Format::PVRTC1_RGBA_2BPP:
+		case Texture::Format::PVRTC1_RGB_4BPP:
+		case Texture::Format::PVRTC1_RGBA_4BPP:
+		case Texture::Format::PVRTC2_RGBA_2BPP:
+		case Texture::Format::PVRTC2_RGBA_4BPP:
+			return true;
+		default:
+			return false;
+	}
+}
+
 template <typename T>
 bool write(std::ostream& stream, const T& value)
 {
@@ -45,4 +63,13 @@ bool write(std::ostream& stream, const T& value)
 
 void readStreamData(std::vector<std::uint8_t>& outData, std::istream& stream);
 
+// Unique name for a temporary file in the same directory as fileName. Files are written to a
+// temporary file first and then moved over fileName with replaceFile(), which keeps the original
+// file intact if writing fails and allows replacing a file that's memory mapped by a loaded
+// texture.
+std::string tempFileName(const char* fileName);
+
+// Replaces fileName with tempFileName, removing the temporary file on failure.
+bool replaceFile(const char* tempFileName, const char* fileName);
+
 } // namespace cuttlefish
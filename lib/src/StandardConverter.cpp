@@ -21,7 +21,7 @@ namespace cuttlefish
 
 void R4G4Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint8_t* curData = reinterpret_cast<std::uint8_t*>(data().data()) + x*batchSize;
+	std::uint8_t* curData = reinterpret_cast<std::uint8_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -44,7 +44,7 @@ void R4G4Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void R4G4B4A4Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data().data()) + x*batchSize;
+	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -69,7 +69,7 @@ void R4G4B4A4Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void B4G4R4A4Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data().data()) + x*batchSize;
+	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -94,7 +94,7 @@ void B4G4R4A4Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void A4R4G4B4Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data().data()) + x*batchSize;
+	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -119,7 +119,7 @@ void A4R4G4B4Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void R5G6B5Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data().data()) + x*batchSize;
+	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -143,7 +143,7 @@ void R5G6B5Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void B5G6R5Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data().data()) + x*batchSize;
+	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -167,7 +167,7 @@ void B5G6R5Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void R5G5B5A1Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data().data()) + x*batchSize;
+	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -192,7 +192,7 @@ void R5G5B5A1Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void B5G5R5A1Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data().data()) + x*batchSize;
+	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -217,7 +217,7 @@ void B5G5R5A1Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void A1R5G5B5Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data().data()) + x*batchSize;
+	std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -242,7 +242,7 @@ void A1R5G5B5Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void B8G8R8Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint8_t* curData = reinterpret_cast<std::uint8_t*>(data().data()) + x*batchSize*3;
+	std::uint8_t* curData = reinterpret_cast<std::uint8_t*>(data()) + x*batchSize*3;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -268,7 +268,7 @@ void B8G8R8Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void B8G8R8A8Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint8_t* curData = reinterpret_cast<std::uint8_t*>(data().data()) + x*batchSize*4;
+	std::uint8_t* curData = reinterpret_cast<std::uint8_t*>(data()) + x*batchSize*4;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -296,7 +296,7 @@ void B8G8R8A8Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void A8B8G8R8Converter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint8_t* curData = reinterpret_cast<std::uint8_t*>(data().data()) + x*batchSize*4;
+	std::uint8_t* curData = reinterpret_cast<std::uint8_t*>(data()) + x*batchSize*4;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -324,7 +324,7 @@ void A8B8G8R8Converter::process(unsigned int x, unsigned int, ThreadData*)
 
 void A2R10G10B10UNormConverter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data().data()) + x*batchSize;
+	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -349,7 +349,7 @@ void A2R10G10B10UNormConverter::process(unsigned int x, unsigned int, ThreadData
 
 void A2R10G10B10UIntConverter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data().data()) + x*batchSize;
+	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -374,7 +374,7 @@ void A2R10G10B10UIntConverter::process(unsigned int x, unsigned int, ThreadData*
 
 void A2B10G10R10UNormConverter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data().data()) + x*batchSize;
+	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -399,7 +399,7 @@ void A2B10G10R10UNormConverter::process(unsigned int x, unsigned int, ThreadData
 
 void A2B10G10R10UIntConverter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data().data()) + x*batchSize;
+	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -424,7 +424,7 @@ void A2B10G10R10UIntConverter::process(unsigned int x, unsigned int, ThreadData*
 
 void B10R11R11UFloatConverter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data().data()) + x*batchSize;
+	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
@@ -445,7 +445,7 @@ void B10R11R11UFloatConverter::process(unsigned int x, unsigned int, ThreadData*
 
 void E5B9G9R9UFloatConverter::process(unsigned int x, unsigned int, ThreadData*)
 {
-	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data().data()) + x*batchSize;
+	std::uint32_t* curData = reinterpret_cast<std::uint32_t*>(data()) + x*batchSize;
 	unsigned int row = x*batchSize/image().width();
 	const ColorRGBAf* scanline = reinterpret_cast<const ColorRGBAf*>(image().scanline(row));
 	for (unsigned int i = 0; i < batchSize; ++i)
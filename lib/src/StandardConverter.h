@@ -50,7 +50,7 @@ public:
 	explicit StandardConverter(const Image& image)
 		: Converter(image)
 	{
-		data().resize(image.width()*image.height()*sizeof(T)*C);
+		setDataSize(image.width()*image.height()*sizeof(T)*C);
 	}
 
 	unsigned int jobsX() const override
@@ -82,7 +82,7 @@ public:
 	void process(unsigned int x, unsigned int, ThreadData*) override
 	{
 		const T maxVal = std::numeric_limits<T>::max();
-		T* curData = reinterpret_cast<T*>(data().data()) + x*batchSize*C;
+		T* curData = reinterpret_cast<T*>(data()) + x*batchSize*C;
 		unsigned int row = x*batchSize/image().width();
 		const float* scanline = reinterpret_cast<const float*>(image().scanline(row));
 		for (unsigned int i = 0; i < batchSize; ++i)
@@ -123,7 +123,7 @@ public:
 	void process(unsigned int x, unsigned int, ThreadData*) override
 	{
 		const T maxVal = std::numeric_limits<T>::max();
-		T* curData = reinterpret_cast<T*>(data().data()) + x*batchSize*C;
+		T* curData = reinterpret_cast<T*>(data()) + x*batchSize*C;
 		unsigned int row = x*batchSize/image().width();
 		const float* scanline = reinterpret_cast<const float*>(image().scanline(row));
 		for (unsigned int i = 0; i < batchSize; ++i)
@@ -166,7 +166,7 @@ public:
 		const float minVal = static_cast<float>(std::numeric_limits<T>::min());
 		const float maxVal = static_cast<float>(std::numeric_limits<T>::max());
 
-		T* curData = reinterpret_cast<T*>(data().data()) + x*batchSize*C;
+		T* curData = reinterpret_cast<T*>(data()) + x*batchSize*C;
 		unsigned int row = x*batchSize/image().width();
 		const float* scanline = reinterpret_cast<const float*>(image().scanline(row));
 		for (unsigned int i = 0; i < batchSize; ++i)
@@ -206,7 +206,7 @@ public:
 
 	void process(unsigned int x, unsigned int, ThreadData*) override
 	{
-		float* curData = reinterpret_cast<float*>(data().data()) + x*batchSize*C;
+		float* curData = reinterpret_cast<float*>(data()) + x*batchSize*C;
 		unsigned int row = x*batchSize/image().width();
 		const float* scanline = reinterpret_cast<const float*>(image().scanline(row));
 		for (unsigned int i = 0; i < batchSize; ++i)
@@ -243,7 +243,7 @@ public:
 
 	void process(unsigned int x, unsigned int, ThreadData*) override
 	{
-		std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data().data()) + x*batchSize*C;
+		std::uint16_t* curData = reinterpret_cast<std::uint16_t*>(data()) + x*batchSize*C;
 		unsigned int row = x*batchSize/image().width();
 		const float* scanline = reinterpret_cast<const float*>(image().scanline(row));
 
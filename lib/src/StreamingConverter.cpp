@@ -0,0 +1,299 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StreamingConverter.h"
+#include "Converter.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <utility>
+
+namespace cuttlefish
+{
+
+StreamingConverter::StreamingConverter(const Texture& texture, Texture::Quality quality,
+	std::size_t memoryBudget, unsigned int threadCount, BlockCache* blockCache)
+	: m_texture(texture), m_quality(quality), m_threadCount(threadCount),
+	m_blockCache(blockCache), m_blockHeight(Texture::blockHeight(texture.format())),
+	m_stream(nullptr), m_refinedBlocks(0)
+{
+	// Start with the width of the source rows in addition to each mip level.
+	std::size_t totalWidth = texture.width();
+	m_levels.resize(texture.mipLevelCount());
+	for (unsigned int i = 0; i < m_levels.size(); ++i)
+	{
+		Level& level = m_levels[i];
+		level.width = texture.width(i);
+		level.height = texture.height(i);
+		level.dataOffset = 0;
+		level.rowSize = 0;
+		level.rowStride = 0;
+		level.bandStart = 0;
+		level.filledRows = 0;
+		level.receivedRows = 0;
+		level.hasPending = false;
+		totalWidth += level.width;
+	}
+
+	// Each level holds a band of RGBAF pixels, and the source rows are read with the same band
+	// size. The encoded output and conversion of the source rows add at most as much again.
+	std::size_t rowBytes = 2*totalWidth*sizeof(ColorRGBAf);
+	std::size_t bandRows = memoryBudget/rowBytes;
+	bandRows -= bandRows % m_blockHeight;
+	m_bandRows = static_cast<unsigned int>(std::min(std::max(bandRows,
+		static_cast<std::size_t>(m_blockHeight)), static_cast<std::size_t>(texture.height())));
+}
+
+Texture::SaveResult StreamingConverter::convert(Texture::RowSource& source, std::ostream& stream,
+	Texture::FileType fileType)
+{
+	m_stream = &stream;
+	std::streamoff startOffset = stream.tellp();
+	if (startOffset < 0)
+		return Texture::SaveResult::WriteError;
+
+	// Compute where each mip level is located in the file so bands can be written as they're
+	// completed, in whichever order that happens.
+	unsigned int blockWidth = Texture::blockWidth(m_texture.format());
+	unsigned int blockSize = Texture::blockSize(m_texture.format());
+	bool compressed = blockWidth > 1;
+	auto offset = static_cast<std::uint64_t>(startOffset);
+	for (Level& level : m_levels)
+	{
+		level.rowSize = (level.width + blockWidth - 1)/blockWidth*blockSize;
+		level.rowStride = level.rowSize;
+		// KTX pads scanlines of uncompressed formats to 4 bytes and prefixes each mip level with
+		// its size.
+		if (fileType == Texture::FileType::KTX)
+		{
+			if (!compressed)
+				level.rowStride = (level.rowSize + 3)/4*4;
+
+			std::uint64_t imageSize =
+				static_cast<std::uint64_t>(level.rowStride)*(level.height + m_blockHeight - 1)/
+				m_blockHeight;
+			if (imageSize > std::numeric_limits<std::uint32_t>::max())
+				return Texture::SaveResult::Unsupported;
+
+			auto imageSize32 = static_cast<std::uint32_t>(imageSize);
+			stream.seekp(static_cast<std::streamoff>(offset));
+			stream.write(reinterpret_cast<const char*>(&imageSize32), sizeof(imageSize32));
+			if (!stream.good())
+				return Texture::SaveResult::WriteError;
+			offset += sizeof(imageSize32);
+		}
+
+		level.dataOffset = offset;
+		offset += static_cast<std::uint64_t>(level.rowStride)*
+			((level.height + m_blockHeight - 1)/m_blockHeight);
+	}
+
+	// Extend the file to its full size up front so later mip levels can be written before the
+	// earlier ones are complete.
+	if (offset > static_cast<std::uint64_t>(startOffset))
+	{
+		stream.seekp(static_cast<std::streamoff>(offset - 1));
+		stream.put(0);
+		if (!stream.good())
+			return Texture::SaveResult::WriteError;
+	}
+
+	for (Level& level : m_levels)
+	{
+		if (!initializeBand(level))
+			return Texture::SaveResult::Invalid;
+	}
+
+	ColorSpace colorSpace = m_texture.colorSpace();
+	unsigned int width = m_texture.width();
+	unsigned int height = m_texture.height();
+	Image sourceRows;
+	for (unsigned int y = 0; y < height;)
+	{
+		unsigned int rowCount = std::min(m_bandRows, height - y);
+		if (!source.read(sourceRows, rowCount) || sourceRows.width() != width ||
+			sourceRows.height() != rowCount)
+		{
+			return Texture::SaveResult::Invalid;
+		}
+
+		if (sourceRows.format() != Image::Format::RGBAF)
+			sourceRows = sourceRows.convert(Image::Format::RGBAF);
+		if (!sourceRows.changeColorSpace(colorSpace))
+			return Texture::SaveResult::Invalid;
+
+		for (unsigned int i = 0; i < rowCount; ++i, ++y)
+		{
+			Texture::SaveResult result = pushRow(0,
+				reinterpret_cast<const ColorRGBAf*>(sourceRows.scanline(i)));
+			if (result != Texture::SaveResult::Success)
+				return result;
+		}
+	}
+
+	assert(std::all_of(m_levels.begin(), m_levels.end(),
+		[](const Level& level) {return level.receivedRows == level.height;}));
+	stream.flush();
+	return stream.good() ? Texture::SaveResult::Success : Texture::SaveResult::WriteError;
+}
+
+bool StreamingConverter::initializeBand(Level& level)
+{
+	unsigned int rows = std::min(m_bandRows, level.height - level.bandStart);
+	return level.band.initialize(Image::Format::RGBAF, level.width, rows,
+		m_texture.colorSpace());
+}
+
+Texture::SaveResult StreamingConverter::pushRow(unsigned int levelIndex, const ColorRGBAf* row)
+{
+	Level& level = m_levels[levelIndex];
+	assert(level.receivedRows < level.height);
+	std::memcpy(level.band.scanline(level.filledRows), row, level.width*sizeof(ColorRGBAf));
+	++level.filledRows;
+	++level.receivedRows;
+	if (level.filledRows == level.band.height())
+	{
+		Texture::SaveResult result = flushBand(level);
+		if (result != Texture::SaveResult::Success)
+			return result;
+	}
+
+	if (levelIndex + 1 >= m_levels.size())
+		return Texture::SaveResult::Success;
+
+	// Average pairs of rows into the next mip level. When the height is odd the last row is
+	// dropped, matching the truncated size of the next level, unless it's the only row.
+	Level& nextLevel = m_levels[levelIndex + 1];
+	const ColorRGBAf* row0 = nullptr;
+	const ColorRGBAf* row1 = nullptr;
+	if (level.hasPending)
+	{
+		row0 = level.pendingRow.data();
+		row1 = row;
+		level.hasPending = false;
+	}
+	else if (level.receivedRows == level.height)
+	{
+		if (nextLevel.receivedRows < nextLevel.height)
+			row0 = row1 = row;
+	}
+	else
+	{
+		level.pendingRow.assign(row, row + level.width);
+		level.hasPending = true;
+	}
+
+	if (!row0)
+		return Texture::SaveResult::Success;
+
+	level.downsampledRow.resize(nextLevel.width);
+	downsampleRow(level.downsampledRow.data(), nextLevel.width, row0, row1, level.width);
+	return pushRow(levelIndex + 1, level.downsampledRow.data());
+}
+
+Texture::SaveResult StreamingConverter::flushBand(Level& level)
+{
+	assert(level.filledRows == level.band.height());
+	unsigned int rows = level.filledRows;
+	Converter::MipImageList images(1, Converter::DepthImageList(1, Converter::FaceImageList(1)));
+	images[0][0][0] = std::move(level.band);
+
+	TextureArena textureData;
+	std::size_t refinedBlocks = 0;
+	Converter::ConvertOptions options;
+	options.blockCache = m_blockCache;
+	options.outRefinedBlocks = &refinedBlocks;
+	if (!Converter::convert(m_texture, images, textureData, m_quality, m_threadCount, options))
+	{
+		return Texture::SaveResult::Invalid;
+	}
+	m_refinedBlocks += refinedBlocks;
+
+	const std::uint8_t* data = textureData.data();
+	unsigned int blockRows = (rows + m_blockHeight - 1)/m_blockHeight;
+	assert(textureData.size() == level.rowSize*blockRows);
+	m_stream->seekp(static_cast<std::streamoff>(
+		level.dataOffset + level.bandStart/m_blockHeight*level.rowStride));
+	if (level.rowStride == level.rowSize)
+		m_stream->write(reinterpret_cast<const char*>(data), textureData.size());
+	else
+	{
+		const char padding[3] = {};
+		std::size_t paddingSize = level.rowStride - level.rowSize;
+		for (unsigned int i = 0; i < blockRows; ++i)
+		{
+			m_stream->write(reinterpret_cast<const char*>(data + i*level.rowSize),
+				level.rowSize);
+			m_stream->write(padding, paddingSize);
+		}
+	}
+
+	if (!m_stream->good())
+		return Texture::SaveResult::WriteError;
+
+	level.bandStart += rows;
+	level.filledRows = 0;
+	if (level.bandStart < level.height && !initializeBand(level))
+		return Texture::SaveResult::Invalid;
+	return Texture::SaveResult::Success;
+}
+
+void StreamingConverter::downsampleRow(ColorRGBAf* outRow, unsigned int outWidth,
+	const ColorRGBAf* row0, const ColorRGBAf* row1, unsigned int width) const
+{
+	// Average in linear space so sRGB images don't darken.
+	bool srgb = m_texture.colorSpace() == ColorSpace::sRGB;
+	for (unsigned int x = 0; x < outWidth; ++x)
+	{
+		unsigned int x0 = std::min(x*2, width - 1);
+		unsigned int x1 = std::min(x*2 + 1, width - 1);
+		const ColorRGBAf* pixels[4] = {row0 + x0, row0 + x1, row1 + x0, row1 + x1};
+		double color[4] = {};
+		for (const ColorRGBAf* pixel : pixels)
+		{
+			if (srgb)
+			{
+				color[0] += sRGBToLinear(pixel->r);
+				color[1] += sRGBToLinear(pixel->g);
+				color[2] += sRGBToLinear(pixel->b);
+			}
+			else
+			{
+				color[0] += pixel->r;
+				color[1] += pixel->g;
+				color[2] += pixel->b;
+			}
+			color[3] += pixel->a;
+		}
+
+		for (double& channel : color)
+			channel *= 0.25;
+		if (srgb)
+		{
+			for (unsigned int c = 0; c < 3; ++c)
+				color[c] = linearToSRGB(color[c]);
+		}
+
+		outRow[x].r = static_cast<float>(color[0]);
+		outRow[x].g = static_cast<float>(color[1]);
+		outRow[x].b = static_cast<float>(color[2]);
+		outRow[x].a = static_cast<float>(color[3]);
+	}
+}
+
+} // namespace cuttlefish
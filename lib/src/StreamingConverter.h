@@ -0,0 +1,87 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace cuttlefish
+{
+
+class BlockCache;
+
+// Converts a texture out of core for Texture::convertStreaming(). Source rows are pushed through
+// every mip level as they're read, with each level keeping a band of rows that's converted and
+// written to its final offset in the file once it's full. Bands are a multiple of the block
+// height, so each block is encoded exactly as it would be when converting the full image.
+class StreamingConverter
+{
+public:
+	StreamingConverter(const Texture& texture, Texture::Quality quality,
+		std::size_t memoryBudget, unsigned int threadCount, BlockCache* blockCache);
+
+	// Writes the image data for the texture. The header must already be written, and the stream
+	// must support seeking past the end, such as a file stream.
+	Texture::SaveResult convert(Texture::RowSource& source, std::ostream& stream,
+		Texture::FileType fileType);
+
+	std::size_t refinedBlocks() const {return m_refinedBlocks;}
+
+private:
+	struct Level
+	{
+		unsigned int width;
+		unsigned int height;
+		std::uint64_t dataOffset;
+		std::size_t rowSize;
+		std::size_t rowStride;
+
+		Image band;
+		unsigned int bandStart;
+		unsigned int filledRows;
+		unsigned int receivedRows;
+
+		// Previous row that's waiting for the next one to be averaged into the next mip level.
+		std::vector<ColorRGBAf> pendingRow;
+		bool hasPending;
+		std::vector<ColorRGBAf> downsampledRow;
+	};
+
+	bool initializeBand(Level& level);
+	Texture::SaveResult pushRow(unsigned int levelIndex, const ColorRGBAf* row);
+	Texture::SaveResult flushBand(Level& level);
+	void downsampleRow(ColorRGBAf* outRow, unsigned int outWidth, const ColorRGBAf* row0,
+		const ColorRGBAf* row1, unsigned int width) const;
+
+	const Texture& m_texture;
+	Texture::Quality m_quality;
+	unsigned int m_threadCount;
+	BlockCache* m_blockCache;
+	unsigned int m_blockHeight;
+	unsigned int m_bandRows;
+	std::vector<Level> m_levels;
+	std::ostream* m_stream;
+	std::size_t m_refinedBlocks;
+};
+
+} // namespace cuttlefish
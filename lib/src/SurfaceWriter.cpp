@@ -0,0 +1,197 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SurfaceWriter.h"
+#include "OutputSlices.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+namespace cuttlefish
+{
+
+// Limits how far the writes may fall behind the conversion.
+static const std::size_t maxPending = 8;
+
+SurfaceWriter::SurfaceWriter()
+	: m_textureData(nullptr)
+	, m_textureSize(0)
+	, m_remainingSize(0)
+	, m_failed(false)
+	, m_finished(false)
+	, m_cancelled(false)
+{
+}
+
+SurfaceWriter::~SurfaceWriter()
+{
+	if (m_thread.joinable())
+		cancel();
+}
+
+bool SurfaceWriter::begin(const char* fileName, const OutputSlices& slices,
+	const std::uint8_t* textureData, std::size_t textureSize)
+{
+	assert(!m_thread.joinable());
+	m_stream.open(fileName, std::ofstream::binary | std::ofstream::trunc);
+	if (!m_stream.is_open())
+		return false;
+
+	m_fileName = fileName;
+	m_textureData = textureData;
+	m_textureSize = textureSize;
+	m_ranges.clear();
+	m_remainingSize = 0;
+	m_failed = false;
+	m_finished = false;
+	m_cancelled = false;
+	m_pending.clear();
+
+	const std::uint8_t* textureEnd = textureData + textureSize;
+	std::size_t fileOffset = 0;
+	slices.forEachSlice([&](const void* data, std::size_t size)
+		{
+			auto sliceData = reinterpret_cast<const std::uint8_t*>(data);
+			if (sliceData >= textureData && sliceData + size <= textureEnd)
+			{
+				m_ranges.push_back(Range{static_cast<std::size_t>(sliceData - textureData), size,
+					fileOffset});
+				m_remainingSize += size;
+			}
+			else
+			{
+				m_stream.seekp(static_cast<std::streamoff>(fileOffset));
+				m_stream.write(reinterpret_cast<const char*>(data),
+					static_cast<std::streamsize>(size));
+			}
+			fileOffset += size;
+		});
+
+	if (!m_stream.good())
+	{
+		m_stream.close();
+		std::remove(m_fileName.c_str());
+		return false;
+	}
+
+	std::sort(m_ranges.begin(), m_ranges.end(),
+		[](const Range& left, const Range& right) {return left.dataOffset < right.dataOffset;});
+	m_thread = std::thread(&SurfaceWriter::writeThread, this);
+	return true;
+}
+
+void SurfaceWriter::add(const std::uint8_t* data, std::size_t size)
+{
+	assert(m_thread.joinable());
+	assert(data >= m_textureData && data + size <= m_textureData + m_textureSize);
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_condition.wait(lock, [this] {return m_pending.size() < maxPending;});
+		m_pending.push_back(Pending{static_cast<std::size_t>(data - m_textureData), size});
+	}
+	m_condition.notify_all();
+}
+
+bool SurfaceWriter::end()
+{
+	if (!m_thread.joinable())
+		return false;
+
+	stop(false);
+	bool success = !m_failed && m_remainingSize == 0;
+	m_stream.close();
+	if (success && !m_stream.fail())
+		return true;
+
+	std::remove(m_fileName.c_str());
+	return false;
+}
+
+void SurfaceWriter::cancel()
+{
+	if (!m_thread.joinable())
+		return;
+
+	stop(true);
+	m_stream.close();
+	std::remove(m_fileName.c_str());
+}
+
+void SurfaceWriter::stop(bool cancel)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_finished = true;
+		m_cancelled = cancel;
+	}
+	m_condition.notify_all();
+	m_thread.join();
+}
+
+void SurfaceWriter::writeThread()
+{
+	while (true)
+	{
+		Pending pending;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this] {return m_finished || !m_pending.empty();});
+			if (m_cancelled || m_pending.empty())
+				return;
+
+			pending = m_pending.front();
+			m_pending.pop_front();
+		}
+		m_condition.notify_all();
+
+		if (!m_failed && !write(pending))
+			m_failed = true;
+	}
+}
+
+bool SurfaceWriter::write(const Pending& pending)
+{
+	std::size_t dataBegin = pending.dataOffset;
+	std::size_t dataEnd = dataBegin + pending.size;
+
+	// Slices may cover multiple surfaces, such as all the faces of a mip level, so start with the
+	// last range that begins before the data.
+	auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), dataBegin,
+		[](std::size_t offset, const Range& range) {return offset < range.dataOffset;});
+	if (it != m_ranges.begin())
+		--it;
+
+	for (; it != m_ranges.end() && it->dataOffset < dataEnd; ++it)
+	{
+		std::size_t overlapBegin = std::max(dataBegin, it->dataOffset);
+		std::size_t overlapEnd = std::min(dataEnd, it->dataOffset + it->size);
+		if (overlapBegin >= overlapEnd)
+			continue;
+
+		const std::uint8_t* data = m_textureData + overlapBegin;
+		m_stream.seekp(static_cast<std::streamoff>(it->fileOffset + overlapBegin - it->dataOffset));
+		m_stream.write(reinterpret_cast<const char*>(data),
+			static_cast<std::streamsize>(overlapEnd - overlapBegin));
+		if (!m_stream.good())
+			return false;
+
+		m_remainingSize -= overlapEnd - overlapBegin;
+	}
+
+	return true;
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cuttlefish
+{
+
+class OutputSlices;
+
+// Writes a texture file on a separate thread as the converted data for each surface is completed,
+// overlapping the file I/O with converting the remaining surfaces. Each surface is written to its
+// final location in the file, so the surfaces may be added in any order. The data is written
+// directly from the converted texture data, so it must remain valid until end() or cancel()
+// returns.
+class SurfaceWriter
+{
+public:
+	SurfaceWriter();
+	~SurfaceWriter();
+
+	SurfaceWriter(const SurfaceWriter&) = delete;
+	SurfaceWriter& operator=(const SurfaceWriter&) = delete;
+
+	// Opens the file and starts the writer thread. Slices that reference the converted texture data
+	// are deferred until that data is added, while all other slices, such as headers and padding,
+	// are written immediately.
+	bool begin(const char* fileName, const OutputSlices& slices, const std::uint8_t* textureData,
+		std::size_t textureSize);
+
+	// Queues data within the converted texture data to be written. This waits for earlier data to
+	// be written if too much is already queued.
+	void add(const std::uint8_t* data, std::size_t size);
+
+	// Waits for the queued data to be written and closes the file. Returns false if a write failed
+	// or not all of the texture data referenced by the slices was added, in which case the
+	// incomplete file is removed.
+	bool end();
+
+	// Stops writing without waiting for the queued data and removes the incomplete file. This must
+	// be called before the texture data is released if conversion fails.
+	void cancel();
+
+private:
+	// Range of the texture data written to the file.
+	struct Range
+	{
+		std::size_t dataOffset;
+		std::size_t size;
+		std::size_t fileOffset;
+	};
+
+	struct Pending
+	{
+		std::size_t dataOffset;
+		std::size_t size;
+	};
+
+	void writeThread();
+	bool write(const Pending& pending);
+	void stop(bool cancel);
+
+	std::string m_fileName;
+	std::ofstream m_stream;
+	const std::uint8_t* m_textureData;
+	std::size_t m_textureSize;
+
+	// Sorted by the offset into the texture data.
+	std::vector<Range> m_ranges;
+	std::size_t m_remainingSize;
+	bool m_failed;
+
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::deque<Pending> m_pending;
+	bool m_finished;
+	bool m_cancelled;
+	std::thread m_thread;
+};
+
+} // namespace cuttlefish
@@ -16,23 +16,40 @@
 
 #include <cuttlefish/Texture.h>
 
+#include "BlockCache.h"
+#include "ContentAnalysis.h"
 #include "Converter.h"
+#include "Decoder.h"
+#include "IncrementalBlocks.h"
+#include "LoadDds.h"
+#include "LoadKtx.h"
+#include "LoadPvr.h"
+#include "LoadedTexture.h"
+#include "MappedFile.h"
+#include "OutputSlices.h"
 #include "SaveDds.h"
 #include "SaveKtx.h"
+#include "SaveKtx2.h"
 #include "SavePvr.h"
 #include "Shared.h"
+#include "StreamingConverter.h"
+#include "SurfaceWriter.h"
+#include "TextureArena.h"
 
 #include <cuttlefish/Color.h>
 
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <limits>
+#include <map>
+#include <memory>
+#include <string>
 #include <thread>
 #include <vector>
-#include <sstream>
 
 #if CUTTLEFISH_MSC
 #include <intrin.h>
@@ -84,6 +101,110 @@ const Image& emptyImage()
 	return image;
 }
 
+double bitsPerPixel(Texture::Format format)
+{
+	return static_cast<double>(Texture::blockSize(format)*8)/
+		static_cast<double>(Texture::blockWidth(format)*Texture::blockHeight(format));
+}
+
+bool meetsQualityTarget(const Converter::MipQualityMetricsList& metrics, double minPsnr,
+	double minSsim)
+{
+	if (metrics.empty())
+		return false;
+
+	for (const Converter::DepthQualityMetricsList& depthMetrics : metrics)
+	{
+		for (const Converter::FaceQualityMetricsList& faceMetrics : depthMetrics)
+		{
+			for (const Texture::QualityMetrics& surfaceMetrics : faceMetrics)
+			{
+				if (surfaceMetrics.combinedPsnr < minPsnr)
+					return false;
+				if (minSsim > -1.0 && surfaceMetrics.ssim < minSsim)
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Single channel formats with at least the precision of the color channels.
+Texture::Format getGrayscaleFormat(Texture::Format format)
+{
+	switch (format)
+	{
+		case Texture::Format::R4G4B4A4:
+		case Texture::Format::B4G4R4A4:
+		case Texture::Format::A4R4G4B4:
+		case Texture::Format::R5G6B5:
+		case Texture::Format::B5G6R5:
+		case Texture::Format::R5G5B5A1:
+		case Texture::Format::B5G5R5A1:
+		case Texture::Format::A1R5G5B5:
+		case Texture::Format::R8G8B8:
+		case Texture::Format::B8G8R8:
+		case Texture::Format::R8G8B8A8:
+		case Texture::Format::B8G8R8A8:
+		case Texture::Format::A8B8G8R8:
+			return Texture::Format::R8;
+		case Texture::Format::A2R10G10B10:
+		case Texture::Format::A2B10G10R10:
+		case Texture::Format::R16G16B16:
+		case Texture::Format::R16G16B16A16:
+			return Texture::Format::R16;
+		case Texture::Format::R32G32B32:
+		case Texture::Format::R32G32B32A32:
+			return Texture::Format::R32;
+		case Texture::Format::BC2:
+		case Texture::Format::BC3:
+		case Texture::Format::BC7:
+			return Texture::Format::BC4;
+		case Texture::Format::ETC2_R8G8B8A8:
+			return Texture::Format::EAC_R11;
+		default:
+			return format;
+	}
+}
+
+Texture::Format getOpaqueFormat(Texture::Format format)
+{
+	switch (format)
+	{
+		case Texture::Format::R8G8B8A8:
+		case Texture::Format::A8B8G8R8:
+			return Texture::Format::R8G8B8;
+		case Texture::Format::B8G8R8A8:
+			return Texture::Format::B8G8R8;
+		case Texture::Format::R16G16B16A16:
+			return Texture::Format::R16G16B16;
+		case Texture::Format::R32G32B32A32:
+			return Texture::Format::R32G32B32;
+		case Texture::Format::BC2:
+		case Texture::Format::BC3:
+			return Texture::Format::BC1_RGB;
+		case Texture::Format::ETC2_R8G8B8A8:
+			return Texture::Format::ETC2_R8G8B8;
+		default:
+			return format;
+	}
+}
+
+Texture::Format getBinaryAlphaFormat(Texture::Format format)
+{
+	switch (format)
+	{
+		case Texture::Format::BC2:
+		case Texture::Format::BC3:
+			return Texture::Format::BC1_RGBA;
+		case Texture::Format::ETC2_R8G8B8A8:
+			return Texture::Format::ETC2_R8G8B8A1;
+		default:
+			return format;
+	}
+}
+
 inline std::uint32_t clz(std::uint32_t x)
 {
 #if CUTTLEFISH_MSC
@@ -226,17 +347,87 @@ void generateMips3d(std::vector<Image>& outMipImages, const std::vector<Image>&
 	}
 }
 
+// Generates a single mip image for a 2D, array, or cube texture from the previous mip level.
+// prevImage holds the generated image to resume from after a custom mip image that's only used
+// once.
+void generateMip(Image& outImage, Image& prevImage, const Image& prevLevelImage,
+	const Texture::ImageIndex& index, unsigned int mipWidth, unsigned int mipHeight,
+	Image::ResizeFilter filter, const Texture::CustomMipImages& customMipImages)
+{
+	// Generated mip, either when no replacement is used or to resume previous state when
+	// replacement is set to once.
+	auto foundCustomMip = customMipImages.find(index);
+	Image curMip;
+	bool customMip = foundCustomMip != customMipImages.end();
+	bool restoreState = customMip && foundCustomMip->second.replacement ==
+		Texture::MipReplacement::Once;
+	if (!customMip || restoreState)
+	{
+		if (prevImage)
+			curMip = prevImage.resize(mipWidth, mipHeight, filter);
+		else
+			curMip = prevLevelImage.resize(mipWidth, mipHeight, filter);
+	}
+
+	// Set up prevImage based on whether we want to restore state for the next mip.
+	if (restoreState)
+		prevImage = std::move(curMip); // Only used to restore state.
+	else
+		prevImage = Image();
+
+	if (customMip)
+	{
+		outImage = foundCustomMip->second.image->resize(mipWidth, mipHeight, filter);
+		if (outImage.format() != Image::Format::RGBAF)
+			outImage = outImage.convert(Image::Format::RGBAF);
+	}
+	else
+		outImage = std::move(curMip);
+}
+
+// Collects the slices to write for the file rather than writing them directly, so the texture data
+// itself is never copied.
+Texture::SaveResult gatherSaveSlices(OutputSlices& output, const Texture& texture,
+	Texture::FileType fileType)
+{
+	if (!texture.converted())
+		return Texture::SaveResult::Invalid;
+
+	switch (fileType)
+	{
+		case Texture::FileType::DDS:
+			return saveDds(texture, output);
+		case Texture::FileType::KTX:
+			return saveKtx(texture, output);
+		case Texture::FileType::PVR:
+			return savePvr(texture, output);
+		case Texture::FileType::KTX2:
+			return saveKtx2(texture, texture.ktx2ZstdLevel(), output);
+		default:
+			return Texture::SaveResult::UnknownFormat;
+	}
+}
+
+bool moveImage(Image& outImage, Image&& image, ColorSpace colorSpace)
+{
+	// Copy external memory before converting the color space in place so the caller's pixels
+	// aren't modified.
+	if (image.format() != Image::Format::RGBAF)
+		outImage = image.convert(Image::Format::RGBAF);
+	else if (image.isExternal() && image.colorSpace() != colorSpace)
+		outImage = image;
+	else
+		outImage = std::move(image);
+	outImage.changeColorSpace(colorSpace);
+	return outImage.isValid();
+}
+
 } // namespace
 
 using FaceImageList = std::vector<Image>;
 using DepthImageList = std::vector<FaceImageList>;
 using MipImageList = std::vector<DepthImageList>;
 
-using TextureData = std::vector<std::uint8_t>;
-using FaceTextureList = std::vector<TextureData>;
-using DepthTextureList = std::vector<FaceTextureList>;
-using MipTextureList = std::vector<DepthTextureList>;
-
 struct Texture::Impl
 {
 	Dimension dimension;
@@ -248,11 +439,66 @@ struct Texture::Impl
 	unsigned int faces;
 	MipImageList images;
 
+	bool fusedMipmapsEnabled = false;
+	bool deferredMipmaps = false;
+	Image::ResizeFilter mipFilter = Image::ResizeFilter::CatmullRom;
+	CustomMipImages mipCustomImages;
+
 	Format format = Format::Unknown;
 	Type type = Type::UNorm;
 	Alpha alphaType = Alpha::Standard;
 	ColorMask colorMask;
-	MipTextureList textures;
+	TextureArena textures;
+
+	// Surfaces of a loaded texture that reference the memory mapped file, ordered by mip level,
+	// depth, then face. The file is shared between copies of the texture.
+	std::shared_ptr<MappedFile> mappedFile;
+	std::vector<const std::uint8_t*> mappedSurfaces;
+
+	const std::uint8_t* mappedData(unsigned int mip, unsigned int d, unsigned int face) const
+	{
+		std::size_t index = 0;
+		for (unsigned int i = 0; i < mip; ++i)
+		{
+			unsigned int mipDepth = dimension == Dimension::Dim3D ? std::max(depth >> i, 1U) :
+				std::max(depth, 1U);
+			index += mipDepth*faces;
+		}
+		index += d*faces + face;
+		assert(index < mappedSurfaces.size());
+		return mappedSurfaces[index];
+	}
+
+	void releaseMapping()
+	{
+		mappedFile.reset();
+		mappedSurfaces.clear();
+	}
+
+	bool blockCacheEnabled = false;
+	std::size_t blockCacheLookups = 0;
+	std::size_t blockCacheHits = 0;
+
+	bool blockHashesEnabled = false;
+	IncrementalBlocks incrementalBlocks;
+
+	bool adaptiveQualityEnabled = false;
+	Quality adaptiveFastQuality = Quality::Low;
+	float adaptiveErrorThreshold = -1.0f;
+	std::size_t adaptiveRefinedBlocks = 0;
+
+	bool qualityMetricsEnabled = false;
+	bool qualityMetricsSsim = false;
+	Converter::MipQualityMetricsList qualityMetrics;
+	bool formatDowngradeEnabled = false;
+	std::map<Format, Encoder> encoders;
+
+	unsigned int ktx2ZstdLevel = 0;
+
+	// Set by convertAndSave() to write each surface as it's converted. The writer is cancelled
+	// before the texture data is released if conversion fails.
+	const Converter::SurfaceCallback* surfaceConverted = nullptr;
+	SurfaceWriter* surfaceWriter = nullptr;
 };
 
 Texture::CustomMipImage::CustomMipImage(const CustomMipImage& other)
@@ -413,11 +659,64 @@ bool Texture::isFormatValid(Format format, Type type, FileType fileType)
 			return isValidForKtx(format, type);
 		case FileType::PVR:
 			return isValidForPvr(format, type);
+		case FileType::KTX2:
+			return isValidForKtx2(format, type);
+		default:
+			return false;
+	}
+}
+
+bool Texture::isEncoderSupported(Format format, Type type, Encoder encoder)
+{
+	if (!isFormatValid(format, type))
+		return false;
+
+	if (encoder == Encoder::Default)
+		return true;
+
+	switch (format)
+	{
+		case Format::BC1_RGB:
+			return encoder == Encoder::Rgbcx || encoder == Encoder::Squish ||
+				(CUTTLEFISH_ISPC && encoder == Encoder::IspcTexcomp);
+		case Format::BC1_RGBA:
+			return encoder == Encoder::Squish;
+		case Format::BC2:
+			return encoder == Encoder::Rgbcx || encoder == Encoder::Squish;
+		case Format::BC3:
+			return encoder == Encoder::Rgbcx || encoder == Encoder::Squish ||
+				(CUTTLEFISH_ISPC && encoder == Encoder::IspcTexcomp);
+		case Format::BC4:
+		case Format::BC5:
+			if (type == Type::SNorm)
+				return encoder == Encoder::Compressonator;
+			return encoder == Encoder::Rgbcx || encoder == Encoder::Compressonator ||
+				(CUTTLEFISH_ISPC && encoder == Encoder::IspcTexcomp);
+		case Format::BC6H:
+			return encoder == Encoder::Compressonator ||
+				(CUTTLEFISH_ISPC && type == Type::UFloat && encoder == Encoder::IspcTexcomp);
+		case Format::BC7:
+			return encoder == Encoder::Bc7enc;
 		default:
 			return false;
 	}
 }
 
+bool Texture::isDecodeSupported(Format format, Type type)
+{
+	return Decoder::isFormatSupported(format, type);
+}
+
+bool Texture::decode(Image& outImage, const void* data, std::size_t dataSize, Format format,
+	Type type, unsigned int width, unsigned int height, ColorSpace colorSpace,
+	unsigned int threads)
+{
+	if (threads == allCores)
+		threads = std::thread::hardware_concurrency();
+	return Decoder::decode(outImage, data, dataSize, format, type, width, height, colorSpace,
+		threads);
+}
+
 bool Texture::hasNativeSRGB(Format format, Type type)
 {
 	switch (format)
@@ -511,6 +810,48 @@ bool Texture::hasAlpha(Format format)
 	}
 }
 
+unsigned int Texture::qualityRank(Quality quality)
+{
+	if (quality == Quality::Preview)
+		return 0;
+	return static_cast<unsigned int>(quality) + 1;
+}
+
+Texture::Format Texture::downgradeFormat(Format format, Type type, Alpha alphaType,
+	ColorSpace colorSpace, const ContentProperties& properties)
+{
+	auto isUsable = [format, type, colorSpace](Format newFormat)
+	{
+		return newFormat != format && isFormatValid(newFormat, type) &&
+			(colorSpace != ColorSpace::sRGB || hasNativeSRGB(newFormat, type));
+	};
+
+	if (properties.opaqueAlpha || alphaType == Alpha::None)
+	{
+		if (properties.grayscale)
+		{
+			Format grayscaleFormat = getGrayscaleFormat(format);
+			if (isUsable(grayscaleFormat))
+				return grayscaleFormat;
+		}
+
+		Format opaqueFormat = getOpaqueFormat(format);
+		if (isUsable(opaqueFormat))
+			return opaqueFormat;
+	}
+	// Punch-through alpha loses the color of transparent pixels, so only use it when alpha is
+	// opacity.
+	else if (properties.binaryAlpha &&
+		(alphaType == Alpha::Standard || alphaType == Alpha::PreMultiplied))
+	{
+		Format binaryAlphaFormat = getBinaryAlphaFormat(format);
+		if (isUsable(binaryAlphaFormat))
+			return binaryAlphaFormat;
+	}
+
+	return format;
+}
+
 unsigned int Texture::maxMipmapLevels(Dimension dimension, unsigned int width,
 	unsigned int height, unsigned int depth)
 {
@@ -944,6 +1285,8 @@ Texture::FileType Texture::fileType(const char* fileName)
 	const std::size_t ktxLen = std::strlen(ktxExt);
 	const char* pvrExt = ".pvr";
 	const std::size_t pvrLen = std::strlen(pvrExt);
+	const char* ktx2Ext = ".ktx2";
+	const std::size_t ktx2Len = std::strlen(ktx2Ext);
 
 	std::size_t len = std::strlen(fileName);
 	if (len >= ddsLen && strcasecmp(fileName + len - ddsLen, ddsExt) == 0)
@@ -952,6 +1295,8 @@ Texture::FileType Texture::fileType(const char* fileName)
 		return FileType::KTX;
 	else if (len >= pvrLen && strcasecmp(fileName + len - pvrLen, pvrExt) == 0)
 		return FileType::PVR;
+	else if (len >= ktx2Len && strcasecmp(fileName + len - ktx2Len, ktx2Ext) == 0)
+		return FileType::KTX2;
 
 	return FileType::Auto;
 }
@@ -1272,12 +1617,7 @@ bool Texture::setImage(Image&& image, unsigned int mipLevel, unsigned int depth)
 		return false;
 	}
 
-	if (image.format() == Image::Format::RGBAF)
-		m_impl->images[mipLevel][depth][0] = std::move(image);
-	else
-		m_impl->images[mipLevel][depth][0] = image.convert(Image::Format::RGBAF);
-	m_impl->images[mipLevel][depth][0].changeColorSpace(m_impl->colorSpace);
-	return m_impl->images[mipLevel][depth][0].isValid();
+	return moveImage(m_impl->images[mipLevel][depth][0], std::move(image), m_impl->colorSpace);
 }
 
 bool Texture::setImage(const Image& image, CubeFace face, unsigned int mipLevel, unsigned int depth)
@@ -1305,16 +1645,8 @@ bool Texture::setImage(Image&& image, CubeFace face, unsigned int mipLevel, unsi
 		return false;
 	}
 
-	if (image.format() == Image::Format::RGBAF)
-		m_impl->images[mipLevel][depth][static_cast<unsigned int>(face)] = std::move(image);
-	else
-	{
-		m_impl->images[mipLevel][depth][static_cast<unsigned int>(face)] =
-			image.convert(Image::Format::RGBAF);
-	}
-	m_impl->images[mipLevel][depth][static_cast<unsigned int>(face)].changeColorSpace(
-		m_impl->colorSpace);
-	return m_impl->images[mipLevel][depth][static_cast<unsigned int>(face)].isValid();
+	return moveImage(m_impl->images[mipLevel][depth][static_cast<unsigned int>(face)],
+		std::move(image), m_impl->colorSpace);
 }
 
 bool Texture::generateMipmaps(Image::ResizeFilter filter, unsigned int mipLevels,
@@ -1342,6 +1674,30 @@ bool Texture::generateMipmaps(Image::ResizeFilter filter, unsigned int mipLevels
 		maxMipmapLevels(dimension(), width(), height(), depth()));
 	m_impl->mipLevels = mipLevels;
 	m_impl->images.resize(mipLevels);
+	m_impl->deferredMipmaps = false;
+	m_impl->mipCustomImages.clear();
+
+	if (m_impl->fusedMipmapsEnabled && m_impl->dimension != Dimension::Dim3D)
+	{
+		// Only set up the storage, leaving the images to be generated during conversion.
+		unsigned int depth = std::max(m_impl->depth, 1U);
+		for (unsigned int mip = 1; mip < mipLevels; ++mip)
+		{
+			DepthImageList& depthImages = m_impl->images[mip];
+			depthImages.resize(depth);
+			for (unsigned int d = 0; d < depth; ++d)
+			{
+				FaceImageList& faceImages = depthImages[d];
+				faceImages.clear();
+				faceImages.resize(m_impl->faces);
+			}
+		}
+
+		m_impl->deferredMipmaps = mipLevels > 1;
+		m_impl->mipFilter = filter;
+		m_impl->mipCustomImages = customMipImages;
+		return true;
+	}
 
 	if (m_impl->dimension == Dimension::Dim3D)
 	{
@@ -1460,51 +1816,12 @@ bool Texture::generateMipmaps(Image::ResizeFilter filter, unsigned int mipLevels
 		{
 			for (unsigned int f = 0; f < m_impl->faces; ++f)
 			{
+				prevImage = Image();
 				for (unsigned int mip = 1; mip < mipLevels; ++mip)
 				{
-					unsigned int mipWidth = width(mip);
-					unsigned int mipHeight = height(mip);
-					auto foundCustomMip = customMipImages.find(
-						ImageIndex(static_cast<CubeFace>(f), mip, d));
-
-					// Generated mip, either when no replacement is used or to resume previous state
-					// when replacement is set to once.
-					Image curMip;
-					bool customMip = foundCustomMip != customMipImages.end();
-					bool restoreState = customMip &&
-						foundCustomMip->second.replacement == MipReplacement::Once;
-					if (!customMip || restoreState)
-					{
-						if (prevImage)
-							curMip = prevImage.resize(mipWidth, mipHeight, filter);
-						else
-						{
-							curMip = m_impl->images[mip - 1][d][f].resize(
-								mipWidth, mipHeight, filter);
-						}
-					}
-
-					// Set up prevImage based on whether we want to restore state for the next mip.
-					if (restoreState)
-					{
-						if (customMip)
-							prevImage = std::move(curMip); // Only used to restore state.
-						else
-							prevImage = curMip;
-					}
-					else
-						prevImage = Image();
-
-					Image& thisMipImage = m_impl->images[mip][d][f];
-					if (customMip)
-					{
-						thisMipImage = foundCustomMip->second.image->resize(
-							mipWidth, mipHeight, filter);
-						if (thisMipImage.format() != Image::Format::RGBAF)
-							thisMipImage = thisMipImage.convert(Image::Format::RGBAF);
-					}
-					else
-						thisMipImage = std::move(curMip);
+					generateMip(m_impl->images[mip][d][f], prevImage,
+						m_impl->images[mip - 1][d][f], ImageIndex(static_cast<CubeFace>(f), mip, d),
+						width(mip), height(mip), filter, customMipImages);
 				}
 			}
 		}
@@ -1513,14 +1830,27 @@ bool Texture::generateMipmaps(Image::ResizeFilter filter, unsigned int mipLevels
 	return true;
 }
 
+void Texture::setFusedMipmapsEnabled(bool enabled)
+{
+	if (m_impl)
+		m_impl->fusedMipmapsEnabled = enabled;
+}
+
+bool Texture::fusedMipmapsEnabled() const
+{
+	return m_impl && m_impl->fusedMipmapsEnabled;
+}
+
 bool Texture::imagesComplete() const
 {
 	if (!m_impl)
 		return false;
 
-	for (const DepthImageList& depthImages : m_impl->images)
+	// Only the first mip level is present when mipmap generation is deferred to conversion.
+	auto endMip = m_impl->deferredMipmaps ? m_impl->images.begin() + 1 : m_impl->images.end();
+	for (auto depthImages = m_impl->images.begin(); depthImages != endMip; ++depthImages)
 	{
-		for (const FaceImageList& faceImages : depthImages)
+		for (const FaceImageList& faceImages : *depthImages)
 		{
 			for (const Image& image : faceImages)
 			{
@@ -1533,153 +1863,842 @@ bool Texture::imagesComplete() const
 	return true;
 }
 
-bool Texture::convert(Format format, Type type, Quality quality, Alpha alphaType,
-	ColorMask colorMask, unsigned int threads)
+void Texture::setBlockCacheEnabled(bool enabled)
 {
-	if (!imagesComplete() || !isFormatValid(format, type))
-		return false;
+	if (m_impl)
+		m_impl->blockCacheEnabled = enabled;
+}
 
-	if (m_impl->colorSpace == ColorSpace::sRGB && !hasNativeSRGB(format, type))
-		return false;
+bool Texture::blockCacheEnabled() const
+{
+	return m_impl && m_impl->blockCacheEnabled;
+}
 
-	m_impl->format = format;
-	m_impl->type = type;
-	m_impl->alphaType = alphaType;
-	m_impl->colorMask = colorMask;
+std::size_t Texture::blockCacheLookups() const
+{
+	if (!m_impl)
+		return 0;
 
-	if (threads == allCores)
-		threads = std::thread::hardware_concurrency();
+	return m_impl->blockCacheLookups;
+}
 
-	if (!Converter::convert(*this, m_impl->images, m_impl->textures, quality, threads))
-	{
-		m_impl->format = Format::Unknown;
-		m_impl->textures.clear();
-		return false;
-	}
+std::size_t Texture::blockCacheHits() const
+{
+	if (!m_impl)
+		return 0;
 
-	return true;
+	return m_impl->blockCacheHits;
 }
 
-bool Texture::converted() const
+void Texture::setBlockHashesEnabled(bool enabled)
 {
-	return m_impl && !m_impl->textures.empty();
+	if (m_impl)
+		m_impl->blockHashesEnabled = enabled;
 }
 
-Texture::Format Texture::format() const
+bool Texture::blockHashesEnabled() const
 {
-	if (!m_impl)
-		return Format::Unknown;
-
-	return m_impl->format;
+	return m_impl && m_impl->blockHashesEnabled;
 }
 
-Texture::Type Texture::type() const
+bool Texture::saveBlockHashes(const char* fileName) const
 {
-	if (!m_impl)
-		return Type::UNorm;
+	if (!converted())
+		return false;
 
-	return m_impl->type;
+	return m_impl->incrementalBlocks.saveHashes(fileName, *this);
 }
 
-Texture::Alpha Texture::alphaType() const
+bool Texture::setPreviousOutput(const char* fileName, const char* blockHashFileName,
+	FileType fileType)
 {
 	if (!m_impl)
-		return Alpha::None;
+		return false;
 
-	return m_impl->alphaType;
+	return m_impl->incrementalBlocks.loadPrevious(fileName, blockHashFileName, fileType);
 }
 
-Texture::ColorMask Texture::colorMask() const
+std::size_t Texture::reusedBlockCount() const
 {
 	if (!m_impl)
-		return ColorMask();
+		return 0;
 
-	return m_impl->colorMask;
+	return m_impl->incrementalBlocks.reusedBlocks();
 }
 
-std::size_t Texture::dataSize(unsigned int mipLevel, unsigned int depth) const
+void Texture::setAdaptiveQuality(bool enabled, Quality fastQuality, float errorThreshold)
 {
-	if (!converted() || depth >= Texture::depth(mipLevel) || m_impl->faces != 1)
-		return 0;
+	if (!m_impl)
+		return;
 
-	return m_impl->textures[mipLevel][depth][0].size();
+	m_impl->adaptiveQualityEnabled = enabled;
+	m_impl->adaptiveFastQuality = fastQuality;
+	m_impl->adaptiveErrorThreshold = errorThreshold;
 }
 
-std::size_t Texture::dataSize(CubeFace face, unsigned int mipLevel, unsigned int depth) const
+bool Texture::adaptiveQualityEnabled() const
 {
-	if (!converted() || depth >= Texture::depth(mipLevel) ||
-		(m_impl->faces != 6 && face != CubeFace::PosX))
-	{
-		return 0;
-	}
-
-	return m_impl->textures[mipLevel][depth][static_cast<unsigned int>(face)].size();
+	return m_impl && m_impl->adaptiveQualityEnabled;
 }
 
-const void* Texture::data(unsigned int mipLevel, unsigned int depth) const
+Texture::Quality Texture::adaptiveFastQuality() const
 {
-	if (!converted() || depth >= Texture::depth(mipLevel) || m_impl->faces != 1)
-		return nullptr;
+	if (!m_impl)
+		return Quality::Low;
 
-	return m_impl->textures[mipLevel][depth][0].data();
+	return m_impl->adaptiveFastQuality;
 }
 
-const void* Texture::data(CubeFace face, unsigned int mipLevel, unsigned int depth) const
+float Texture::adaptiveErrorThreshold() const
 {
-	if (!converted() || depth >= Texture::depth(mipLevel) ||
+	if (!m_impl)
+		return -1.0f;
+
+	return m_impl->adaptiveErrorThreshold;
+}
+
+float Texture::defaultAdaptiveErrorThreshold(Format format, Type type)
+{
+	// HDR formats are measured in log2(1 + value) space.
+	if (type == Type::UFloat || type == Type::Float)
+		return 0.02f;
+
+	switch (format)
+	{
+		// Single and dual channel formats have more precision per channel, as does BC7.
+		case Format::BC4:
+		case Format::BC5:
+		case Format::BC7:
+		case Format::EAC_R11:
+		case Format::EAC_R11G11:
+			return 2.0f/255.0f;
+		case Format::ASTC_4x4:
+		case Format::ASTC_5x4:
+		case Format::ASTC_5x5:
+		case Format::ASTC_6x5:
+		case Format::ASTC_6x6:
+		case Format::ASTC_8x5:
+		case Format::ASTC_8x6:
+		case Format::ASTC_8x8:
+		case Format::ASTC_10x5:
+		case Format::ASTC_10x6:
+		case Format::ASTC_10x8:
+		case Format::ASTC_10x10:
+		case Format::ASTC_12x10:
+		case Format::ASTC_12x12:
+			return 3.0f/255.0f;
+		default:
+			return 4.0f/255.0f;
+	}
+}
+
+std::size_t Texture::adaptiveRefinedBlockCount() const
+{
+	if (!m_impl)
+		return 0;
+
+	return m_impl->adaptiveRefinedBlocks;
+}
+
+void Texture::setQualityMetricsEnabled(bool enabled, bool ssim)
+{
+	if (!m_impl)
+		return;
+
+	m_impl->qualityMetricsEnabled = enabled;
+	m_impl->qualityMetricsSsim = ssim;
+}
+
+bool Texture::qualityMetricsEnabled() const
+{
+	return m_impl && m_impl->qualityMetricsEnabled;
+}
+
+bool Texture::qualityMetricsSsimEnabled() const
+{
+	return m_impl && m_impl->qualityMetricsSsim;
+}
+
+bool Texture::qualityMetrics(QualityMetrics& outMetrics, unsigned int mipLevel,
+	unsigned int depth) const
+{
+	if (!converted() || m_impl->qualityMetrics.empty() || depth >= Texture::depth(mipLevel) ||
+		m_impl->faces != 1)
+	{
+		return false;
+	}
+
+	outMetrics = m_impl->qualityMetrics[mipLevel][depth][0];
+	return true;
+}
+
+bool Texture::qualityMetrics(QualityMetrics& outMetrics, CubeFace face, unsigned int mipLevel,
+	unsigned int depth) const
+{
+	if (!converted() || m_impl->qualityMetrics.empty() || depth >= Texture::depth(mipLevel) ||
 		(m_impl->faces != 6 && face != CubeFace::PosX))
 	{
-		return nullptr;
+		return false;
 	}
 
-	return m_impl->textures[mipLevel][depth][static_cast<unsigned int>(face)].data();
+	outMetrics = m_impl->qualityMetrics[mipLevel][depth][static_cast<unsigned int>(face)];
+	return true;
 }
 
-Texture::SaveResult Texture::save(const char* fileName, FileType fileType)
+bool Texture::analyzeContent(ContentProperties& outProperties, unsigned int threads) const
 {
-	if (!converted() || !fileName)
+	if (!imagesComplete())
+		return false;
+
+	if (threads == allCores)
+		threads = std::thread::hardware_concurrency();
+
+	outProperties.opaqueAlpha = true;
+	outProperties.binaryAlpha = true;
+	outProperties.grayscale = true;
+	auto endMip = m_impl->deferredMipmaps ? m_impl->images.begin() + 1 : m_impl->images.end();
+	for (auto depthImages = m_impl->images.begin(); depthImages != endMip; ++depthImages)
+	{
+		for (const FaceImageList& faceImages : *depthImages)
+		{
+			for (const Image& image : faceImages)
+			{
+				if (!cuttlefish::analyzeContent(outProperties, image, threads))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void Texture::setFormatDowngradeEnabled(bool enabled)
+{
+	if (m_impl)
+		m_impl->formatDowngradeEnabled = enabled;
+}
+
+bool Texture::formatDowngradeEnabled() const
+{
+	return m_impl && m_impl->formatDowngradeEnabled;
+}
+
+void Texture::setEncoder(Format format, Encoder encoder)
+{
+	if (!m_impl)
+		return;
+
+	if (encoder == Encoder::Default)
+		m_impl->encoders.erase(format);
+	else
+		m_impl->encoders[format] = encoder;
+}
+
+Texture::Encoder Texture::encoder(Format format) const
+{
+	if (!m_impl)
+		return Encoder::Default;
+
+	auto foundIter = m_impl->encoders.find(format);
+	if (foundIter == m_impl->encoders.end())
+		return Encoder::Default;
+
+	return foundIter->second;
+}
+
+bool Texture::convert(Format format, Type type, Quality quality, Alpha alphaType,
+	ColorMask colorMask, unsigned int threads)
+{
+	if (!imagesComplete() || !isFormatValid(format, type))
+		return false;
+
+	if (m_impl->colorSpace == ColorSpace::sRGB && !hasNativeSRGB(format, type))
+		return false;
+
+	if (threads == allCores)
+		threads = std::thread::hardware_concurrency();
+
+	if (m_impl->formatDowngradeEnabled)
+	{
+		ContentProperties properties;
+		if (!analyzeContent(properties, threads))
+			return false;
+
+		// Alpha that's masked out doesn't need to be stored.
+		if (!colorMask.a)
+		{
+			properties.opaqueAlpha = true;
+			properties.binaryAlpha = true;
+		}
+		format = downgradeFormat(format, type, alphaType, m_impl->colorSpace, properties);
+	}
+
+	if (!isEncoderSupported(format, type, encoder(format)))
+		return false;
+
+	m_impl->format = format;
+	m_impl->type = type;
+	m_impl->alphaType = alphaType;
+	m_impl->colorMask = colorMask;
+	m_impl->releaseMapping();
+
+	std::unique_ptr<BlockCache> blockCache;
+	if (m_impl->blockCacheEnabled)
+		blockCache.reset(new BlockCache);
+
+	IncrementalBlocks* incrementalBlocks = nullptr;
+	if (m_impl->blockHashesEnabled || m_impl->incrementalBlocks.hasPrevious())
+	{
+		incrementalBlocks = &m_impl->incrementalBlocks;
+		incrementalBlocks->begin(*this, quality);
+	}
+	else
+		m_impl->incrementalBlocks = IncrementalBlocks();
+
+	// Deferred mipmaps are generated as each level is converted, following the mip chain for each
+	// image.
+	Converter::MipGenerator mipGenerator;
+	if (m_impl->deferredMipmaps)
+	{
+		Image prevImage;
+		mipGenerator = [this, prevImage](Converter::MipImageList& images, unsigned int mip,
+			unsigned int d, unsigned int f) mutable
+		{
+			if (mip == 0)
+				prevImage = Image();
+
+			unsigned int nextMip = mip + 1;
+			generateMip(images[nextMip][d][f], prevImage, images[mip][d][f],
+				ImageIndex(static_cast<CubeFace>(f), nextMip, d), width(nextMip), height(nextMip),
+				m_impl->mipFilter, m_impl->mipCustomImages);
+		};
+	}
+
+	m_impl->qualityMetrics.clear();
+	Converter::ConvertOptions options;
+	options.blockCache = blockCache.get();
+	options.incrementalBlocks = incrementalBlocks;
+	options.outRefinedBlocks = &m_impl->adaptiveRefinedBlocks;
+	if (m_impl->qualityMetricsEnabled)
+		options.outQualityMetrics = &m_impl->qualityMetrics;
+	if (m_impl->deferredMipmaps)
+		options.mipGenerator = &mipGenerator;
+	options.surfaceConverted = m_impl->surfaceConverted;
+	bool success = Converter::convert(*this, m_impl->images, m_impl->textures, quality, threads,
+		options);
+
+	// Only keep the previous output for a single conversion since it may be very large.
+	m_impl->incrementalBlocks.clearPrevious();
+	m_impl->blockCacheLookups = blockCache ? blockCache->lookups() : 0;
+	m_impl->blockCacheHits = blockCache ? blockCache->hits() : 0;
+	if (!success)
+	{
+		if (m_impl->surfaceWriter)
+			m_impl->surfaceWriter->cancel();
+		m_impl->format = Format::Unknown;
+		m_impl->textures.reset();
+		m_impl->qualityMetrics.clear();
+		return false;
+	}
+
+	// The images are released during conversion, including any that were generated.
+	m_impl->deferredMipmaps = false;
+	m_impl->mipCustomImages.clear();
+	return true;
+}
+
+bool Texture::convertToQualityTarget(const std::vector<Format>& candidates, Type type,
+	double minPsnr, double minSsim, Quality quality, Alpha alphaType, ColorMask colorMask,
+	unsigned int threads)
+{
+	if (!imagesComplete())
+		return false;
+
+	std::vector<Format> sortedCandidates;
+	sortedCandidates.reserve(candidates.size());
+	for (Format candidate : candidates)
+	{
+		// isEncoderSupported() also checks that the format is valid.
+		if (!isEncoderSupported(candidate, type, encoder(candidate)) ||
+			!isDecodeSupported(candidate, type) ||
+			(m_impl->colorSpace == ColorSpace::sRGB && !hasNativeSRGB(candidate, type)))
+		{
+			continue;
+		}
+
+		sortedCandidates.push_back(candidate);
+	}
+
+	if (sortedCandidates.empty())
+		return false;
+
+	std::stable_sort(sortedCandidates.begin(), sortedCandidates.end(),
+		[](Format left, Format right) {return bitsPerPixel(left) < bitsPerPixel(right);});
+
+	if (threads == allCores)
+		threads = std::thread::hardware_concurrency();
+
+	// The largest candidate is used as a fallback, so only the others need to be previewed. Only
+	// the first mip level is used since it has the most detail and is the most expensive to
+	// encode, and the converter releases the images so a copy is used for each candidate. The
+	// previews are encoded with a copy of the texture, which shares the image data, so the state
+	// of this texture is left unchanged. The incremental blocks aren't used for the previews, so
+	// they are kept out of the copy to avoid duplicating the previous output.
+	Format selectedFormat = sortedCandidates.back();
+	if (sortedCandidates.size() > 1)
+	{
+		IncrementalBlocks incrementalBlocks(std::move(m_impl->incrementalBlocks));
+		Texture preview(*this);
+		m_impl->incrementalBlocks = std::move(incrementalBlocks);
+
+		preview.m_impl->qualityMetricsSsim = minSsim > -1.0;
+		preview.m_impl->type = type;
+		preview.m_impl->alphaType = alphaType;
+		preview.m_impl->colorMask = colorMask;
+
+		Converter::MipImageList previewImages(m_impl->images.begin(), m_impl->images.begin() + 1);
+		for (std::size_t i = 0; i < sortedCandidates.size() - 1; ++i)
+		{
+			preview.m_impl->format = sortedCandidates[i];
+			Converter::MipImageList images = previewImages;
+			TextureArena textureData;
+			Converter::MipQualityMetricsList metrics;
+			Converter::ConvertOptions options;
+			options.outQualityMetrics = &metrics;
+			if (Converter::convert(preview, images, textureData, Quality::Preview, threads,
+					options) &&
+				meetsQualityTarget(metrics, minPsnr, minSsim))
+			{
+				selectedFormat = sortedCandidates[i];
+				break;
+			}
+		}
+	}
+
+	return convert(selectedFormat, type, quality, alphaType, colorMask, threads);
+}
+
+Texture::SaveResult Texture::convertAndSave(const char* fileName, FileType fileType,
+	Format format, Type type, Quality quality, Alpha alphaType, ColorMask colorMask,
+	unsigned int threads)
+{
+	if (!m_impl || !fileName)
 		return SaveResult::Invalid;
 
 	if (fileType == FileType::Auto)
 		fileType = Texture::fileType(fileName);
+	if (fileType == FileType::Auto)
+		return SaveResult::UnknownFormat;
 
-	std::ofstream stream(fileName, std::ofstream::binary);
-	if (!stream.is_open())
-		return SaveResult::WriteError;
-	return save(stream, fileType);
+	// Supercompression needs the data for each complete mip level, so save after converting.
+	if (fileType == FileType::KTX2 && m_impl->ktx2ZstdLevel > 0)
+	{
+		if (!convert(format, type, quality, alphaType, colorMask, threads))
+			return SaveResult::Invalid;
+		return save(fileName, fileType);
+	}
+
+	// The file layout is known once the texture data is laid out, which happens before the first
+	// surface is converted.
+	SurfaceWriter writer;
+	SaveResult gatherResult = SaveResult::Success;
+	bool writing = false;
+	Converter::SurfaceCallback surfaceConverted =
+		[&](unsigned int mip, unsigned int depth, unsigned int face)
+		{
+			if (!writing && gatherResult == SaveResult::Success)
+			{
+				OutputSlices output;
+				gatherResult = gatherSaveSlices(output, *this, fileType);
+				if (gatherResult == SaveResult::Success)
+				{
+					if (writer.begin(fileName, output, m_impl->textures.data(),
+							m_impl->textures.size()))
+					{
+						writing = true;
+					}
+					else
+						gatherResult = SaveResult::WriteError;
+				}
+			}
+
+			if (writing)
+			{
+				writer.add(m_impl->textures.data(mip, depth, face),
+					m_impl->textures.size(mip, depth, face));
+			}
+		};
+
+	m_impl->surfaceConverted = &surfaceConverted;
+	m_impl->surfaceWriter = &writer;
+	bool success = convert(format, type, quality, alphaType, colorMask, threads);
+	m_impl->surfaceConverted = nullptr;
+	m_impl->surfaceWriter = nullptr;
+
+	// The writer removes the incomplete file if conversion or writing fails.
+	if (!success)
+		return SaveResult::Invalid;
+	bool written = writing && writer.end();
+	if (gatherResult != SaveResult::Success)
+		return gatherResult;
+	return written ? SaveResult::Success : SaveResult::WriteError;
 }
 
-Texture::SaveResult Texture::save(std::ostream& stream, Texture::FileType fileType)
+Texture::SaveResult Texture::convertStreaming(RowSource& source, const char* fileName,
+	FileType fileType, Format format, Type type, Quality quality, Alpha alphaType,
+	ColorMask colorMask, std::size_t memoryBudget, unsigned int threads)
 {
-	if (!converted())
+	if (!m_impl || m_impl->dimension != Dimension::Dim2D || m_impl->depth > 0 || !fileName ||
+		!isFormatValid(format, type))
+	{
+		return SaveResult::Invalid;
+	}
+
+	// PVRTC can't be split into bands since blocks depend on their neighbors.
+	if (isPvrtc(format))
+		return SaveResult::Unsupported;
+
+	if ((m_impl->colorSpace == ColorSpace::sRGB && !hasNativeSRGB(format, type)) ||
+		!isEncoderSupported(format, type, encoder(format)))
+	{
 		return SaveResult::Invalid;
+	}
+
+	if (fileType == FileType::Auto)
+		fileType = Texture::fileType(fileName);
+	if (fileType == FileType::KTX2)
+		return SaveResult::Unsupported;
+	if (fileType != FileType::DDS && fileType != FileType::KTX && fileType != FileType::PVR)
+		return SaveResult::UnknownFormat;
+	if (!isFormatValid(format, type, fileType))
+		return SaveResult::Unsupported;
 
+	if (threads == allCores)
+		threads = std::thread::hardware_concurrency();
+
+	// Write to a temporary file so a failure doesn't leave a truncated file behind.
+	std::string tempName = tempFileName(fileName);
+	std::ofstream stream(tempName, std::ofstream::binary | std::ofstream::trunc);
+	if (!stream.is_open())
+		return SaveResult::WriteError;
+
+	m_impl->format = format;
+	m_impl->type = type;
+	m_impl->alphaType = alphaType;
+	m_impl->colorMask = colorMask;
+	m_impl->textures.reset();
+	m_impl->releaseMapping();
+	m_impl->qualityMetrics.clear();
+	m_impl->incrementalBlocks = IncrementalBlocks();
+	m_impl->adaptiveRefinedBlocks = 0;
+
+	SaveResult result;
 	switch (fileType)
 	{
 		case FileType::DDS:
-			return saveDds(*this, stream);
+			result = saveDdsHeader(*this, stream);
+			break;
 		case FileType::KTX:
-			return saveKtx(*this, stream);
+			result = saveKtxHeader(*this, stream);
+			break;
 		case FileType::PVR:
-			return savePvr(*this, stream);
+			result = savePvrHeader(*this, stream);
+			break;
 		default:
-			return SaveResult::UnknownFormat;
+			assert(false);
+			result = SaveResult::UnknownFormat;
+			break;
 	}
+
+	if (result == SaveResult::Success)
+	{
+		std::unique_ptr<BlockCache> blockCache;
+		if (m_impl->blockCacheEnabled)
+			blockCache.reset(new BlockCache);
+
+		StreamingConverter converter(*this, quality, memoryBudget, threads, blockCache.get());
+		result = converter.convert(source, stream, fileType);
+		m_impl->adaptiveRefinedBlocks = converter.refinedBlocks();
+		m_impl->blockCacheLookups = blockCache ? blockCache->lookups() : 0;
+		m_impl->blockCacheHits = blockCache ? blockCache->hits() : 0;
+	}
+
+	stream.close();
+	if (result == SaveResult::Success && stream.fail())
+		result = SaveResult::WriteError;
+	if (result != SaveResult::Success)
+	{
+		std::remove(tempName.c_str());
+		return result;
+	}
+
+	return replaceFile(tempName.c_str(), fileName) ? SaveResult::Success :
+		SaveResult::WriteError;
 }
 
-Texture::SaveResult Texture::save(std::vector<std::uint8_t>& outData, Texture::FileType fileType)
+bool Texture::converted() const
+{
+	return m_impl && (!m_impl->textures.empty() || !m_impl->mappedSurfaces.empty());
+}
+
+Texture::Format Texture::format() const
+{
+	if (!m_impl)
+		return Format::Unknown;
+
+	return m_impl->format;
+}
+
+Texture::Type Texture::type() const
+{
+	if (!m_impl)
+		return Type::UNorm;
+
+	return m_impl->type;
+}
+
+Texture::Alpha Texture::alphaType() const
+{
+	if (!m_impl)
+		return Alpha::None;
+
+	return m_impl->alphaType;
+}
+
+Texture::ColorMask Texture::colorMask() const
+{
+	if (!m_impl)
+		return ColorMask();
+
+	return m_impl->colorMask;
+}
+
+std::size_t Texture::dataSize(unsigned int mipLevel, unsigned int depth) const
+{
+	if (!converted() || depth >= Texture::depth(mipLevel) || m_impl->faces != 1)
+		return 0;
+
+	if (!m_impl->mappedSurfaces.empty())
+		return TextureArena::imageSize(m_impl->format, width(mipLevel), height(mipLevel));
+	return m_impl->textures.size(mipLevel, depth, 0);
+}
+
+std::size_t Texture::dataSize(CubeFace face, unsigned int mipLevel, unsigned int depth) const
+{
+	if (!converted() || depth >= Texture::depth(mipLevel) ||
+		(m_impl->faces != 6 && face != CubeFace::PosX))
+	{
+		return 0;
+	}
+
+	if (!m_impl->mappedSurfaces.empty())
+		return TextureArena::imageSize(m_impl->format, width(mipLevel), height(mipLevel));
+	return m_impl->textures.size(mipLevel, depth, static_cast<unsigned int>(face));
+}
+
+const void* Texture::data(unsigned int mipLevel, unsigned int depth) const
+{
+	if (!converted() || depth >= Texture::depth(mipLevel) || m_impl->faces != 1)
+		return nullptr;
+
+	if (!m_impl->mappedSurfaces.empty())
+		return m_impl->mappedData(mipLevel, depth, 0);
+	return m_impl->textures.data(mipLevel, depth, 0);
+}
+
+const void* Texture::data(CubeFace face, unsigned int mipLevel, unsigned int depth) const
+{
+	if (!converted() || depth >= Texture::depth(mipLevel) ||
+		(m_impl->faces != 6 && face != CubeFace::PosX))
+	{
+		return nullptr;
+	}
+
+	if (!m_impl->mappedSurfaces.empty())
+		return m_impl->mappedData(mipLevel, depth, static_cast<unsigned int>(face));
+	return m_impl->textures.data(mipLevel, depth, static_cast<unsigned int>(face));
+}
+
+bool Texture::decode(Image& outImage, unsigned int mipLevel, unsigned int depth,
+	unsigned int threads) const
+{
+	const void* textureData = data(mipLevel, depth);
+	if (!textureData)
+		return false;
+
+	return decode(outImage, textureData, dataSize(mipLevel, depth), format(), type(),
+		width(mipLevel), height(mipLevel), colorSpace(), threads);
+}
+
+bool Texture::decode(Image& outImage, CubeFace face, unsigned int mipLevel, unsigned int depth,
+	unsigned int threads) const
 {
-	// Implementations of stringstream typically don't differentiate between text and binary, but
-	// the standard doesn't guarantee this.
-	std::stringstream stream(std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+	const void* textureData = data(face, mipLevel, depth);
+	if (!textureData)
+		return false;
+
+	return decode(outImage, textureData, dataSize(face, mipLevel, depth), format(), type(),
+		width(mipLevel), height(mipLevel), colorSpace(), threads);
+}
+
+void Texture::setKtx2ZstdLevel(unsigned int level)
+{
+	if (m_impl)
+		m_impl->ktx2ZstdLevel = level;
+}
+
+unsigned int Texture::ktx2ZstdLevel() const
+{
+	return m_impl ? m_impl->ktx2ZstdLevel : 0;
+}
+
+bool Texture::load(const char* fileName, FileType fileType)
+{
+	reset();
+	if (!fileName)
+		return false;
+
+	if (fileType == FileType::Auto)
+		fileType = Texture::fileType(fileName);
+
+	std::shared_ptr<MappedFile> file(new MappedFile);
+	if (!file->open(fileName))
+		return false;
+
+	LoadedTexture loaded;
+	bool success;
+	switch (fileType)
+	{
+		case FileType::DDS:
+			success = loadDds(loaded, file->data(), file->size());
+			break;
+		case FileType::KTX:
+			success = loadKtx(loaded, file->data(), file->size());
+			break;
+		case FileType::PVR:
+			success = loadPvr(loaded, file->data(), file->size());
+			break;
+		default:
+			success = false;
+			break;
+	}
+
+	if (!success || !initialize(loaded.dimension, loaded.width, loaded.height, loaded.depth,
+			loaded.mipLevels, loaded.colorSpace) || m_impl->mipLevels != loaded.mipLevels)
+	{
+		reset();
+		return false;
+	}
+
+	m_impl->format = loaded.format;
+	m_impl->type = loaded.type;
+	m_impl->alphaType = loaded.alphaType;
+
+	if (!loaded.hasRowPadding())
+	{
+		m_impl->mappedFile = std::move(file);
+		m_impl->mappedSurfaces = std::move(loaded.surfaces);
+		return true;
+	}
 
-	SaveResult ret = save(stream, fileType);
-	if (ret == SaveResult::Success)
+	// Padded rows are copied so the data is tightly packed, as it is after converting.
+	if (!m_impl->textures.initialize(*this, m_impl->images))
 	{
-		readStreamData(outData, stream);
-		assert(!outData.empty());
+		reset();
+		return false;
+	}
+
+	std::size_t index = 0;
+	unsigned int formatSize = blockSize(loaded.format);
+	for (unsigned int mip = 0; mip < loaded.mipLevels; ++mip)
+	{
+		std::size_t rowSize = static_cast<std::size_t>(width(mip))*formatSize;
+		std::size_t srcRowSize = loaded.surfaceSize(mip)/height(mip);
+		for (unsigned int d = 0; d < depth(mip); ++d)
+		{
+			for (unsigned int f = 0; f < m_impl->faces; ++f, ++index)
+			{
+				const std::uint8_t* srcData = loaded.surfaces[index];
+				std::uint8_t* dstData = m_impl->textures.data(mip, d, f);
+				assert(m_impl->textures.size(mip, d, f) == rowSize*height(mip));
+				for (unsigned int y = 0; y < height(mip); ++y)
+					std::memcpy(dstData + y*rowSize, srcData + y*srcRowSize, rowSize);
+			}
+		}
 	}
-	return ret;
+
+	return true;
+}
+
+Texture::SaveResult Texture::transcode(const char* inputFileName, const char* outputFileName,
+	FileType inputFileType, FileType outputFileType, unsigned int ktx2ZstdLevel)
+{
+	Texture texture;
+	if (!texture.load(inputFileName, inputFileType))
+		return SaveResult::Invalid;
+
+	texture.setKtx2ZstdLevel(ktx2ZstdLevel);
+	return texture.save(outputFileName, outputFileType);
+}
+
+Texture::SaveResult Texture::save(const char* fileName, FileType fileType)
+{
+	if (!converted() || !fileName)
+		return SaveResult::Invalid;
+
+	if (fileType == FileType::Auto)
+		fileType = Texture::fileType(fileName);
+
+	OutputSlices output;
+	SaveResult ret = gatherSaveSlices(output, *this, fileType);
+	if (ret != SaveResult::Success)
+		return ret;
+
+	return output.write(fileName) ? SaveResult::Success : SaveResult::WriteError;
+}
+
+Texture::SaveResult Texture::save(std::ostream& stream, Texture::FileType fileType)
+{
+	OutputSlices output;
+	SaveResult ret = gatherSaveSlices(output, *this, fileType);
+	if (ret != SaveResult::Success)
+		return ret;
+
+	return output.write(stream) ? SaveResult::Success : SaveResult::WriteError;
+}
+
+Texture::SaveResult Texture::save(std::vector<std::uint8_t>& outData, Texture::FileType fileType)
+{
+	OutputSlices output;
+	SaveResult ret = gatherSaveSlices(output, *this, fileType);
+	if (ret != SaveResult::Success)
+		return ret;
+
+	outData.resize(output.size());
+	return output.write(outData.data(), outData.size()) ? SaveResult::Success :
+		SaveResult::WriteError;
+}
+
+Texture::SaveResult Texture::save(void* outData, std::size_t size, FileType fileType)
+{
+	if (!outData)
+		return SaveResult::Invalid;
+
+	OutputSlices output;
+	SaveResult ret = gatherSaveSlices(output, *this, fileType);
+	if (ret != SaveResult::Success)
+		return ret;
+
+	return output.write(outData, size) ? SaveResult::Success : SaveResult::WriteError;
+}
+
+std::size_t Texture::savedSize(FileType fileType) const
+{
+	OutputSlices output;
+	if (gatherSaveSlices(output, *this, fileType) != SaveResult::Success)
+		return 0;
+
+	return output.size();
 }
 
 } // namespace cuttlefish
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureArena.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace cuttlefish
+{
+
+std::size_t TextureArena::imageSize(Texture::Format format, unsigned int width,
+	unsigned int height)
+{
+	unsigned int blockWidth = Texture::blockWidth(format);
+	unsigned int blockHeight = Texture::blockHeight(format);
+	if (blockWidth == 0 || blockHeight == 0)
+		return 0;
+
+	width = std::max(width, Texture::minWidth(format));
+	height = std::max(height, Texture::minHeight(format));
+	std::size_t blocksX = (width + blockWidth - 1)/blockWidth;
+	std::size_t blocksY = (height + blockHeight - 1)/blockHeight;
+	return blocksX*blocksY*Texture::blockSize(format);
+}
+
+TextureArena::TextureArena()
+	: m_size(0), m_faces(0)
+{
+}
+
+TextureArena::TextureArena(const TextureArena& other)
+	: TextureArena()
+{
+	*this = other;
+}
+
+TextureArena::TextureArena(TextureArena&& other) noexcept
+	: m_data(std::move(other.m_data)), m_size(other.m_size), m_faces(other.m_faces),
+	m_mipStarts(std::move(other.m_mipStarts)), m_offsets(std::move(other.m_offsets))
+{
+	other.reset();
+}
+
+TextureArena& TextureArena::operator=(const TextureArena& other)
+{
+	if (this == &other)
+		return *this;
+
+	reset();
+	if (!other.m_data)
+		return *this;
+
+	m_data = other.m_data;
+	m_size = other.m_size;
+	m_faces = other.m_faces;
+	m_mipStarts = other.m_mipStarts;
+	m_offsets = other.m_offsets;
+	return *this;
+}
+
+TextureArena& TextureArena::operator=(TextureArena&& other) noexcept
+{
+	if (this == &other)
+		return *this;
+
+	m_data = std::move(other.m_data);
+	m_size = other.m_size;
+	m_faces = other.m_faces;
+	m_mipStarts = std::move(other.m_mipStarts);
+	m_offsets = std::move(other.m_offsets);
+	other.reset();
+	return *this;
+}
+
+bool TextureArena::initialize(const Texture& texture, const MipImageList& images)
+{
+	reset();
+	if (images.empty() || images[0].empty() || images[0][0].empty())
+		return false;
+
+	m_faces = static_cast<unsigned int>(images[0][0].size());
+	m_mipStarts.reserve(images.size() + 1);
+	for (unsigned int mip = 0; mip < images.size(); ++mip)
+	{
+		// Mip levels may be generated during conversion, in which case the images won't be present
+		// yet.
+		m_mipStarts.push_back(m_offsets.size());
+		const Image* firstImage = images[mip].empty() || images[mip][0].empty() ? nullptr :
+			&images[mip][0][0];
+		std::size_t imageSize;
+		if (firstImage && firstImage->isValid())
+		{
+			imageSize = TextureArena::imageSize(texture.format(), firstImage->width(),
+				firstImage->height());
+		}
+		else
+		{
+			imageSize = TextureArena::imageSize(texture.format(), texture.width(mip),
+				texture.height(mip));
+		}
+		if (imageSize == 0)
+		{
+			reset();
+			return false;
+		}
+
+		for (const std::vector<Image>& faceImages : images[mip])
+		{
+			if (faceImages.size() != m_faces)
+			{
+				reset();
+				return false;
+			}
+
+			for (unsigned int f = 0; f < m_faces; ++f)
+			{
+				m_offsets.push_back(m_size);
+				m_size += imageSize;
+			}
+		}
+	}
+	m_mipStarts.push_back(m_offsets.size());
+	m_offsets.push_back(m_size);
+
+	std::uint8_t* data = new (std::nothrow) std::uint8_t[m_size];
+	if (!data)
+	{
+		reset();
+		return false;
+	}
+
+	m_data.reset(data, std::default_delete<std::uint8_t[]>());
+	return true;
+}
+
+void TextureArena::reset()
+{
+	m_data.reset();
+	m_size = 0;
+	m_faces = 0;
+	m_mipStarts.clear();
+	m_offsets.clear();
+}
+
+std::uint8_t* TextureArena::data()
+{
+	detach();
+	return m_data.get();
+}
+
+std::uint8_t* TextureArena::data(unsigned int mip, unsigned int depth, unsigned int face)
+{
+	std::size_t index;
+	if (!getIndex(index, mip, depth, face))
+		return nullptr;
+
+	detach();
+	return m_data.get() + m_offsets[index];
+}
+
+const std::uint8_t* TextureArena::data(unsigned int mip, unsigned int depth,
+	unsigned int face) const
+{
+	std::size_t index;
+	if (!getIndex(index, mip, depth, face))
+		return nullptr;
+
+	return m_data.get() + m_offsets[index];
+}
+
+std::size_t TextureArena::size(unsigned int mip, unsigned int depth, unsigned int face) const
+{
+	std::size_t index;
+	if (!getIndex(index, mip, depth, face))
+		return 0;
+
+	return m_offsets[index + 1] - m_offsets[index];
+}
+
+bool TextureArena::getIndex(std::size_t& outIndex, unsigned int mip, unsigned int depth,
+	unsigned int face) const
+{
+	if (!m_data || mip + 1 >= m_mipStarts.size() || face >= m_faces)
+		return false;
+
+	outIndex = m_mipStarts[mip] + depth*m_faces + face;
+	return outIndex < m_mipStarts[mip + 1];
+}
+
+void TextureArena::detach()
+{
+	if (!m_data || m_data.use_count() == 1)
+		return;
+
+	std::shared_ptr<std::uint8_t> data(new std::uint8_t[m_size],
+		std::default_delete<std::uint8_t[]>());
+	std::memcpy(data.get(), m_data.get(), m_size);
+	m_data = std::move(data);
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Config.h>
+#include <cuttlefish/Export.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace cuttlefish
+{
+
+// Converted data for every image of a texture in a single allocation. Images are ordered by mip
+// level, depth, then face, which matches the layout of KTX and PVR files. Copies share the data
+// until the non-const data accessors are called on one of them.
+class CUTTLEFISH_EXPORT TextureArena
+{
+public:
+	// Same layout as Converter::MipImageList.
+	using MipImageList = std::vector<std::vector<std::vector<Image>>>;
+
+	// The size of the converted data for a single image.
+	static std::size_t imageSize(Texture::Format format, unsigned int width, unsigned int height);
+
+	TextureArena();
+	TextureArena(const TextureArena& other);
+	TextureArena(TextureArena&& other) noexcept;
+
+	TextureArena& operator=(const TextureArena& other);
+	TextureArena& operator=(TextureArena&& other) noexcept;
+
+	// Lays out the data for the texture's format, taking the number of depth levels and faces for
+	// each mip level from images. The dimensions are taken from the first image of each mip level,
+	// or from the texture if it isn't present. The memory isn't initialized.
+	bool initialize(const Texture& texture, const MipImageList& images);
+	void reset();
+
+	bool empty() const {return !m_data;}
+
+	std::uint8_t* data();
+	const std::uint8_t* data() const {return m_data.get();}
+	std::size_t size() const {return m_size;}
+
+	// Returns null or 0 if the indices are out of range.
+	std::uint8_t* data(unsigned int mip, unsigned int depth, unsigned int face);
+	const std::uint8_t* data(unsigned int mip, unsigned int depth, unsigned int face) const;
+	std::size_t size(unsigned int mip, unsigned int depth, unsigned int face) const;
+
+private:
+	bool getIndex(std::size_t& outIndex, unsigned int mip, unsigned int depth,
+		unsigned int face) const;
+	void detach();
+
+	std::shared_ptr<std::uint8_t> m_data;
+	std::size_t m_size;
+	unsigned int m_faces;
+
+	// Index of the first image for each mip level, with the total image count at the end.
+	std::vector<std::size_t> m_mipStarts;
+
+	// Offset for each image, with the total size at the end.
+	std::vector<std::size_t> m_offsets;
+};
+
+} // namespace cuttlefish
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BlockCache.h"
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+#include <gtest/gtest.h>
+#include <cstring>
+
+namespace cuttlefish
+{
+
+TEST(BlockCacheTest, ComputeKey)
+{
+	std::uint8_t data[20];
+	for (unsigned int i = 0; i < sizeof(data); ++i)
+		data[i] = static_cast<std::uint8_t>(i);
+
+	BlockCache::Key key = BlockCache::computeKey(data, sizeof(data));
+	EXPECT_EQ(key, BlockCache::computeKey(data, sizeof(data)));
+	EXPECT_FALSE(key == BlockCache::computeKey(data, sizeof(data), 1));
+	EXPECT_FALSE(key == BlockCache::computeKey(data, sizeof(data) - 1));
+
+	data[17] = 0;
+	EXPECT_FALSE(key == BlockCache::computeKey(data, sizeof(data)));
+}
+
+TEST(BlockCacheTest, FindInsert)
+{
+	BlockCache cache;
+	const std::uint8_t source[2] = {1, 2};
+	BlockCache::Key key = BlockCache::computeKey(source, sizeof(source));
+
+	std::uint8_t block[8] = {};
+	EXPECT_FALSE(cache.find(block, key, sizeof(block)));
+
+	const std::uint8_t encoded[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+	cache.insert(key, encoded, sizeof(encoded));
+	EXPECT_TRUE(cache.find(block, key, sizeof(block)));
+	EXPECT_EQ(0, std::memcmp(encoded, block, sizeof(block)));
+
+	EXPECT_EQ(2U, cache.lookups());
+	EXPECT_EQ(1U, cache.hits());
+}
+
+#if CUTTLEFISH_HAS_ETC || CUTTLEFISH_HAS_ASTC
+// The block cache must not change the encoder that's used, including for the low qualities that
+// encode full rows of blocks at a time.
+static void testConvertMatches(Texture::Format format, Texture::Quality quality)
+{
+	// Repeated tiles to find blocks in the cache, a flat region for constant blocks, and a width
+	// that isn't a multiple of the block size for partial blocks.
+	Image image(Image::Format::RGBAF, 30, 16);
+	for (unsigned int y = 0; y < image.height(); ++y)
+	{
+		for (unsigned int x = 0; x < image.width(); ++x)
+		{
+			ColorRGBAd color(0.25, 0.5, 0.75, 1.0);
+			if (x >= 8)
+				color = ColorRGBAd((x % 8)/8.0, (y % 8)/8.0, ((x + y) % 8)/8.0, 1.0);
+			EXPECT_TRUE(image.setPixel(x, y, color));
+		}
+	}
+
+	Texture texture(Texture::Dimension::Dim2D, image.width(), image.height());
+	ASSERT_TRUE(texture.setImage(image));
+	ASSERT_TRUE(texture.convert(format, Texture::Type::UNorm, quality));
+
+	Texture cachedTexture(Texture::Dimension::Dim2D, image.width(), image.height());
+	cachedTexture.setBlockCacheEnabled(true);
+	ASSERT_TRUE(cachedTexture.setImage(image));
+	ASSERT_TRUE(cachedTexture.convert(format, Texture::Type::UNorm, quality));
+	EXPECT_LT(0U, cachedTexture.blockCacheHits());
+
+	ASSERT_EQ(texture.dataSize(), cachedTexture.dataSize());
+	EXPECT_EQ(0, std::memcmp(texture.data(), cachedTexture.data(), texture.dataSize()));
+}
+#endif
+
+#if CUTTLEFISH_HAS_ETC
+TEST(BlockCacheTest, EtcConvertMatches)
+{
+	testConvertMatches(Texture::Format::ETC1, Texture::Quality::Lowest);
+	testConvertMatches(Texture::Format::ETC2_R8G8B8, Texture::Quality::Low);
+}
+#endif
+
+#if CUTTLEFISH_HAS_ASTC
+TEST(BlockCacheTest, AstcConvertMatches)
+{
+	testConvertMatches(Texture::Format::ASTC_4x4, Texture::Quality::Preview);
+	testConvertMatches(Texture::Format::ASTC_6x6, Texture::Quality::Low);
+}
+#endif
+
+} // namespace cuttlefish
@@ -0,0 +1,402 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BlockDecoder.h"
+#include "ConstantBlock.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+std::uint64_t setBits(std::uint64_t bits, std::uint64_t value, unsigned int shift)
+{
+	return bits | (value << shift);
+}
+
+void writeBigEndian64(std::uint8_t block[8], std::uint64_t bits)
+{
+	for (unsigned int i = 0; i < 8; ++i)
+		block[i] = static_cast<std::uint8_t>(bits >> ((7 - i)*8));
+}
+
+// Sets the bits unused by the ETC2 T, H, and planar modes to overflow the differential color for
+// the channel that selects the mode.
+std::uint64_t forceEtc2Overflow(std::uint64_t bits, unsigned int channel, std::uint64_t freeBits)
+{
+	for (std::uint64_t subset = freeBits;; subset = (subset - 1) & freeBits)
+	{
+		std::uint64_t candidate = bits | subset;
+		bool valid = true;
+		for (unsigned int c = 0; c <= channel && valid; ++c)
+		{
+			int first = static_cast<int>((candidate >> (59 - c*8)) & 0x1F);
+			int delta = static_cast<int>((candidate >> (56 - c*8)) & 0x7);
+			int second = first + (delta >= 4 ? delta - 8 : delta);
+			bool overflow = second < 0 || second > 31;
+			valid = overflow == (c == channel);
+		}
+
+		if (valid)
+			return candidate;
+		if (subset == 0)
+			break;
+	}
+
+	ADD_FAILURE() << "Couldn't force ETC2 overflow.";
+	return bits;
+}
+
+} // namespace
+
+TEST(BlockDecoderTest, BlockError)
+{
+	ColorRGBAf colors[2] = {ColorRGBAf(0.5f, 0.5f, 0.5f, 1.0f), ColorRGBAf(0.5f, 0.5f, 0.5f, 1.0f)};
+	ColorRGBAf decodedColors[2] =
+		{ColorRGBAf(0.5f, 0.5f, 0.5f, 0.0f), ColorRGBAf(0.7f, 0.5f, 0.5f, 0.0f)};
+
+	EXPECT_FLOAT_EQ(std::sqrt(0.02f), getBlockError(colors, decodedColors, 2,
+		Texture::ColorMask(true, false, false, false)));
+	EXPECT_FLOAT_EQ(0.0f, getBlockError(colors, decodedColors, 2,
+		Texture::ColorMask(false, true, true, false)));
+	EXPECT_FLOAT_EQ(std::sqrt(0.04f/6.0f), getBlockError(colors, decodedColors, 2,
+		Texture::ColorMask(true, true, true, false)));
+}
+
+TEST(BlockDecoderTest, Bc1)
+{
+	const std::uint8_t testColors[][3] =
+		{{0, 0, 0}, {0xFF, 0xFF, 0xFF}, {0x12, 0x34, 0x56}, {0xC8, 0x7D, 0x01}};
+	for (const std::uint8_t* color : testColors)
+	{
+		std::uint8_t block[8];
+		encodeConstantBc1(block, color);
+
+		std::uint8_t decoded[16][4];
+		decodeBc1(decoded, block, true);
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			for (unsigned int c = 0; c < 3; ++c)
+				EXPECT_GE(1, std::abs(decoded[i][c] - color[c]));
+			EXPECT_EQ(0xFF, decoded[i][3]);
+		}
+	}
+
+	std::uint8_t block[8];
+	std::uint8_t decoded[16][4];
+	encodeTransparentBc1(block);
+	decodeBc1(decoded, block, true);
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		for (unsigned int c = 0; c < 4; ++c)
+			EXPECT_EQ(0, decoded[i][c]);
+	}
+
+	// Always uses 4 color mode for BC2 and BC3.
+	decodeBc1(decoded, block, false);
+	EXPECT_EQ(0xFF, decoded[0][3]);
+}
+
+TEST(BlockDecoderTest, Bc2)
+{
+	std::uint8_t block[16] = {0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE};
+	const std::uint8_t color[3] = {0xFF, 0, 0xFF};
+	encodeConstantBc1(block + 8, color);
+
+	std::uint8_t decoded[16][4];
+	decodeBc2(decoded, block);
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		EXPECT_EQ(0xFF, decoded[i][0]);
+		EXPECT_EQ(0, decoded[i][1]);
+		EXPECT_EQ(0xFF, decoded[i][2]);
+		EXPECT_EQ(i*0x11, decoded[i][3]);
+	}
+}
+
+TEST(BlockDecoderTest, Bc3)
+{
+	std::uint8_t block[16];
+	const std::uint8_t color[3] = {0, 0xFF, 0};
+	encodeConstantBc4(block, 0x80);
+	encodeConstantBc1(block + 8, color);
+
+	std::uint8_t decoded[16][4];
+	decodeBc3(decoded, block);
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		EXPECT_EQ(0, decoded[i][0]);
+		EXPECT_EQ(0xFF, decoded[i][1]);
+		EXPECT_EQ(0, decoded[i][2]);
+		EXPECT_EQ(0x80, decoded[i][3]);
+	}
+}
+
+TEST(BlockDecoderTest, Bc4)
+{
+	std::uint8_t block[8];
+	std::uint8_t decoded[16];
+	for (unsigned int value = 0; value < 0x100; ++value)
+	{
+		encodeConstantBc4(block, static_cast<std::uint8_t>(value));
+		decodeBc4(decoded, block, 1);
+		for (unsigned int i = 0; i < 16; ++i)
+			EXPECT_EQ(value, decoded[i]);
+	}
+
+	// Interpolated values with 8 and 6 value modes.
+	const std::uint8_t interpolatedBlock[8] = {0xFF, 0, 0x88, 0x88, 0x88, 0x88, 0x88, 0x88};
+	decodeBc4(decoded, interpolatedBlock, 1);
+	EXPECT_EQ(0xFF, decoded[0]);
+	EXPECT_EQ(0, decoded[1]);
+	EXPECT_EQ(0xDB, decoded[2]);
+
+	const std::uint8_t sixValueBlock[8] = {0, 0xFF, 0xAB, 0x0F, 0, 0, 0, 0};
+	decodeBc4(decoded, sixValueBlock, 1);
+	EXPECT_EQ(0x66, decoded[0]);
+	EXPECT_EQ(0xCC, decoded[1]);
+	EXPECT_EQ(0, decoded[2]);
+	EXPECT_EQ(0xFF, decoded[3]);
+
+	std::int8_t signedDecoded[16];
+	for (int value = -127; value <= 127; ++value)
+	{
+		encodeConstantBc4S(block, static_cast<std::int8_t>(value));
+		decodeBc4S(signedDecoded, block, 1);
+		for (unsigned int i = 0; i < 16; ++i)
+			EXPECT_EQ(value, signedDecoded[i]);
+	}
+}
+
+TEST(BlockDecoderTest, Bc7)
+{
+	const std::uint8_t testColors[][4] =
+	{
+		{0, 0, 0, 0}, {0xFF, 0xFF, 0xFF, 0xFF}, {0x12, 0x34, 0x56, 0x78},
+		{0xC8, 0x7D, 0x01, 0xFF}
+	};
+	for (const std::uint8_t* color : testColors)
+	{
+		std::uint8_t block[16];
+		encodeConstantBc7(block, color);
+
+		std::uint8_t decoded[16][4];
+		decodeBc7(decoded, block);
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			for (unsigned int c = 0; c < 4; ++c)
+				EXPECT_EQ(color[c], decoded[i][c]);
+		}
+	}
+
+	// Invalid mode.
+	std::uint8_t invalidBlock[16] = {};
+	std::uint8_t decoded[16][4];
+	decodeBc7(decoded, invalidBlock);
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		for (unsigned int c = 0; c < 4; ++c)
+			EXPECT_EQ(0, decoded[i][c]);
+	}
+}
+
+TEST(BlockDecoderTest, Etc2)
+{
+	const std::uint8_t testColors[][3] =
+		{{0, 0, 0}, {0xFF, 0xFF, 0xFF}, {0x12, 0x34, 0x56}, {0xC8, 0x7D, 0x01}};
+	for (const std::uint8_t* color : testColors)
+	{
+		std::uint8_t block[8];
+		encodeConstantEtc1(block, color);
+
+		std::uint8_t decoded[16][4];
+		decodeEtc2(decoded, block, false);
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			for (unsigned int c = 0; c < 3; ++c)
+				EXPECT_GE(4, std::abs(decoded[i][c] - color[c]));
+			EXPECT_EQ(0xFF, decoded[i][3]);
+		}
+
+		// Also valid for opaque punch-through alpha blocks.
+		decodeEtc2(decoded, block, true);
+		EXPECT_EQ(0xFF, decoded[0][3]);
+	}
+
+	// Individual mode with red for the left sub-block and black for the right, with a modifier of
+	// +2 for all pixels.
+	std::uint8_t block[8];
+	std::uint8_t decoded[16][4];
+	writeBigEndian64(block, setBits(0, 0xF, 60));
+	decodeEtc2(decoded, block, false);
+	for (unsigned int y = 0; y < 4; ++y)
+	{
+		for (unsigned int x = 0; x < 4; ++x)
+		{
+			const std::uint8_t* color = decoded[y*4 + x];
+			EXPECT_EQ(x < 2 ? 0xFF : 2, color[0]);
+			EXPECT_EQ(2, color[1]);
+			EXPECT_EQ(2, color[2]);
+		}
+	}
+
+	encodeTransparentEtc2A1(block);
+	decodeEtc2(decoded, block, true);
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		for (unsigned int c = 0; c < 4; ++c)
+			EXPECT_EQ(0, decoded[i][c]);
+	}
+}
+
+TEST(BlockDecoderTest, Etc2T)
+{
+	// First color red, second color half green, distance 3, and selector i & 3 for pixel i.
+	std::uint64_t bits = setBits(0, 0x3, 59);
+	bits = setBits(bits, 0x3, 56);
+	bits = setBits(bits, 0x8, 40);
+	bits = setBits(bits, 0x1, 33);
+	bits = setBits(bits, 0xCCCC, 16);
+	bits = setBits(bits, 0xAAAA, 0);
+	bits = forceEtc2Overflow(bits, 0, 0xE400000000000000ULL);
+
+	std::uint8_t block[8];
+	writeBigEndian64(block, bits);
+	std::uint8_t decoded[16][4];
+	decodeEtc2(decoded, block, false);
+
+	const std::uint8_t expectedColors[4][3] = {{0xFF, 0, 0}, {3, 139, 3}, {0, 136, 0}, {0, 133, 0}};
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		const std::uint8_t* expectedColor = expectedColors[i & 0x3];
+		const std::uint8_t* color = decoded[(i & 0x3)*4 + (i >> 2)];
+		for (unsigned int c = 0; c < 3; ++c)
+			EXPECT_EQ(expectedColor[c], color[c]);
+		EXPECT_EQ(0xFF, color[3]);
+	}
+
+	// Selector 2 is transparent for punch-through alpha when the opaque bit isn't set.
+	writeBigEndian64(block, bits & ~(1ULL << 33));
+	decodeEtc2(decoded, block, true);
+	EXPECT_EQ(0xFF, decoded[0][3]);
+	EXPECT_EQ(0, decoded[8][3]);
+}
+
+TEST(BlockDecoderTest, Etc2H)
+{
+	// First color 0x8 and second color 0x4 for each channel, distance 6, and selector i & 3 for
+	// pixel i.
+	std::uint64_t bits = setBits(0, 0x8, 59);
+	bits = setBits(bits, 0x4, 56);
+	bits = setBits(bits, 0x1, 51);
+	bits = setBits(bits, 0x4, 43);
+	bits = setBits(bits, 0x4, 39);
+	bits = setBits(bits, 0x4, 35);
+	bits = setBits(bits, 0x1, 33);
+	bits = setBits(bits, 0xCCCC, 16);
+	bits = setBits(bits, 0xAAAA, 0);
+	bits = forceEtc2Overflow(bits, 1, 0x80E4000000000000ULL);
+
+	std::uint8_t block[8];
+	writeBigEndian64(block, bits);
+	std::uint8_t decoded[16][4];
+	decodeEtc2(decoded, block, false);
+
+	const std::uint8_t expectedValues[4] = {142, 130, 74, 62};
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		const std::uint8_t* color = decoded[(i & 0x3)*4 + (i >> 2)];
+		for (unsigned int c = 0; c < 3; ++c)
+			EXPECT_EQ(expectedValues[i & 0x3], color[c]);
+		EXPECT_EQ(0xFF, color[3]);
+	}
+}
+
+TEST(BlockDecoderTest, Etc2Planar)
+{
+	// Red increases horizontally, blue increases vertically, and green is constant.
+	std::uint64_t bits = setBits(0, 0x20, 57);
+	bits = setBits(bits, 0x1, 56);
+	bits = setBits(bits, 0x2, 43);
+	bits = setBits(bits, 0x1F, 34);
+	bits = setBits(bits, 0x1, 33);
+	bits = setBits(bits, 0x1, 32);
+	bits = setBits(bits, 0x40, 25);
+	bits = setBits(bits, 0x10, 19);
+	bits = setBits(bits, 0x20, 13);
+	bits = setBits(bits, 0x40, 6);
+	bits = setBits(bits, 0x3F, 0);
+	bits = forceEtc2Overflow(bits, 2, 0x8080E40000000000ULL);
+
+	std::uint8_t block[8];
+	writeBigEndian64(block, bits);
+	std::uint8_t decoded[16][4];
+	decodeEtc2(decoded, block, true);
+	for (int y = 0; y < 4; ++y)
+	{
+		for (int x = 0; x < 4; ++x)
+		{
+			const std::uint8_t* color = decoded[y*4 + x];
+			EXPECT_EQ((x*(255 - 130) + 4*130 + 2) >> 2, color[0]);
+			EXPECT_EQ(129, color[1]);
+			EXPECT_EQ((y*(255 - 65) + 4*65 + 2) >> 2, color[2]);
+			EXPECT_EQ(0xFF, color[3]);
+		}
+	}
+}
+
+TEST(BlockDecoderTest, Eac)
+{
+	std::uint8_t block[8];
+	std::uint8_t decoded[16];
+	for (unsigned int value = 0; value < 0x100; ++value)
+	{
+		encodeConstantEtc2Alpha(block, static_cast<std::uint8_t>(value));
+		decodeEtc2Alpha(decoded, block, 1);
+		for (unsigned int i = 0; i < 16; ++i)
+			EXPECT_EQ(value, decoded[i]);
+	}
+
+	std::uint16_t decoded11[16];
+	for (unsigned int value = 0; value < 2048; ++value)
+	{
+		encodeConstantEacR11(block, static_cast<std::uint16_t>(value));
+		decodeEacR11(decoded11, block, 1);
+		for (unsigned int i = 0; i < 16; ++i)
+			EXPECT_EQ(value, decoded11[i]);
+	}
+
+	std::int16_t signedDecoded11[16];
+	for (int value = -1023; value <= 1023; ++value)
+	{
+		encodeConstantEacR11S(block, static_cast<std::int16_t>(value));
+		decodeEacR11S(signedDecoded11, block, 1);
+		for (unsigned int i = 0; i < 16; ++i)
+			EXPECT_EQ(value, signedDecoded11[i]);
+	}
+
+	// Indices are stored in column-major order.
+	const std::uint8_t indexBlock[8] = {0x80, 0x1D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07};
+	decodeEtc2Alpha(decoded, indexBlock, 1);
+	EXPECT_EQ(0x80 + 9, decoded[15]);
+	EXPECT_EQ(0x80 - 1, decoded[0]);
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ConstantBlock.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+namespace cuttlefish
+{
+
+TEST(ConstantBlockTest, BlockRange)
+{
+	ColorRGBAf colors[4] =
+	{
+		ColorRGBAf(0.1f, 0.2f, 0.3f, 1.0f),
+		ColorRGBAf(0.1f, 0.25f, 0.3f, 0.0f),
+		ColorRGBAf(0.1f, 0.2f, 0.3f, 1.0f),
+		ColorRGBAf(0.1f, 0.2f, 0.3f, 0.5f)
+	};
+
+	EXPECT_FLOAT_EQ(1.0f, getBlockRange(colors, 4, Texture::ColorMask()));
+	EXPECT_FLOAT_EQ(0.05f, getBlockRange(colors, 4, Texture::ColorMask(true, true, true, false)));
+	EXPECT_FLOAT_EQ(0.0f, getBlockRange(colors, 4, Texture::ColorMask(true, false, true, false)));
+}
+
+TEST(ConstantBlockTest, IsBlockConstant)
+{
+	std::uint8_t colors[4][4] =
+	{
+		{1, 2, 3, 4},
+		{1, 2, 3, 5},
+		{1, 2, 3, 6},
+		{1, 2, 3, 7}
+	};
+
+	EXPECT_FALSE(isBlockConstant(colors[0], 4, 4, 4));
+	EXPECT_TRUE(isBlockConstant(colors[0], 4, 4, 3));
+	EXPECT_FALSE(isBlockConstant(colors[0] + 3, 4, 4, 1));
+}
+
+TEST(ConstantBlockTest, Bc1)
+{
+	std::uint8_t block[8];
+	const std::uint8_t white[3] = {0xFF, 0xFF, 0xFF};
+	const std::uint8_t expectedWhite[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0};
+	encodeConstantBc1(block, white);
+	EXPECT_EQ(0, std::memcmp(expectedWhite, block, sizeof(block)));
+
+	const std::uint8_t expectedTransparent[8] = {0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF};
+	encodeTransparentBc1(block);
+	EXPECT_EQ(0, std::memcmp(expectedTransparent, block, sizeof(block)));
+}
+
+TEST(ConstantBlockTest, Bc4)
+{
+	std::uint8_t block[8];
+	const std::uint8_t expected[8] = {0x12, 0x12, 0, 0, 0, 0, 0, 0};
+	encodeConstantBc4(block, 0x12);
+	EXPECT_EQ(0, std::memcmp(expected, block, sizeof(block)));
+
+	const std::uint8_t expectedSigned[8] = {0x81, 0x81, 0, 0, 0, 0, 0, 0};
+	encodeConstantBc4S(block, -127);
+	EXPECT_EQ(0, std::memcmp(expectedSigned, block, sizeof(block)));
+}
+
+TEST(ConstantBlockTest, Bc6H)
+{
+	std::uint8_t block[16];
+	const std::uint16_t black[3] = {0, 0, 0};
+	encodeConstantBc6H(block, black);
+	// Mode 11 with all endpoints and indices 0.
+	EXPECT_EQ(0x03, block[0]);
+	for (unsigned int i = 1; i < sizeof(block); ++i)
+		EXPECT_EQ(0, block[i]);
+}
+
+TEST(ConstantBlockTest, Bc7)
+{
+	std::uint8_t block[16];
+	const std::uint8_t color[4] = {0x80, 0x40, 0x20, 0xFF};
+	encodeConstantBc7(block, color);
+	// Mode 5 with no rotation.
+	EXPECT_EQ(0x20, block[0]);
+}
+
+TEST(ConstantBlockTest, Etc)
+{
+	std::uint8_t block[8];
+	const std::uint8_t black[3] = {0, 0, 0};
+	const std::uint8_t expectedBlack[8] = {0, 0, 0, 0x02, 0xFF, 0xFF, 0, 0};
+	encodeConstantEtc1(block, black);
+	EXPECT_EQ(0, std::memcmp(expectedBlack, block, sizeof(block)));
+
+	const std::uint8_t expectedTransparent[8] = {0, 0, 0, 0, 0xFF, 0xFF, 0, 0};
+	encodeTransparentEtc2A1(block);
+	EXPECT_EQ(0, std::memcmp(expectedTransparent, block, sizeof(block)));
+
+	const std::uint8_t expectedAlpha[8] = {0x34, 0x1D, 0x92, 0x49, 0x24, 0x92, 0x49, 0x24};
+	encodeConstantEtc2Alpha(block, 0x34);
+	EXPECT_EQ(0, std::memcmp(expectedAlpha, block, sizeof(block)));
+}
+
+TEST(ConstantBlockTest, Eac)
+{
+	std::uint8_t block[8];
+	const std::uint8_t expectedMax[8] = {0xFE, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+	encodeConstantEacR11(block, 2047);
+	EXPECT_EQ(0, std::memcmp(expectedMax, block, sizeof(block)));
+
+	// Minimum base with a modifier of 0.
+	const std::uint8_t expectedSigned[8] = {0x81, 0x0D, 0x92, 0x49, 0x24, 0x92, 0x49, 0x24};
+	encodeConstantEacR11S(block, -127*8);
+	EXPECT_EQ(0, std::memcmp(expectedSigned, block, sizeof(block)));
+}
+
+TEST(ConstantBlockTest, Astc)
+{
+	std::uint8_t block[16];
+	const std::uint16_t ldrColor[4] = {0xFFFF, 0x1234, 0, 0xFFFF};
+	const std::uint8_t expectedLdr[16] = {0xFC, 0xFD, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+		0xFF, 0xFF, 0x34, 0x12, 0, 0, 0xFF, 0xFF};
+	encodeConstantAstc(block, ldrColor, false);
+	EXPECT_EQ(0, std::memcmp(expectedLdr, block, sizeof(block)));
+
+	const std::uint16_t hdrColor[4] = {0x3C00, 0x3C00, 0x3C00, 0x3C00};
+	const std::uint8_t expectedHdr[16] = {0xFC, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+		0, 0x3C, 0, 0x3C, 0, 0x3C, 0, 0x3C};
+	encodeConstantAstc(block, hdrColor, true);
+	EXPECT_EQ(0, std::memcmp(expectedHdr, block, sizeof(block)));
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ContentAnalysis.h"
+#include "TestHelpers.h"
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+#include <gtest/gtest.h>
+
+namespace cuttlefish
+{
+
+static Texture::ContentProperties analyzeImage(const Image& image)
+{
+	Texture::ContentProperties properties = {true, true, true};
+	EXPECT_TRUE(analyzeContent(properties, image, 2));
+	return properties;
+}
+
+TEST(ContentAnalysisTest, Properties)
+{
+	// Width that isn't a multiple of 4 to test both the vectorized and remaining pixels.
+	Image image(Image::Format::RGBAF, 7, 5);
+	fillImage(image, ColorRGBAd(0.25, 0.25, 0.25, 1.0));
+	Texture::ContentProperties properties = analyzeImage(image);
+	EXPECT_TRUE(properties.opaqueAlpha);
+	EXPECT_TRUE(properties.binaryAlpha);
+	EXPECT_TRUE(properties.grayscale);
+
+	EXPECT_TRUE(image.setPixel(2, 3, ColorRGBAd(0.25, 0.5, 0.25, 0.0)));
+	properties = analyzeImage(image);
+	EXPECT_FALSE(properties.opaqueAlpha);
+	EXPECT_TRUE(properties.binaryAlpha);
+	EXPECT_FALSE(properties.grayscale);
+
+	fillImage(image, ColorRGBAd(0.25, 0.25, 0.25, 1.0));
+	EXPECT_TRUE(image.setPixel(6, 4, ColorRGBAd(0.25, 0.25, 0.5, 0.5)));
+	properties = analyzeImage(image);
+	EXPECT_FALSE(properties.opaqueAlpha);
+	EXPECT_FALSE(properties.binaryAlpha);
+	EXPECT_FALSE(properties.grayscale);
+}
+
+TEST(ContentAnalysisTest, Combine)
+{
+	Image image(Image::Format::RGBAF, 8, 4);
+	fillImage(image, ColorRGBAd(1.0, 0.0, 0.0, 1.0));
+
+	Texture::ContentProperties properties = {true, true, false};
+	EXPECT_TRUE(analyzeContent(properties, image, 1));
+	EXPECT_TRUE(properties.opaqueAlpha);
+	EXPECT_TRUE(properties.binaryAlpha);
+	EXPECT_FALSE(properties.grayscale);
+
+	EXPECT_FALSE(analyzeContent(properties, Image(), 1));
+	EXPECT_FALSE(analyzeContent(properties, Image(Image::Format::RGBA8, 4, 4), 1));
+}
+
+TEST(ContentAnalysisTest, DowngradeFormat)
+{
+	Texture::ContentProperties opaque = {true, true, false};
+	Texture::ContentProperties binary = {false, true, false};
+	Texture::ContentProperties grayscale = {true, true, true};
+	Texture::ContentProperties none = {false, false, false};
+
+	EXPECT_EQ(Texture::Format::BC1_RGB, Texture::downgradeFormat(Texture::Format::BC3,
+		Texture::Type::UNorm, Texture::Alpha::Standard, ColorSpace::Linear, opaque));
+	EXPECT_EQ(Texture::Format::ETC2_R8G8B8, Texture::downgradeFormat(
+		Texture::Format::ETC2_R8G8B8A8, Texture::Type::UNorm, Texture::Alpha::Standard,
+		ColorSpace::sRGB, opaque));
+	EXPECT_EQ(Texture::Format::BC1_RGB, Texture::downgradeFormat(Texture::Format::BC3,
+		Texture::Type::UNorm, Texture::Alpha::None, ColorSpace::Linear, none));
+	EXPECT_EQ(Texture::Format::BC7, Texture::downgradeFormat(Texture::Format::BC7,
+		Texture::Type::UNorm, Texture::Alpha::Standard, ColorSpace::Linear, opaque));
+
+	EXPECT_EQ(Texture::Format::ETC2_R8G8B8A1, Texture::downgradeFormat(
+		Texture::Format::ETC2_R8G8B8A8, Texture::Type::UNorm, Texture::Alpha::Standard,
+		ColorSpace::Linear, binary));
+	EXPECT_EQ(Texture::Format::BC1_RGBA, Texture::downgradeFormat(Texture::Format::BC3,
+		Texture::Type::UNorm, Texture::Alpha::PreMultiplied, ColorSpace::Linear, binary));
+	EXPECT_EQ(Texture::Format::BC3, Texture::downgradeFormat(Texture::Format::BC3,
+		Texture::Type::UNorm, Texture::Alpha::Encoded, ColorSpace::Linear, binary));
+	EXPECT_EQ(Texture::Format::BC3, Texture::downgradeFormat(Texture::Format::BC3,
+		Texture::Type::UNorm, Texture::Alpha::Standard, ColorSpace::Linear, none));
+
+	EXPECT_EQ(Texture::Format::R8, Texture::downgradeFormat(Texture::Format::R8G8B8A8,
+		Texture::Type::UNorm, Texture::Alpha::Standard, ColorSpace::Linear, grayscale));
+	EXPECT_EQ(Texture::Format::BC4, Texture::downgradeFormat(Texture::Format::BC7,
+		Texture::Type::UNorm, Texture::Alpha::Standard, ColorSpace::Linear, grayscale));
+	EXPECT_EQ(Texture::Format::EAC_R11, Texture::downgradeFormat(Texture::Format::ETC2_R8G8B8A8,
+		Texture::Type::UNorm, Texture::Alpha::Standard, ColorSpace::Linear, grayscale));
+	EXPECT_EQ(Texture::Format::R16, Texture::downgradeFormat(Texture::Format::R16G16B16A16,
+		Texture::Type::Float, Texture::Alpha::Standard, ColorSpace::Linear, grayscale));
+
+	// Single channel formats don't support sRGB.
+	EXPECT_EQ(Texture::Format::R8G8B8, Texture::downgradeFormat(Texture::Format::R8G8B8A8,
+		Texture::Type::UNorm, Texture::Alpha::Standard, ColorSpace::sRGB, grayscale));
+	EXPECT_EQ(Texture::Format::BC7, Texture::downgradeFormat(Texture::Format::BC7,
+		Texture::Type::UNorm, Texture::Alpha::Standard, ColorSpace::sRGB, grayscale));
+}
+
+TEST(ContentAnalysisTest, Convert)
+{
+	Texture texture(Texture::Dimension::Dim2D, 5, 3, 0, 2);
+	Image image(Image::Format::RGBAF, 5, 3);
+	fillImage(image, ColorRGBAd(0.5, 0.5, 0.5, 1.0));
+	EXPECT_TRUE(texture.setImage(image));
+	EXPECT_TRUE(texture.generateMipmaps());
+
+	Texture::ContentProperties properties;
+	ASSERT_TRUE(texture.analyzeContent(properties));
+	EXPECT_TRUE(properties.opaqueAlpha);
+	EXPECT_TRUE(properties.binaryAlpha);
+	EXPECT_TRUE(properties.grayscale);
+
+	EXPECT_FALSE(texture.formatDowngradeEnabled());
+	texture.setFormatDowngradeEnabled(true);
+	EXPECT_TRUE(texture.formatDowngradeEnabled());
+	EXPECT_TRUE(texture.convert(Texture::Format::R8G8B8A8, Texture::Type::UNorm));
+	EXPECT_EQ(Texture::Format::R8, texture.format());
+	EXPECT_EQ(5U*3U, texture.dataSize(0));
+
+	// Images are released after conversion.
+	EXPECT_FALSE(texture.analyzeContent(properties));
+}
+
+} // namespace cuttlefish
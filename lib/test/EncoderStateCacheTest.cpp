@@ -0,0 +1,194 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EncoderStateCache.h"
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+class TestState : public EncoderStateCache::State
+{
+public:
+	explicit TestState(int& _liveCount)
+		: liveCount(_liveCount)
+	{
+		++liveCount;
+	}
+
+	~TestState()
+	{
+		--liveCount;
+	}
+
+	int& liveCount;
+};
+
+EncoderStateCache::Key createKey(Texture::Quality quality, int params = 0)
+{
+	return EncoderStateCache::Key(EncoderStateCache::Kind::AstcContext, Texture::Format::ASTC_4x4,
+		Texture::Type::UNorm, quality, params);
+}
+
+} // namespace
+
+TEST(EncoderStateCacheTest, Key)
+{
+	EXPECT_TRUE(createKey(Texture::Quality::Normal) == createKey(Texture::Quality::Normal));
+	EXPECT_FALSE(createKey(Texture::Quality::Normal) == createKey(Texture::Quality::High));
+	EXPECT_FALSE(createKey(Texture::Quality::Normal) == createKey(Texture::Quality::Normal, 1));
+	EXPECT_FALSE(createKey(Texture::Quality::Normal) ==
+		EncoderStateCache::Key(EncoderStateCache::Kind::Bc7Params, Texture::Format::ASTC_4x4,
+			Texture::Type::UNorm, Texture::Quality::Normal, 0));
+}
+
+TEST(EncoderStateCacheTest, Reuse)
+{
+	EncoderStateCache::clear();
+
+	int liveCount = 0;
+	int createCount = 0;
+	auto create = [&liveCount, &createCount]()
+	{
+		++createCount;
+		return new TestState(liveCount);
+	};
+
+	TestState* firstState;
+	{
+		auto handle = EncoderStateCache::get<TestState>(createKey(Texture::Quality::Normal),
+			create);
+		ASSERT_TRUE(handle);
+		firstState = handle.get();
+		EXPECT_EQ(1, createCount);
+		EXPECT_EQ(0U, EncoderStateCache::size());
+
+		// The state is in use, so another is created.
+		auto otherHandle = EncoderStateCache::get<TestState>(createKey(Texture::Quality::Normal),
+			create);
+		EXPECT_NE(firstState, otherHandle.get());
+		EXPECT_EQ(2, createCount);
+	}
+
+	EXPECT_EQ(2U, EncoderStateCache::size());
+	EXPECT_EQ(2, liveCount);
+
+	{
+		auto handle = EncoderStateCache::get<TestState>(createKey(Texture::Quality::Normal),
+			create);
+		EXPECT_EQ(2, createCount);
+
+		auto highHandle = EncoderStateCache::get<TestState>(createKey(Texture::Quality::High),
+			create);
+		EXPECT_EQ(3, createCount);
+	}
+
+	EncoderStateCache::clear();
+	EXPECT_EQ(0U, EncoderStateCache::size());
+	EXPECT_EQ(0, liveCount);
+}
+
+TEST(EncoderStateCacheTest, MaxStates)
+{
+	EncoderStateCache::clear();
+
+	int liveCount = 0;
+	for (unsigned int i = 0; i < EncoderStateCache::maxStates + 5; ++i)
+	{
+		EncoderStateCache::release(createKey(Texture::Quality::Normal, static_cast<int>(i)),
+			std::unique_ptr<EncoderStateCache::State>(new TestState(liveCount)));
+	}
+
+	EXPECT_EQ(EncoderStateCache::maxStates, EncoderStateCache::size());
+	EXPECT_EQ(static_cast<int>(EncoderStateCache::maxStates), liveCount);
+
+	// The least recently released states are removed first.
+	EXPECT_FALSE(EncoderStateCache::acquire(createKey(Texture::Quality::Normal, 0)));
+	EXPECT_TRUE(EncoderStateCache::acquire(createKey(Texture::Quality::Normal,
+		static_cast<int>(EncoderStateCache::maxStates + 4))));
+
+	EncoderStateCache::clear();
+	EXPECT_EQ(0, liveCount);
+}
+
+TEST(EncoderStateCacheTest, PerThread)
+{
+	EncoderStateCache::clear();
+
+	int liveCount = 0;
+	EncoderStateCache::release(createKey(Texture::Quality::Normal),
+		std::unique_ptr<EncoderStateCache::State>(new TestState(liveCount)));
+
+	bool foundOnThread = true;
+	std::thread thread([&foundOnThread]()
+		{
+			foundOnThread = EncoderStateCache::acquire(createKey(Texture::Quality::Normal)) !=
+				nullptr;
+		});
+	thread.join();
+
+	EXPECT_FALSE(foundOnThread);
+	EXPECT_TRUE(EncoderStateCache::acquire(createKey(Texture::Quality::Normal)));
+	EXPECT_EQ(0, liveCount);
+}
+
+#if CUTTLEFISH_HAS_ASTC
+TEST(EncoderStateCacheTest, AstcContexts)
+{
+	EncoderStateCache::clear();
+
+	// A flat half with a small amount of noise uses the nearly constant block path, while the
+	// gradient half uses the fast context for adaptive quality.
+	Image image(Image::Format::RGBAF, 32, 32);
+	for (unsigned int y = 0; y < image.height(); ++y)
+	{
+		for (unsigned int x = 0; x < image.width(); ++x)
+		{
+			ColorRGBAd color;
+			if (x < image.width()/2)
+				color = ColorRGBAd(0.5 + ((x + y) % 2)/512.0, 0.5, 0.5, 1.0);
+			else
+				color = ColorRGBAd(x/32.0, y/32.0, (x + y)/64.0, 1.0);
+			EXPECT_TRUE(image.setPixel(x, y, color));
+		}
+	}
+
+	Texture texture(Texture::Dimension::Dim2D, image.width(), image.height());
+	texture.setAdaptiveQuality(true, Texture::Quality::Lowest);
+	ASSERT_TRUE(texture.setImage(image));
+	ASSERT_TRUE(texture.convert(Texture::Format::ASTC_4x4, Texture::Type::UNorm,
+		Texture::Quality::Normal, Texture::Alpha::Standard, Texture::ColorMask(), 2));
+	std::size_t cachedStates = EncoderStateCache::size();
+	EXPECT_LT(0U, cachedStates);
+
+	// The contexts from the first conversion are re-used rather than adding more to the cache.
+	ASSERT_TRUE(texture.setImage(image));
+	ASSERT_TRUE(texture.convert(Texture::Format::ASTC_4x4, Texture::Type::UNorm,
+		Texture::Quality::Normal, Texture::Alpha::Standard, Texture::ColorMask(), 2));
+	EXPECT_EQ(cachedStates, EncoderStateCache::size());
+
+	EncoderStateCache::clear();
+}
+#endif
+
+} // namespace cuttlefish
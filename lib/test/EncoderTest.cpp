@@ -0,0 +1,163 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "QualityMetrics.h"
+#include "TestHelpers.h"
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace cuttlefish
+{
+
+#if CUTTLEFISH_HAS_S3TC
+
+struct FormatInfo
+{
+	Texture::Format format;
+	Texture::Type type;
+	const char* name;
+};
+
+static const FormatInfo formats[] =
+{
+	{Texture::Format::BC1_RGB, Texture::Type::UNorm, "BC1_RGB"},
+	{Texture::Format::BC1_RGBA, Texture::Type::UNorm, "BC1_RGBA"},
+	{Texture::Format::BC2, Texture::Type::UNorm, "BC2"},
+	{Texture::Format::BC3, Texture::Type::UNorm, "BC3"},
+	{Texture::Format::BC4, Texture::Type::UNorm, "BC4_UNorm"},
+	{Texture::Format::BC4, Texture::Type::SNorm, "BC4_SNorm"},
+	{Texture::Format::BC5, Texture::Type::UNorm, "BC5_UNorm"},
+	{Texture::Format::BC5, Texture::Type::SNorm, "BC5_SNorm"},
+	{Texture::Format::BC6H, Texture::Type::UFloat, "BC6H_UFloat"},
+	{Texture::Format::BC7, Texture::Type::UNorm, "BC7"}
+};
+
+static const std::pair<Texture::Encoder, const char*> encoders[] =
+{
+	{Texture::Encoder::Default, "Default"},
+	{Texture::Encoder::Rgbcx, "Rgbcx"},
+	{Texture::Encoder::Squish, "Squish"},
+	{Texture::Encoder::Compressonator, "Compressonator"},
+	{Texture::Encoder::IspcTexcomp, "IspcTexcomp"},
+	{Texture::Encoder::Bc7enc, "Bc7enc"}
+};
+
+TEST(EncoderTest, Supported)
+{
+	EXPECT_TRUE(Texture::isEncoderSupported(Texture::Format::R8G8B8A8, Texture::Type::UNorm,
+		Texture::Encoder::Default));
+	EXPECT_FALSE(Texture::isEncoderSupported(Texture::Format::R8G8B8A8, Texture::Type::UNorm,
+		Texture::Encoder::Rgbcx));
+	EXPECT_FALSE(Texture::isEncoderSupported(Texture::Format::BC1_RGB, Texture::Type::SNorm,
+		Texture::Encoder::Default));
+
+	EXPECT_TRUE(Texture::isEncoderSupported(Texture::Format::BC1_RGB, Texture::Type::UNorm,
+		Texture::Encoder::Rgbcx));
+	EXPECT_TRUE(Texture::isEncoderSupported(Texture::Format::BC1_RGB, Texture::Type::UNorm,
+		Texture::Encoder::Squish));
+	EXPECT_FALSE(Texture::isEncoderSupported(Texture::Format::BC1_RGBA, Texture::Type::UNorm,
+		Texture::Encoder::Rgbcx));
+	EXPECT_TRUE(Texture::isEncoderSupported(Texture::Format::BC4, Texture::Type::UNorm,
+		Texture::Encoder::Rgbcx));
+	EXPECT_FALSE(Texture::isEncoderSupported(Texture::Format::BC4, Texture::Type::SNorm,
+		Texture::Encoder::Rgbcx));
+	EXPECT_TRUE(Texture::isEncoderSupported(Texture::Format::BC4, Texture::Type::SNorm,
+		Texture::Encoder::Compressonator));
+	EXPECT_TRUE(Texture::isEncoderSupported(Texture::Format::BC7, Texture::Type::UNorm,
+		Texture::Encoder::Bc7enc));
+	EXPECT_FALSE(Texture::isEncoderSupported(Texture::Format::BC7, Texture::Type::UNorm,
+		Texture::Encoder::Squish));
+}
+
+TEST(EncoderTest, SetEncoder)
+{
+	Texture texture(Texture::Dimension::Dim2D, 16, 16);
+	EXPECT_EQ(Texture::Encoder::Default, texture.encoder(Texture::Format::BC3));
+	texture.setEncoder(Texture::Format::BC3, Texture::Encoder::Squish);
+	EXPECT_EQ(Texture::Encoder::Squish, texture.encoder(Texture::Format::BC3));
+	EXPECT_EQ(Texture::Encoder::Default, texture.encoder(Texture::Format::BC1_RGB));
+
+	Image image(Image::Format::RGBAF, 16, 16);
+	fillGradientImage(image);
+	EXPECT_TRUE(texture.setImage(image));
+	texture.setEncoder(Texture::Format::BC7, Texture::Encoder::Squish);
+	EXPECT_FALSE(texture.convert(Texture::Format::BC7, Texture::Type::UNorm));
+
+	EXPECT_TRUE(texture.initialize(Texture::Dimension::Dim2D, 16, 16));
+	EXPECT_EQ(Texture::Encoder::Default, texture.encoder(Texture::Format::BC3));
+}
+
+// Converts with every supported encoder for each format, checking the quality and recording the
+// time taken as a test property to compare the speed of each encoder. This is disabled by default
+// due to the time taken, and may be run with --gtest_also_run_disabled_tests.
+TEST(EncoderTest, DISABLED_Benchmark)
+{
+	const unsigned int imageSize = 256;
+	const double minPsnr = 25.0;
+	Image image(Image::Format::RGBAF, imageSize, imageSize);
+	fillGradientImage(image);
+
+	for (const FormatInfo& formatInfo : formats)
+	{
+		if (!Texture::isDecodeSupported(formatInfo.format, formatInfo.type))
+			continue;
+
+		for (const auto& encoderInfo : encoders)
+		{
+			if (!Texture::isEncoderSupported(formatInfo.format, formatInfo.type,
+					encoderInfo.first))
+			{
+				continue;
+			}
+
+			Texture texture(Texture::Dimension::Dim2D, imageSize, imageSize);
+			EXPECT_TRUE(texture.setImage(image));
+			texture.setEncoder(formatInfo.format, encoderInfo.first);
+
+			auto start = std::chrono::steady_clock::now();
+			EXPECT_TRUE(texture.convert(formatInfo.format, formatInfo.type,
+				Texture::Quality::Normal, Texture::Alpha::Standard, Texture::ColorMask(), 1)) <<
+				formatInfo.name << " " << encoderInfo.second;
+			auto end = std::chrono::steady_clock::now();
+
+			// Compute the quality separately so it isn't included in the conversion time.
+			Image decodedImage;
+			ASSERT_TRUE(texture.decode(decodedImage));
+			Texture::QualityMetrics metrics;
+			ASSERT_TRUE(computeQualityMetrics(metrics, texture, image, decodedImage, 1));
+			EXPECT_LT(minPsnr, metrics.combinedPsnr) << formatInfo.name << " " <<
+				encoderInfo.second;
+
+			std::ostringstream name;
+			name << formatInfo.name << "_" << encoderInfo.second;
+			RecordProperty(name.str() + "_us", static_cast<int>(
+				std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+			std::ostringstream psnr;
+			psnr << std::fixed << std::setprecision(2) << metrics.combinedPsnr;
+			RecordProperty(name.str() + "_psnr", psnr.str());
+		}
+	}
+}
+
+#endif // CUTTLEFISH_HAS_S3TC
+
+} // namespace cuttlefish
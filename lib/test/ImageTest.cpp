@@ -19,7 +19,10 @@
 #include <gtest/gtest.h>
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <sstream>
+#include <vector>
 
 // Handle different versions of gtest.
 #ifndef INSTANTIATE_TEST_SUITE_P
@@ -211,6 +214,170 @@ TEST(ImageSaveTest, SaveLoadBuffer)
 	EXPECT_EQ(image.height(), otherImage.height());
 }
 
+TEST(ImageSaveTest, SaveLoadFile)
+{
+	Image image;
+	EXPECT_TRUE(image.initialize(Image::Format::RGBA8, 10, 15));
+	for (unsigned int y = 0; y < image.height(); ++y)
+	{
+		for (unsigned int x = 0; x < image.width(); ++x)
+			EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd{x/10.0, y/15.0, 0.5, 1.0}));
+	}
+
+	const char* fileName = "ImageSaveTest.png";
+	EXPECT_TRUE(image.save(fileName));
+
+	Image otherImage;
+	EXPECT_TRUE(otherImage.load(fileName));
+	EXPECT_EQ(image.format(), otherImage.format());
+	EXPECT_EQ(image.width(), otherImage.width());
+	EXPECT_EQ(image.height(), otherImage.height());
+	for (unsigned int y = 0; y < image.height(); ++y)
+	{
+		EXPECT_EQ(0, std::memcmp(image.scanline(y), otherImage.scanline(y),
+			image.width()*sizeof(std::uint32_t)));
+	}
+
+	std::remove(fileName);
+	EXPECT_FALSE(otherImage.load(fileName));
+}
+
+TEST(ImageSaveTest, SaveLoadUnseekableStream)
+{
+	// Stream buffer that doesn't support seeking, such as for a pipe.
+	class UnseekableBuffer : public std::streambuf
+	{
+	public:
+		explicit UnseekableBuffer(std::vector<std::uint8_t>& data)
+		{
+			char* begin = reinterpret_cast<char*>(data.data());
+			setg(begin, begin, begin + data.size());
+		}
+	};
+
+	Image image;
+	EXPECT_TRUE(image.initialize(Image::Format::RGBA8, 300, 200));
+
+	std::vector<std::uint8_t> data;
+	EXPECT_TRUE(image.save(data, "png"));
+
+	UnseekableBuffer buffer(data);
+	std::istream stream(&buffer);
+	ASSERT_LT(stream.tellg(), 0);
+
+	Image otherImage;
+	EXPECT_TRUE(otherImage.load(stream));
+	EXPECT_EQ(image.format(), otherImage.format());
+	EXPECT_EQ(image.width(), otherImage.width());
+	EXPECT_EQ(image.height(), otherImage.height());
+}
+
+TEST(ImageTest, CopyOnWrite)
+{
+	Image image(Image::Format::RGBAF, 10, 15);
+	EXPECT_TRUE(image.setPixel(1, 2, ColorRGBAd{0.25, 0.5, 0.75, 1.0}));
+
+	const Image copy = image;
+	const Image& constImage = image;
+	EXPECT_EQ(constImage.scanline(0), copy.scanline(0));
+	EXPECT_EQ(copy.scanline(0), image.convert(Image::Format::RGBAF).scanline(0));
+	EXPECT_EQ(copy.scanline(0),
+		image.resize(10, 15, Image::ResizeFilter::Linear).scanline(0));
+
+	EXPECT_TRUE(image.setPixel(1, 2, ColorRGBAd{1.0, 1.0, 1.0, 1.0}));
+	EXPECT_NE(constImage.scanline(0), copy.scanline(0));
+
+	ColorRGBAd color;
+	EXPECT_TRUE(copy.getPixel(color, 1, 2));
+	EXPECT_EQ(0.25, color.r);
+	EXPECT_TRUE(image.getPixel(color, 1, 2));
+	EXPECT_EQ(1.0, color.r);
+
+	// Modifying the only reference doesn't copy.
+	const void* scanline = constImage.scanline(0);
+	EXPECT_TRUE(image.flipVertical());
+	EXPECT_EQ(scanline, constImage.scanline(0));
+}
+
+TEST(ImageViewTest, WrapMemory)
+{
+	const unsigned int width = 7, height = 5;
+	Image image(Image::Format::RGBA8, width, height);
+	for (unsigned int y = 0; y < height; ++y)
+	{
+		for (unsigned int x = 0; x < width; ++x)
+			EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd{x/7.0, y/5.0, (x + y)/12.0, 1.0}));
+	}
+
+	// Padded rows, ordered from top to bottom.
+	const std::size_t rowSize = width*sizeof(std::uint32_t);
+	const std::size_t stride = rowSize + 12;
+	std::vector<std::uint8_t> data(stride*height);
+	for (unsigned int y = 0; y < height; ++y)
+		std::memcpy(data.data() + y*stride, image.scanline(y), rowSize);
+
+	Image view;
+	EXPECT_FALSE(view.initialize(Image::Format::RGBA8, width, height, data.data(), rowSize - 1));
+	EXPECT_FALSE(view.initialize(Image::Format::RGBA8, width, height, nullptr, stride));
+	ASSERT_TRUE(view.initialize(Image::Format::RGBA8, width, height, data.data(), stride));
+	EXPECT_EQ(width, view.width());
+	EXPECT_EQ(height, view.height());
+	for (unsigned int y = 0; y < height; ++y)
+		EXPECT_EQ(data.data() + y*stride, view.scanline(y));
+
+	auto expectEqual = [](const Image& expected, const Image& actual)
+	{
+		ASSERT_EQ(expected.width(), actual.width());
+		ASSERT_EQ(expected.height(), actual.height());
+		for (unsigned int y = 0; y < expected.height(); ++y)
+		{
+			for (unsigned int x = 0; x < expected.width(); ++x)
+			{
+				ColorRGBAd expectedColor, color;
+				EXPECT_TRUE(expected.getPixel(expectedColor, x, y));
+				EXPECT_TRUE(actual.getPixel(color, x, y));
+				EXPECT_NEAR(expectedColor.r, color.r, 1e-3);
+				EXPECT_NEAR(expectedColor.g, color.g, 1e-3);
+				EXPECT_NEAR(expectedColor.b, color.b, 1e-3);
+				EXPECT_NEAR(expectedColor.a, color.a, 1e-3);
+			}
+		}
+	};
+
+	expectEqual(image, view);
+	expectEqual(image.convert(Image::Format::RGBAF), view.convert(Image::Format::RGBAF));
+	expectEqual(image.convert(Image::Format::RGB16), view.convert(Image::Format::RGB16));
+	expectEqual(image.resize(4, 3, Image::ResizeFilter::Linear),
+		view.resize(4, 3, Image::ResizeFilter::Linear));
+	expectEqual(image.rotate(Image::RotateAngle::CW90), view.rotate(Image::RotateAngle::CW90));
+	expectEqual(image.rotate(Image::RotateAngle::CCW90), view.rotate(Image::RotateAngle::CCW90));
+	expectEqual(image.createNormalMap(Image::NormalOptions::Default, 1.0, Image::Format::RGBAF),
+		view.createNormalMap(Image::NormalOptions::Default, 1.0, Image::Format::RGBAF));
+
+	std::vector<std::uint8_t> savedData;
+	EXPECT_TRUE(view.save(savedData, "png"));
+	expectEqual(image, Image(savedData.data(), savedData.size()));
+
+	// Copies have their own storage, while modifying the view writes to the memory.
+	Image copy = view;
+	EXPECT_TRUE(view.flipVertical());
+	EXPECT_TRUE(image.flipVertical());
+	expectEqual(image, view);
+	EXPECT_EQ(0, std::memcmp(image.scanline(0), data.data(), rowSize));
+	EXPECT_TRUE(image.flipVertical());
+	expectEqual(image, copy);
+
+	EXPECT_TRUE(view.setPixel(2, 1, ColorRGBAd{1.0, 0.0, 0.0, 1.0}));
+	ColorRGBAd color;
+	EXPECT_TRUE(copy.getPixel(color, 2, 1));
+	EXPECT_NE(1.0, color.r);
+
+	Image otherView(Image::Format::RGBA8, width, height, data.data(), stride);
+	EXPECT_TRUE(otherView.getPixel(color, 2, 1));
+	EXPECT_EQ(1.0, color.r);
+	EXPECT_EQ(0.0, color.g);
+}
+
 TEST_P(ImageTest, GetSetPixel)
 {
 	const ImageTestInfo& imageInfo = GetParam();
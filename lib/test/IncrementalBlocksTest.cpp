@@ -0,0 +1,216 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "IncrementalBlocks.h"
+#include "TestHelpers.h"
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace cuttlefish
+{
+
+#if CUTTLEFISH_HAS_S3TC
+
+namespace
+{
+
+const char* outputFileName = "IncrementalBlocksTest.dds";
+const char* hashFileName = "IncrementalBlocksTest.hash";
+const unsigned int imageSize = 16;
+const unsigned int blockCount = (imageSize/4)*(imageSize/4);
+
+Image createImage()
+{
+	Image image(Image::Format::RGBAF, imageSize, imageSize);
+	for (unsigned int y = 0; y < imageSize; ++y)
+	{
+		for (unsigned int x = 0; x < imageSize; ++x)
+		{
+			EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd{x/double(imageSize),
+				y/double(imageSize), (x*y % 7)/7.0, 1.0}));
+		}
+	}
+	return image;
+}
+
+bool convertTexture(Texture& texture, const Image& image, Texture::Format format,
+	Texture::Quality quality, bool usePrevious)
+{
+	if (!texture.initialize(Texture::Dimension::Dim2D, imageSize, imageSize) ||
+		!texture.setImage(image))
+	{
+		return false;
+	}
+
+	texture.setBlockHashesEnabled(true);
+	if (usePrevious && !texture.setPreviousOutput(outputFileName, hashFileName))
+		return false;
+
+	return texture.convert(format, Texture::Type::UNorm, quality, Texture::Alpha::Standard,
+		Texture::ColorMask(), 1);
+}
+
+bool saveOutput(Texture& texture)
+{
+	return texture.save(outputFileName) == Texture::SaveResult::Success &&
+		texture.saveBlockHashes(hashFileName);
+}
+
+class IncrementalBlocksTest : public testing::Test
+{
+protected:
+	void TearDown() override
+	{
+		std::remove(outputFileName);
+		std::remove(hashFileName);
+	}
+};
+
+} // namespace
+
+TEST_F(IncrementalBlocksTest, SaveLoad)
+{
+	Image image = createImage();
+	Texture texture;
+	ASSERT_TRUE(convertTexture(texture, image, Texture::Format::BC1_RGB, Texture::Quality::Low,
+		false));
+	ASSERT_TRUE(saveOutput(texture));
+
+	std::vector<std::uint8_t> hashData = readFile(hashFileName);
+	ASSERT_EQ(sizeof(IncrementalBlocks::Header) + blockCount*sizeof(IncrementalBlocks::Key),
+		hashData.size());
+
+	IncrementalBlocks blocks;
+	EXPECT_FALSE(blocks.loadPrevious("nonexistent.dds", hashFileName,
+		Texture::FileType::Auto));
+	EXPECT_FALSE(blocks.hasPrevious());
+	ASSERT_TRUE(blocks.loadPrevious(outputFileName, hashFileName, Texture::FileType::Auto));
+	EXPECT_TRUE(blocks.hasPrevious());
+
+	blocks.begin(texture, Texture::Quality::Low);
+	const std::uint8_t* previousBlocks = blocks.previousBlocks(0, 0, 0);
+	ASSERT_TRUE(previousBlocks);
+	EXPECT_EQ(0, std::memcmp(texture.data(), previousBlocks, texture.dataSize()));
+	const IncrementalBlocks::Key* previousHashes = blocks.previousHashes(0, 0, 0);
+	ASSERT_TRUE(previousHashes);
+	EXPECT_EQ(0, std::memcmp(hashData.data() + sizeof(IncrementalBlocks::Header), previousHashes,
+		blockCount*sizeof(IncrementalBlocks::Key)));
+}
+
+TEST_F(IncrementalBlocksTest, InvalidHashFile)
+{
+	Image image = createImage();
+	Texture texture;
+	ASSERT_TRUE(convertTexture(texture, image, Texture::Format::BC1_RGB, Texture::Quality::Low,
+		false));
+	ASSERT_TRUE(saveOutput(texture));
+	std::vector<std::uint8_t> hashData = readFile(hashFileName);
+
+	IncrementalBlocks blocks;
+	std::vector<std::uint8_t> invalidData = hashData;
+	invalidData[offsetof(IncrementalBlocks::Header, magic)] ^= 0xFF;
+	writeFile(hashFileName, invalidData);
+	EXPECT_FALSE(blocks.loadPrevious(outputFileName, hashFileName, Texture::FileType::Auto));
+
+	invalidData = hashData;
+	invalidData[offsetof(IncrementalBlocks::Header, version)] ^= 0xFF;
+	writeFile(hashFileName, invalidData);
+	EXPECT_FALSE(blocks.loadPrevious(outputFileName, hashFileName, Texture::FileType::Auto));
+
+	invalidData = hashData;
+	invalidData.pop_back();
+	writeFile(hashFileName, invalidData);
+	EXPECT_FALSE(blocks.loadPrevious(outputFileName, hashFileName, Texture::FileType::Auto));
+	EXPECT_FALSE(blocks.hasPrevious());
+
+	writeFile(hashFileName, hashData);
+	EXPECT_TRUE(blocks.loadPrevious(outputFileName, hashFileName, Texture::FileType::Auto));
+}
+
+TEST_F(IncrementalBlocksTest, ReuseUnchangedBlocks)
+{
+	Image image = createImage();
+	Texture texture;
+	ASSERT_TRUE(convertTexture(texture, image, Texture::Format::BC1_RGB, Texture::Quality::Low,
+		false));
+	ASSERT_TRUE(saveOutput(texture));
+
+	Texture unchangedTexture;
+	ASSERT_TRUE(convertTexture(unchangedTexture, image, Texture::Format::BC1_RGB,
+		Texture::Quality::Low, true));
+	EXPECT_EQ(blockCount, unchangedTexture.reusedBlockCount());
+	ASSERT_EQ(texture.dataSize(), unchangedTexture.dataSize());
+	EXPECT_EQ(0, std::memcmp(texture.data(), unchangedTexture.data(), texture.dataSize()));
+
+	// Change a single block, which should be the only one re-encoded.
+	for (unsigned int y = 4; y < 8; ++y)
+	{
+		for (unsigned int x = 8; x < 12; ++x)
+			EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd{1.0, 0.0, 0.0, 1.0}));
+	}
+
+	Texture expectedTexture;
+	ASSERT_TRUE(convertTexture(expectedTexture, image, Texture::Format::BC1_RGB,
+		Texture::Quality::Low, false));
+
+	Texture changedTexture;
+	ASSERT_TRUE(convertTexture(changedTexture, image, Texture::Format::BC1_RGB,
+		Texture::Quality::Low, true));
+	EXPECT_EQ(blockCount - 1, changedTexture.reusedBlockCount());
+	ASSERT_EQ(expectedTexture.dataSize(), changedTexture.dataSize());
+	EXPECT_EQ(0, std::memcmp(expectedTexture.data(), changedTexture.data(),
+		expectedTexture.dataSize()));
+	EXPECT_NE(0, std::memcmp(texture.data(), changedTexture.data(), texture.dataSize()));
+}
+
+TEST_F(IncrementalBlocksTest, MismatchedConversion)
+{
+	Image image = createImage();
+	Texture texture;
+	ASSERT_TRUE(convertTexture(texture, image, Texture::Format::BC1_RGB, Texture::Quality::Low,
+		false));
+	ASSERT_TRUE(saveOutput(texture));
+
+	Texture otherQuality;
+	ASSERT_TRUE(convertTexture(otherQuality, image, Texture::Format::BC1_RGB,
+		Texture::Quality::Normal, true));
+	EXPECT_EQ(0U, otherQuality.reusedBlockCount());
+
+	Texture otherFormat;
+	ASSERT_TRUE(convertTexture(otherFormat, image, Texture::Format::BC3, Texture::Quality::Low,
+		true));
+	EXPECT_EQ(0U, otherFormat.reusedBlockCount());
+
+	// The previous output is ignored if it was modified after the hashes were saved.
+	std::vector<std::uint8_t> outputData = readFile(outputFileName);
+	outputData.back() ^= 0xFF;
+	writeFile(outputFileName, outputData);
+
+	Texture modifiedOutput;
+	ASSERT_TRUE(convertTexture(modifiedOutput, image, Texture::Format::BC1_RGB,
+		Texture::Quality::Low, true));
+	EXPECT_EQ(0U, modifiedOutput.reusedBlockCount());
+}
+
+#endif // CUTTLEFISH_HAS_S3TC
+
+} // namespace cuttlefish
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OutputSlices.h"
+#include "Shared.h"
+#include "TestHelpers.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace cuttlefish
+{
+
+static std::vector<std::uint8_t> createSlices(OutputSlices& output,
+	const std::vector<std::uint8_t>& data)
+{
+	std::vector<std::uint8_t> expectedData;
+
+	std::uint32_t header = 0x12345678;
+	EXPECT_TRUE(write(output.stream(), header));
+	output.stream().put(9);
+	auto headerBytes = reinterpret_cast<const std::uint8_t*>(&header);
+	expectedData.insert(expectedData.end(), headerBytes, headerBytes + sizeof(header));
+	expectedData.push_back(9);
+
+	output.add(data.data(), data.size());
+	expectedData.insert(expectedData.end(), data.begin(), data.end());
+
+	output.addPadding(3);
+	output.addPadding(100);
+	expectedData.insert(expectedData.end(), 103, 0);
+
+	output.stream().put(1);
+	output.add(data.data(), 10);
+	expectedData.push_back(1);
+	expectedData.insert(expectedData.end(), data.begin(), data.begin() + 10);
+	return expectedData;
+}
+
+TEST(OutputSlicesTest, WriteMemory)
+{
+	std::vector<std::uint8_t> data(1000);
+	for (std::size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<std::uint8_t>(i*7);
+
+	OutputSlices output;
+	std::vector<std::uint8_t> expectedData = createSlices(output, data);
+	EXPECT_EQ(expectedData.size(), output.size());
+
+	std::vector<std::uint8_t> writtenData(output.size());
+	EXPECT_FALSE(output.write(writtenData.data(), writtenData.size() - 1));
+	EXPECT_TRUE(output.write(writtenData.data(), writtenData.size()));
+	EXPECT_EQ(expectedData, writtenData);
+}
+
+TEST(OutputSlicesTest, WriteStream)
+{
+	std::vector<std::uint8_t> data(1000);
+	for (std::size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<std::uint8_t>(i*7);
+
+	OutputSlices output;
+	std::vector<std::uint8_t> expectedData = createSlices(output, data);
+
+	std::stringstream stream(std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+	EXPECT_TRUE(output.write(stream));
+	std::string writtenString = stream.str();
+	std::vector<std::uint8_t> writtenData(writtenString.begin(), writtenString.end());
+	EXPECT_EQ(expectedData, writtenData);
+}
+
+TEST(OutputSlicesTest, WriteFile)
+{
+	std::vector<std::uint8_t> data(1000);
+	for (std::size_t i = 0; i < data.size(); ++i)
+		data[i] = static_cast<std::uint8_t>(i*7);
+
+	// Use enough slices to require multiple gather writes.
+	OutputSlices output;
+	std::vector<std::uint8_t> expectedData;
+	for (unsigned int i = 0; i < 3000; ++i)
+	{
+		std::vector<std::uint8_t> curData = createSlices(output, data);
+		expectedData.insert(expectedData.end(), curData.begin(), curData.end());
+	}
+
+	const char* fileName = "OutputSlicesTest.dat";
+	EXPECT_TRUE(output.write(fileName));
+
+	std::vector<std::uint8_t> writtenData = readFile(fileName);
+	std::remove(fileName);
+	EXPECT_EQ(expectedData, writtenData);
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PreviewEncoder.h"
+#include "BlockDecoder.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+// Smooth gradient across the block, which the bounding box endpoints should closely match.
+void fillGradient(std::uint8_t colors[16][4])
+{
+	for (unsigned int y = 0; y < 4; ++y)
+	{
+		for (unsigned int x = 0; x < 4; ++x)
+		{
+			std::uint8_t* color = colors[y*4 + x];
+			color[0] = static_cast<std::uint8_t>(40 + x*20 + y*10);
+			color[1] = static_cast<std::uint8_t>(100 + x*10 + y*5);
+			color[2] = static_cast<std::uint8_t>(200 - x*20 - y*10);
+			color[3] = static_cast<std::uint8_t>(255 - x*30 - y*15);
+		}
+	}
+}
+
+int getMaxError(const std::uint8_t colors[16][4], const std::uint8_t decodedColors[16][4],
+	unsigned int channelCount)
+{
+	int maxError = 0;
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		for (unsigned int c = 0; c < channelCount; ++c)
+			maxError = std::max(maxError, std::abs(colors[i][c] - decodedColors[i][c]));
+	}
+	return maxError;
+}
+
+} // namespace
+
+TEST(PreviewEncoderTest, Bc1)
+{
+	std::uint8_t colors[16][4];
+	fillGradient(colors);
+
+	std::uint8_t block[8];
+	std::uint8_t decodedColors[16][4];
+	encodeBc1Preview(block, colors);
+	decodeBc1(decodedColors, block, true);
+	EXPECT_GE(16, getMaxError(colors, decodedColors, 3));
+
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		colors[i][0] = 0x20;
+		colors[i][1] = 0x40;
+		colors[i][2] = 0x60;
+	}
+	encodeBc1Preview(block, colors);
+	decodeBc1(decodedColors, block, true);
+	EXPECT_GE(4, getMaxError(colors, decodedColors, 3));
+}
+
+TEST(PreviewEncoderTest, Bc3)
+{
+	std::uint8_t colors[16][4];
+	fillGradient(colors);
+
+	std::uint8_t block[16];
+	std::uint8_t decodedColors[16][4];
+	encodeBc3Preview(block, colors);
+	decodeBc3(decodedColors, block);
+	EXPECT_GE(16, getMaxError(colors, decodedColors, 4));
+}
+
+TEST(PreviewEncoderTest, Bc4)
+{
+	std::uint8_t values[16];
+	std::uint8_t decodedValues[16];
+	for (unsigned int i = 0; i < 16; ++i)
+		values[i] = static_cast<std::uint8_t>(i*17);
+
+	std::uint8_t block[8];
+	encodeBc4Preview(block, values, 1);
+	decodeBc4(decodedValues, block, 1);
+	for (unsigned int i = 0; i < 16; ++i)
+		EXPECT_GE(19, std::abs(values[i] - decodedValues[i]));
+	EXPECT_EQ(0, decodedValues[0]);
+	EXPECT_EQ(255, decodedValues[15]);
+
+	std::int8_t signedValues[16];
+	std::int8_t decodedSignedValues[16];
+	for (unsigned int i = 0; i < 16; ++i)
+		signedValues[i] = static_cast<std::int8_t>(-120 + static_cast<int>(i)*16);
+	encodeBc4SPreview(block, signedValues, 1);
+	decodeBc4S(decodedSignedValues, block, 1);
+	for (unsigned int i = 0; i < 16; ++i)
+		EXPECT_GE(18, std::abs(signedValues[i] - decodedSignedValues[i]));
+	EXPECT_EQ(-120, decodedSignedValues[0]);
+	EXPECT_EQ(120, decodedSignedValues[15]);
+}
+
+TEST(PreviewEncoderTest, Bc7)
+{
+	std::uint8_t colors[16][4];
+	fillGradient(colors);
+
+	std::uint8_t block[16];
+	std::uint8_t decodedColors[16][4];
+	encodeBc7Preview(block, colors);
+	decodeBc7(decodedColors, block);
+	EXPECT_GE(8, getMaxError(colors, decodedColors, 4));
+
+	// Reversed gradient to swap the endpoints for the anchor index.
+	std::uint8_t reversedColors[16][4];
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		for (unsigned int c = 0; c < 4; ++c)
+			reversedColors[i][c] = colors[15 - i][c];
+	}
+	encodeBc7Preview(block, reversedColors);
+	decodeBc7(decodedColors, block);
+	EXPECT_GE(8, getMaxError(reversedColors, decodedColors, 4));
+}
+
+TEST(PreviewEncoderTest, Etc1)
+{
+	std::uint8_t colors[16][4];
+	fillGradient(colors);
+
+	std::uint8_t block[8];
+	std::uint8_t decodedColors[16][4];
+	encodeEtc1Preview(block, colors);
+	decodeEtc2(decodedColors, block, false);
+	EXPECT_GE(40, getMaxError(colors, decodedColors, 3));
+
+	// Colors too far apart for differential mode.
+	for (unsigned int i = 0; i < 16; ++i)
+	{
+		std::uint8_t value = (i & 0x3) < 2 ? 0x10 : 0xF0;
+		colors[i][0] = colors[i][1] = colors[i][2] = value;
+	}
+	encodeEtc1Preview(block, colors);
+	EXPECT_EQ(0, block[3] & 0x2);
+	decodeEtc2(decodedColors, block, false);
+	EXPECT_GE(4, getMaxError(colors, decodedColors, 3));
+}
+
+TEST(PreviewEncoderTest, Etc2Alpha)
+{
+	std::uint8_t colors[16][4];
+	fillGradient(colors);
+
+	std::uint8_t block[8];
+	std::uint8_t decodedColors[16][4] = {};
+	encodeEtc2AlphaPreview(block, colors[0] + 3, 4);
+	decodeEtc2Alpha(decodedColors[0] + 3, block, 4);
+	for (unsigned int i = 0; i < 16; ++i)
+		EXPECT_GE(12, std::abs(colors[i][3] - decodedColors[i][3]));
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "QualityMetrics.h"
+#include "TestHelpers.h"
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+namespace cuttlefish
+{
+
+static void convertTexture(Texture& texture, Texture::ColorMask colorMask = Texture::ColorMask())
+{
+	EXPECT_TRUE(texture.setImage(Image(Image::Format::RGBAF, 13, 11)));
+	EXPECT_TRUE(texture.convert(Texture::Format::R8G8B8A8, Texture::Type::UNorm,
+		Texture::Quality::Normal, Texture::Alpha::Standard, colorMask));
+}
+
+TEST(QualityMetricsTest, Identical)
+{
+	Texture texture(Texture::Dimension::Dim2D, 13, 11);
+	texture.setQualityMetricsEnabled(true, true);
+	convertTexture(texture);
+
+	Image image(Image::Format::RGBAF, 13, 11);
+	fillImage(image, ColorRGBAd(0.5, 0.25, 0.75, 1.0));
+
+	Texture::QualityMetrics metrics;
+	ASSERT_TRUE(computeQualityMetrics(metrics, texture, image, image, 1));
+	EXPECT_EQ(0.0, metrics.rmse.r);
+	EXPECT_EQ(0.0, metrics.rmse.a);
+	EXPECT_TRUE(std::isinf(metrics.psnr.g));
+	EXPECT_EQ(0.0, metrics.combinedRmse);
+	EXPECT_TRUE(std::isinf(metrics.combinedPsnr));
+	EXPECT_DOUBLE_EQ(1.0, metrics.ssim);
+}
+
+TEST(QualityMetricsTest, ChannelError)
+{
+	Texture texture(Texture::Dimension::Dim2D, 13, 11);
+	texture.setQualityMetricsEnabled(true, true);
+	convertTexture(texture);
+
+	Image image(Image::Format::RGBAF, 13, 11);
+	fillImage(image, ColorRGBAd(0.5, 0.5, 0.5, 1.0));
+	Image decodedImage(Image::Format::RGBAF, 13, 11);
+	fillImage(decodedImage, ColorRGBAd(0.6, 0.5, 0.5, 1.0));
+
+	Texture::QualityMetrics metrics;
+	ASSERT_TRUE(computeQualityMetrics(metrics, texture, image, decodedImage, 4));
+	EXPECT_NEAR(0.1, metrics.rmse.r, 1e-6);
+	EXPECT_NEAR(20.0, metrics.psnr.r, 1e-4);
+	EXPECT_EQ(0.0, metrics.rmse.g);
+	EXPECT_NEAR(0.05, metrics.combinedRmse, 1e-6);
+	EXPECT_NEAR(10.0*std::log10(400.0), metrics.combinedPsnr, 1e-4);
+	EXPECT_GT(1.0, metrics.ssim);
+	EXPECT_LT(0.99, metrics.ssim);
+
+	// Values outside of the range of the type are clamped.
+	fillImage(image, ColorRGBAd(1.5, 0.5, 0.5, 1.0));
+	fillImage(decodedImage, ColorRGBAd(1.0, 0.5, 0.5, 1.0));
+	ASSERT_TRUE(computeQualityMetrics(metrics, texture, image, decodedImage, 4));
+	EXPECT_EQ(0.0, metrics.rmse.r);
+}
+
+TEST(QualityMetricsTest, SNormPeak)
+{
+	Texture texture(Texture::Dimension::Dim2D, 13, 11);
+	texture.setQualityMetricsEnabled(true);
+	EXPECT_TRUE(texture.setImage(Image(Image::Format::RGBAF, 13, 11)));
+	EXPECT_TRUE(texture.convert(Texture::Format::R8G8B8A8, Texture::Type::SNorm));
+
+	Image image(Image::Format::RGBAF, 13, 11);
+	fillImage(image, ColorRGBAd(-0.5, 0.5, 0.5, 1.0));
+	Image decodedImage(Image::Format::RGBAF, 13, 11);
+	fillImage(decodedImage, ColorRGBAd(-0.6, 0.5, 0.5, 1.0));
+
+	// The peak is the span of [-1, 1].
+	Texture::QualityMetrics metrics;
+	ASSERT_TRUE(computeQualityMetrics(metrics, texture, image, decodedImage, 1));
+	EXPECT_NEAR(0.1, metrics.rmse.r, 1e-6);
+	EXPECT_NEAR(20.0*std::log10(2.0/0.1), metrics.psnr.r, 1e-4);
+}
+
+TEST(QualityMetricsTest, ColorMask)
+{
+	Texture texture(Texture::Dimension::Dim2D, 13, 11);
+	convertTexture(texture, Texture::ColorMask(false, true, true, true));
+
+	Image image(Image::Format::RGBAF, 13, 11);
+	fillImage(image, ColorRGBAd(0.5, 0.5, 0.5, 1.0));
+	Image decodedImage(Image::Format::RGBAF, 13, 11);
+	fillImage(decodedImage, ColorRGBAd(0.6, 0.5, 0.5, 1.0));
+
+	Texture::QualityMetrics metrics;
+	ASSERT_TRUE(computeQualityMetrics(metrics, texture, image, decodedImage, 1));
+	EXPECT_EQ(0.0, metrics.rmse.r);
+	EXPECT_TRUE(std::isinf(metrics.psnr.r));
+	EXPECT_TRUE(std::isinf(metrics.combinedPsnr));
+	EXPECT_EQ(-1.0, metrics.ssim);
+}
+
+TEST(QualityMetricsTest, PerceptualWeights)
+{
+	Texture texture(Texture::Dimension::Dim2D, 13, 11, 0, 1, ColorSpace::sRGB);
+	EXPECT_TRUE(texture.setImage(Image(Image::Format::RGBAF, 13, 11, ColorSpace::sRGB)));
+	EXPECT_TRUE(texture.convert(Texture::Format::R8G8B8A8, Texture::Type::UNorm));
+
+	Image image(Image::Format::RGBAF, 13, 11);
+	fillImage(image, ColorRGBAd(0.5, 0.5, 0.5, 1.0));
+	Image redImage(Image::Format::RGBAF, 13, 11);
+	fillImage(redImage, ColorRGBAd(0.6, 0.5, 0.5, 1.0));
+	Image greenImage(Image::Format::RGBAF, 13, 11);
+	fillImage(greenImage, ColorRGBAd(0.5, 0.6, 0.5, 1.0));
+
+	// Green contributes more to the perceived error than red.
+	Texture::QualityMetrics redMetrics, greenMetrics;
+	ASSERT_TRUE(computeQualityMetrics(redMetrics, texture, image, redImage, 1));
+	ASSERT_TRUE(computeQualityMetrics(greenMetrics, texture, image, greenImage, 1));
+	EXPECT_DOUBLE_EQ(redMetrics.psnr.r, greenMetrics.psnr.g);
+	EXPECT_GT(redMetrics.combinedPsnr, greenMetrics.combinedPsnr);
+}
+
+TEST(QualityMetricsTest, Invalid)
+{
+	Texture texture(Texture::Dimension::Dim2D, 13, 11);
+	convertTexture(texture);
+
+	Texture::QualityMetrics metrics;
+	EXPECT_FALSE(computeQualityMetrics(metrics, texture, Image(Image::Format::RGBAF, 13, 11),
+		Image(Image::Format::RGBAF, 12, 11), 1));
+	EXPECT_FALSE(computeQualityMetrics(metrics, texture, Image(Image::Format::RGBAF, 13, 11),
+		Image(Image::Format::RGBA8, 13, 11), 1));
+
+	// Not supported for formats that can't be decoded.
+	EXPECT_FALSE(texture.qualityMetrics(metrics));
+}
+
+#if CUTTLEFISH_HAS_S3TC
+TEST(QualityMetricsTest, Convert)
+{
+	Texture texture(Texture::Dimension::Dim2D, 13, 11);
+	Image image(Image::Format::RGBAF, 13, 11);
+	fillImage(image, ColorRGBAd(0.0, 1.0, 0.0, 1.0));
+	EXPECT_TRUE(texture.setImage(image));
+
+	EXPECT_TRUE(texture.convert(Texture::Format::BC1_RGB, Texture::Type::UNorm));
+	Texture::QualityMetrics metrics;
+	EXPECT_FALSE(texture.qualityMetrics(metrics));
+
+	EXPECT_TRUE(texture.setImage(image));
+	texture.setQualityMetricsEnabled(true);
+	EXPECT_TRUE(texture.convert(Texture::Format::BC1_RGB, Texture::Type::UNorm));
+	ASSERT_TRUE(texture.qualityMetrics(metrics));
+	EXPECT_GT(1e-2, metrics.combinedRmse);
+	EXPECT_EQ(0.0, metrics.rmse.a);
+	EXPECT_EQ(-1.0, metrics.ssim);
+
+	EXPECT_FALSE(texture.qualityMetrics(metrics, 1));
+	EXPECT_FALSE(texture.qualityMetrics(metrics, 0, 1));
+}
+
+TEST(QualityMetricsTest, ConvertToQualityTarget)
+{
+	std::vector<Texture::Format> candidates = {Texture::Format::BC7, Texture::Format::BC3,
+		Texture::Format::BC1_RGBA};
+
+	Texture texture(Texture::Dimension::Dim2D, 13, 11);
+	Image image(Image::Format::RGBAF, 13, 11);
+	fillImage(image, ColorRGBAd(0.0, 1.0, 0.0, 1.0));
+	EXPECT_TRUE(texture.setImage(image));
+	EXPECT_TRUE(texture.convertToQualityTarget(candidates, Texture::Type::UNorm, 30.0));
+	EXPECT_EQ(Texture::Format::BC1_RGBA, texture.format());
+	Texture::QualityMetrics metrics;
+	EXPECT_FALSE(texture.qualityMetrics(metrics));
+
+	// Fall back to the largest format when the target can't be met.
+	for (unsigned int y = 0; y < image.height(); ++y)
+	{
+		for (unsigned int x = 0; x < image.width(); ++x)
+		{
+			EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd((x*7 % 5)/4.0, (y*3 % 7)/6.0,
+				((x + y) % 3)/2.0, 1.0)));
+		}
+	}
+	EXPECT_TRUE(texture.setImage(image));
+	EXPECT_TRUE(texture.convertToQualityTarget(candidates, Texture::Type::UNorm, 1000.0));
+	EXPECT_EQ(Texture::Format::BC7, texture.format());
+
+	EXPECT_TRUE(texture.setImage(image));
+	EXPECT_FALSE(texture.convertToQualityTarget({}, Texture::Type::UNorm, 30.0));
+	EXPECT_FALSE(texture.convertToQualityTarget({Texture::Format::R8G8B8A8},
+		Texture::Type::UNorm, 30.0));
+}
+#endif
+
+} // namespace cuttlefish
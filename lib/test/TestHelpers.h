@@ -0,0 +1,74 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Image.h>
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace cuttlefish
+{
+
+inline void fillImage(Image& image, const ColorRGBAd& color)
+{
+	for (unsigned int y = 0; y < image.height(); ++y)
+	{
+		for (unsigned int x = 0; x < image.width(); ++x)
+			EXPECT_TRUE(image.setPixel(x, y, color));
+	}
+}
+
+inline void fillGradientImage(Image& image)
+{
+	// Smooth gradients with a small amount of deterministic noise to exercise the endpoint search.
+	for (unsigned int y = 0; y < image.height(); ++y)
+	{
+		for (unsigned int x = 0; x < image.width(); ++x)
+		{
+			double noise = ((x*7 + y*13) % 5)/64.0;
+			ColorRGBAd color(static_cast<double>(x)/image.width() + noise,
+				static_cast<double>(y)/image.height(),
+				static_cast<double>(x + y)/(image.width() + image.height()) - noise, 1.0);
+			EXPECT_TRUE(image.setPixel(x, y, color));
+		}
+	}
+}
+
+inline std::vector<std::uint8_t> readFile(const char* fileName)
+{
+	std::ifstream stream(fileName, std::ifstream::binary);
+	return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(stream),
+		std::istreambuf_iterator<char>());
+}
+
+inline void writeFile(const char* fileName, const void* data, std::size_t size)
+{
+	std::ofstream stream(fileName, std::ofstream::binary);
+	stream.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+inline void writeFile(const char* fileName, const std::vector<std::uint8_t>& data)
+{
+	writeFile(fileName, data.data(), data.size());
+}
+
+} // namespace cuttlefish
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureArena.h"
+#include <gtest/gtest.h>
+
+namespace cuttlefish
+{
+
+TEST(TextureArenaTest, ImageSize)
+{
+	EXPECT_EQ(15U*10U*4U, TextureArena::imageSize(Texture::Format::R8G8B8A8, 15, 10));
+	EXPECT_EQ(4U*3U*8U, TextureArena::imageSize(Texture::Format::BC1_RGB, 15, 10));
+	EXPECT_EQ(8U, TextureArena::imageSize(Texture::Format::BC1_RGB, 1, 1));
+	EXPECT_EQ(3U*3U*16U, TextureArena::imageSize(Texture::Format::ASTC_5x5, 15, 11));
+	EXPECT_EQ(32U, TextureArena::imageSize(Texture::Format::PVRTC1_RGB_4BPP, 1, 1));
+	EXPECT_EQ(32U, TextureArena::imageSize(Texture::Format::PVRTC1_RGB_2BPP, 1, 1));
+	EXPECT_EQ(0U, TextureArena::imageSize(Texture::Format::Unknown, 1, 1));
+}
+
+TEST(TextureArenaTest, Layout)
+{
+	Texture texture(Texture::Dimension::Cube, 8, 4, 2, Texture::allMipLevels);
+	ASSERT_TRUE(texture.isValid());
+	ASSERT_EQ(4U, texture.mipLevelCount());
+
+	// Only the number of images is needed, so they don't need to be set.
+	TextureArena::MipImageList images(texture.mipLevelCount(),
+		std::vector<std::vector<Image>>(2, std::vector<Image>(6)));
+
+	TextureArena arena;
+	EXPECT_TRUE(arena.empty());
+	EXPECT_FALSE(arena.initialize(texture, images));
+
+	// The texture format is only set when converting.
+	Image image(Image::Format::RGBAF, 8, 4);
+	for (unsigned int d = 0; d < 2; ++d)
+	{
+		for (unsigned int f = 0; f < 6; ++f)
+			ASSERT_TRUE(texture.setImage(image, static_cast<Texture::CubeFace>(f), 0, d));
+	}
+	ASSERT_TRUE(texture.generateMipmaps(Image::ResizeFilter::Box));
+	ASSERT_TRUE(texture.convert(Texture::Format::R8G8, Texture::Type::UNorm));
+
+	ASSERT_TRUE(arena.initialize(texture, images));
+	EXPECT_FALSE(arena.empty());
+	EXPECT_EQ((8U*4U + 4U*2U + 2U*1U + 1U*1U)*2U*2U*6U, arena.size());
+
+	// Images are ordered by mip level, depth, then face.
+	EXPECT_EQ(arena.data(), arena.data(0, 0, 0));
+	EXPECT_EQ(8U*4U*2U, arena.size(0, 0, 0));
+	EXPECT_EQ(arena.data(0, 0, 0) + 8*4*2, arena.data(0, 0, 1));
+	EXPECT_EQ(arena.data(0, 0, 0) + 8*4*2*6, arena.data(0, 1, 0));
+	EXPECT_EQ(arena.data(0, 0, 0) + 8*4*2*12, arena.data(1, 0, 0));
+	EXPECT_EQ(4U*2U*2U, arena.size(1, 1, 5));
+	EXPECT_EQ(arena.data() + arena.size() - 2, arena.data(3, 1, 5));
+
+	EXPECT_EQ(nullptr, arena.data(4, 0, 0));
+	EXPECT_EQ(nullptr, arena.data(0, 2, 0));
+	EXPECT_EQ(nullptr, arena.data(0, 0, 6));
+	EXPECT_EQ(0U, arena.size(4, 0, 0));
+
+	arena.data()[0] = 12;
+	arena.data()[1] = 0;
+	TextureArena copy(arena);
+	ASSERT_EQ(arena.size(), copy.size());
+
+	// Copies share the data until they're modified.
+	const TextureArena& constArena = arena;
+	const TextureArena& constCopy = copy;
+	EXPECT_EQ(constArena.data(), constCopy.data());
+	copy.data()[1] = 34;
+	EXPECT_NE(constArena.data(), constCopy.data());
+	EXPECT_NE(34, constArena.data()[1]);
+	EXPECT_EQ(12, copy.data()[0]);
+	EXPECT_EQ(copy.data() + 8*4*2, copy.data(0, 0, 1));
+
+	TextureArena moved(std::move(copy));
+	EXPECT_TRUE(copy.empty());
+	EXPECT_EQ(12, moved.data()[0]);
+
+	arena.reset();
+	EXPECT_TRUE(arena.empty());
+	EXPECT_EQ(0U, arena.size());
+}
+
+} // namespace cuttlefish
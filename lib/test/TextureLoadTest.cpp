@@ -0,0 +1,249 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TestHelpers.h"
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Handle different versions of gtest.
+#ifndef INSTANTIATE_TEST_SUITE_P
+#define INSTANTIATE_TEST_SUITE_P INSTANTIATE_TEST_CASE_P
+#endif
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+struct TextureLoadTestInfo
+{
+	Texture::Dimension dimension;
+	unsigned int width;
+	unsigned int height;
+	unsigned int depth;
+	unsigned int mipLevels;
+	Texture::Format format;
+	Texture::Type type;
+};
+
+class TextureLoadTest : public testing::TestWithParam<TextureLoadTestInfo>
+{
+};
+
+void createTexture(Texture& texture, const TextureLoadTestInfo& info)
+{
+	ASSERT_TRUE(texture.initialize(info.dimension, info.width, info.height, info.depth));
+	for (unsigned int d = 0; d < texture.depth(); ++d)
+	{
+		for (unsigned int f = 0; f < texture.faceCount(); ++f)
+		{
+			Image image(Image::Format::RGBAF, info.width, info.height);
+			for (unsigned int y = 0; y < image.height(); ++y)
+			{
+				for (unsigned int x = 0; x < image.width(); ++x)
+				{
+					EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd{x/double(info.width),
+						y/double(info.height), (d*6 + f)/64.0, 1.0}));
+				}
+			}
+			EXPECT_TRUE(texture.setImage(image, static_cast<Texture::CubeFace>(f), 0, d));
+		}
+	}
+	EXPECT_TRUE(texture.generateMipmaps(Image::ResizeFilter::Box, info.mipLevels));
+	EXPECT_TRUE(texture.convert(info.format, info.type));
+}
+
+} // namespace
+
+TEST_P(TextureLoadTest, Load)
+{
+	const TextureLoadTestInfo& info = GetParam();
+	Texture texture;
+	createTexture(texture, info);
+	ASSERT_TRUE(texture.converted());
+
+	const Texture::FileType fileTypes[] =
+		{Texture::FileType::DDS, Texture::FileType::KTX, Texture::FileType::PVR};
+	const char* fileName = "TextureLoadTest.tex";
+	for (Texture::FileType fileType : fileTypes)
+	{
+		if (!Texture::isFormatValid(info.format, info.type, fileType))
+			continue;
+
+		ASSERT_EQ(Texture::SaveResult::Success, texture.save(fileName, fileType));
+
+		Texture loadedTexture;
+		ASSERT_TRUE(loadedTexture.load(fileName, fileType));
+		EXPECT_TRUE(loadedTexture.converted());
+		EXPECT_EQ(texture.dimension(), loadedTexture.dimension());
+		EXPECT_EQ(texture.width(), loadedTexture.width());
+		EXPECT_EQ(texture.height(), loadedTexture.height());
+		EXPECT_EQ(texture.depth(), loadedTexture.depth());
+		EXPECT_EQ(texture.mipLevelCount(), loadedTexture.mipLevelCount());
+		EXPECT_EQ(texture.faceCount(), loadedTexture.faceCount());
+		EXPECT_EQ(texture.format(), loadedTexture.format());
+		EXPECT_EQ(texture.type(), loadedTexture.type());
+
+		for (unsigned int mip = 0; mip < texture.mipLevelCount(); ++mip)
+		{
+			for (unsigned int d = 0; d < texture.depth(mip); ++d)
+			{
+				for (unsigned int f = 0; f < texture.faceCount(); ++f)
+				{
+					auto face = static_cast<Texture::CubeFace>(f);
+					std::size_t size = texture.dataSize(face, mip, d);
+					ASSERT_EQ(size, loadedTexture.dataSize(face, mip, d));
+					EXPECT_EQ(0, std::memcmp(texture.data(face, mip, d),
+						loadedTexture.data(face, mip, d), size));
+				}
+			}
+		}
+
+		// Copies share the mapped file, so the original may be released first.
+		Texture copiedTexture = loadedTexture;
+		loadedTexture.reset();
+
+		std::vector<std::uint8_t> expectedData;
+		EXPECT_EQ(Texture::SaveResult::Success, texture.save(expectedData, fileType));
+		std::vector<std::uint8_t> data;
+		EXPECT_EQ(Texture::SaveResult::Success, copiedTexture.save(data, fileType));
+		EXPECT_EQ(expectedData, data);
+	}
+
+	std::remove(fileName);
+}
+
+TEST(TextureLoadTest, Invalid)
+{
+	const char* fileName = "TextureLoadTest.tex";
+	Texture texture;
+	EXPECT_FALSE(texture.load(nullptr));
+	EXPECT_FALSE(texture.load("nonexistent.dds"));
+
+	const std::uint8_t invalidData[] = {1, 2, 3, 4, 5, 6, 7, 8};
+	writeFile(fileName, invalidData, sizeof(invalidData));
+	EXPECT_FALSE(texture.load(fileName, Texture::FileType::DDS));
+	EXPECT_FALSE(texture.load(fileName, Texture::FileType::KTX));
+	EXPECT_FALSE(texture.load(fileName, Texture::FileType::PVR));
+	EXPECT_FALSE(texture.load(fileName, Texture::FileType::KTX2));
+	EXPECT_FALSE(texture.load(fileName, Texture::FileType::Auto));
+
+	// Truncated files must not reference data past the end.
+	TextureLoadTestInfo info = {Texture::Dimension::Dim2D, 16, 16, 0, 3,
+		Texture::Format::R8G8B8A8, Texture::Type::UNorm};
+	Texture savedTexture;
+	createTexture(savedTexture, info);
+	const Texture::FileType fileTypes[] =
+		{Texture::FileType::DDS, Texture::FileType::KTX, Texture::FileType::PVR};
+	for (Texture::FileType fileType : fileTypes)
+	{
+		std::vector<std::uint8_t> data;
+		EXPECT_EQ(Texture::SaveResult::Success, savedTexture.save(data, fileType));
+		writeFile(fileName, data.data(), data.size() - 1);
+		EXPECT_FALSE(texture.load(fileName, fileType));
+		EXPECT_FALSE(texture.converted());
+	}
+
+	std::remove(fileName);
+}
+
+TEST(TextureLoadTest, SaveToLoadedFile)
+{
+	const char* fileName = "TextureLoadTest.tex";
+	TextureLoadTestInfo info = {Texture::Dimension::Dim2D, 16, 16, 0, 3,
+		Texture::Format::R8G8B8A8, Texture::Type::UNorm};
+	Texture texture;
+	createTexture(texture, info);
+
+	const Texture::FileType fileTypes[] =
+		{Texture::FileType::DDS, Texture::FileType::KTX, Texture::FileType::PVR};
+	for (Texture::FileType fileType : fileTypes)
+	{
+		ASSERT_EQ(Texture::SaveResult::Success, texture.save(fileName, fileType));
+		std::vector<std::uint8_t> expectedData = readFile(fileName);
+
+		// The loaded texture references the file that's being replaced.
+		Texture loadedTexture;
+		ASSERT_TRUE(loadedTexture.load(fileName, fileType));
+		EXPECT_EQ(Texture::SaveResult::Success, loadedTexture.save(fileName, fileType));
+		EXPECT_EQ(expectedData, readFile(fileName));
+
+		std::vector<std::uint8_t> data;
+		EXPECT_EQ(Texture::SaveResult::Success, loadedTexture.save(data, fileType));
+		EXPECT_EQ(expectedData, data);
+	}
+
+	std::remove(fileName);
+}
+
+TEST(TextureLoadTest, Transcode)
+{
+	const char* inputFileName = "TextureLoadTestInput.ktx";
+	const char* outputFileName = "TextureLoadTestOutput.tex";
+	TextureLoadTestInfo info = {Texture::Dimension::Dim2D, 15, 9, 3, 4,
+		Texture::Format::R8G8B8, Texture::Type::UNorm};
+	Texture texture;
+	createTexture(texture, info);
+	ASSERT_EQ(Texture::SaveResult::Success, texture.save(inputFileName));
+
+	std::vector<std::uint8_t> expectedData;
+	EXPECT_EQ(Texture::SaveResult::Success, texture.save(expectedData, Texture::FileType::PVR));
+	EXPECT_EQ(Texture::SaveResult::Success, Texture::transcode(inputFileName, outputFileName,
+		Texture::FileType::Auto, Texture::FileType::PVR));
+	EXPECT_EQ(expectedData, readFile(outputFileName));
+
+	EXPECT_EQ(Texture::SaveResult::Unsupported, Texture::transcode(inputFileName,
+		outputFileName, Texture::FileType::Auto, Texture::FileType::DDS));
+
+	// Transcode back to the original container to exercise KTX row padding.
+	EXPECT_EQ(Texture::SaveResult::Success, Texture::transcode(outputFileName, inputFileName,
+		Texture::FileType::PVR, Texture::FileType::KTX));
+	EXPECT_EQ(Texture::SaveResult::Success, texture.save(expectedData, Texture::FileType::KTX));
+	EXPECT_EQ(expectedData, readFile(inputFileName));
+
+	// Transcode in place, replacing the file that's memory mapped for the input.
+	EXPECT_EQ(Texture::SaveResult::Success, Texture::transcode(inputFileName, inputFileName,
+		Texture::FileType::KTX, Texture::FileType::KTX));
+	EXPECT_EQ(expectedData, readFile(inputFileName));
+
+	EXPECT_EQ(Texture::SaveResult::Invalid,
+		Texture::transcode("nonexistent.ktx", outputFileName));
+
+	std::remove(inputFileName);
+	std::remove(outputFileName);
+}
+
+INSTANTIATE_TEST_SUITE_P(TextureLoadTestTypes,
+	TextureLoadTest,
+	testing::Values(
+		TextureLoadTestInfo{Texture::Dimension::Dim2D, 16, 16, 0, 5,
+			Texture::Format::R8G8B8A8, Texture::Type::UNorm},
+		TextureLoadTestInfo{Texture::Dimension::Dim2D, 15, 9, 3, 3,
+			Texture::Format::R8G8B8, Texture::Type::UNorm},
+		TextureLoadTestInfo{Texture::Dimension::Dim2D, 8, 8, 1, 2,
+			Texture::Format::R8G8B8A8, Texture::Type::UNorm},
+		TextureLoadTestInfo{Texture::Dimension::Cube, 8, 8, 2, 2,
+			Texture::Format::R16G16B16A16, Texture::Type::Float},
+		TextureLoadTestInfo{Texture::Dimension::Dim3D, 8, 8, 4, 3,
+			Texture::Format::R8, Texture::Type::UNorm}));
+
+} // namespace cuttlefish
@@ -14,10 +14,13 @@
  * limitations under the License.
  */
 
+#include "TestHelpers.h"
 #include <cuttlefish/Color.h>
 #include <cuttlefish/Image.h>
 #include <cuttlefish/Texture.h>
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
 #include <vector>
 #include <utility>
 
@@ -37,6 +40,15 @@ static const char* nullFile = "nul";
 static const char* nullFile = "/dev/null";
 #endif
 
+template <typename T>
+static T readValue(const std::vector<std::uint8_t>& data, std::size_t offset)
+{
+	T value = 0;
+	if (offset + sizeof(T) <= data.size())
+		std::memcpy(&value, data.data() + offset, sizeof(T));
+	return value;
+}
+
 struct TextureSaveTestInfo
 {
 	TextureSaveTestInfo(Texture::Format _format,
@@ -66,6 +78,14 @@ class TextureSaveSpecialKtxTest : public testing::TestWithParam<TextureSaveTestI
 {
 };
 
+class TextureSaveKtx2Test : public testing::TestWithParam<TextureSaveTestInfo>
+{
+};
+
+class TextureSaveSpecialKtx2Test : public testing::TestWithParam<TextureSaveTestInfo>
+{
+};
+
 class TextureSavePvrTest : public testing::TestWithParam<TextureSaveTestInfo>
 {
 };
@@ -182,6 +202,60 @@ TEST_P(TextureSaveSpecialKtxTest, Save)
 	}
 }
 
+TEST_P(TextureSaveKtx2Test, Save)
+{
+	const TextureSaveTestInfo& info = GetParam();
+	for (const auto& typeInfo : info.types)
+	{
+		Texture texture(Texture::Dimension::Dim2D, 16, 16);
+		Image image(Image::Format::RGBAF, 16, 16);
+		for (unsigned int y = 0; y < image.height(); ++y)
+		{
+			for (unsigned int x = 0; x < image.width(); ++x)
+				EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd{0.0, 0.0, 0.0, 1.0}));
+		}
+		EXPECT_TRUE(texture.setImage(image));
+
+		EXPECT_TRUE(texture.convert(info.format, typeInfo.first));
+		unsigned int blockX = (texture.width() + Texture::blockWidth(info.format) - 1)/
+			Texture::blockWidth(info.format);
+		unsigned int blockY = (texture.height() + Texture::blockHeight(info.format) - 1)/
+			Texture::blockHeight(info.format);
+		EXPECT_EQ(blockX*blockY*Texture::blockSize(info.format), texture.dataSize());
+
+		EXPECT_EQ(typeInfo.second == success, Texture::isFormatValid(info.format, typeInfo.first,
+			Texture::FileType::KTX2));
+		EXPECT_EQ(typeInfo.second, texture.save(nullFile, Texture::FileType::KTX2));
+	}
+}
+
+TEST_P(TextureSaveSpecialKtx2Test, Save)
+{
+	const TextureSaveTestInfo& info = GetParam();
+	for (const auto& typeInfo : info.types)
+	{
+		Texture texture(Texture::Dimension::Dim2D, 16, 16);
+		Image image(Image::Format::RGBAF, 16, 16);
+		for (unsigned int y = 0; y < image.height(); ++y)
+		{
+			for (unsigned int x = 0; x < image.width(); ++x)
+				EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd{0.0, 0.0, 0.0, 1.0}));
+		}
+		EXPECT_TRUE(texture.setImage(image));
+
+		EXPECT_TRUE(texture.convert(info.format, typeInfo.first));
+		unsigned int blockX = (texture.width() + Texture::blockWidth(info.format) - 1)/
+			Texture::blockWidth(info.format);
+		unsigned int blockY = (texture.height() + Texture::blockHeight(info.format) - 1)/
+			Texture::blockHeight(info.format);
+		EXPECT_EQ(blockX*blockY*Texture::blockSize(info.format), texture.dataSize());
+
+		EXPECT_EQ(typeInfo.second == success, Texture::isFormatValid(info.format, typeInfo.first,
+			Texture::FileType::KTX2));
+		EXPECT_EQ(typeInfo.second, texture.save(nullFile, Texture::FileType::KTX2));
+	}
+}
+
 TEST_P(TextureSavePvrTest, Save)
 {
 	const TextureSaveTestInfo& info = GetParam();
@@ -265,6 +339,203 @@ TEST(TextureSaveTest, SaveVector)
 	EXPECT_EQ(pvrHeaderSize + dataSize, data.size());
 }
 
+TEST(TextureSaveTest, SaveMemory)
+{
+	Texture texture(Texture::Dimension::Dim2D, 16, 16);
+	EXPECT_EQ(0U, texture.savedSize(Texture::FileType::DDS));
+
+	Image image(Image::Format::RGBAF, 16, 16);
+	for (unsigned int y = 0; y < image.height(); ++y)
+	{
+		for (unsigned int x = 0; x < image.width(); ++x)
+			EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd{0.0, 0.0, 0.0, 1.0}));
+	};
+	EXPECT_TRUE(texture.setImage(image));
+	EXPECT_TRUE(texture.convert(Texture::Format::R8G8B8A8, Texture::Type::UNorm));
+	EXPECT_EQ(0U, texture.savedSize(Texture::FileType::Auto));
+
+	const Texture::FileType fileTypes[] =
+	{
+		Texture::FileType::DDS, Texture::FileType::KTX, Texture::FileType::PVR,
+		Texture::FileType::KTX2
+	};
+	for (Texture::FileType fileType : fileTypes)
+	{
+		std::vector<std::uint8_t> expectedData;
+		EXPECT_EQ(success, texture.save(expectedData, fileType));
+
+		std::size_t size = texture.savedSize(fileType);
+		EXPECT_EQ(expectedData.size(), size);
+
+		std::vector<std::uint8_t> data(size + 1, 0xFF);
+		EXPECT_EQ(success, texture.save(data.data(), size, fileType));
+		EXPECT_EQ(0xFF, data.back());
+		data.pop_back();
+		EXPECT_EQ(expectedData, data);
+
+		EXPECT_EQ(Texture::SaveResult::WriteError, texture.save(data.data(), size - 1, fileType));
+	}
+}
+
+TEST(TextureSaveTest, ConvertAndSave)
+{
+	// Odd sizes with 3 channels require row padding for KTX, and the cube faces with mipmaps are
+	// ordered differently for DDS.
+	auto createTexture = [](Texture& texture)
+	{
+		EXPECT_TRUE(texture.initialize(Texture::Dimension::Cube, 15, 15));
+		for (unsigned int f = 0; f < 6; ++f)
+		{
+			Image image(Image::Format::RGBAF, 15, 15);
+			for (unsigned int y = 0; y < image.height(); ++y)
+			{
+				for (unsigned int x = 0; x < image.width(); ++x)
+					EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd{x/15.0, y/15.0, f/6.0, 1.0}));
+			}
+			EXPECT_TRUE(texture.setImage(image, static_cast<Texture::CubeFace>(f)));
+		}
+		EXPECT_TRUE(texture.generateMipmaps(Image::ResizeFilter::Box, 3));
+	};
+
+	const Texture::Format formats[] = {Texture::Format::R8G8B8A8, Texture::Format::R8G8B8};
+	const Texture::FileType fileTypes[] =
+	{
+		Texture::FileType::DDS, Texture::FileType::KTX, Texture::FileType::PVR,
+		Texture::FileType::KTX2
+	};
+	const char* fileName = "TextureSaveTest.tex";
+	for (Texture::Format format : formats)
+	{
+		for (Texture::FileType fileType : fileTypes)
+		{
+			Texture expectedTexture;
+			createTexture(expectedTexture);
+			EXPECT_TRUE(expectedTexture.convert(format, Texture::Type::UNorm));
+			std::vector<std::uint8_t> expectedData;
+			Texture::SaveResult expectedResult = expectedTexture.save(expectedData, fileType);
+
+			Texture texture;
+			createTexture(texture);
+			EXPECT_EQ(expectedResult, texture.convertAndSave(fileName, fileType, format,
+				Texture::Type::UNorm));
+			EXPECT_TRUE(texture.converted());
+			if (expectedResult == success)
+			{
+				EXPECT_EQ(expectedData, readFile(fileName));
+			}
+			std::remove(fileName);
+		}
+	}
+
+	Texture texture;
+	createTexture(texture);
+	EXPECT_EQ(Texture::SaveResult::UnknownFormat, texture.convertAndSave("test.tex",
+		Texture::FileType::Auto, Texture::Format::R8G8B8A8, Texture::Type::UNorm));
+}
+
+TEST(TextureSaveTest, SaveKtx2)
+{
+	Texture texture(Texture::Dimension::Dim2D, 16, 16);
+	Image image(Image::Format::RGBAF, 16, 16);
+	for (unsigned int y = 0; y < image.height(); ++y)
+	{
+		for (unsigned int x = 0; x < image.width(); ++x)
+			EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd{0.0, 0.0, 0.0, 1.0}));
+	};
+	EXPECT_TRUE(texture.setImage(image));
+	EXPECT_TRUE(texture.generateMipmaps(Image::ResizeFilter::Box, 3));
+	EXPECT_TRUE(texture.convert(Texture::Format::R8G8B8A8, Texture::Type::UNorm));
+
+	EXPECT_EQ(Texture::FileType::KTX2, Texture::fileType("test.ktx2"));
+	EXPECT_EQ(Texture::FileType::KTX, Texture::fileType("test.ktx"));
+
+	std::vector<std::uint8_t> data;
+	ASSERT_EQ(success, texture.save(data, Texture::FileType::KTX2));
+	const char identifier[] =
+		{'\xAB', 'K', 'T', 'X', ' ', '2', '0', '\xBB', '\r', '\n', '\x1A', '\n'};
+	ASSERT_LT(sizeof(identifier), data.size());
+	EXPECT_EQ(0, std::memcmp(identifier, data.data(), sizeof(identifier)));
+
+	EXPECT_EQ(37U, readValue<std::uint32_t>(data, 12)); // VK_FORMAT_R8G8B8A8_UNORM
+	EXPECT_EQ(1U, readValue<std::uint32_t>(data, 16));
+	EXPECT_EQ(16U, readValue<std::uint32_t>(data, 20));
+	EXPECT_EQ(16U, readValue<std::uint32_t>(data, 24));
+	EXPECT_EQ(0U, readValue<std::uint32_t>(data, 28));
+	EXPECT_EQ(0U, readValue<std::uint32_t>(data, 32));
+	EXPECT_EQ(1U, readValue<std::uint32_t>(data, 36));
+	EXPECT_EQ(3U, readValue<std::uint32_t>(data, 40));
+	EXPECT_EQ(0U, readValue<std::uint32_t>(data, 44));
+
+	// DFD with 4 samples.
+	auto dfdOffset = readValue<std::uint32_t>(data, 48);
+	EXPECT_EQ(80U + 3*24, dfdOffset);
+	EXPECT_EQ(4U + 24 + 4*16, readValue<std::uint32_t>(data, 52));
+	EXPECT_EQ(4U + 24 + 4*16, readValue<std::uint32_t>(data, dfdOffset));
+
+	// Levels are stored from smallest to largest.
+	std::uint64_t prevOffset = data.size();
+	for (unsigned int level = 0; level < 3; ++level)
+	{
+		std::size_t indexOffset = 80 + level*24;
+		auto offset = readValue<std::uint64_t>(data, indexOffset);
+		auto size = readValue<std::uint64_t>(data, indexOffset + 8);
+		EXPECT_EQ(texture.dataSize(Texture::CubeFace::PosX, level), size);
+		EXPECT_EQ(size, readValue<std::uint64_t>(data, indexOffset + 16));
+		EXPECT_EQ(0U, offset % 4);
+		EXPECT_GE(prevOffset, offset + size);
+		prevOffset = offset;
+
+		ASSERT_LE(offset + size, data.size());
+		EXPECT_EQ(0, std::memcmp(texture.data(Texture::CubeFace::PosX, level),
+			data.data() + offset, static_cast<std::size_t>(size)));
+	}
+	EXPECT_EQ(data.size(), readValue<std::uint64_t>(data, 80) +
+		readValue<std::uint64_t>(data, 88));
+}
+
+TEST(TextureSaveTest, SaveKtx2Zstd)
+{
+	Texture texture(Texture::Dimension::Dim2D, 16, 16);
+	Image image(Image::Format::RGBAF, 16, 16);
+	for (unsigned int y = 0; y < image.height(); ++y)
+	{
+		for (unsigned int x = 0; x < image.width(); ++x)
+			EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd{0.0, 0.0, 0.0, 1.0}));
+	};
+	EXPECT_TRUE(texture.setImage(image));
+	EXPECT_TRUE(texture.generateMipmaps(Image::ResizeFilter::Box, 3));
+	EXPECT_TRUE(texture.convert(Texture::Format::R8G8B8A8, Texture::Type::UNorm));
+	texture.setKtx2ZstdLevel(3);
+	EXPECT_EQ(3U, texture.ktx2ZstdLevel());
+
+	std::vector<std::uint8_t> data;
+#if CUTTLEFISH_HAS_ZSTD
+	ASSERT_EQ(success, texture.save(data, Texture::FileType::KTX2));
+	EXPECT_EQ(2U, readValue<std::uint32_t>(data, 44));
+
+	std::uint64_t prevOffset = data.size();
+	for (unsigned int level = 0; level < 3; ++level)
+	{
+		std::size_t indexOffset = 80 + level*24;
+		auto offset = readValue<std::uint64_t>(data, indexOffset);
+		auto size = readValue<std::uint64_t>(data, indexOffset + 8);
+		EXPECT_EQ(texture.dataSize(Texture::CubeFace::PosX, level),
+			readValue<std::uint64_t>(data, indexOffset + 16));
+		EXPECT_LT(0U, size);
+		EXPECT_EQ(prevOffset, offset + size);
+		prevOffset = offset;
+	}
+
+	// The solid color should compress well.
+	EXPECT_GT(texture.dataSize(Texture::CubeFace::PosX, 0), readValue<std::uint64_t>(data, 88));
+#else
+	EXPECT_EQ(unsupported, texture.save(data, Texture::FileType::KTX2));
+#endif
+
+	// Other file types are unaffected.
+	EXPECT_EQ(success, texture.save(data, Texture::FileType::KTX));
+}
+
 INSTANTIATE_TEST_SUITE_P(TextureSaveTestTypes,
 	TextureSaveDdsTest,
 	testing::Values(
@@ -553,6 +824,150 @@ INSTANTIATE_TEST_SUITE_P(TextureSaveTestTypes,
 		PVRTC_SAVE_KTX_TESTS
 		));
 
+INSTANTIATE_TEST_SUITE_P(TextureSaveTestTypes,
+	TextureSaveKtx2Test,
+	testing::Values(
+		TextureSaveTestInfo(Texture::Format::R4G4, {{Texture::Type::UNorm, success}}),
+		TextureSaveTestInfo(Texture::Format::R4G4B4A4, {{Texture::Type::UNorm, success}}),
+		TextureSaveTestInfo(Texture::Format::B4G4R4A4, {{Texture::Type::UNorm, success}}),
+		TextureSaveTestInfo(Texture::Format::A4R4G4B4, {{Texture::Type::UNorm, success}}),
+		TextureSaveTestInfo(Texture::Format::R5G6B5, {{Texture::Type::UNorm, success}}),
+		TextureSaveTestInfo(Texture::Format::B5G6R5, {{Texture::Type::UNorm, success}}),
+		TextureSaveTestInfo(Texture::Format::R5G5B5A1, {{Texture::Type::UNorm, success}}),
+		TextureSaveTestInfo(Texture::Format::B5G5R5A1, {{Texture::Type::UNorm, success}}),
+		TextureSaveTestInfo(Texture::Format::A1R5G5B5, {{Texture::Type::UNorm, success}}),
+		TextureSaveTestInfo(Texture::Format::R8, {{Texture::Type::UNorm, success},
+			{Texture::Type::SNorm, success}, {Texture::Type::UInt, success},
+			{Texture::Type::Int, success}}),
+		TextureSaveTestInfo(Texture::Format::R8G8, {{Texture::Type::UNorm, success},
+			{Texture::Type::SNorm, success}, {Texture::Type::UInt, success},
+			{Texture::Type::Int, success}}),
+		TextureSaveTestInfo(Texture::Format::R8G8B8, {{Texture::Type::UNorm, success},
+			{Texture::Type::SNorm, success}, {Texture::Type::UInt, success},
+			{Texture::Type::Int, success}}),
+		TextureSaveTestInfo(Texture::Format::B8G8R8, {{Texture::Type::UNorm, success}}),
+		TextureSaveTestInfo(Texture::Format::R8G8B8A8, {{Texture::Type::UNorm, success},
+			{Texture::Type::SNorm, success}, {Texture::Type::UInt, success},
+			{Texture::Type::Int, success}}),
+		TextureSaveTestInfo(Texture::Format::B8G8R8A8, {{Texture::Type::UNorm, success}}),
+		TextureSaveTestInfo(Texture::Format::A8B8G8R8, {{Texture::Type::UNorm, unsupported}}),
+		TextureSaveTestInfo(Texture::Format::A2R10G10B10, {{Texture::Type::UNorm, success},
+			{Texture::Type::UInt, success}}),
+		TextureSaveTestInfo(Texture::Format::A2B10G10R10, {{Texture::Type::UNorm, success},
+			{Texture::Type::UInt, success}}),
+		TextureSaveTestInfo(Texture::Format::R16, {{Texture::Type::UNorm, success},
+			{Texture::Type::SNorm, success}, {Texture::Type::UInt, success},
+			{Texture::Type::Int, success}, {Texture::Type::Float, success}}),
+		TextureSaveTestInfo(Texture::Format::R16G16, {{Texture::Type::UNorm, success},
+			{Texture::Type::SNorm, success}, {Texture::Type::UInt, success},
+			{Texture::Type::Int, success}, {Texture::Type::Float, success}}),
+		TextureSaveTestInfo(Texture::Format::R16G16B16, {{Texture::Type::UNorm, success},
+			{Texture::Type::SNorm, success}, {Texture::Type::UInt, success},
+			{Texture::Type::Int, success}, {Texture::Type::Float, success}}),
+		TextureSaveTestInfo(Texture::Format::R16G16B16A16, {{Texture::Type::UNorm, success},
+			{Texture::Type::SNorm, success}, {Texture::Type::UInt, success},
+			{Texture::Type::Int, success}, {Texture::Type::Float, success}}),
+		TextureSaveTestInfo(Texture::Format::R32, {{Texture::Type::UInt, success},
+			{Texture::Type::Int, success}, {Texture::Type::Float, success}}),
+		TextureSaveTestInfo(Texture::Format::R32G32, {{Texture::Type::UInt, success},
+			{Texture::Type::Int, success}, {Texture::Type::Float, success}}),
+		TextureSaveTestInfo(Texture::Format::R32G32B32, {{Texture::Type::UInt, success},
+			{Texture::Type::Int, success}, {Texture::Type::Float, success}}),
+		TextureSaveTestInfo(Texture::Format::R32G32B32A32, {{Texture::Type::UInt, success},
+			{Texture::Type::Int, success}, {Texture::Type::Float, success}})));
+
+#if CUTTLEFISH_HAS_S3TC
+#define S3TC_SAVE_KTX2_TESTS \
+	, TextureSaveTestInfo(Texture::Format::BC1_RGB, {{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::BC1_RGBA, {{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::BC2, {{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::BC3, {{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::BC4, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::SNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::BC5, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::SNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::BC6H, {{Texture::Type::UFloat, success}, \
+		{Texture::Type::Float, success}}), \
+	TextureSaveTestInfo(Texture::Format::BC7, {{Texture::Type::UNorm, success}})
+#else
+#define S3TC_SAVE_KTX2_TESTS
+#endif
+
+#if CUTTLEFISH_HAS_ETC
+#define ETC_SAVE_KTX2_TESTS \
+	, TextureSaveTestInfo(Texture::Format::ETC1, {{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::ETC2_R8G8B8, {{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::ETC2_R8G8B8A1, {{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::ETC2_R8G8B8A8, {{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::EAC_R11, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::SNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::EAC_R11G11, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::SNorm, success}})
+#else
+#define ETC_SAVE_KTX2_TESTS
+#endif
+
+#if CUTTLEFISH_HAS_ASTC
+#define ASTC_SAVE_KTX2_TESTS \
+	, TextureSaveTestInfo(Texture::Format::ASTC_4x4, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_5x4, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_5x5, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_6x5, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_8x5, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_8x6, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_8x8, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_10x5, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_10x6, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_10x8, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_10x10, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_12x10, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}}), \
+	TextureSaveTestInfo(Texture::Format::ASTC_12x12, {{Texture::Type::UNorm, success}, \
+		{Texture::Type::UFloat, success}})
+#else
+#define ASTC_SAVE_KTX2_TESTS
+#endif
+
+#if CUTTLEFISH_HAS_PVRTC
+#define PVRTC_SAVE_KTX2_TESTS \
+	, TextureSaveTestInfo(Texture::Format::PVRTC1_RGB_2BPP, \
+		{{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::PVRTC1_RGBA_2BPP, \
+		{{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::PVRTC1_RGB_4BPP, \
+		{{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::PVRTC1_RGBA_4BPP, \
+		{{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::PVRTC2_RGBA_2BPP, \
+		{{Texture::Type::UNorm, success}}), \
+	TextureSaveTestInfo(Texture::Format::PVRTC2_RGBA_4BPP, \
+		{{Texture::Type::UNorm, success}})
+#else
+#define PVRTC_SAVE_KTX2_TESTS
+#endif
+
+INSTANTIATE_TEST_SUITE_P(TextureSaveTestTypes,
+	TextureSaveSpecialKtx2Test,
+	testing::Values(
+		TextureSaveTestInfo(Texture::Format::B10G11R11_UFloat, {{Texture::Type::UFloat, success}}),
+		TextureSaveTestInfo(Texture::Format::E5B9G9R9_UFloat, {{Texture::Type::UFloat, success}})
+		S3TC_SAVE_KTX2_TESTS
+		ETC_SAVE_KTX2_TESTS
+		ASTC_SAVE_KTX2_TESTS
+		PVRTC_SAVE_KTX2_TESTS
+		));
+
 INSTANTIATE_TEST_SUITE_P(TextureSaveTestTypes,
 	TextureSavePvrTest,
 	testing::Values(
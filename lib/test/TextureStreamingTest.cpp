@@ -0,0 +1,186 @@
+/*
+ * Copyright 2026 Aaron Barany
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TestHelpers.h"
+#include <cuttlefish/Color.h>
+#include <cuttlefish/Image.h>
+#include <cuttlefish/Texture.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace cuttlefish
+{
+
+namespace
+{
+
+class ImageRowSource : public Texture::RowSource
+{
+public:
+	explicit ImageRowSource(const Image& image)
+		: m_image(image), m_y(0)
+	{
+	}
+
+	bool read(Image& outImage, unsigned int rowCount) override
+	{
+		if (m_y + rowCount > m_image.height())
+			return false;
+
+		if (!outImage.initialize(m_image.format(), m_image.width(), rowCount,
+				m_image.colorSpace()))
+		{
+			return false;
+		}
+
+		std::size_t rowSize = m_image.width()*m_image.bitsPerPixel()/8;
+		for (unsigned int y = 0; y < rowCount; ++y, ++m_y)
+			std::memcpy(outImage.scanline(y), m_image.scanline(m_y), rowSize);
+		return true;
+	}
+
+private:
+	const Image& m_image;
+	unsigned int m_y;
+};
+
+Image createImage(unsigned int width, unsigned int height, bool constant)
+{
+	Image image(Image::Format::RGBAF, width, height);
+	for (unsigned int y = 0; y < height; ++y)
+	{
+		for (unsigned int x = 0; x < width; ++x)
+		{
+			ColorRGBAd color = {0.25, 0.5, 0.75, 1.0};
+			if (!constant)
+			{
+				color.r = static_cast<double>(x)/width;
+				color.g = static_cast<double>(y)/height;
+				color.b = static_cast<double>((x*7 + y*3) % 11)/10.0;
+			}
+			image.setPixel(x, y, color);
+		}
+	}
+	return image;
+}
+
+void testMatchesConvert(Texture::Format format, Texture::FileType fileType,
+	unsigned int mipLevels, bool constant)
+{
+	const char* fileName = "TextureStreamingTest.tex";
+	const unsigned int width = 37;
+	const unsigned int height = 29;
+	Image image = createImage(width, height, constant);
+
+	Texture texture(Texture::Dimension::Dim2D, width, height);
+	ASSERT_TRUE(texture.setImage(image));
+	ASSERT_TRUE(texture.generateMipmaps(Image::ResizeFilter::Box, mipLevels));
+	ASSERT_TRUE(texture.convert(format, Texture::Type::UNorm, Texture::Quality::Low));
+	std::vector<std::uint8_t> expectedData;
+	ASSERT_EQ(Texture::SaveResult::Success, texture.save(expectedData, fileType));
+
+	// Use a tiny budget so each mip level is split into many bands.
+	Texture streamingTexture(Texture::Dimension::Dim2D, width, height, 0, mipLevels);
+	ImageRowSource source(image);
+	EXPECT_EQ(Texture::SaveResult::Success, streamingTexture.convertStreaming(source, fileName,
+		fileType, format, Texture::Type::UNorm, Texture::Quality::Low, Texture::Alpha::Standard,
+		Texture::ColorMask(), 1));
+	EXPECT_FALSE(streamingTexture.converted());
+
+	std::vector<std::uint8_t> data = readFile(fileName);
+	std::remove(fileName);
+	EXPECT_EQ(expectedData, data);
+}
+
+} // namespace
+
+TEST(TextureStreamingTest, UncompressedDds)
+{
+	testMatchesConvert(Texture::Format::R8G8B8A8, Texture::FileType::DDS, 1, false);
+}
+
+TEST(TextureStreamingTest, UncompressedKtx)
+{
+	// Scanlines for R8G8B8 are padded to 4 bytes in KTX.
+	testMatchesConvert(Texture::Format::R8G8B8, Texture::FileType::KTX, 1, false);
+}
+
+#if CUTTLEFISH_HAS_S3TC
+TEST(TextureStreamingTest, CompressedPvr)
+{
+	testMatchesConvert(Texture::Format::BC1_RGB, Texture::FileType::PVR, 1, false);
+}
+#endif
+
+TEST(TextureStreamingTest, Mipmaps)
+{
+	// Mipmaps are generated with a 2x2 box filter, so a constant image matches exactly.
+	testMatchesConvert(Texture::Format::R8G8B8A8, Texture::FileType::DDS,
+		Texture::allMipLevels, true);
+	testMatchesConvert(Texture::Format::R8G8B8, Texture::FileType::KTX,
+		Texture::allMipLevels, true);
+}
+
+TEST(TextureStreamingTest, Invalid)
+{
+	Image image = createImage(16, 16, true);
+	Texture arrayTexture(Texture::Dimension::Dim2D, 16, 16, 2);
+	ImageRowSource arraySource(image);
+	EXPECT_EQ(Texture::SaveResult::Invalid, arrayTexture.convertStreaming(arraySource,
+		"TextureStreamingTest.dds", Texture::FileType::DDS, Texture::Format::R8G8B8A8,
+		Texture::Type::UNorm));
+
+	Texture cubeTexture(Texture::Dimension::Cube, 16, 16);
+	ImageRowSource cubeSource(image);
+	EXPECT_EQ(Texture::SaveResult::Invalid, cubeTexture.convertStreaming(cubeSource,
+		"TextureStreamingTest.dds", Texture::FileType::DDS, Texture::Format::R8G8B8A8,
+		Texture::Type::UNorm));
+
+	// The source doesn't have enough rows. The existing file should be kept.
+	const char* fileName = "TextureStreamingTest.dds";
+	std::vector<std::uint8_t> existingData = {1, 2, 3, 4};
+	writeFile(fileName, existingData);
+
+	Texture texture(Texture::Dimension::Dim2D, 16, 32);
+	ImageRowSource source(image);
+	EXPECT_EQ(Texture::SaveResult::Invalid, texture.convertStreaming(source, fileName,
+		Texture::FileType::DDS, Texture::Format::R8G8B8A8, Texture::Type::UNorm));
+	EXPECT_EQ(existingData, readFile(fileName));
+	std::remove(fileName);
+}
+
+TEST(TextureStreamingTest, UnsupportedKeepsState)
+{
+	Image image = createImage(16, 16, true);
+	Texture texture(Texture::Dimension::Dim2D, 16, 16);
+	ImageRowSource source(image);
+	EXPECT_EQ(Texture::SaveResult::Unsupported, texture.convertStreaming(source,
+		"TextureStreamingTest.ktx2", Texture::FileType::KTX2, Texture::Format::R8G8B8A8,
+		Texture::Type::UNorm));
+	EXPECT_EQ(Texture::Format::Unknown, texture.format());
+
+	// PVRTC can't be streamed regardless of whether it's supported by the build.
+	EXPECT_NE(Texture::SaveResult::Success, texture.convertStreaming(source,
+		"TextureStreamingTest.pvr", Texture::FileType::PVR, Texture::Format::PVRTC1_RGBA_4BPP,
+		Texture::Type::UNorm));
+	EXPECT_EQ(Texture::Format::Unknown, texture.format());
+	EXPECT_FALSE(std::ifstream("TextureStreamingTest.pvr").is_open());
+}
+
+} // namespace cuttlefish
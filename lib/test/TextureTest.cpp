@@ -18,6 +18,7 @@
 #include <cuttlefish/Image.h>
 #include <cuttlefish/Texture.h>
 #include <gtest/gtest.h>
+#include <cstring>
 #include <limits>
 #include <tuple>
 #include <vector>
@@ -437,6 +438,17 @@ TEST(TextureTest, Create)
 	EXPECT_EQ(4U, texture.mipLevelCount());
 }
 
+TEST(TextureTest, QualityRank)
+{
+	const Texture::Quality qualities[] = {Texture::Quality::Preview, Texture::Quality::Lowest,
+		Texture::Quality::Low, Texture::Quality::Normal, Texture::Quality::High,
+		Texture::Quality::Highest};
+	for (unsigned int i = 1; i < sizeof(qualities)/sizeof(*qualities); ++i)
+	{
+		EXPECT_LT(Texture::qualityRank(qualities[i - 1]), Texture::qualityRank(qualities[i]));
+	}
+}
+
 TEST(TextureTest, SetImages)
 {
 	Texture texture(Texture::Dimension::Dim2D, 15, 10, 5);
@@ -507,6 +519,51 @@ TEST(TextureTest, SetImagesCubeConvert)
 	EXPECT_TRUE(texture.imagesComplete());
 }
 
+TEST(TextureTest, CopySharesData)
+{
+	Texture texture(Texture::Dimension::Dim2D, 16, 16);
+	Image image(Image::Format::RGBAF, 16, 16);
+	const Image& constImage = image;
+	EXPECT_TRUE(texture.setImage(image));
+	EXPECT_EQ(constImage.scanline(0), texture.getImage().scanline(0));
+
+	Texture copy(texture);
+	EXPECT_EQ(texture.getImage().scanline(0), copy.getImage().scanline(0));
+
+	// Modifying the original image doesn't affect the copies.
+	EXPECT_TRUE(image.setPixel(0, 0, ColorRGBAd{1.0, 0.0, 0.0, 1.0}));
+	EXPECT_NE(constImage.scanline(0), texture.getImage().scanline(0));
+	ColorRGBAd color;
+	EXPECT_TRUE(texture.getImage().getPixel(color, 0, 0));
+	EXPECT_EQ(0.0, color.r);
+
+	ASSERT_TRUE(texture.convert(Texture::Format::R8G8B8A8, Texture::Type::UNorm));
+	copy = texture;
+	EXPECT_EQ(texture.data(), copy.data());
+}
+
+TEST(TextureTest, SetExternalImage)
+{
+	std::vector<ColorRGBAf> pixels(16*16, ColorRGBAf{0.5f, 0.25f, 0.75f, 1.0f});
+	const std::vector<ColorRGBAf> origPixels = pixels;
+
+	// Used in place when no conversion is needed.
+	Texture texture(Texture::Dimension::Dim2D, 16, 16);
+	Image image(Image::Format::RGBAF, 16, 16, pixels.data(), 16*sizeof(ColorRGBAf));
+	EXPECT_TRUE(image.isExternal());
+	EXPECT_TRUE(texture.setImage(std::move(image)));
+	EXPECT_EQ(static_cast<const void*>(pixels.data()), texture.getImage().scanline(0));
+
+	// Copied rather than converting the caller's memory.
+	Texture srgbTexture(Texture::Dimension::Dim2D, 16, 16, 0, 1, ColorSpace::sRGB);
+	image = Image(Image::Format::RGBAF, 16, 16, pixels.data(), 16*sizeof(ColorRGBAf));
+	EXPECT_TRUE(srgbTexture.setImage(std::move(image)));
+	EXPECT_NE(static_cast<const void*>(pixels.data()), srgbTexture.getImage().scanline(0));
+	EXPECT_FALSE(srgbTexture.getImage().isExternal());
+	EXPECT_EQ(0, std::memcmp(origPixels.data(), pixels.data(),
+		pixels.size()*sizeof(ColorRGBAf)));
+}
+
 TEST(TextureTest, CustomMipImageStorage)
 {
 	Image testImage(Image::Format::RGBAF, 10, 15);
@@ -804,6 +861,81 @@ TEST(TextureTest, Generate3DMipmapsCustomMips)
 	}
 }
 
+TEST(TextureTest, FusedMipmaps)
+{
+	unsigned int width = 21;
+	unsigned int height = 13;
+	unsigned int depth = 2;
+	Image greenImage(Image::Format::RGBAF, width, height);
+	Texture textures[2] =
+	{
+		Texture(Texture::Dimension::Cube, width, height, depth),
+		Texture(Texture::Dimension::Cube, width, height, depth)
+	};
+	textures[1].setFusedMipmapsEnabled(true);
+	EXPECT_TRUE(textures[1].fusedMipmapsEnabled());
+
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		for (unsigned int j = 0; j < depth; ++j)
+		{
+			Image image(Image::Format::RGBAF, width, height);
+			for (unsigned int y = 0; y < height; ++y)
+			{
+				for (unsigned int x = 0; x < width; ++x)
+				{
+					EXPECT_TRUE(image.setPixel(x, y, ColorRGBAd(static_cast<double>(x)/width,
+						static_cast<double>(y)/height, static_cast<double>(i)/6,
+						static_cast<double>(j + 1)/depth)));
+					EXPECT_TRUE(greenImage.setPixel(x, y, ColorRGBAd(0.0, 1.0, 0.0, 1.0)));
+				}
+			}
+
+			for (Texture& texture : textures)
+			{
+				EXPECT_TRUE(texture.setImage(image, static_cast<Texture::CubeFace>(i), 0, j));
+			}
+		}
+	}
+
+	Texture::CustomMipImages mipImages =
+	{
+		{Texture::ImageIndex(Texture::CubeFace::NegY, 1, 1),
+			Texture::CustomMipImage(greenImage, Texture::MipReplacement::Once)},
+		{Texture::ImageIndex(Texture::CubeFace::PosZ, 2, 0),
+			Texture::CustomMipImage(greenImage, Texture::MipReplacement::Continue)}
+	};
+
+	for (Texture& texture : textures)
+	{
+		EXPECT_TRUE(texture.generateMipmaps(Image::ResizeFilter::Box, Texture::allMipLevels,
+			mipImages));
+		EXPECT_TRUE(texture.imagesComplete());
+		EXPECT_EQ(5U, texture.mipLevelCount());
+	}
+
+	// Mipmaps are only generated during conversion.
+	EXPECT_TRUE(textures[0].getImage(1).isValid());
+	EXPECT_FALSE(textures[1].getImage(1).isValid());
+
+	for (Texture& texture : textures)
+		EXPECT_TRUE(texture.convert(Texture::Format::R8G8B8A8, Texture::Type::UNorm));
+
+	for (unsigned int mip = 0; mip < textures[0].mipLevelCount(); ++mip)
+	{
+		for (unsigned int d = 0; d < depth; ++d)
+		{
+			for (unsigned int f = 0; f < 6; ++f)
+			{
+				auto face = static_cast<Texture::CubeFace>(f);
+				ASSERT_EQ(textures[0].dataSize(face, mip, d), textures[1].dataSize(face, mip, d));
+				EXPECT_EQ(0, std::memcmp(textures[0].data(face, mip, d),
+					textures[1].data(face, mip, d), textures[0].dataSize(face, mip, d)));
+			}
+		}
+	}
+}
+
 TEST(TextureTest, ConvertSRGB)
 {
 	{
@@ -864,9 +996,44 @@ TEST_P(TextureConvertSpecialTest, Convert)
 		unsigned int blockY = (texture.height() + Texture::blockHeight(info.format) - 1)/
 			Texture::blockHeight(info.format);
 		EXPECT_EQ(blockX*blockY*Texture::blockSize(info.format), texture.dataSize());
+
+		if (!Texture::isDecodeSupported(info.format, type))
+			continue;
+
+		Image decodedImage;
+		ASSERT_TRUE(texture.decode(decodedImage));
+		EXPECT_EQ(Image::Format::RGBAF, decodedImage.format());
+		EXPECT_EQ(texture.width(), decodedImage.width());
+		EXPECT_EQ(texture.height(), decodedImage.height());
+		for (unsigned int y = 0; y < decodedImage.height(); ++y)
+		{
+			for (unsigned int x = 0; x < decodedImage.width(); ++x)
+			{
+				ColorRGBAd color;
+				ASSERT_TRUE(decodedImage.getPixel(color, x, y));
+				EXPECT_NEAR(0.0, color.r, 1e-2);
+				EXPECT_NEAR(0.0, color.g, 1e-2);
+				EXPECT_NEAR(0.0, color.b, 1e-2);
+				EXPECT_NEAR(1.0, color.a, 1e-2);
+			}
+		}
 	}
 }
 
+TEST(TextureTest, DecodeInvalid)
+{
+	Texture texture(Texture::Dimension::Dim2D, 16, 16);
+	EXPECT_TRUE(texture.setImage(Image(Image::Format::RGBAF, 16, 16)));
+
+	Image decodedImage;
+	EXPECT_FALSE(texture.decode(decodedImage));
+
+	EXPECT_TRUE(texture.convert(Texture::Format::R8G8B8A8, Texture::Type::UNorm));
+	EXPECT_FALSE(Texture::isDecodeSupported(Texture::Format::R8G8B8A8, Texture::Type::UNorm));
+	EXPECT_FALSE(texture.decode(decodedImage));
+	EXPECT_FALSE(texture.decode(decodedImage, 1));
+}
+
 INSTANTIATE_TEST_SUITE_P(TextureConvertTestTypes,
 	TextureConvertTest,
 	testing::Values(
@@ -160,6 +160,11 @@ void printHelp(const char* name)
 	          << "                                     +x, -x, +y, -y, +z, -z" << std::endl
 	          << "                                   file: path to a file containing a list of " << std::endl
 	          << "                                     image paths, one per line" << std::endl;
+	std::cout << "      --transcode file           an existing DDS, KTX, or PVR texture to rewrite" << std::endl
+	          << "                                   to the output file format without" << std::endl
+	          << "                                   re-encoding; only the output options -o," << std::endl
+	          << "                                   --file-format, --zstd, and --create-dir" << std::endl
+	          << "                                   are used" << std::endl;
 
 	std::cout << std::endl << "Manipulation options:" << std::endl;
 	std::cout << "  -r, --resize w h [filter]     resizes the image:" << std::endl
@@ -242,7 +247,10 @@ void printHelp(const char* name)
 
 	std::cout << std::endl << "Output options: options marked with (*) are required" << std::endl;
 	std::cout << "  -d, --dimension d     the texture dimesion; d may be: 1, 2 (default), 3" << std::endl;
-	std::cout << "  -f, --format f (*)    the format to store the texture; f may be:" << std::endl;
+	std::cout << "  -f, --format f (*)    the format to store the texture; may be provided" << std::endl
+	          << "                        multiple times with --target-psnr or --target-ssim to" << std::endl
+	          << "                        select the smallest format that meets the target; f" << std::endl
+	          << "                        may be:" << std::endl;
 	for (const auto& format : formatMap)
 		std::cout << "                          " << format.second << std::endl;
 	std::cout << "  -t, --type t          the type stored in each channel; t may be:" << std::endl
@@ -261,12 +269,44 @@ void printHelp(const char* name)
 	          << "                          encoded: alpha is an encoded value rather than " << std::endl
 	          << "                            opacity; this will avoid weighting the colors during" << std::endl
 	          << "                            compression for some formats" << std::endl;
-	std::cout << "  -Q, --quality q       the quality of compression; may be: lowest, low," << std::endl
-	          << "                        normal (default), high, highest; lower qualities are" << std::endl
-	          << "                        faster to convert" << std::endl;
+	std::cout << "  -Q, --quality q       the quality of compression; may be: preview, lowest," << std::endl
+	          << "                        low, normal (default), high, highest; lower qualities" << std::endl
+	          << "                        are faster to convert" << std::endl;
+	std::cout << "      --encoder e       the library to encode BC formats with; may be: default," << std::endl
+	          << "                        rgbcx, squish, compressonator, ispc, bc7enc; which" << std::endl
+	          << "                        are supported depends on the format" << std::endl;
+	std::cout << "      --adaptive q      first compress each block with quality q, and only" << std::endl
+	          << "                        re-compress blocks with a high error with the full" << std::endl
+	          << "                        quality; q may be the same values as --quality" << std::endl;
+	std::cout << "      --adaptive-threshold t" << std::endl
+	          << "                        the RMS error, in the range [0, 1], above which blocks" << std::endl
+	          << "                        are re-compressed with --adaptive; default depends on" << std::endl
+	          << "                        the format" << std::endl;
+	std::cout << "      --metrics         decode the compressed texture and print the PSNR and" << std::endl
+	          << "                        RMS error compared to the original image" << std::endl;
+	std::cout << "      --ssim            also compute the structural similarity index with" << std::endl
+	          << "                        --metrics; implies --metrics" << std::endl;
+	std::cout << "      --min-psnr db     fail if the PSNR of any image is below db decibels;" << std::endl
+	          << "                        implies --metrics" << std::endl;
+	std::cout << "      --target-psnr db  use the smallest format passed to --format where a fast" << std::endl
+	          << "                        preview of each image has a PSNR of at least db" << std::endl
+	          << "                        decibels, falling back to the largest format" << std::endl;
+	std::cout << "      --target-ssim s   like --target-psnr, but requiring a structural" << std::endl
+	          << "                        similarity index of at least s; may be combined with" << std::endl
+	          << "                        --target-psnr" << std::endl;
+	std::cout << "      --downgrade       use a smaller format when the images allow it without" << std::endl
+	          << "                        loss, such as BC1 instead of BC3 for opaque images or" << std::endl
+	          << "                        R8 instead of R8G8B8A8 for opaque grayscale images" << std::endl;
+	std::cout << "      --block-cache     only compress each unique block once; faster for images" << std::endl
+	          << "                        with many repeated blocks, such as atlases or tiles" << std::endl;
+	std::cout << "      --incremental f   only re-compress blocks that changed since the" << std::endl
+	          << "                        previous output file, using the block hashes stored" << std::endl
+	          << "                        in file f; the hashes are updated after saving" << std::endl;
 	std::cout << "  -o, --output file (*) the output file for the texture" << std::endl;
-	std::cout << "      --file-format f   the output file format; may be: dds, ktx, pvr; default" << std::endl
-	          << "                        is based on the extension" << std::endl;
+	std::cout << "      --file-format f   the output file format; may be: dds, ktx, pvr, ktx2;" << std::endl
+	          << "                        default is based on the extension" << std::endl;
+	std::cout << "      --zstd level      supercompress KTX2 files with Zstandard at the given" << std::endl
+	          << "                        compression level" << std::endl;
 	std::cout << "      --create-dir      create the parent directory for the output file if it" << std::endl
 			  << "                        doesn't exist" << std::endl;
 }
@@ -337,6 +377,25 @@ bool strToMipReplace(Texture::MipReplacement& replace, const char* str)
 	return true;
 }
 
+bool strToQuality(Texture::Quality& quality, const char* str)
+{
+	if (strcasecmp(str, "preview") == 0)
+		quality = Texture::Quality::Preview;
+	else if (strcasecmp(str, "lowest") == 0)
+		quality = Texture::Quality::Lowest;
+	else if (strcasecmp(str, "low") == 0)
+		quality = Texture::Quality::Low;
+	else if (strcasecmp(str, "normal") == 0)
+		quality = Texture::Quality::Normal;
+	else if (strcasecmp(str, "high") == 0)
+		quality = Texture::Quality::High;
+	else if (strcasecmp(str, "highest") == 0)
+		quality = Texture::Quality::Highest;
+	else
+		return false;
+	return true;
+}
+
 bool readMipReplace(Texture::MipReplacement& replace, int& i, int argc, const char** argv)
 {
 	if (i >= argc - 1)
@@ -348,6 +407,33 @@ bool readMipReplace(Texture::MipReplacement& replace, int& i, int argc, const ch
 	return success;
 }
 
+bool strToEncoder(Texture::Encoder& encoder, const char* str)
+{
+	if (strcasecmp(str, "default") == 0)
+		encoder = Texture::Encoder::Default;
+	else if (strcasecmp(str, "rgbcx") == 0)
+		encoder = Texture::Encoder::Rgbcx;
+	else if (strcasecmp(str, "squish") == 0)
+		encoder = Texture::Encoder::Squish;
+	else if (strcasecmp(str, "compressonator") == 0)
+		encoder = Texture::Encoder::Compressonator;
+	else if (strcasecmp(str, "ispc") == 0)
+		encoder = Texture::Encoder::IspcTexcomp;
+	else if (strcasecmp(str, "bc7enc") == 0)
+		encoder = Texture::Encoder::Bc7enc;
+	else
+		return false;
+	return true;
+}
+
+const char* encoderName(Texture::Encoder encoder)
+{
+	static const char* encoderNames[] = {"default", "rgbcx", "squish", "compressonator", "ispc",
+		"bc7enc"};
+	assert(static_cast<unsigned int>(encoder) < sizeof(encoderNames)/sizeof(*encoderNames));
+	return encoderNames[static_cast<unsigned int>(encoder)];
+}
+
 const char* faceName(Texture::CubeFace face)
 {
 	static const char* faceNames[] = {"+x", "-x", "+y", "-y", "+z", "-z"};
@@ -374,7 +460,7 @@ const char* typeName(Texture::Type type)
 
 const char* fileTypeName(Texture::FileType type)
 {
-	static const char* typeNames[] = {"unknown", "DDS", "KTX", "PVR"};
+	static const char* typeNames[] = {"unknown", "DDS", "KTX", "PVR", "KTX2"};
 	assert(static_cast<unsigned int>(type) < sizeof(typeNames)/sizeof(*typeNames));
 	return typeNames[static_cast<unsigned int>(type)];
 }
@@ -621,8 +707,52 @@ bool readCustomMipList(CommandLine::CustomMipImages& customMipImages, const char
 	return true;
 }
 
+bool validateOutput(CommandLine& args)
+{
+	if (!args.output)
+	{
+		std::cerr << "error: output file must be provided" << std::endl;
+		return false;
+	}
+
+	if (args.fileType == Texture::FileType::Auto)
+	{
+		args.fileType = Texture::fileType(args.output);
+		if (args.fileType == Texture::FileType::Auto)
+		{
+			std::cerr << "error: cannot deduce file type for '" << args.output << "'" << std::endl;
+			return false;
+		}
+	}
+
+	if (args.zstdLevel > 0 && args.fileType != Texture::FileType::KTX2)
+	{
+		std::cerr << "error: --zstd requires the KTX2 file format" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
 bool validate(CommandLine& args)
 {
+	if (args.transcode)
+	{
+		if (!args.images.empty())
+		{
+			std::cerr << "error: --transcode cannot be combined with input images" << std::endl;
+			return false;
+		}
+
+		if (args.incremental)
+		{
+			std::cerr << "error: --transcode cannot be combined with --incremental" << std::endl;
+			return false;
+		}
+
+		return validateOutput(args);
+	}
+
 	if (args.images.empty())
 	{
 		std::cerr << "error: an input image must be provided" << std::endl;
@@ -688,34 +818,62 @@ bool validate(CommandLine& args)
 		return false;
 	}
 
-	if (!args.output)
+	if (!validateOutput(args))
+		return false;
+
+	bool targetQuality = args.targetPsnr > 0 || args.targetSsim > -1;
+	if (args.formats.size() > 1 && !targetQuality)
 	{
-		std::cerr << "error: output file must be provided" << std::endl;
+		std::cerr << "error: multiple formats require --target-psnr or --target-ssim" << std::endl;
 		return false;
 	}
 
-	if (args.fileType == Texture::FileType::Auto)
+	if (args.formats.size() > 1 && args.incremental)
 	{
-		args.fileType = Texture::fileType(args.output);
-		if (args.fileType == Texture::FileType::Auto)
+		std::cerr << "error: incremental conversion cannot be used with multiple formats" <<
+			std::endl;
+		return false;
+	}
+
+	for (Texture::Format format : args.formats)
+	{
+		if (!Texture::isFormatValid(format, args.type, args.fileType))
 		{
-			std::cerr << "error: cannot deduce file type for '" << args.output << "'" << std::endl;
+			std::cerr << "error: file format " << fileTypeName(args.fileType) <<
+				" doesn't support format " << formatName(format) << " with type " <<
+				typeName(args.type) << std::endl;
 			return false;
 		}
-	}
 
-	if (!Texture::isFormatValid(args.format, args.type, args.fileType))
-	{
-		std::cerr << "error: file format " << fileTypeName(args.fileType) <<
-			" doesn't support format " << formatName(args.format) << " with type " <<
-			typeName(args.type) << std::endl;
-		return false;
+		if (!Texture::isEncoderSupported(format, args.type, args.encoder))
+		{
+			std::cerr << "error: encoder " << encoderName(args.encoder) <<
+				" doesn't support format " << formatName(format) << " with type " <<
+				typeName(args.type) << std::endl;
+			return false;
+		}
+
+		if ((args.qualityMetrics || targetQuality) &&
+			!Texture::isDecodeSupported(format, args.type))
+		{
+			std::cerr << "error: quality metrics aren't supported for format " <<
+				formatName(format) << " with type " << typeName(args.type) << std::endl;
+			return false;
+		}
+
+		if (args.textureColorSpace == ColorSpace::sRGB &&
+			!Texture::hasNativeSRGB(format, args.type))
+		{
+			args.textureColorSpace = ColorSpace::Linear;
+		}
 	}
 
-	if (args.textureColorSpace == ColorSpace::sRGB &&
-		!Texture::hasNativeSRGB(args.format, args.type))
+	if (args.incremental && (Texture::blockWidth(args.format) == 1 ||
+		args.format >= Texture::Format::PVRTC1_RGB_2BPP))
 	{
-		args.textureColorSpace = ColorSpace::Linear;
+		std::cerr << "error: incremental conversion requires a block compressed format other " <<
+			"than PVRTC" << std::endl;
+		return false;
 	}
 
 	if (args.imageColorSpace == ColorSpace::sRGB && args.log != CommandLine::Log::Quiet)
@@ -856,6 +1014,24 @@ bool CommandLine::parse(int argc, const char** argv)
 
 			images.push_back(argv[++i]);
 		}
+		else if (std::strcmp(argv[i], "--transcode") == 0)
+		{
+			if (i >= argc - 1)
+			{
+				std::cerr << "error: command " << argv[i] << " requires 1 argument" << std::endl;
+				success = false;
+				break;
+			}
+
+			if (transcode)
+			{
+				std::cerr << "error: transcode input already provided" << std::endl;
+				success = false;
+				break;
+			}
+
+			transcode = argv[++i];
+		}
 		else if (matches(argv[i], "-a", "--array"))
 		{
 			if (images.empty())
@@ -1281,6 +1457,7 @@ bool CommandLine::parse(int argc, const char** argv)
 			}
 
 			++i;
+			format = Texture::Format::Unknown;
 			for (const auto& formatInfo : formatMap)
 			{
 				if (strcasecmp(formatInfo.second, argv[i]) == 0)
@@ -1297,6 +1474,8 @@ bool CommandLine::parse(int argc, const char** argv)
 				break;
 			}
 
+			formats.push_back(format);
+
 			// Unique default types
 			if (!typeSet)
 			{
@@ -1373,23 +1552,150 @@ bool CommandLine::parse(int argc, const char** argv)
 			}
 
 			++i;
-			if (strcasecmp(argv[i], "lowest") == 0)
-				quality = Texture::Quality::Lowest;
-			else if (strcasecmp(argv[i], "low") == 0)
-				quality = Texture::Quality::Low;
-			else if (strcasecmp(argv[i], "normal") == 0)
-				quality = Texture::Quality::Normal;
-			else if (strcasecmp(argv[i], "high") == 0)
-				quality = Texture::Quality::High;
-			else if (strcasecmp(argv[i], "highest") == 0)
-				quality = Texture::Quality::Highest;
-			else
+			if (!strToQuality(quality, argv[i]))
+			{
+				std::cerr << "error: unknown quality " << argv[i] << std::endl;
+				success = false;
+				break;
+			}
+		}
+		else if (std::strcmp(argv[i], "--encoder") == 0)
+		{
+			if (i >= argc - 1)
+			{
+				std::cerr << "error: command " << argv[i] << " requires 1 argument" << std::endl;
+				success = false;
+				break;
+			}
+
+			++i;
+			if (!strToEncoder(encoder, argv[i]))
+			{
+				std::cerr << "error: unknown encoder " << argv[i] << std::endl;
+				success = false;
+				break;
+			}
+		}
+		else if (std::strcmp(argv[i], "--adaptive") == 0)
+		{
+			if (i >= argc - 1)
+			{
+				std::cerr << "error: command " << argv[i] << " requires 1 argument" << std::endl;
+				success = false;
+				break;
+			}
+
+			++i;
+			adaptive = true;
+			if (!strToQuality(adaptiveQuality, argv[i]))
 			{
 				std::cerr << "error: unknown quality " << argv[i] << std::endl;
 				success = false;
 				break;
 			}
 		}
+		else if (std::strcmp(argv[i], "--adaptive-threshold") == 0)
+		{
+			if (i >= argc - 1)
+			{
+				std::cerr << "error: command " << argv[i] << " requires 1 argument" << std::endl;
+				success = false;
+				break;
+			}
+
+			++i;
+			char* endPtr;
+			double threshold = std::strtod(argv[i], &endPtr);
+			if (endPtr != argv[i] + std::strlen(argv[i]) || threshold < 0)
+			{
+				std::cerr << "error: invalid adaptive threshold " << argv[i] << std::endl;
+				success = false;
+				break;
+			}
+
+			adaptiveThreshold = static_cast<float>(threshold);
+		}
+		else if (std::strcmp(argv[i], "--metrics") == 0)
+			qualityMetrics = true;
+		else if (std::strcmp(argv[i], "--ssim") == 0)
+		{
+			qualityMetrics = true;
+			ssim = true;
+		}
+		else if (std::strcmp(argv[i], "--min-psnr") == 0)
+		{
+			if (i >= argc - 1)
+			{
+				std::cerr << "error: command " << argv[i] << " requires 1 argument" << std::endl;
+				success = false;
+				break;
+			}
+
+			++i;
+			char* endPtr;
+			minPsnr = std::strtod(argv[i], &endPtr);
+			if (endPtr != argv[i] + std::strlen(argv[i]) || minPsnr <= 0)
+			{
+				std::cerr << "error: invalid minimum PSNR " << argv[i] << std::endl;
+				success = false;
+				break;
+			}
+
+			qualityMetrics = true;
+		}
+		else if (std::strcmp(argv[i], "--target-psnr") == 0)
+		{
+			if (i >= argc - 1)
+			{
+				std::cerr << "error: command " << argv[i] << " requires 1 argument" << std::endl;
+				success = false;
+				break;
+			}
+
+			++i;
+			char* endPtr;
+			targetPsnr = std::strtod(argv[i], &endPtr);
+			if (endPtr != argv[i] + std::strlen(argv[i]) || targetPsnr <= 0)
+			{
+				std::cerr << "error: invalid target PSNR " << argv[i] << std::endl;
+				success = false;
+				break;
+			}
+		}
+		else if (std::strcmp(argv[i], "--target-ssim") == 0)
+		{
+			if (i >= argc - 1)
+			{
+				std::cerr << "error: command " << argv[i] << " requires 1 argument" << std::endl;
+				success = false;
+				break;
+			}
+
+			++i;
+			char* endPtr;
+			targetSsim = std::strtod(argv[i], &endPtr);
+			if (endPtr != argv[i] + std::strlen(argv[i]) || targetSsim <= -1 || targetSsim > 1)
+			{
+				std::cerr << "error: invalid target SSIM " << argv[i] << std::endl;
+				success = false;
+				break;
+			}
+		}
+		else if (std::strcmp(argv[i], "--downgrade") == 0)
+			downgrade = true;
+		else if (std::strcmp(argv[i], "--block-cache") == 0)
+			blockCache = true;
+		else if (std::strcmp(argv[i], "--incremental") == 0)
+		{
+			if (i >= argc - 1)
+			{
+				std::cerr << "error: command " << argv[i] << " requires 1 argument" << std::endl;
+				success = false;
+				break;
+			}
+
+			incremental = argv[++i];
+		}
 		else if (matches(argv[i], "-o", "--output"))
 		{
 			if (i >= argc - 1)
@@ -1424,6 +1730,8 @@ bool CommandLine::parse(int argc, const char** argv)
 				fileType = Texture::FileType::KTX;
 			else if (strcasecmp(argv[i], "pvr") == 0)
 				fileType = Texture::FileType::PVR;
+			else if (strcasecmp(argv[i], "ktx2") == 0)
+				fileType = Texture::FileType::KTX2;
 			else
 			{
 				std::cerr << "error: unknown file format " << argv[i] << std::endl;
@@ -1431,6 +1739,26 @@ bool CommandLine::parse(int argc, const char** argv)
 				break;
 			}
 		}
+		else if (std::strcmp(argv[i], "--zstd") == 0)
+		{
+			if (i >= argc - 1)
+			{
+				std::cerr << "error: command " << argv[i] << " requires 1 argument" << std::endl;
+				success = false;
+				break;
+			}
+
+			++i;
+			char* endPtr;
+			unsigned long level = std::strtoul(argv[i], &endPtr, 10);
+			if (endPtr != argv[i] + std::strlen(argv[i]) || level == 0 || level > 22)
+			{
+				std::cerr << "error: invalid Zstandard level " << argv[i] << std::endl;
+				success = false;
+				break;
+			}
+			zstdLevel = static_cast<unsigned int>(level);
+		}
 		else if (std::strcmp(argv[i], "--create-dir") == 0)
 			createOutputDir = true;
 		else
@@ -77,6 +77,7 @@ struct CommandLine
 	Log log = Log::Normal;
 	ImageType imageType = ImageType::Image;
 	std::vector<std::string> images;
+	const char* transcode = nullptr;
 	int width = OriginalSize;
 	int height = OriginalSize;
 	cuttlefish::Image::ResizeFilter resizeFilter = cuttlefish::Image::ResizeFilter::CatmullRom;
@@ -102,10 +103,24 @@ struct CommandLine
 	bool preMultiply = false;
 	cuttlefish::Texture::Dimension dimension = cuttlefish::Texture::Dimension::Dim2D;
 	cuttlefish::Texture::Format format = cuttlefish::Texture::Format::Unknown;
+	std::vector<cuttlefish::Texture::Format> formats;
 	cuttlefish::Texture::Type type = cuttlefish::Texture::Type::UNorm;
 	cuttlefish::Texture::Alpha alpha = cuttlefish::Texture::Alpha::Standard;
 	cuttlefish::Texture::Quality quality = cuttlefish::Texture::Quality::Normal;
+	cuttlefish::Texture::Encoder encoder = cuttlefish::Texture::Encoder::Default;
+	bool adaptive = false;
+	cuttlefish::Texture::Quality adaptiveQuality = cuttlefish::Texture::Quality::Low;
+	float adaptiveThreshold = -1.0f;
+	bool qualityMetrics = false;
+	bool ssim = false;
+	double minPsnr = 0.0;
+	double targetPsnr = 0.0;
+	double targetSsim = -1.0;
+	bool downgrade = false;
+	bool blockCache = false;
+	const char* incremental = nullptr;
 	const char* output = nullptr;
 	cuttlefish::Texture::FileType fileType = cuttlefish::Texture::FileType::Auto;
+	unsigned int zstdLevel = 0;
 	bool createOutputDir = false;
 };
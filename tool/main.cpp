@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <functional>
 #include <vector>
 #include <iostream>
 
@@ -144,6 +145,66 @@ unsigned int getDimension(unsigned int curDim, unsigned int width, unsigned int
 	}
 }
 
+bool saveBlockHashes(const Texture& texture, const CommandLine& args)
+{
+	if (!args.incremental)
+		return true;
+
+	if (args.log == CommandLine::Log::Verbose)
+		std::cout << "saving block hashes '" << args.incremental << "'" << std::endl;
+	if (!texture.saveBlockHashes(args.incremental))
+	{
+		std::cerr << "error: couldn't write file '" << args.incremental << "'" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool checkQualityMetrics(const Texture& texture, const CommandLine& args)
+{
+	if (!args.qualityMetrics)
+		return true;
+
+	bool success = true;
+	unsigned int faces = texture.dimension() == Texture::Dimension::Cube ? 6 : 1;
+	for (unsigned int mip = 0; mip < texture.mipLevelCount(); ++mip)
+	{
+		for (unsigned int d = 0; d < texture.depth(mip); ++d)
+		{
+			for (unsigned int f = 0; f < faces; ++f)
+			{
+				Texture::QualityMetrics metrics;
+				if (!texture.qualityMetrics(metrics, static_cast<Texture::CubeFace>(f), mip, d))
+				{
+					std::cerr << "error: couldn't compute quality metrics" << std::endl;
+					return false;
+				}
+
+				if (args.log != CommandLine::Log::Quiet)
+				{
+					std::cout << "mip " << mip << ", depth " << d;
+					if (faces > 1)
+						std::cout << ", face " << f;
+					std::cout << ": PSNR " << metrics.combinedPsnr << " dB (r " <<
+						metrics.psnr.r << ", g " << metrics.psnr.g << ", b " << metrics.psnr.b <<
+						", a " << metrics.psnr.a << "), RMSE " << metrics.combinedRmse;
+					if (args.ssim)
+						std::cout << ", SSIM " << metrics.ssim;
+					std::cout << std::endl;
+				}
+
+				if (metrics.combinedPsnr < args.minPsnr)
+					success = false;
+			}
+		}
+	}
+
+	if (!success)
+		std::cerr << "error: PSNR is below " << args.minPsnr << " dB" << std::endl;
+	return success;
+}
+
 bool loadAndProcessImage(Image& image, CommandLine& args, const std::string& path,
 	unsigned int& width, unsigned int& height, unsigned int mipLevel = 0)
 {
@@ -321,6 +382,47 @@ bool loadImages(
 	return true;
 }
 
+// save is called again if the output directory needs to be created.
+bool handleSaveResult(Texture::SaveResult saveResult,
+	const std::function<Texture::SaveResult()>& save, const CommandLine& args)
+{
+	switch (saveResult)
+	{
+		case Texture::SaveResult::Success:
+			return true;
+		case Texture::SaveResult::Invalid:
+			std::cerr << "error: texture parameters were invalid" << std::endl;
+			return false;
+		case Texture::SaveResult::UnknownFormat:
+			std::cerr << "error: unknown texture file format" << std::endl;
+			return false;
+		case Texture::SaveResult::Unsupported:
+			std::cerr << "error: texture format unsupported by target file format" << std::endl;
+			return false;
+		case Texture::SaveResult::WriteError:
+		{
+			if (args.createOutputDir)
+			{
+				// Try to create the directory and save again. We do this off of the initial save
+				// so another error like an invalid format won't leave directories behind.
+				if (!createParentDir(args.output))
+				{
+					std::cerr << "error: couldn't create parent directory for '" <<
+						args.output << "'" << std::endl;
+					return false;
+				}
+
+				if (save() == Texture::SaveResult::Success)
+					return true;
+			}
+			std::cerr << "error: couldn't write file '" << args.output << "'" << std::endl;
+			return false;
+		}
+	}
+	assert(false);
+	return false;
+}
+
 bool saveTexture(
 	std::vector<Image>& images, Texture::CustomMipImages customMipImages, const CommandLine& args)
 {
@@ -370,56 +472,118 @@ bool saveTexture(
 	{
 		if (args.log == CommandLine::Log::Verbose)
 			std::cout << "generating mipmaps" << std::endl;
+		// Generate each mip level as the previous one is converted to reduce memory use. Format
+		// downgrades need to analyze every mip level up front.
+		texture.setFusedMipmapsEnabled(!args.downgrade);
 		texture.generateMipmaps(args.mipFilter, args.mipLevels, customMipImages);
 		customMipImages.clear();
 	}
 
 	if (args.log == CommandLine::Log::Verbose)
 		std::cout << "converting texture" << std::endl;
-	if (!texture.convert(args.format, args.type, args.quality, args.alpha, args.colorMask,
-			args.jobs))
+	texture.setFormatDowngradeEnabled(args.downgrade);
+	for (Texture::Format format : args.formats)
+		texture.setEncoder(format, args.encoder);
+	texture.setBlockCacheEnabled(args.blockCache);
+	texture.setAdaptiveQuality(args.adaptive, args.adaptiveQuality, args.adaptiveThreshold);
+	texture.setQualityMetricsEnabled(args.qualityMetrics, args.ssim);
+	texture.setKtx2ZstdLevel(args.zstdLevel);
+	if (args.incremental)
+	{
+		texture.setBlockHashesEnabled(true);
+		if (texture.setPreviousOutput(args.output, args.incremental, args.fileType) &&
+			args.log == CommandLine::Log::Verbose)
+		{
+			std::cout << "using previous output '" << args.output << "'" << std::endl;
+		}
+	}
+
+	// Save each surface as it's converted unless the quality needs to be checked before saving.
+	bool targetQuality = args.targetPsnr > 0 || args.targetSsim > -1;
+	bool pipelined = !targetQuality && !args.qualityMetrics;
+	Texture::SaveResult saveResult = Texture::SaveResult::Success;
+	bool converted;
+	if (targetQuality)
+	{
+		converted = texture.convertToQualityTarget(args.formats, args.type, args.targetPsnr,
+			args.targetSsim, args.quality, args.alpha, args.colorMask, args.jobs);
+	}
+	else if (pipelined)
+	{
+		if (args.log != CommandLine::Log::Quiet)
+			std::cout << "saving texture '" << args.output << "'" << std::endl;
+		saveResult = texture.convertAndSave(args.output, args.fileType, args.format, args.type,
+			args.quality, args.alpha, args.colorMask, args.jobs);
+		converted = texture.converted();
+	}
+	else
+	{
+		converted = texture.convert(args.format, args.type, args.quality, args.alpha,
+			args.colorMask, args.jobs);
+	}
+
+	if (!converted)
 	{
 		std::cerr << "error: failed to convert texture" << std::endl;
 		return false;
 	}
 
+	if (args.log == CommandLine::Log::Verbose && texture.blockCacheLookups() > 0)
+	{
+		std::cout << "block cache hits: " << texture.blockCacheHits() << " / " <<
+			texture.blockCacheLookups() << " (" <<
+			100.0*static_cast<double>(texture.blockCacheHits())/
+				static_cast<double>(texture.blockCacheLookups()) << "%)" << std::endl;
+	}
+
+	if (args.incremental && args.log == CommandLine::Log::Verbose)
+		std::cout << "reused blocks: " << texture.reusedBlockCount() << std::endl;
+
+	if (args.adaptive && args.log == CommandLine::Log::Verbose)
+		std::cout << "refined blocks: " << texture.adaptiveRefinedBlockCount() << std::endl;
+
+	if (!checkQualityMetrics(texture, args))
+		return false;
+
+	if (!pipelined)
+	{
+		if (args.log != CommandLine::Log::Quiet)
+			std::cout << "saving texture '" << args.output << "'" << std::endl;
+		saveResult = texture.save(args.output, args.fileType);
+	}
+
+	if (!handleSaveResult(saveResult,
+			[&texture, &args]() {return texture.save(args.output, args.fileType);}, args))
+	{
+		return false;
+	}
+
+	return saveBlockHashes(texture, args);
+}
+
+bool transcodeTexture(const CommandLine& args)
+{
 	if (args.log != CommandLine::Log::Quiet)
-		std::cout << "saving texture '" << args.output << "'" << std::endl;
-	switch (texture.save(args.output, args.fileType))
 	{
-		case Texture::SaveResult::Success:
-			return true;
-		case Texture::SaveResult::Invalid:
-			std::cerr << "error: texture parameters were invalid" << std::endl;
-			return false;
-		case Texture::SaveResult::UnknownFormat:
-			std::cerr << "error: unknown texture file format" << std::endl;
-			return false;
-		case Texture::SaveResult::Unsupported:
-			std::cerr << "error: texture format unsupported by target file format" << std::endl;
-			return false;
-		case Texture::SaveResult::WriteError:
-		{
-			if (args.createOutputDir)
-			{
-				// Try to create the directory and save again. We do this off of the initial save
-				// so another error like an invalid format won't leave directories behind.
-				if (!createParentDir(args.output))
-				{
-					std::cerr << "error: couldn't create parent directory for '" <<
-						args.output << "'" << std::endl;
-					return false;
-				}
+		std::cout << "transcoding texture '" << args.transcode << "' to '" << args.output << "'" <<
+			std::endl;
+	}
 
-				if (texture.save(args.output, args.fileType) == Texture::SaveResult::Success)
-					return true;
-			}
-			std::cerr << "error: couldn't write file '" << args.output << "'" << std::endl;
-			return false;
-		}
+	// The surfaces are written directly from the memory mapped input without re-encoding.
+	auto transcode = [&args]()
+	{
+		return Texture::transcode(args.transcode, args.output, Texture::FileType::Auto,
+			args.fileType, args.zstdLevel);
+	};
+
+	Texture::SaveResult saveResult = transcode();
+	if (saveResult == Texture::SaveResult::Invalid)
+	{
+		std::cerr << "error: couldn't load texture '" << args.transcode << "'" << std::endl;
+		return false;
 	}
-	assert(false);
-	return false;
+
+	return handleSaveResult(saveResult, transcode, args);
 }
 
 } // namespace
@@ -430,6 +594,9 @@ int main(int argc, const char** argv)
 	if (!commandLine.parse(argc, argv))
 		return 1;
 
+	if (commandLine.transcode)
+		return transcodeTexture(commandLine) ? 0 : 3;
+
 	std::vector<Image> images;
 	Texture::CustomMipImages customMipImages;
 	if (!loadImages(images, customMipImages, commandLine))